@@ -111,6 +111,192 @@ bool scc_set_dist_functions(scc_check_data_set,
                             scc_nearest_neighbor_search,
                             scc_close_nn_search_object);
 
+/** Declare the nearest neighbor search function thread-safe.
+ *
+ *  When the nearest neighbor search function set with #scc_set_dist_functions
+ *  may be called concurrently from several threads with the same search
+ *  object, the library splits large searches into blocks of queries that are
+ *  searched in parallel. The declaration is cleared when new search functions
+ *  are set. The built-in searches parallelize internally and are not
+ *  declared thread-safe.
+ *
+ *  \return \c true if the declaration was set, otherwise \c false.
+ */
+bool scc_set_nn_search_thread_safe(bool thread_safe);
+
+
+// =============================================================================
+// Built-in search backends
+// =============================================================================
+
+/** Use a kd-tree for nearest neighbor searching.
+ *
+ *  Replaces the nearest neighbor search functions with a built-in kd-tree.
+ *  This is often much faster than the default brute-force search when data
+ *  points have few dimensions (say, less than 10-15). Other distance functions
+ *  are not changed. Use #scc_reset_dist_functions to restore the defaults.
+ *
+ *  The kd-tree works only with data sets made by #scc_init_data_set.
+ *
+ *  \return \c true if the functions were set, otherwise \c false.
+ */
+bool scc_set_kdtree_dist_search(void);
+
+/** Use a ball tree for nearest neighbor and max distance searching.
+ *
+ *  Replaces the nearest neighbor search functions and the max distance
+ *  functions with a built-in ball tree. The ball tree prunes the search
+ *  using bounding spheres, which remain effective in more dimensions than
+ *  the kd-tree (say, up to 50-100 depending on the structure of the data).
+ *  Other distance functions are not changed. Use #scc_reset_dist_functions
+ *  to restore the defaults.
+ *
+ *  The ball tree works only with data sets made by #scc_init_data_set.
+ *
+ *  \return \c true if the functions were set, otherwise \c false.
+ */
+bool scc_set_balltree_dist_search(void);
+
+/** Use an early abandoning brute-force search for nearest neighbor searching.
+ *
+ *  Replaces the nearest neighbor search functions with a brute-force search
+ *  that skips candidates using precomputed norms and stops summing the
+ *  distance to a candidate once it exceeds the distance to the current k-th
+ *  nearest neighbor. The neighbors are those of the default search, up to
+ *  rounding of the distances. This is useful when data points have many
+ *  dimensions, where the trees do not prune well. Other distance functions
+ *  are not changed. Use #scc_reset_dist_functions to restore the defaults.
+ *
+ *  The search works only with data sets made by #scc_init_data_set.
+ *
+ *  \param reorder_dimensions if \c true, the dimensions are summed in order
+ *                            of decreasing variance, so that the search can
+ *                            abandon candidates sooner. This makes a reordered
+ *                            copy of the data matrix for each search.
+ *
+ *  \return \c true if the functions were set, otherwise \c false.
+ */
+bool scc_set_early_abandon_dist_search(bool reorder_dimensions);
+
+/** Use an HNSW graph for approximate nearest neighbor searching.
+ *
+ *  Replaces the nearest neighbor search functions with a built-in
+ *  hierarchical navigable small world graph. Queries are sub-linear in the
+ *  number of search points, but the returned neighbors are approximate:
+ *  some may not be among the exact nearest neighbors. Other distance
+ *  functions are not changed. Use #scc_reset_dist_functions to restore the
+ *  defaults.
+ *
+ *  The HNSW graph works only with data sets made by #scc_init_data_set.
+ *
+ *  \param m maximum number of links per node on the upper levels of the graph
+ *           (twice as many on the bottom level). Zero selects the default (16).
+ *  \param ef_construction beam width when building the graph. Larger values give
+ *                         better graphs at higher build cost. Zero selects the default (200).
+ *  \param ef_search beam width when searching (at least the number of neighbors
+ *                   searched for). Larger values give better recall. Zero selects the default (50).
+ *  \param index_file if not \c NULL, graphs over all data points are read from this
+ *                    file when it holds a graph built with the same data and parameters,
+ *                    and are otherwise written to it after being built.
+ *
+ *  \return \c true if the functions were set, otherwise \c false.
+ */
+bool scc_set_hnsw_dist_search(uint32_t m,
+                              uint32_t ef_construction,
+                              uint32_t ef_search,
+                              const char* index_file);
+
+
+// =============================================================================
+// Distance backends
+// =============================================================================
+
+/** Create a distance backend.
+ *
+ *  A backend is a set of distance functions that is passed to individual
+ *  clusterings (see `scc_ClusterOptions::dist_backend` and
+ *  `scc_HierarchicalOptions::dist_backend`), as opposed to the global
+ *  functions set with #scc_set_dist_functions. Clusterings with different
+ *  backends can run concurrently in different threads.
+ *
+ *  The function arguments are as in #scc_set_dist_functions. Functions that
+ *  are \c NULL are replaced by the built-in defaults. The max distance and
+ *  nearest neighbor functions must be given in complete triples.
+ *
+ *  \param[in] user_data pointer that the functions can retrieve with
+ *                       #scc_get_dist_backend_user_data (may be \c NULL).
+ *  \param[out] out_dist_backend double pointer to where to write the backend reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_init_dist_backend(scc_check_data_set check_data_set,
+                                    scc_get_dist_matrix get_dist_matrix,
+                                    scc_get_dist_rows get_dist_rows,
+                                    scc_init_max_dist_object init_max_dist_object,
+                                    scc_get_max_dist get_max_dist,
+                                    scc_close_max_dist_object close_max_dist_object,
+                                    scc_init_nn_search_object init_nn_search_object,
+                                    scc_nearest_neighbor_search nearest_neighbor_search,
+                                    scc_close_nn_search_object close_nn_search_object,
+                                    void* user_data,
+                                    scc_DistBackend** out_dist_backend);
+
+/** Create a distance backend using the built-in kd-tree.
+ *
+ *  The backend counterpart of #scc_set_kdtree_dist_search.
+ */
+scc_ErrorCode scc_init_kdtree_dist_backend(scc_DistBackend** out_dist_backend);
+
+/** Create a distance backend using the built-in ball tree.
+ *
+ *  The backend counterpart of #scc_set_balltree_dist_search.
+ */
+scc_ErrorCode scc_init_balltree_dist_backend(scc_DistBackend** out_dist_backend);
+
+/** Create a distance backend using the early abandoning brute-force search.
+ *
+ *  The backend counterpart of #scc_set_early_abandon_dist_search.
+ */
+scc_ErrorCode scc_init_early_abandon_dist_backend(bool reorder_dimensions,
+                                                  scc_DistBackend** out_dist_backend);
+
+/** Create a distance backend using an HNSW graph.
+ *
+ *  The backend counterpart of #scc_set_hnsw_dist_search. The parameters are
+ *  kept in the backend, so clusterings with different HNSW backends can run
+ *  concurrently, and neither depends on the parameters set with
+ *  #scc_set_hnsw_dist_search. The backend's user data holds the parameters
+ *  and is freed with the backend.
+ */
+scc_ErrorCode scc_init_hnsw_dist_backend(uint32_t m,
+                                         uint32_t ef_construction,
+                                         uint32_t ef_search,
+                                         const char* index_file,
+                                         scc_DistBackend** out_dist_backend);
+
+/** Declare the nearest neighbor search function of a backend thread-safe.
+ *
+ *  The backend counterpart of #scc_set_nn_search_thread_safe.
+ *  #scc_get_dist_backend_user_data may be called from all threads that
+ *  search concurrently.
+ */
+scc_ErrorCode scc_set_dist_backend_thread_safe(scc_DistBackend* dist_backend,
+                                               bool thread_safe);
+
+/** Free distance backend.
+ *
+ *  The backend must not be in use by any running clustering.
+ */
+void scc_free_dist_backend(scc_DistBackend** dist_backend);
+
+/** User data of the active distance backend.
+ *
+ *  Called from the distance functions of a backend. Returns the `user_data`
+ *  of the backend used by the clustering running in the calling thread, or
+ *  \c NULL if the clustering uses the global functions.
+ */
+void* scc_get_dist_backend_user_data(void);
+
 
 #ifdef __cplusplus
 }
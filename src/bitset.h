@@ -0,0 +1,119 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_BITSET_HG
+#define SCC_BITSET_HG
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "parallel.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Bitsets
+// =============================================================================
+
+/* Mark arrays with one bit per vertex. A bitset is an array of words where
+ * bit `i % 64` of word `i / 64` holds element `i`. Bits past the length
+ * of the set are always zero. */
+
+/// Type of the words in bitsets.
+typedef uint64_t iscc_BitWord;
+
+/// Number of bits in a word.
+#define ISCC_BITWORD_BITS 64
+
+
+/// Number of words in a bitset with `len` bits.
+static inline size_t iscc_bitset_words(const size_t len)
+{
+	return (len + ISCC_BITWORD_BITS - 1) / ISCC_BITWORD_BITS;
+}
+
+
+/** Allocate a bitset with all bits cleared.
+ *
+ *  Returns \c NULL if out of memory. The bitset is freed with `free`.
+ */
+static inline iscc_BitWord* iscc_alloc_bitset(const size_t len)
+{
+	// Allocate at least one word so that `NULL` always signals failure
+	const size_t words = iscc_bitset_words(len);
+	return calloc((words > 0) ? words : 1, sizeof(iscc_BitWord));
+}
+
+
+static inline bool iscc_bitset_test(const iscc_BitWord* const bitset,
+                                    const size_t i)
+{
+	assert(bitset != NULL);
+	return (bitset[i / ISCC_BITWORD_BITS] >> (i % ISCC_BITWORD_BITS)) & 1u;
+}
+
+
+static inline void iscc_bitset_set(iscc_BitWord* const bitset,
+                                   const size_t i)
+{
+	assert(bitset != NULL);
+	bitset[i / ISCC_BITWORD_BITS] |= ((iscc_BitWord) 1) << (i % ISCC_BITWORD_BITS);
+}
+
+
+/// Set bit `i` and return its previous value.
+static inline bool iscc_bitset_test_and_set(iscc_BitWord* const bitset,
+                                            const size_t i)
+{
+	assert(bitset != NULL);
+	iscc_BitWord* const word = bitset + i / ISCC_BITWORD_BITS;
+	const iscc_BitWord mask = ((iscc_BitWord) 1) << (i % ISCC_BITWORD_BITS);
+	const bool was_set = ((*word & mask) != 0);
+	*word |= mask;
+	return was_set;
+}
+
+
+/** Set bit `i` with an atomic OR.
+ *
+ *  Bits in the same word may be set concurrently from several threads.
+ *  Reads of the bitset must be separated from the writes by a barrier.
+ */
+static inline void iscc_bitset_atomic_set(iscc_BitWord* const bitset,
+                                          const size_t i)
+{
+	assert(bitset != NULL);
+	iscc_BitWord* const word = bitset + i / ISCC_BITWORD_BITS;
+	const iscc_BitWord mask = ((iscc_BitWord) 1) << (i % ISCC_BITWORD_BITS);
+	ISCC_OMP(atomic)
+	*word |= mask;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_BITSET_HG
@@ -22,6 +22,11 @@
 #ifndef SCC_CMOCKA_HEADERS_HG
 #define SCC_CMOCKA_HEADERS_HG
 
+// Included before the library sources, so their feature macros must be set here
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
@@ -30,11 +35,54 @@
 #include <stdlib.h>
 #include <assert.h>
 
+#ifdef _OPENMP
+
+// The cmocka allocation records are not thread-safe, so library threads allocate one at a time
+
+static inline void* iscc_test_malloc(const size_t size, const char* const file, const int line)
+{
+	void* ptr;
+	_Pragma("omp critical(iscc_test_alloc)")
+	ptr = _test_malloc(size, file, line);
+	return ptr;
+}
+
+static inline void* iscc_test_calloc(const size_t num, const size_t size, const char* const file, const int line)
+{
+	void* ptr;
+	_Pragma("omp critical(iscc_test_alloc)")
+	ptr = _test_calloc(num, size, file, line);
+	return ptr;
+}
+
+static inline void* iscc_test_realloc(void* const ptr, const size_t size, const char* const file, const int line)
+{
+	void* new_ptr;
+	_Pragma("omp critical(iscc_test_alloc)")
+	new_ptr = _test_realloc(ptr, size, file, line);
+	return new_ptr;
+}
+
+static inline void iscc_test_free(void* const ptr, const char* const file, const int line)
+{
+	_Pragma("omp critical(iscc_test_alloc)")
+	_test_free(ptr, file, line);
+}
+
+#define malloc(size) iscc_test_malloc(size, __FILE__, __LINE__)
+#define calloc(num, size) iscc_test_calloc(num, size, __FILE__, __LINE__)
+#define realloc(ptr, size) iscc_test_realloc(ptr, size, __FILE__, __LINE__)
+#define free(ptr) iscc_test_free(ptr, __FILE__, __LINE__)
+
+#else
+
 #define malloc(size) _test_malloc(size, __FILE__, __LINE__)
 #define calloc(num, size) _test_calloc(num, size, __FILE__, __LINE__)
 #define realloc(ptr, size) _test_realloc(ptr, size, __FILE__, __LINE__)
 #define free(ptr) _test_free(ptr, __FILE__, __LINE__)
 
+#endif
+
 #ifndef NDEBUG
 #undef assert
 #define assert(expression) mock_assert((int)(expression), #expression, __LINE__)
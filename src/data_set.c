@@ -18,6 +18,11 @@
  * License along with this library. If not, see http://www.gnu.org/licenses/
  * ========================================================================== */
 
+// Exposes `mmap` and `madvise` in strict C99 mode
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 #include "../include/scclust.h"
 
 #include <assert.h>
@@ -30,6 +35,58 @@
 #include "data_set_struct.h"
 #include "scclust_types.h"
 
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+	#define ISCC_HAS_MMAP
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+// =============================================================================
+// Data file header
+// =============================================================================
+
+#define ISCC_DATA_FILE_HEADER_SIZE 64
+
+static const char ISCC_DATA_FILE_MAGIC[8] = "SCCDATA";
+static const uint32_t ISCC_DATA_FILE_FORMAT_VERSION = 1;
+
+typedef struct iscc_DataFileHeader iscc_DataFileHeader;
+struct iscc_DataFileHeader {
+	char magic[8];
+	uint32_t format_version;
+	uint32_t data_type;
+	uint64_t num_data_points;
+	uint64_t num_dimensions;
+	double scale;
+};
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_check_data_set_input(uintmax_t num_data_points,
+                                               uintmax_t num_dimensions,
+                                               size_t len_data_matrix,
+                                               bool data_matrix_is_null,
+                                               scc_DataSet** out_data_set);
+
+static scc_ErrorCode iscc_make_data_set(scc_DataSet data_set,
+                                        scc_DataSet** out_data_set);
+
+#ifdef ISCC_HAS_MMAP
+
+static scc_ErrorCode iscc_data_set_from_map(void* file_map,
+                                            size_t file_map_size,
+                                            uintmax_t num_data_points,
+                                            uintmax_t num_dimensions,
+                                            scc_DataSet** out_data_set);
+
+#endif // ifdef ISCC_HAS_MMAP
+
 
 // =============================================================================
 // External function implementations
@@ -40,6 +97,213 @@ scc_ErrorCode scc_init_data_set(const uintmax_t num_data_points,
                                 const size_t len_data_matrix,
                                 const double data_matrix[const],
                                 scc_DataSet** const out_data_set)
+{
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_data_set_input(num_data_points,
+	                                    num_dimensions,
+	                                    len_data_matrix,
+	                                    (data_matrix == NULL),
+	                                    out_data_set)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	return iscc_make_data_set((scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = (size_t) num_data_points,
+		.num_dimensions = (uint_fast16_t) num_dimensions,
+		.data_type = ISCC_DT_DOUBLE,
+		.data_matrix = data_matrix,
+	}, out_data_set);
+}
+
+
+scc_ErrorCode scc_init_float_data_set(const uintmax_t num_data_points,
+                                      const uintmax_t num_dimensions,
+                                      const size_t len_data_matrix,
+                                      const float data_matrix[const],
+                                      const double rerank_matrix[const],
+                                      scc_DataSet** const out_data_set)
+{
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_data_set_input(num_data_points,
+	                                    num_dimensions,
+	                                    len_data_matrix,
+	                                    (data_matrix == NULL),
+	                                    out_data_set)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	return iscc_make_data_set((scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = (size_t) num_data_points,
+		.num_dimensions = (uint_fast16_t) num_dimensions,
+		.data_type = ISCC_DT_FLOAT,
+		.float_matrix = data_matrix,
+		.rerank_matrix = rerank_matrix,
+	}, out_data_set);
+}
+
+
+scc_ErrorCode scc_init_quantized_data_set(const uintmax_t num_data_points,
+                                          const uintmax_t num_dimensions,
+                                          const size_t len_data_matrix,
+                                          const uint8_t data_matrix[const],
+                                          const double scale,
+                                          const double rerank_matrix[const],
+                                          scc_DataSet** const out_data_set)
+{
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_data_set_input(num_data_points,
+	                                    num_dimensions,
+	                                    len_data_matrix,
+	                                    (data_matrix == NULL),
+	                                    out_data_set)) != SCC_ER_OK) {
+		return ec;
+	}
+	if (!(scale > 0.0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Quantization scale must be positive.");
+	}
+
+	return iscc_make_data_set((scc_DataSet) {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = (size_t) num_data_points,
+		.num_dimensions = (uint_fast16_t) num_dimensions,
+		.data_type = ISCC_DT_UINT8,
+		.uint8_matrix = data_matrix,
+		.uint8_scale = scale,
+		.rerank_matrix = rerank_matrix,
+	}, out_data_set);
+}
+
+
+scc_ErrorCode scc_init_data_set_from_file(const char* const file_path,
+                                          const uintmax_t num_data_points,
+                                          const uintmax_t num_dimensions,
+                                          const scc_FileAccessHint access_hint,
+                                          const bool huge_pages,
+                                          scc_DataSet** const out_data_set)
+{
+	if (out_data_set == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_data_set = NULL;
+
+	if (file_path == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid file path.");
+	}
+	if ((access_hint != SCC_FA_NORMAL) &&
+	        (access_hint != SCC_FA_SEQUENTIAL) &&
+	        (access_hint != SCC_FA_RANDOM) &&
+	        (access_hint != SCC_FA_WILLNEED)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown access hint.");
+	}
+
+#ifdef ISCC_HAS_MMAP
+
+	const int file_desc = open(file_path, O_RDONLY);
+	if (file_desc == -1) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Could not open data file.");
+	}
+
+	struct stat file_stat;
+	if ((fstat(file_desc, &file_stat) != 0) || (file_stat.st_size <= 0)) {
+		close(file_desc);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data file.");
+	}
+	if ((uintmax_t) file_stat.st_size > SIZE_MAX) {
+		close(file_desc);
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Data file too large.");
+	}
+	const size_t file_map_size = (size_t) file_stat.st_size;
+
+	// A shared mapping lets processes using the same file share the page cache
+	void* const file_map = mmap(NULL, file_map_size, PROT_READ, MAP_SHARED, file_desc, 0);
+	close(file_desc);
+	if (file_map == MAP_FAILED) {
+		return iscc_make_error_msg(SCC_ER_NO_MEMORY, "Could not map data file.");
+	}
+
+	// Hints are advisory, failures are ignored
+	switch (access_hint) {
+		case SCC_FA_SEQUENTIAL:
+			posix_madvise(file_map, file_map_size, POSIX_MADV_SEQUENTIAL);
+			break;
+		case SCC_FA_RANDOM:
+			posix_madvise(file_map, file_map_size, POSIX_MADV_RANDOM);
+			break;
+		case SCC_FA_WILLNEED:
+			posix_madvise(file_map, file_map_size, POSIX_MADV_WILLNEED);
+			break;
+		default:
+			break;
+	}
+	#ifdef MADV_HUGEPAGE
+		if (huge_pages) madvise(file_map, file_map_size, MADV_HUGEPAGE);
+	#else
+		(void) huge_pages;
+	#endif
+
+	const scc_ErrorCode ec = iscc_data_set_from_map(file_map,
+	                                                file_map_size,
+	                                                num_data_points,
+	                                                num_dimensions,
+	                                                out_data_set);
+	if (ec != SCC_ER_OK) munmap(file_map, file_map_size);
+	return ec;
+
+#else
+
+	(void) num_data_points;
+	(void) num_dimensions;
+	(void) huge_pages;
+	return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Memory mapped data sets are not supported on this platform.");
+
+#endif // ifdef ISCC_HAS_MMAP
+}
+
+
+void scc_free_data_set(scc_DataSet** const data_set)
+{
+	if ((data_set != NULL) && (*data_set != NULL)) {
+		#ifdef ISCC_HAS_MMAP
+			if ((*data_set)->file_map != NULL) {
+				munmap((*data_set)->file_map, (*data_set)->file_map_size);
+			}
+		#endif
+		free(*data_set);
+		*data_set = NULL;
+	}
+}
+
+
+bool scc_is_initialized_data_set(const scc_DataSet* const data_set)
+{
+	if (data_set == NULL) return false;
+	if (data_set->data_set_version != ISCC_DATASET_STRUCT_VERSION) return false;
+	if (data_set->num_data_points == 0) return false;
+	if (data_set->num_dimensions == 0) return false;
+	switch (data_set->data_type) {
+		case ISCC_DT_DOUBLE:
+			return (data_set->data_matrix != NULL);
+		case ISCC_DT_FLOAT:
+			return (data_set->float_matrix != NULL);
+		case ISCC_DT_UINT8:
+			return (data_set->uint8_matrix != NULL) && (data_set->uint8_scale > 0.0);
+		default:
+			return false;
+	}
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_check_data_set_input(const uintmax_t num_data_points,
+                                               const uintmax_t num_dimensions,
+                                               const size_t len_data_matrix,
+                                               const bool data_matrix_is_null,
+                                               scc_DataSet** const out_data_set)
 {
 	if (out_data_set == NULL) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
@@ -66,41 +330,119 @@ scc_ErrorCode scc_init_data_set(const uintmax_t num_data_points,
 	if (len_data_matrix < num_data_points * num_dimensions) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
 	}
-	if (data_matrix == NULL) {
+	if (data_matrix_is_null) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
 	}
 
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_make_data_set(const scc_DataSet data_set,
+                                        scc_DataSet** const out_data_set)
+{
+	assert(out_data_set != NULL);
+
 	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
 	if (tmp_dso == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
-	*tmp_dso = (scc_DataSet) {
-		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
-		.num_data_points = (size_t) num_data_points,
-		.num_dimensions = (uint_fast16_t) num_dimensions,
-		.data_matrix = data_matrix,
-	};
-
+	*tmp_dso = data_set;
 	*out_data_set = tmp_dso;
 
 	return iscc_no_error();
 }
 
 
-void scc_free_data_set(scc_DataSet** const data_set)
+#ifdef ISCC_HAS_MMAP
+
+static scc_ErrorCode iscc_data_set_from_map(void* const file_map,
+                                            const size_t file_map_size,
+                                            const uintmax_t num_data_points,
+                                            const uintmax_t num_dimensions,
+                                            scc_DataSet** const out_data_set)
 {
-	if ((data_set != NULL) && (*data_set != NULL)) {
-		free(*data_set);
-		*data_set = NULL;
+	assert(file_map != NULL);
+	assert(out_data_set != NULL);
+
+	const unsigned char* const file_bytes = file_map;
+	scc_DataSet data_set = {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.data_type = ISCC_DT_DOUBLE,
+		.file_map = file_map,
+		.file_map_size = file_map_size,
+	};
+	size_t data_offset = 0;
+	size_t value_size = sizeof(double);
+	uintmax_t file_num_data_points = num_data_points;
+	uintmax_t file_num_dimensions = num_dimensions;
+
+	if ((file_map_size >= ISCC_DATA_FILE_HEADER_SIZE) &&
+	        (memcmp(file_bytes, ISCC_DATA_FILE_MAGIC, sizeof(ISCC_DATA_FILE_MAGIC)) == 0)) {
+		iscc_DataFileHeader header;
+		memcpy(&header.magic, file_bytes, 8);
+		memcpy(&header.format_version, file_bytes + 8, 4);
+		memcpy(&header.data_type, file_bytes + 12, 4);
+		memcpy(&header.num_data_points, file_bytes + 16, 8);
+		memcpy(&header.num_dimensions, file_bytes + 24, 8);
+		memcpy(&header.scale, file_bytes + 32, 8);
+
+		if (header.format_version != ISCC_DATA_FILE_FORMAT_VERSION) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unsupported data file version.");
+		}
+		if (((num_data_points != 0) && (num_data_points != header.num_data_points)) ||
+		        ((num_dimensions != 0) && (num_dimensions != header.num_dimensions))) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data file does not match the data set size.");
+		}
+		switch (header.data_type) {
+			case 0:
+				break;
+			case 1:
+				data_set.data_type = ISCC_DT_FLOAT;
+				value_size = sizeof(float);
+				break;
+			case 2:
+				if (!(header.scale > 0.0)) {
+					return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Quantization scale must be positive.");
+				}
+				data_set.data_type = ISCC_DT_UINT8;
+				data_set.uint8_scale = header.scale;
+				value_size = sizeof(uint8_t);
+				break;
+			default:
+				return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown data type in data file.");
+		}
+		data_offset = ISCC_DATA_FILE_HEADER_SIZE;
+		file_num_data_points = header.num_data_points;
+		file_num_dimensions = header.num_dimensions;
+	} else if ((num_data_points == 0) || (num_dimensions == 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Data set size must be given for raw data files.");
 	}
-}
 
+	const size_t len_data_matrix = (file_map_size - data_offset) / value_size;
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_data_set_input(file_num_data_points,
+	                                    file_num_dimensions,
+	                                    len_data_matrix,
+	                                    false,
+	                                    out_data_set)) != SCC_ER_OK) {
+		return ec;
+	}
 
-bool scc_is_initialized_data_set(const scc_DataSet* const data_set)
-{
-	if (data_set == NULL) return false;
-	if (data_set->data_set_version != ISCC_DATASET_STRUCT_VERSION) return false;
-	if (data_set->num_data_points == 0) return false;
-	if (data_set->num_dimensions == 0) return false;
-	if (data_set->data_matrix == NULL) return false;
-	return true;
+	data_set.num_data_points = (size_t) file_num_data_points;
+	data_set.num_dimensions = (uint_fast16_t) file_num_dimensions;
+	switch (data_set.data_type) {
+		case ISCC_DT_FLOAT:
+			data_set.float_matrix = (const float*) (file_bytes + data_offset);
+			break;
+		case ISCC_DT_UINT8:
+			data_set.uint8_matrix = file_bytes + data_offset;
+			break;
+		default:
+			data_set.data_matrix = (const double*) (file_bytes + data_offset);
+			break;
+	}
+
+	return iscc_make_data_set(data_set, out_data_set);
 }
+
+#endif // ifdef ISCC_HAS_MMAP
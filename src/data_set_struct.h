@@ -35,14 +35,34 @@ extern "C" {
 // Structs, types and variables
 // =============================================================================
 
+/// Enum to identify how the coordinates are stored.
+enum iscc_DataType {
+	ISCC_DT_DOUBLE,
+	ISCC_DT_FLOAT,
+	ISCC_DT_UINT8,
+};
+
+typedef enum iscc_DataType iscc_DataType;
+
+/* Only the matrix of the data set's type is set. Quantized coordinates are
+ * `uint8_scale` times the stored values. `rerank_matrix` is an optional
+ * double precision copy of low precision data sets. Data sets made from
+ * files hold the mapping in `file_map`, which is unmapped when freed. */
 struct scc_DataSet {
 	int32_t data_set_version;
 	size_t num_data_points;
 	uint_fast16_t num_dimensions;
+	iscc_DataType data_type;
 	const double* data_matrix;
+	const float* float_matrix;
+	const uint8_t* uint8_matrix;
+	double uint8_scale;
+	const double* rerank_matrix;
+	void* file_map;
+	size_t file_map_size;
 };
 
-static const int32_t ISCC_DATASET_STRUCT_VERSION = 722328001;
+static const int32_t ISCC_DATASET_STRUCT_VERSION = 722720001;
 
 #ifdef __cplusplus
 }
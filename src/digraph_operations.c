@@ -295,6 +295,99 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 }
 
 
+scc_ErrorCode iscc_digraph_bfs_order(const iscc_Digraph* const dg,
+                                     scc_PointIndex out_order[const])
+{
+	assert(iscc_digraph_is_valid(dg));
+	assert(dg->vertices > 0);
+	assert(out_order != NULL);
+
+	scc_ErrorCode ec;
+	iscc_Digraph dg_transpose;
+	if ((ec = iscc_digraph_transpose(dg, &dg_transpose)) != SCC_ER_OK) return ec;
+
+	bool* const visited = calloc(dg->vertices, sizeof(bool));
+	if (visited == NULL) {
+		iscc_free_digraph(&dg_transpose);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// `out_order` is the queue
+	size_t queue_read = 0;
+	size_t queue_write = 0;
+	assert(dg->vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) dg->vertices; // If `scc_PointIndex` is signed
+	for (scc_PointIndex start = 0; start < vertices; ++start) {
+		if (visited[start]) continue;
+		visited[start] = true;
+		out_order[queue_write++] = start;
+
+		for (; queue_read < queue_write; ++queue_read) {
+			const scc_PointIndex v = out_order[queue_read];
+			for (iscc_ArcIndex a = dg->tail_ptr[v]; a < dg->tail_ptr[v + 1]; ++a) {
+				if (!visited[dg->head[a]]) {
+					visited[dg->head[a]] = true;
+					out_order[queue_write++] = dg->head[a];
+				}
+			}
+			for (iscc_ArcIndex a = dg_transpose.tail_ptr[v]; a < dg_transpose.tail_ptr[v + 1]; ++a) {
+				if (!visited[dg_transpose.head[a]]) {
+					visited[dg_transpose.head[a]] = true;
+					out_order[queue_write++] = dg_transpose.head[a];
+				}
+			}
+		}
+	}
+	assert(queue_write == dg->vertices);
+
+	free(visited);
+	iscc_free_digraph(&dg_transpose);
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_permute_digraph(const iscc_Digraph* const dg,
+                                   const scc_PointIndex order[const],
+                                   iscc_Digraph* const out_dg)
+{
+	assert(iscc_digraph_is_valid(dg));
+	assert(dg->vertices > 0);
+	assert(order != NULL);
+	assert(out_dg != NULL);
+
+	const size_t vertices = dg->vertices;
+
+	scc_PointIndex* const new_label = malloc(sizeof(scc_PointIndex[vertices]));
+	if (new_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_init_digraph(vertices, dg->tail_ptr[vertices], out_dg)) != SCC_ER_OK) {
+		free(new_label);
+		return ec;
+	}
+
+	assert(vertices <= ISCC_POINTINDEX_MAX);
+	out_dg->tail_ptr[0] = 0;
+	for (size_t i = 0; i < vertices; ++i) {
+		new_label[order[i]] = (scc_PointIndex) i;
+		out_dg->tail_ptr[i + 1] = out_dg->tail_ptr[i] + (dg->tail_ptr[order[i] + 1] - dg->tail_ptr[order[i]]);
+	}
+
+	for (size_t i = 0; i < vertices; ++i) {
+		const iscc_ArcIndex old_start = dg->tail_ptr[order[i]];
+		const iscc_ArcIndex row_arcs = dg->tail_ptr[order[i] + 1] - old_start;
+		for (iscc_ArcIndex a = 0; a < row_arcs; ++a) {
+			out_dg->head[out_dg->tail_ptr[i] + a] = new_label[dg->head[old_start + a]];
+		}
+	}
+
+	free(new_label);
+
+	return iscc_no_error();
+}
+
+
 // =============================================================================
 // Internal function implementations
 // =============================================================================
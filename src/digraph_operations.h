@@ -180,4 +180,30 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* in_dg_a,
                                      iscc_Digraph* out_dg);
 
 
+/** Orders the vertices of a digraph breadth-first.
+ *
+ *  This function visits the vertices breadth-first, following arcs in both directions,
+ *  and starts a new search from the vertex with the lowest ID among the unvisited
+ *  vertices when a search is exhausted. Vertices that are close in the digraph are
+ *  therefore close in the order. This is the Cuthill-McKee order without sorting
+ *  the neighbors by degree.
+ *
+ *  \param[in] dg digraph to order.
+ *  \param[out] out_order the vertices of \p dg in breadth-first order (length \p dg->vertices).
+ */
+scc_ErrorCode iscc_digraph_bfs_order(const iscc_Digraph* dg,
+                                     scc_PointIndex out_order[]);
+
+/** Relabels the vertices of a digraph.
+ *
+ *  Vertex `i` in \p out_dg is vertex `order[i]` in \p dg. The arcs of each vertex keep their internal ordering.
+ *
+ *  \param[in] dg digraph to relabel.
+ *  \param[in] order a permutation of the vertices of \p dg.
+ *  \param[out] out_dg the relabeled digraph.
+ */
+scc_ErrorCode iscc_permute_digraph(const iscc_Digraph* dg,
+                                   const scc_PointIndex order[],
+                                   iscc_Digraph* out_dg);
+
 #endif // ifndef SCC_DIGRAPH_OPERATIONS_HG
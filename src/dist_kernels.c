@@ -0,0 +1,317 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "dist_kernels.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(SCC_SIMD_NONE)
+	// Only the scalar kernel
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define ISCC_X86_SIMD
+	#include <immintrin.h>
+#elif defined(SCC_SIMD_SSE2) || defined(SCC_SIMD_AVX2) || defined(SCC_SIMD_AVX512)
+	#error "SIMD kernels require GCC or Clang on x86."
+#endif
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+#ifdef ISCC_X86_SIMD
+
+static double iscc_sq_dist_sse2(const double* vec1,
+                                const double* vec2,
+                                size_t len);
+
+static double iscc_sq_dist_avx2(const double* vec1,
+                                const double* vec2,
+                                size_t len);
+
+static double iscc_sq_dist_avx512(const double* vec1,
+                                  const double* vec2,
+                                  size_t len);
+
+static bool iscc_cpu_supports(iscc_SqDistKernelType kernel_type);
+
+#endif // ifdef ISCC_X86_SIMD
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+iscc_SqDistKernel iscc_get_sq_dist_kernel(void)
+{
+	#if defined(SCC_SIMD_AVX512)
+		return iscc_sq_dist_avx512;
+	#elif defined(SCC_SIMD_AVX2)
+		return iscc_sq_dist_avx2;
+	#elif defined(SCC_SIMD_SSE2)
+		return iscc_sq_dist_sse2;
+	#else
+		return iscc_get_sq_dist_kernel_by_type(iscc_get_sq_dist_kernel_type());
+	#endif
+}
+
+
+iscc_SqDistKernelType iscc_get_sq_dist_kernel_type(void)
+{
+	#if defined(SCC_SIMD_AVX512)
+		return ISCC_SDK_AVX512;
+	#elif defined(SCC_SIMD_AVX2)
+		return ISCC_SDK_AVX2;
+	#elif defined(SCC_SIMD_SSE2)
+		return ISCC_SDK_SSE2;
+	#elif defined(ISCC_X86_SIMD)
+		if (iscc_cpu_supports(ISCC_SDK_AVX512)) return ISCC_SDK_AVX512;
+		if (iscc_cpu_supports(ISCC_SDK_AVX2)) return ISCC_SDK_AVX2;
+		if (iscc_cpu_supports(ISCC_SDK_SSE2)) return ISCC_SDK_SSE2;
+		return ISCC_SDK_SCALAR;
+	#else
+		return ISCC_SDK_SCALAR;
+	#endif
+}
+
+
+iscc_SqDistKernel iscc_get_sq_dist_kernel_by_type(const iscc_SqDistKernelType kernel_type)
+{
+	switch (kernel_type) {
+		case ISCC_SDK_SCALAR:
+			return iscc_sq_dist_scalar;
+
+	#ifdef ISCC_X86_SIMD
+		case ISCC_SDK_SSE2:
+			return iscc_cpu_supports(ISCC_SDK_SSE2) ? iscc_sq_dist_sse2 : NULL;
+
+		case ISCC_SDK_AVX2:
+			return iscc_cpu_supports(ISCC_SDK_AVX2) ? iscc_sq_dist_avx2 : NULL;
+
+		case ISCC_SDK_AVX512:
+			return iscc_cpu_supports(ISCC_SDK_AVX512) ? iscc_sq_dist_avx512 : NULL;
+	#endif // ifdef ISCC_X86_SIMD
+
+		default:
+			return NULL;
+	}
+}
+
+
+double iscc_sq_dist_scalar(const double* vec1,
+                           const double* vec2,
+                           const size_t len)
+{
+	const double* const vec1_stop = vec1 + len;
+
+	double tmp_dist = 0.0;
+	while (vec1 != vec1_stop) {
+		const double value_diff = (*vec1 - *vec2);
+		++vec1;
+		++vec2;
+		tmp_dist += value_diff * value_diff;
+	}
+	return tmp_dist;
+}
+
+
+double iscc_sq_dist_early_abandon(const iscc_SqDistKernel sq_dist,
+                                  const double* const vec1,
+                                  const double* const vec2,
+                                  const size_t len,
+                                  const double bound)
+{
+	assert(sq_dist != NULL);
+
+	double tmp_dist = 0.0;
+
+	size_t i = 0;
+	for (; i + ISCC_EARLY_ABANDON_BLOCK < len; i += ISCC_EARLY_ABANDON_BLOCK) {
+		tmp_dist += sq_dist(vec1 + i, vec2 + i, ISCC_EARLY_ABANDON_BLOCK);
+		if (tmp_dist > bound) return tmp_dist;
+	}
+
+	return tmp_dist + sq_dist(vec1 + i, vec2 + i, len - i);
+}
+
+
+double iscc_sq_dist_float(const float* const vec1,
+                          const float* const vec2,
+                          const size_t len)
+{
+	// Independent accumulators so the loop is vectorized
+	float acc[8] = { 0.0f };
+
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		for (size_t j = 0; j < 8; ++j) {
+			const float value_diff = vec1[i + j] - vec2[i + j];
+			acc[j] += value_diff * value_diff;
+		}
+	}
+	for (; i < len; ++i) {
+		const float value_diff = vec1[i] - vec2[i];
+		acc[0] += value_diff * value_diff;
+	}
+
+	return (double) (((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7])));
+}
+
+
+uint32_t iscc_sq_dist_uint8(const uint8_t* const vec1,
+                            const uint8_t* const vec2,
+                            const size_t len)
+{
+	assert(len <= UINT16_MAX);
+
+	uint32_t tmp_dist = 0;
+	for (size_t i = 0; i < len; ++i) {
+		const int32_t value_diff = (int32_t) vec1[i] - (int32_t) vec2[i];
+		tmp_dist += (uint32_t) (value_diff * value_diff);
+	}
+	return tmp_dist;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+#ifdef ISCC_X86_SIMD
+
+__attribute__((target("sse2")))
+static double iscc_sq_dist_sse2(const double* const vec1,
+                                const double* const vec2,
+                                const size_t len)
+{
+	__m128d acc1 = _mm_setzero_pd();
+	__m128d acc2 = _mm_setzero_pd();
+
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4) {
+		const __m128d diff1 = _mm_sub_pd(_mm_loadu_pd(vec1 + i), _mm_loadu_pd(vec2 + i));
+		const __m128d diff2 = _mm_sub_pd(_mm_loadu_pd(vec1 + i + 2), _mm_loadu_pd(vec2 + i + 2));
+		acc1 = _mm_add_pd(acc1, _mm_mul_pd(diff1, diff1));
+		acc2 = _mm_add_pd(acc2, _mm_mul_pd(diff2, diff2));
+	}
+	if (i + 2 <= len) {
+		const __m128d diff1 = _mm_sub_pd(_mm_loadu_pd(vec1 + i), _mm_loadu_pd(vec2 + i));
+		acc1 = _mm_add_pd(acc1, _mm_mul_pd(diff1, diff1));
+		i += 2;
+	}
+
+	acc1 = _mm_add_pd(acc1, acc2);
+	double tmp_dist = _mm_cvtsd_f64(_mm_add_sd(acc1, _mm_unpackhi_pd(acc1, acc1)));
+
+	if (i < len) {
+		const double value_diff = vec1[i] - vec2[i];
+		tmp_dist += value_diff * value_diff;
+	}
+
+	return tmp_dist;
+}
+
+
+__attribute__((target("avx2,fma")))
+static double iscc_sq_dist_avx2(const double* const vec1,
+                                const double* const vec2,
+                                const size_t len)
+{
+	__m256d acc1 = _mm256_setzero_pd();
+	__m256d acc2 = _mm256_setzero_pd();
+
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		const __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(vec1 + i), _mm256_loadu_pd(vec2 + i));
+		const __m256d diff2 = _mm256_sub_pd(_mm256_loadu_pd(vec1 + i + 4), _mm256_loadu_pd(vec2 + i + 4));
+		acc1 = _mm256_fmadd_pd(diff1, diff1, acc1);
+		acc2 = _mm256_fmadd_pd(diff2, diff2, acc2);
+	}
+	if (i + 4 <= len) {
+		const __m256d diff1 = _mm256_sub_pd(_mm256_loadu_pd(vec1 + i), _mm256_loadu_pd(vec2 + i));
+		acc1 = _mm256_fmadd_pd(diff1, diff1, acc1);
+		i += 4;
+	}
+
+	acc1 = _mm256_add_pd(acc1, acc2);
+	__m128d acc_half = _mm_add_pd(_mm256_castpd256_pd128(acc1), _mm256_extractf128_pd(acc1, 1));
+	double tmp_dist = _mm_cvtsd_f64(_mm_add_sd(acc_half, _mm_unpackhi_pd(acc_half, acc_half)));
+
+	for (; i < len; ++i) {
+		const double value_diff = vec1[i] - vec2[i];
+		tmp_dist += value_diff * value_diff;
+	}
+
+	return tmp_dist;
+}
+
+
+__attribute__((target("avx512f")))
+static double iscc_sq_dist_avx512(const double* const vec1,
+                                  const double* const vec2,
+                                  const size_t len)
+{
+	__m512d acc1 = _mm512_setzero_pd();
+	__m512d acc2 = _mm512_setzero_pd();
+
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		const __m512d diff1 = _mm512_sub_pd(_mm512_loadu_pd(vec1 + i), _mm512_loadu_pd(vec2 + i));
+		const __m512d diff2 = _mm512_sub_pd(_mm512_loadu_pd(vec1 + i + 8), _mm512_loadu_pd(vec2 + i + 8));
+		acc1 = _mm512_fmadd_pd(diff1, diff1, acc1);
+		acc2 = _mm512_fmadd_pd(diff2, diff2, acc2);
+	}
+	if (i + 8 <= len) {
+		const __m512d diff1 = _mm512_sub_pd(_mm512_loadu_pd(vec1 + i), _mm512_loadu_pd(vec2 + i));
+		acc1 = _mm512_fmadd_pd(diff1, diff1, acc1);
+		i += 8;
+	}
+	if (i < len) {
+		// Masked load of the remaining (at most 7) dimensions
+		const __mmask8 tail_mask = (__mmask8) ((1u << (len - i)) - 1u);
+		const __m512d diff1 = _mm512_sub_pd(_mm512_maskz_loadu_pd(tail_mask, vec1 + i), _mm512_maskz_loadu_pd(tail_mask, vec2 + i));
+		acc2 = _mm512_fmadd_pd(diff1, diff1, acc2);
+	}
+
+	return _mm512_reduce_add_pd(_mm512_add_pd(acc1, acc2));
+}
+
+
+static bool iscc_cpu_supports(const iscc_SqDistKernelType kernel_type)
+{
+	__builtin_cpu_init();
+	switch (kernel_type) {
+		case ISCC_SDK_SCALAR:
+			return true;
+		case ISCC_SDK_SSE2:
+			return __builtin_cpu_supports("sse2");
+		case ISCC_SDK_AVX2:
+			return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		case ISCC_SDK_AVX512:
+			return __builtin_cpu_supports("avx512f");
+		default:
+			return false;
+	}
+}
+
+#endif // ifdef ISCC_X86_SIMD
@@ -0,0 +1,118 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_DIST_KERNELS_HG
+#define SCC_DIST_KERNELS_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Structs, types and variables
+// =============================================================================
+
+/** Function computing the squared Euclidean distance between two vectors
+ *  of length `len` (the number of dimensions).
+ */
+typedef double (*iscc_SqDistKernel)(const double* vec1,
+                                    const double* vec2,
+                                    size_t len);
+
+/// Enum to identify the distance kernels.
+enum iscc_SqDistKernelType {
+	ISCC_SDK_SCALAR,
+	ISCC_SDK_SSE2,
+	ISCC_SDK_AVX2,
+	ISCC_SDK_AVX512,
+};
+
+typedef enum iscc_SqDistKernelType iscc_SqDistKernelType;
+
+/// Number of dimensions summed between the checks in #iscc_sq_dist_early_abandon.
+#define ISCC_EARLY_ABANDON_BLOCK 16
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/** Get the fastest squared distance kernel.
+ *
+ *  The kernel is chosen at runtime based on the instruction sets supported by
+ *  the CPU, unless a kernel has been forced at compile time with one of
+ *  the `SCC_SIMD_*` macros (see `./configure --with-simd`).
+ */
+iscc_SqDistKernel iscc_get_sq_dist_kernel(void);
+
+/// Type of the kernel returned by #iscc_get_sq_dist_kernel.
+iscc_SqDistKernelType iscc_get_sq_dist_kernel_type(void);
+
+/** Get a specific kernel.
+ *
+ *  Returns `NULL` if the kernel is not compiled into the library or if
+ *  the CPU does not support it.
+ */
+iscc_SqDistKernel iscc_get_sq_dist_kernel_by_type(iscc_SqDistKernelType kernel_type);
+
+/// Portable squared distance kernel.
+double iscc_sq_dist_scalar(const double* vec1,
+                           const double* vec2,
+                           size_t len);
+
+/** Squared distance with early abandoning.
+ *
+ *  Sums the dimensions with `sq_dist` in blocks of `ISCC_EARLY_ABANDON_BLOCK`
+ *  and returns as soon as the running sum exceeds `bound`. The returned value
+ *  is then larger than `bound` and at most the distance. Otherwise the full
+ *  squared distance is returned. As the block sums are non-negative, the
+ *  partial sums never exceed the full sum, so `bound` can be compared to the
+ *  result as if it was the distance.
+ */
+double iscc_sq_dist_early_abandon(iscc_SqDistKernel sq_dist,
+                                  const double* vec1,
+                                  const double* vec2,
+                                  size_t len,
+                                  double bound);
+
+/// Squared distance between single precision vectors, accumulated in single precision.
+double iscc_sq_dist_float(const float* vec1,
+                          const float* vec2,
+                          size_t len);
+
+/** Squared distance between 8-bit quantized vectors.
+ *
+ *  The sum is exact: with at most `UINT16_MAX` dimensions it fits in 32 bits.
+ */
+uint32_t iscc_sq_dist_uint8(const uint8_t* vec1,
+                            const uint8_t* vec2,
+                            size_t len);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_DIST_KERNELS_HG
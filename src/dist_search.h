@@ -24,7 +24,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include "../include/scclust.h"
 #include "../include/scclust_spi.h"
+#include "parallel.h"
 
 
 struct iscc_dist_functions_struct {
@@ -37,12 +39,46 @@ struct iscc_dist_functions_struct {
 	scc_init_nn_search_object init_nn_search_object;
 	scc_nearest_neighbor_search nearest_neighbor_search;
 	scc_close_nn_search_object close_nn_search_object;
+	// `nearest_neighbor_search` may be called concurrently on the same search object
+	bool nn_search_thread_safe;
 };
 
 typedef struct iscc_dist_functions_struct iscc_dist_functions_struct;
 
 extern iscc_dist_functions_struct iscc_dist_functions;
 
+struct scc_DistBackend {
+	int32_t dist_backend_version;
+	iscc_dist_functions_struct functions;
+	void* user_data;
+	// `user_data` was allocated by the library and is freed with the backend
+	bool owns_user_data;
+};
+
+static const int32_t ISCC_DIST_BACKEND_STRUCT_VERSION = 722723002;
+
+/* Backend of the clustering running in the current thread, or NULL when
+ * the global `iscc_dist_functions` are used. The functions below must be
+ * called from the thread that started the clustering. Workers in parallel
+ * regions do not see the backend unless it is set in each worker. */
+extern ISCC_THREAD_LOCAL const scc_DistBackend* iscc_active_dist_backend;
+
+
+// =============================================================================
+// Backend selection
+// =============================================================================
+
+bool iscc_is_dist_backend(const scc_DistBackend* dist_backend);
+
+// Returns the previously active backend, to be restored when the clustering is done
+const scc_DistBackend* iscc_set_active_dist_backend(const scc_DistBackend* dist_backend);
+
+static inline const iscc_dist_functions_struct* iscc_get_dist_functions(void)
+{
+	if (iscc_active_dist_backend == NULL) return &iscc_dist_functions;
+	return &iscc_active_dist_backend->functions;
+}
+
 
 // =============================================================================
 // Miscellaneous functions
@@ -51,8 +87,8 @@ extern iscc_dist_functions_struct iscc_dist_functions;
 static inline bool iscc_check_data_set(void* data_set,
                                        size_t num_data_points)
 {
-	return iscc_dist_functions.check_data_set(data_set,
-	                                          num_data_points);
+	return iscc_get_dist_functions()->check_data_set(data_set,
+	                                                 num_data_points);
 }
 
 
@@ -61,10 +97,10 @@ static inline bool iscc_get_dist_matrix(void* data_set,
                                         const scc_PointIndex point_indices[],
                                         double output_dists[])
 {
-	return iscc_dist_functions.get_dist_matrix(data_set,
-	                                           len_point_indices,
-	                                           point_indices,
-	                                           output_dists);
+	return iscc_get_dist_functions()->get_dist_matrix(data_set,
+	                                                  len_point_indices,
+	                                                  point_indices,
+	                                                  output_dists);
 }
 
 
@@ -75,12 +111,12 @@ static inline bool iscc_get_dist_rows(void* data_set,
                                       const scc_PointIndex column_indices[],
                                       double output_dists[])
 {
-	return iscc_dist_functions.get_dist_rows(data_set,
-	                                         len_query_indices,
-	                                         query_indices,
-	                                         len_column_indices,
-	                                         column_indices,
-	                                         output_dists);
+	return iscc_get_dist_functions()->get_dist_rows(data_set,
+	                                                len_query_indices,
+	                                                query_indices,
+	                                                len_column_indices,
+	                                                column_indices,
+	                                                output_dists);
 }
 
 
@@ -93,10 +129,10 @@ static inline bool iscc_init_max_dist_object(void* data_set,
                                              const scc_PointIndex search_indices[],
                                              iscc_MaxDistObject** out_max_dist_object)
 {
-	return iscc_dist_functions.init_max_dist_object(data_set,
-	                                                len_search_indices,
-	                                                search_indices,
-	                                                out_max_dist_object);
+	return iscc_get_dist_functions()->init_max_dist_object(data_set,
+	                                                       len_search_indices,
+	                                                       search_indices,
+	                                                       out_max_dist_object);
 }
 
 
@@ -106,17 +142,17 @@ static inline bool iscc_get_max_dist(iscc_MaxDistObject* max_dist_object,
                                      scc_PointIndex out_max_indices[],
                                      double out_max_dists[])
 {
-	return iscc_dist_functions.get_max_dist(max_dist_object,
-	                                        len_query_indices,
-	                                        query_indices,
-	                                        out_max_indices,
-	                                        out_max_dists);
+	return iscc_get_dist_functions()->get_max_dist(max_dist_object,
+	                                               len_query_indices,
+	                                               query_indices,
+	                                               out_max_indices,
+	                                               out_max_dists);
 }
 
 
 static inline bool iscc_close_max_dist_object(iscc_MaxDistObject** max_dist_object)
 {
-	return iscc_dist_functions.close_max_dist_object(max_dist_object);
+	return iscc_get_dist_functions()->close_max_dist_object(max_dist_object);
 }
 
 
@@ -129,10 +165,10 @@ static inline bool iscc_init_nn_search_object(void* data_set,
                                               const scc_PointIndex search_indices[],
                                               iscc_NNSearchObject** out_nn_search_object)
 {
-	return iscc_dist_functions.init_nn_search_object(data_set,
-	                                                 len_search_indices,
-	                                                 search_indices,
-	                                                 out_nn_search_object);
+	return iscc_get_dist_functions()->init_nn_search_object(data_set,
+	                                                        len_search_indices,
+	                                                        search_indices,
+	                                                        out_nn_search_object);
 }
 
 
@@ -146,21 +182,21 @@ static inline bool iscc_nearest_neighbor_search(iscc_NNSearchObject* nn_search_o
                                                 scc_PointIndex out_query_indices[],
                                                 scc_PointIndex out_nn_indices[])
 {
-	return iscc_dist_functions.nearest_neighbor_search(nn_search_object,
-	                                                   len_query_indices,
-	                                                   query_indices,
-	                                                   k,
-	                                                   radius_search,
-	                                                   radius,
-	                                                   out_num_ok_queries,
-	                                                   out_query_indices,
-	                                                   out_nn_indices);
+	return iscc_get_dist_functions()->nearest_neighbor_search(nn_search_object,
+	                                                          len_query_indices,
+	                                                          query_indices,
+	                                                          k,
+	                                                          radius_search,
+	                                                          radius,
+	                                                          out_num_ok_queries,
+	                                                          out_query_indices,
+	                                                          out_nn_indices);
 }
 
 
 static inline bool iscc_close_nn_search_object(iscc_NNSearchObject** nn_search_object)
 {
-	return iscc_dist_functions.close_nn_search_object(nn_search_object);
+	return iscc_get_dist_functions()->close_nn_search_object(nn_search_object);
 }
 
 #endif // ifndef SCC_DIST_SEARCH_HG
@@ -0,0 +1,395 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "dist_search_abandon.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "data_set_struct.h"
+#include "dist_kernels.h"
+#include "dist_search_imp.h"
+#include "dist_search_list.h"
+#include "parallel.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+/* The norms of all data points are computed when the search object is made.
+ * As |norm(q) - norm(p)| is at most the distance between q and p, candidates
+ * whose norms differ by more than the current k-th distance are skipped
+ * without touching their coordinates. The norms are rounded, so the test
+ * allows for a slack of `ISCC_EA_NORM_TOL` times the largest norm.
+ *
+ * When the dimensions are reordered, all data points are copied with their
+ * coordinates in order of decreasing variance among the search points. The
+ * dimensions with the largest contributions to the distances are then summed
+ * first, and the early abandoning happens earlier. */
+
+static const double ISCC_EA_NORM_TOL = 1e-10;
+
+struct iscc_NNSearchObject {
+	int32_t nn_search_version;
+	iscc_SqDistKernel sq_dist;
+	const scc_DataSet* data_set;
+	size_t len_search_indices;
+	const scc_PointIndex* search_indices;
+	const double* coords;
+	double* reordered_coords;
+	double* norms;
+	double norm_slack;
+};
+
+static const int32_t ISCC_EA_NN_SEARCH_STRUCT_VERSION = 722724001;
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static bool iscc_ea_init(void* data_set,
+                         size_t len_search_indices,
+                         const scc_PointIndex search_indices[],
+                         bool reorder_dimensions,
+                         iscc_NNSearchObject** out_nn_search_object);
+
+static bool iscc_ea_reorder_dimensions(const scc_DataSet* data_set,
+                                       size_t len_search_indices,
+                                       const scc_PointIndex search_indices[],
+                                       double out_coords[]);
+
+static size_t iscc_ea_search_range(const void* search_object,
+                                   size_t len_query_indices,
+                                   const scc_PointIndex query_indices[],
+                                   size_t query_offset,
+                                   uint32_t k,
+                                   bool radius_search,
+                                   double radius,
+                                   double sort_scratch[],
+                                   scc_PointIndex out_query_indices[],
+                                   scc_PointIndex out_nn_indices[]);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_ea_init_nn_search_object(void* const data_set,
+                                   const size_t len_search_indices,
+                                   const scc_PointIndex search_indices[const],
+                                   iscc_NNSearchObject** const out_nn_search_object)
+{
+	return iscc_ea_init(data_set, len_search_indices, search_indices, false, out_nn_search_object);
+}
+
+
+bool iscc_ea_init_nn_search_object_reordered(void* const data_set,
+                                             const size_t len_search_indices,
+                                             const scc_PointIndex search_indices[const],
+                                             iscc_NNSearchObject** const out_nn_search_object)
+{
+	return iscc_ea_init(data_set, len_search_indices, search_indices, true, out_nn_search_object);
+}
+
+
+bool iscc_ea_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                     const size_t len_query_indices,
+                                     const scc_PointIndex query_indices[const],
+                                     const uint32_t k,
+                                     const bool radius_search,
+                                     const double radius,
+                                     size_t* const out_num_ok_queries,
+                                     scc_PointIndex out_query_indices[const],
+                                     scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_EA_NN_SEARCH_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->len_search_indices);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	return iscc_nn_search_in_chunks(nn_search_object,
+	                                iscc_ea_search_range,
+	                                (size_t) iscc_get_num_threads(),
+	                                len_query_indices,
+	                                query_indices,
+	                                k,
+	                                radius_search,
+	                                radius,
+	                                out_num_ok_queries,
+	                                out_query_indices,
+	                                out_nn_indices);
+}
+
+
+bool iscc_ea_close_nn_search_object(iscc_NNSearchObject** const nn_search_object)
+{
+	if (nn_search_object != NULL && *nn_search_object != NULL) {
+		assert((*nn_search_object)->nn_search_version == ISCC_EA_NN_SEARCH_STRUCT_VERSION);
+		free((*nn_search_object)->reordered_coords);
+		free((*nn_search_object)->norms);
+		free(*nn_search_object);
+		*nn_search_object = NULL;
+	}
+	return true;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static bool iscc_ea_init(void* const data_set,
+                         const size_t len_search_indices,
+                         const scc_PointIndex search_indices[const],
+                         const bool reorder_dimensions,
+                         iscc_NNSearchObject** const out_nn_search_object)
+{
+	assert(iscc_imp_check_data_set(data_set, 0));
+	assert(len_search_indices > 0);
+	assert(out_nn_search_object != NULL);
+
+	const scc_DataSet* const data_set_cast = data_set;
+	const size_t num_data_points = data_set_cast->num_data_points;
+	const size_t num_dimensions = (size_t) data_set_cast->num_dimensions;
+
+	// The distances are summed in double precision
+	if (data_set_cast->data_type != ISCC_DT_DOUBLE) return false;
+
+	iscc_NNSearchObject* search_object = malloc(sizeof(iscc_NNSearchObject));
+	if (search_object != NULL) {
+		*search_object = (iscc_NNSearchObject) {
+			.nn_search_version = ISCC_EA_NN_SEARCH_STRUCT_VERSION,
+			.sq_dist = iscc_get_sq_dist_kernel(),
+			.data_set = data_set_cast,
+			.len_search_indices = len_search_indices,
+			.search_indices = search_indices,
+			.coords = data_set_cast->data_matrix,
+			.reordered_coords = NULL,
+			.norms = malloc(sizeof(double[num_data_points])),
+			.norm_slack = 0.0,
+		};
+		if (reorder_dimensions) {
+			search_object->reordered_coords = malloc(sizeof(double[num_data_points * num_dimensions]));
+		}
+	}
+
+	if ((search_object == NULL) || (search_object->norms == NULL) ||
+	        (reorder_dimensions && (search_object->reordered_coords == NULL))) {
+		iscc_ea_close_nn_search_object(&search_object);
+		return false;
+	}
+
+	if (reorder_dimensions) {
+		if (!iscc_ea_reorder_dimensions(data_set_cast, len_search_indices, search_indices, search_object->reordered_coords)) {
+			iscc_ea_close_nn_search_object(&search_object);
+			return false;
+		}
+		search_object->coords = search_object->reordered_coords;
+	}
+
+	double max_norm = 0.0;
+	const double* point_data = data_set_cast->data_matrix;
+	for (size_t i = 0; i < num_data_points; ++i) {
+		double sq_norm = 0.0;
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			sq_norm += point_data[d] * point_data[d];
+		}
+		search_object->norms[i] = sqrt(sq_norm);
+		if (search_object->norms[i] > max_norm) max_norm = search_object->norms[i];
+		point_data += num_dimensions;
+	}
+	search_object->norm_slack = ISCC_EA_NORM_TOL * max_norm;
+
+	*out_nn_search_object = search_object;
+
+	return true;
+}
+
+
+// Copies all data points with their dimensions in order of decreasing variance among the search points
+static bool iscc_ea_reorder_dimensions(const scc_DataSet* const data_set,
+                                       const size_t len_search_indices,
+                                       const scc_PointIndex search_indices[const],
+                                       double out_coords[const])
+{
+	assert(data_set->data_type == ISCC_DT_DOUBLE);
+	assert(len_search_indices > 0);
+	assert(out_coords != NULL);
+
+	const double* const data_matrix = data_set->data_matrix;
+	const size_t num_data_points = data_set->num_data_points;
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+
+	double* const mean = calloc(num_dimensions, sizeof(double));
+	double* const variance = calloc(num_dimensions, sizeof(double));
+	size_t* const dim_order = malloc(sizeof(size_t[num_dimensions]));
+	if ((mean == NULL) || (variance == NULL) || (dim_order == NULL)) {
+		free(mean);
+		free(variance);
+		free(dim_order);
+		return false;
+	}
+
+	for (size_t s = 0; s < len_search_indices; ++s) {
+		const size_t point = (search_indices == NULL) ? s : (size_t) search_indices[s];
+		const double* const point_data = &data_matrix[point * num_dimensions];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			mean[d] += point_data[d];
+		}
+	}
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		mean[d] /= (double) len_search_indices;
+	}
+	for (size_t s = 0; s < len_search_indices; ++s) {
+		const size_t point = (search_indices == NULL) ? s : (size_t) search_indices[s];
+		const double* const point_data = &data_matrix[point * num_dimensions];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			variance[d] += (point_data[d] - mean[d]) * (point_data[d] - mean[d]);
+		}
+	}
+
+	// Insertion sort, ties keep the original order
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		size_t pos = d;
+		for (; (pos > 0) && (variance[dim_order[pos - 1]] < variance[d]); --pos) {
+			dim_order[pos] = dim_order[pos - 1];
+		}
+		dim_order[pos] = d;
+	}
+
+	for (size_t i = 0; i < num_data_points; ++i) {
+		const double* const point_data = &data_matrix[i * num_dimensions];
+		double* const point_out = &out_coords[i * num_dimensions];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			point_out[d] = point_data[dim_order[d]];
+		}
+	}
+
+	free(mean);
+	free(variance);
+	free(dim_order);
+
+	return true;
+}
+
+
+/* Searches a contiguous range of queries, returns the number of queries with
+ * `k` neighbors. The neighbors are kept in sorted lists, or in heaps when `k`
+ * is at least `ISCC_DIST_HEAP_MIN_K`, with ties ordered as in the `iscc_imp_*`
+ * search. `bound` is the distance a candidate must not exceed to be added,
+ * and `norm_bound` is its square root plus the slack of the norms. */
+static size_t iscc_ea_search_range(const void* const search_object,
+                                   const size_t len_query_indices,
+                                   const scc_PointIndex query_indices[const],
+                                   const size_t query_offset,
+                                   const uint32_t k,
+                                   const bool radius_search,
+                                   const double radius,
+                                   double sort_scratch[const],
+                                   scc_PointIndex out_query_indices[const],
+                                   scc_PointIndex out_nn_indices[const])
+{
+	const iscc_NNSearchObject* const nn_search_object = search_object;
+	const iscc_SqDistKernel sq_dist = nn_search_object->sq_dist;
+	const size_t num_dimensions = (size_t) nn_search_object->data_set->num_dimensions;
+	const size_t len_search_indices = nn_search_object->len_search_indices;
+	const scc_PointIndex* const search_indices = nn_search_object->search_indices;
+	const double* const coords = nn_search_object->coords;
+	const double* const norms = nn_search_object->norms;
+	const double norm_slack = nn_search_object->norm_slack;
+	const bool use_heap = (k >= ISCC_DIST_HEAP_MIN_K);
+
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+	double* const sort_scratch_end = sort_scratch + k - 1;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+		const double* const query_coords = &coords[query * num_dimensions];
+		const double query_norm = norms[query];
+		scc_PointIndex* const index_write_end = index_write + k - 1;
+
+		double bound = radius_search ? radius * radius : HUGE_VAL;
+		double norm_bound = radius_search ? radius + norm_slack : HUGE_VAL;
+		uint32_t found = 0;
+
+		for (size_t s = 0; s < len_search_indices; ++s) {
+			const size_t search_point = (search_indices == NULL) ? s : (size_t) search_indices[s];
+			if (fabs(query_norm - norms[search_point]) > norm_bound) continue;
+			const double tmp_dist = iscc_sq_dist_early_abandon(sq_dist,
+			                                                   query_coords,
+			                                                   &coords[search_point * num_dimensions],
+			                                                   num_dimensions,
+			                                                   bound);
+			if (found < k) {
+				if (tmp_dist > bound) continue;
+				if (use_heap) {
+					iscc_push_dist_heap(tmp_dist, (scc_PointIndex) s, found, sort_scratch, index_write);
+				} else {
+					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) search_point, sort_scratch + found, index_write + found, sort_scratch);
+				}
+				++found;
+				if (found < k) continue;
+			} else {
+				if (tmp_dist >= bound) continue;
+				if (use_heap) {
+					iscc_replace_dist_heap_top(tmp_dist, (scc_PointIndex) s, k, sort_scratch, index_write);
+				} else {
+					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) search_point, sort_scratch_end, index_write_end, sort_scratch);
+				}
+			}
+			bound = use_heap ? sort_scratch[0] : *sort_scratch_end;
+			norm_bound = sqrt(bound) + norm_slack;
+		}
+
+		assert(found == k || out_query_indices != NULL);
+		if (found == k) {
+			if (use_heap) {
+				iscc_sort_dist_heap(k, sort_scratch, index_write);
+				if (search_indices != NULL) {
+					for (uint32_t i = 0; i < k; ++i) {
+						index_write[i] = search_indices[index_write[i]];
+					}
+				}
+			}
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	return num_ok_queries;
+}
@@ -0,0 +1,571 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "dist_search_balltree.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "data_set_struct.h"
+#include "dist_kernels.h"
+#include "dist_search_imp.h"
+#include "dist_search_kdtree.h"
+#include "dist_search_list.h"
+#include "parallel.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+/* The ball tree is built by median splits along the dimension with largest
+ * spread (as the kd-tree), but each node stores the centroid of its points and
+ * the radius of the smallest ball around the centroid containing them. With
+ * `c` the distance from a query to the centroid and `r` the radius, all points
+ * in the node are at least `c - r` and at most `c + r` from the query. Unlike
+ * the splitting planes of a kd-tree, these bounds remain useful in moderately
+ * high dimensions.
+ *
+ * The search points are stored in tree order, so every node covers a
+ * contiguous range. The two children of a node are stored next to each other. */
+
+#define ISCC_BT_LEAF_SIZE 32
+
+// Relative slack on the bounds to guard against rounding errors
+static const double ISCC_BT_BOUND_SLACK = 1e-10;
+
+typedef struct iscc_bt_Node iscc_bt_Node;
+struct iscc_bt_Node {
+	size_t start;
+	size_t stop;
+	size_t left_child; // 0 if leaf (root is never a child), right child is `left_child + 1`
+	double radius;
+};
+
+typedef struct iscc_bt_Tree iscc_bt_Tree;
+struct iscc_bt_Tree {
+	iscc_SqDistKernel sq_dist;
+	const scc_DataSet* data_set;
+	size_t num_points;
+	scc_PointIndex* point_indices;
+	double* coords;
+	iscc_bt_Node* nodes;
+	double* centers;
+};
+
+struct iscc_MaxDistObject {
+	int32_t max_dist_version;
+	iscc_bt_Tree tree;
+};
+
+static const int32_t ISCC_BT_MAXDIST_STRUCT_VERSION = 722645001;
+
+struct iscc_NNSearchObject {
+	int32_t nn_search_version;
+	iscc_bt_Tree tree;
+};
+
+static const int32_t ISCC_BT_NN_SEARCH_STRUCT_VERSION = 722647001;
+
+typedef struct iscc_bt_Query iscc_bt_Query;
+struct iscc_bt_Query {
+	const double* query_coords;
+	uint32_t k;
+	uint32_t found;
+	double radius_sq;
+	double* dist_list;
+	scc_PointIndex* index_list;
+};
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static bool iscc_bt_init_tree(const scc_DataSet* data_set,
+                              size_t len_search_indices,
+                              const scc_PointIndex search_indices[],
+                              iscc_bt_Tree* out_tree);
+
+static void iscc_bt_free_tree(iscc_bt_Tree* tree);
+
+static size_t iscc_bt_build(iscc_bt_Tree* tree,
+                            size_t* point_rows,
+                            size_t node,
+                            size_t next_free_node,
+                            size_t start,
+                            size_t stop);
+
+static inline double iscc_bt_center_dist(const iscc_bt_Tree* tree,
+                                         size_t node,
+                                         const double* query_coords);
+
+static void iscc_bt_max_dist_node(const iscc_bt_Tree* tree,
+                                  size_t node,
+                                  double center_dist,
+                                  const double* query_coords,
+                                  double* max_sq_dist,
+                                  scc_PointIndex* max_index);
+
+static size_t iscc_bt_search_range(const void* search_object,
+                                   size_t len_query_indices,
+                                   const scc_PointIndex query_indices[],
+                                   size_t query_offset,
+                                   uint32_t k,
+                                   bool radius_search,
+                                   double radius,
+                                   double sort_scratch[],
+                                   scc_PointIndex out_query_indices[],
+                                   scc_PointIndex out_nn_indices[]);
+
+static void iscc_bt_search_node(const iscc_bt_Tree* tree,
+                                size_t node,
+                                double center_dist,
+                                iscc_bt_Query* query);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_bt_init_max_dist_object(void* const data_set,
+                                  const size_t len_search_indices,
+                                  const scc_PointIndex search_indices[const],
+                                  iscc_MaxDistObject** const out_max_dist_object)
+{
+	assert(iscc_imp_check_data_set(data_set, 0));
+	assert(len_search_indices > 0);
+	assert(out_max_dist_object != NULL);
+
+	*out_max_dist_object = malloc(sizeof(iscc_MaxDistObject));
+	if (*out_max_dist_object == NULL) return false;
+
+	(*out_max_dist_object)->max_dist_version = ISCC_BT_MAXDIST_STRUCT_VERSION;
+	if (!iscc_bt_init_tree(data_set, len_search_indices, search_indices, &(*out_max_dist_object)->tree)) {
+		free(*out_max_dist_object);
+		*out_max_dist_object = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool iscc_bt_get_max_dist(iscc_MaxDistObject* const max_dist_object,
+                          const size_t len_query_indices,
+                          const scc_PointIndex query_indices[const],
+                          scc_PointIndex out_max_indices[const],
+                          double out_max_dists[const])
+{
+	assert(max_dist_object != NULL);
+	assert(max_dist_object->max_dist_version == ISCC_BT_MAXDIST_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(out_max_indices != NULL);
+	assert(out_max_dists != NULL);
+
+	const iscc_bt_Tree* const tree = &max_dist_object->tree;
+	const scc_DataSet* const data_set = tree->data_set;
+
+	ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(dynamic, 16))
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		const size_t query = (query_indices == NULL) ? q : (size_t) query_indices[q];
+		assert(query < data_set->num_data_points);
+		const double* const query_coords = &data_set->data_matrix[query * data_set->num_dimensions];
+
+		double max_sq_dist = -1.0;
+		iscc_bt_max_dist_node(tree, 0, iscc_bt_center_dist(tree, 0, query_coords), query_coords, &max_sq_dist, &out_max_indices[q]);
+		out_max_dists[q] = sqrt(max_sq_dist);
+	}
+
+	return true;
+}
+
+
+bool iscc_bt_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
+{
+	if (max_dist_object != NULL && *max_dist_object != NULL) {
+		assert((*max_dist_object)->max_dist_version == ISCC_BT_MAXDIST_STRUCT_VERSION);
+		iscc_bt_free_tree(&(*max_dist_object)->tree);
+		free(*max_dist_object);
+		*max_dist_object = NULL;
+	}
+	return true;
+}
+
+
+bool iscc_bt_init_nn_search_object(void* const data_set,
+                                   const size_t len_search_indices,
+                                   const scc_PointIndex search_indices[const],
+                                   iscc_NNSearchObject** const out_nn_search_object)
+{
+	assert(iscc_imp_check_data_set(data_set, 0));
+	assert(len_search_indices > 0);
+	assert(out_nn_search_object != NULL);
+
+	*out_nn_search_object = malloc(sizeof(iscc_NNSearchObject));
+	if (*out_nn_search_object == NULL) return false;
+
+	(*out_nn_search_object)->nn_search_version = ISCC_BT_NN_SEARCH_STRUCT_VERSION;
+	if (!iscc_bt_init_tree(data_set, len_search_indices, search_indices, &(*out_nn_search_object)->tree)) {
+		free(*out_nn_search_object);
+		*out_nn_search_object = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool iscc_bt_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                     const size_t len_query_indices,
+                                     const scc_PointIndex query_indices[const],
+                                     const uint32_t k,
+                                     const bool radius_search,
+                                     const double radius,
+                                     size_t* const out_num_ok_queries,
+                                     scc_PointIndex out_query_indices[const],
+                                     scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_BT_NN_SEARCH_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->tree.num_points);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	return iscc_nn_search_in_chunks(&nn_search_object->tree,
+	                                iscc_bt_search_range,
+	                                (size_t) iscc_get_num_threads(),
+	                                len_query_indices,
+	                                query_indices,
+	                                k,
+	                                radius_search,
+	                                radius,
+	                                out_num_ok_queries,
+	                                out_query_indices,
+	                                out_nn_indices);
+}
+
+
+bool iscc_bt_close_nn_search_object(iscc_NNSearchObject** const nn_search_object)
+{
+	if (nn_search_object != NULL && *nn_search_object != NULL) {
+		assert((*nn_search_object)->nn_search_version == ISCC_BT_NN_SEARCH_STRUCT_VERSION);
+		iscc_bt_free_tree(&(*nn_search_object)->tree);
+		free(*nn_search_object);
+		*nn_search_object = NULL;
+	}
+	return true;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static bool iscc_bt_init_tree(const scc_DataSet* const data_set,
+                              const size_t len_search_indices,
+                              const scc_PointIndex search_indices[const],
+                              iscc_bt_Tree* const out_tree)
+{
+	assert(data_set != NULL);
+	assert(len_search_indices > 0);
+	assert(out_tree != NULL);
+
+	// The tree is built on double precision coordinates
+	if (data_set->data_type != ISCC_DT_DOUBLE) return false;
+
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+
+	// Leaves have at least `(ISCC_BT_LEAF_SIZE + 1) / 2` points
+	const size_t max_nodes = 2 * (len_search_indices / ((ISCC_BT_LEAF_SIZE + 1) / 2)) + 1;
+
+	*out_tree = (iscc_bt_Tree) {
+		.sq_dist = iscc_get_sq_dist_kernel(),
+		.data_set = data_set,
+		.num_points = len_search_indices,
+		.point_indices = malloc(sizeof(scc_PointIndex[len_search_indices])),
+		.coords = malloc(sizeof(double[len_search_indices * num_dimensions])),
+		.nodes = malloc(sizeof(iscc_bt_Node[max_nodes])),
+		.centers = malloc(sizeof(double[max_nodes * num_dimensions])),
+	};
+	size_t* const point_rows = malloc(sizeof(size_t[len_search_indices]));
+
+	if ((point_rows == NULL) || (out_tree->point_indices == NULL) || (out_tree->coords == NULL) ||
+	        (out_tree->nodes == NULL) || (out_tree->centers == NULL)) {
+		free(point_rows);
+		iscc_bt_free_tree(out_tree);
+		return false;
+	}
+
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		point_rows[i] = (search_indices == NULL) ? i : (size_t) search_indices[i];
+		assert(point_rows[i] < data_set->num_data_points);
+	}
+
+	// Copy is made in `iscc_bt_build` as points are placed in leaves
+	const size_t num_nodes = iscc_bt_build(out_tree, point_rows, 0, 1, 0, len_search_indices);
+	assert(num_nodes <= max_nodes);
+	(void) num_nodes; // If NDEBUG
+
+	free(point_rows);
+
+	return true;
+}
+
+
+static void iscc_bt_free_tree(iscc_bt_Tree* const tree)
+{
+	assert(tree != NULL);
+	free(tree->point_indices);
+	free(tree->coords);
+	free(tree->nodes);
+	free(tree->centers);
+	*tree = (iscc_bt_Tree) { .data_set = NULL };
+}
+
+
+// Builds the subtree at `node` over `point_rows[start:stop]`, returns next free node
+static size_t iscc_bt_build(iscc_bt_Tree* const tree,
+                            size_t* const point_rows,
+                            const size_t node,
+                            size_t next_free_node,
+                            const size_t start,
+                            const size_t stop)
+{
+	assert(start < stop);
+
+	const size_t num_dimensions = (size_t) tree->data_set->num_dimensions;
+	const double* const data_matrix = tree->data_set->data_matrix;
+	double* const center = tree->centers + node * num_dimensions;
+
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		center[d] = 0.0;
+	}
+	for (size_t i = start; i < stop; ++i) {
+		const double* const point_data = &data_matrix[point_rows[i] * num_dimensions];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			center[d] += point_data[d];
+		}
+	}
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		center[d] /= (double) (stop - start);
+	}
+
+	double max_sq_dist = 0.0;
+	for (size_t i = start; i < stop; ++i) {
+		const double sq_dist = tree->sq_dist(center, &data_matrix[point_rows[i] * num_dimensions], num_dimensions);
+		if (sq_dist > max_sq_dist) max_sq_dist = sq_dist;
+	}
+
+	tree->nodes[node] = (iscc_bt_Node) {
+		.start = start,
+		.stop = stop,
+		.left_child = 0,
+		.radius = sqrt(max_sq_dist) * (1.0 + ISCC_BT_BOUND_SLACK),
+	};
+
+	if (stop - start <= ISCC_BT_LEAF_SIZE) {
+		for (size_t i = start; i < stop; ++i) {
+			tree->point_indices[i] = (scc_PointIndex) point_rows[i];
+			const double* const point_data = &data_matrix[point_rows[i] * num_dimensions];
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				tree->coords[i * num_dimensions + d] = point_data[d];
+			}
+		}
+		return next_free_node;
+	}
+
+	iscc_kdt_split_at_median(tree->data_set, point_rows + start, stop - start);
+	const size_t mid = start + (stop - start) / 2;
+
+	const size_t left_child = next_free_node;
+	tree->nodes[node].left_child = left_child;
+	next_free_node += 2;
+
+	next_free_node = iscc_bt_build(tree, point_rows, left_child, next_free_node, start, mid);
+	next_free_node = iscc_bt_build(tree, point_rows, left_child + 1, next_free_node, mid, stop);
+
+	return next_free_node;
+}
+
+
+static inline double iscc_bt_center_dist(const iscc_bt_Tree* const tree,
+                                         const size_t node,
+                                         const double* const query_coords)
+{
+	const size_t num_dimensions = (size_t) tree->data_set->num_dimensions;
+	return sqrt(tree->sq_dist(query_coords, tree->centers + node * num_dimensions, num_dimensions));
+}
+
+
+static void iscc_bt_max_dist_node(const iscc_bt_Tree* const tree,
+                                  const size_t node,
+                                  const double center_dist,
+                                  const double* const query_coords,
+                                  double* const max_sq_dist,
+                                  scc_PointIndex* const max_index)
+{
+	const iscc_bt_Node* const this_node = &tree->nodes[node];
+
+	// No point in the node can be farther than the current maximum
+	const double upper_bound = center_dist * (1.0 + ISCC_BT_BOUND_SLACK) + this_node->radius;
+	if (upper_bound * upper_bound <= *max_sq_dist) return;
+
+	if (this_node->left_child == 0) {
+		const size_t num_dimensions = (size_t) tree->data_set->num_dimensions;
+		for (size_t i = this_node->start; i < this_node->stop; ++i) {
+			const double sq_dist = tree->sq_dist(query_coords, tree->coords + i * num_dimensions, num_dimensions);
+			if (*max_sq_dist < sq_dist) {
+				*max_sq_dist = sq_dist;
+				*max_index = tree->point_indices[i];
+			}
+		}
+		return;
+	}
+
+	// Visit the child that may contain the farthest point first
+	const size_t left_child = this_node->left_child;
+	const double left_dist = iscc_bt_center_dist(tree, left_child, query_coords);
+	const double right_dist = iscc_bt_center_dist(tree, left_child + 1, query_coords);
+	if (left_dist + tree->nodes[left_child].radius >= right_dist + tree->nodes[left_child + 1].radius) {
+		iscc_bt_max_dist_node(tree, left_child, left_dist, query_coords, max_sq_dist, max_index);
+		iscc_bt_max_dist_node(tree, left_child + 1, right_dist, query_coords, max_sq_dist, max_index);
+	} else {
+		iscc_bt_max_dist_node(tree, left_child + 1, right_dist, query_coords, max_sq_dist, max_index);
+		iscc_bt_max_dist_node(tree, left_child, left_dist, query_coords, max_sq_dist, max_index);
+	}
+}
+
+
+static size_t iscc_bt_search_range(const void* const search_object,
+                                   const size_t len_query_indices,
+                                   const scc_PointIndex query_indices[const],
+                                   const size_t query_offset,
+                                   const uint32_t k,
+                                   const bool radius_search,
+                                   const double radius,
+                                   double sort_scratch[const],
+                                   scc_PointIndex out_query_indices[const],
+                                   scc_PointIndex out_nn_indices[const])
+{
+	const iscc_bt_Tree* const tree = search_object;
+	const scc_DataSet* const data_set = tree->data_set;
+
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+		assert(query < data_set->num_data_points);
+
+		iscc_bt_Query query_state = {
+			.query_coords = &data_set->data_matrix[query * data_set->num_dimensions],
+			.k = k,
+			.found = 0,
+			.radius_sq = radius_search ? radius * radius : HUGE_VAL,
+			.dist_list = sort_scratch,
+			.index_list = index_write,
+		};
+
+		iscc_bt_search_node(tree, 0, iscc_bt_center_dist(tree, 0, query_state.query_coords), &query_state);
+
+		assert(query_state.found == k || out_query_indices != NULL);
+		if (query_state.found == k) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	return num_ok_queries;
+}
+
+
+// Whether a point (or node) at squared distance `sq_dist` may enter the list
+static inline bool iscc_bt_within_bound(const iscc_bt_Query* const query,
+                                        const double sq_dist)
+{
+	if (query->found < query->k) {
+		return sq_dist <= query->radius_sq;
+	}
+	return sq_dist < query->dist_list[query->k - 1];
+}
+
+
+static void iscc_bt_search_node(const iscc_bt_Tree* const tree,
+                                const size_t node,
+                                const double center_dist,
+                                iscc_bt_Query* const query)
+{
+	const iscc_bt_Node* const this_node = &tree->nodes[node];
+
+	// All points in the node are at least this far from the query
+	double lower_bound = center_dist * (1.0 - ISCC_BT_BOUND_SLACK) - this_node->radius;
+	if (lower_bound < 0.0) lower_bound = 0.0;
+	if (!iscc_bt_within_bound(query, lower_bound * lower_bound)) return;
+
+	if (this_node->left_child == 0) {
+		const size_t num_dimensions = (size_t) tree->data_set->num_dimensions;
+		for (size_t i = this_node->start; i < this_node->stop; ++i) {
+			const double sq_dist = tree->sq_dist(query->query_coords, tree->coords + i * num_dimensions, num_dimensions);
+			if (!iscc_bt_within_bound(query, sq_dist)) continue;
+			if (query->found < query->k) {
+				iscc_add_dist_to_list(sq_dist,
+				                      tree->point_indices[i],
+				                      query->dist_list + query->found,
+				                      query->index_list + query->found,
+				                      query->dist_list);
+				++(query->found);
+			} else {
+				iscc_add_dist_to_list(sq_dist,
+				                      tree->point_indices[i],
+				                      query->dist_list + query->k - 1,
+				                      query->index_list + query->k - 1,
+				                      query->dist_list);
+			}
+		}
+		return;
+	}
+
+	// Visit the closer child first
+	const size_t left_child = this_node->left_child;
+	const double left_dist = iscc_bt_center_dist(tree, left_child, query->query_coords);
+	const double right_dist = iscc_bt_center_dist(tree, left_child + 1, query->query_coords);
+	if (left_dist - tree->nodes[left_child].radius <= right_dist - tree->nodes[left_child + 1].radius) {
+		iscc_bt_search_node(tree, left_child, left_dist, query);
+		iscc_bt_search_node(tree, left_child + 1, right_dist, query);
+	} else {
+		iscc_bt_search_node(tree, left_child + 1, right_dist, query);
+		iscc_bt_search_node(tree, left_child, left_dist, query);
+	}
+}
@@ -0,0 +1,85 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_DIST_SEARCH_BALLTREE_HG
+#define SCC_DIST_SEARCH_BALLTREE_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "../include/scclust_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Max dist functions
+// =============================================================================
+
+/* Searches with a ball tree over the search points. The functions follow the
+ * semantics of the `iscc_imp_*` search functions and accept only `scc_DataSet`
+ * data sets. See `scc_set_balltree_dist_search`. */
+
+bool iscc_bt_init_max_dist_object(void* data_set,
+                                  size_t len_search_indices,
+                                  const scc_PointIndex search_indices[],
+                                  iscc_MaxDistObject** out_max_dist_object);
+
+// `max_indices` and `max_dists` must be of length `n_query_points`
+bool iscc_bt_get_max_dist(iscc_MaxDistObject* max_dist_object,
+                          size_t len_query_indices,
+                          const scc_PointIndex query_indices[],
+                          scc_PointIndex out_max_indices[],
+                          double out_max_dists[]);
+
+bool iscc_bt_close_max_dist_object(iscc_MaxDistObject** max_dist_object);
+
+
+// =============================================================================
+// Nearest neighbor search functions
+// =============================================================================
+
+bool iscc_bt_init_nn_search_object(void* data_set,
+                                   size_t len_search_indices,
+                                   const scc_PointIndex search_indices[],
+                                   iscc_NNSearchObject** out_nn_search_object);
+
+// `out_nn_indices` must be of length `k * len_query_indices`
+bool iscc_bt_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
+                                     size_t len_query_indices,
+                                     const scc_PointIndex query_indices[],
+                                     uint32_t k,
+                                     bool radius_search,
+                                     double radius,
+                                     size_t* out_num_ok_queries,
+                                     scc_PointIndex out_query_indices[],
+                                     scc_PointIndex out_nn_indices[]);
+
+bool iscc_bt_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_DIST_SEARCH_BALLTREE_HG
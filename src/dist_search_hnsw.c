@@ -0,0 +1,1105 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "dist_search_hnsw.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "data_set_struct.h"
+#include "dist_kernels.h"
+#include "dist_search_imp.h"
+#include "dist_search_list.h"
+#include "error.h"
+#include "parallel.h"
+#include "random.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+/* The HNSW graph (Malkov & Yashunin, 2018) is a hierarchy of proximity graphs.
+ * Each node is given a random top level, with exponentially fewer nodes on
+ * higher levels. A search greedily descends from the entry point through the
+ * upper levels and ends with a beam search of width `ef` on level 0, where
+ * every node has at most `2 * m` neighbors (`m` on the upper levels).
+ *
+ * Nodes are numbered by their position among the search points. The links of
+ * level 0 are stored in one block per node (a count followed by the
+ * neighbors), the links of the upper levels in a shared pool where
+ * `upper_offset` points to the level 1 block of each node.
+ *
+ * Search sets with few points are searched by brute force, as are queries for
+ * which the graph search finds fewer than `k` points. */
+
+#define ISCC_HNSW_DEFAULT_M 16
+#define ISCC_HNSW_DEFAULT_EF_CONSTRUCTION 200
+#define ISCC_HNSW_DEFAULT_EF_SEARCH 50
+#define ISCC_HNSW_MAX_LEVEL 16
+#define ISCC_HNSW_MAX_PATH 4096
+
+static const size_t ISCC_HNSW_BRUTE_FORCE_LIMIT = 512;
+
+static const uint64_t ISCC_HNSW_RNG_SEED = 0x853C49E6748FEA9Bu;
+
+static const char ISCC_HNSW_FILE_MAGIC[8] = { 'S', 'C', 'C', 'H', 'N', 'S', 'W', '\0' };
+
+static const uint32_t ISCC_HNSW_FILE_VERSION = 1;
+
+struct iscc_hnsw_Settings {
+	uint32_t m;
+	uint32_t ef_construction;
+	uint32_t ef_search;
+	bool use_index_file;
+	char index_file[ISCC_HNSW_MAX_PATH];
+};
+
+static iscc_hnsw_Settings iscc_hnsw_settings = {
+	.m = ISCC_HNSW_DEFAULT_M,
+	.ef_construction = ISCC_HNSW_DEFAULT_EF_CONSTRUCTION,
+	.ef_search = ISCC_HNSW_DEFAULT_EF_SEARCH,
+	.use_index_file = false,
+};
+
+typedef struct iscc_hnsw_Cand iscc_hnsw_Cand;
+struct iscc_hnsw_Cand {
+	double sq_dist;
+	uint32_t node;
+};
+
+// Work space of one search; `capacity` is the maximum length of the heaps
+typedef struct iscc_hnsw_Scratch iscc_hnsw_Scratch;
+struct iscc_hnsw_Scratch {
+	uint32_t* visited;
+	uint32_t visit_tag;
+	size_t capacity;
+	size_t num_candidates;
+	iscc_hnsw_Cand* candidates; // Min-heap of nodes to expand
+	size_t num_results;
+	iscc_hnsw_Cand* results;    // Max-heap of nearest nodes found
+};
+
+typedef struct iscc_hnsw_Index iscc_hnsw_Index;
+struct iscc_hnsw_Index {
+	iscc_SqDistKernel sq_dist;
+	const scc_DataSet* data_set;
+	size_t num_points;
+	size_t num_dimensions;
+	uint32_t m;
+	uint32_t ef_construction;
+	uint32_t ef_search;
+	scc_PointIndex* point_indices;
+	double* coords;
+	uint32_t* levels;
+	uint32_t* links0;
+	size_t* upper_offset;
+	uint32_t* upper_links;
+	size_t len_upper_links;
+	uint32_t entry_point;
+	uint32_t max_level;
+	iscc_hnsw_Scratch* scratch; // One per thread during searches
+};
+
+struct iscc_NNSearchObject {
+	int32_t nn_search_version;
+	iscc_hnsw_Index index;
+};
+
+static const int32_t ISCC_HNSW_NN_SEARCH_STRUCT_VERSION = 722712001;
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static bool iscc_hnsw_fill_settings(uint32_t m,
+                                    uint32_t ef_construction,
+                                    uint32_t ef_search,
+                                    const char* index_file,
+                                    iscc_hnsw_Settings* out_settings);
+
+static const iscc_hnsw_Settings* iscc_hnsw_get_settings(void);
+
+static bool iscc_hnsw_init_index(const iscc_hnsw_Settings* settings,
+                                 const scc_DataSet* data_set,
+                                 size_t len_search_indices,
+                                 const scc_PointIndex search_indices[],
+                                 iscc_hnsw_Index* out_index);
+
+static void iscc_hnsw_free_index(iscc_hnsw_Index* index);
+
+static bool iscc_hnsw_alloc_links(iscc_hnsw_Index* index);
+
+static bool iscc_hnsw_build(iscc_hnsw_Index* index);
+
+static void iscc_hnsw_insert(iscc_hnsw_Index* index,
+                             iscc_hnsw_Scratch* scratch,
+                             iscc_hnsw_Cand* work,
+                             uint32_t node);
+
+static void iscc_hnsw_connect(iscc_hnsw_Index* index,
+                              iscc_hnsw_Cand* work,
+                              uint32_t node,
+                              uint32_t neighbor,
+                              uint32_t level);
+
+static size_t iscc_hnsw_select_neighbors(const iscc_hnsw_Index* index,
+                                         iscc_hnsw_Cand* cands,
+                                         size_t num_cands,
+                                         size_t max_neighbors);
+
+static uint32_t iscc_hnsw_greedy_search(const iscc_hnsw_Index* index,
+                                        const double* query_coords,
+                                        uint32_t level_stop);
+
+static void iscc_hnsw_search_level(const iscc_hnsw_Index* index,
+                                   iscc_hnsw_Scratch* scratch,
+                                   const double* query_coords,
+                                   uint32_t entry_point,
+                                   size_t ef,
+                                   uint32_t level);
+
+static size_t iscc_hnsw_sorted_results(iscc_hnsw_Scratch* scratch,
+                                       iscc_hnsw_Cand* out_sorted);
+
+static size_t iscc_hnsw_search_range(const void* search_object,
+                                     size_t len_query_indices,
+                                     const scc_PointIndex query_indices[],
+                                     size_t query_offset,
+                                     uint32_t k,
+                                     bool radius_search,
+                                     double radius,
+                                     double sort_scratch[],
+                                     scc_PointIndex out_query_indices[],
+                                     scc_PointIndex out_nn_indices[]);
+
+static uint32_t iscc_hnsw_brute_force(const iscc_hnsw_Index* index,
+                                      const double* query_coords,
+                                      uint32_t k,
+                                      double radius_sq,
+                                      double dist_list[],
+                                      scc_PointIndex index_list[]);
+
+static bool iscc_hnsw_init_scratch(iscc_hnsw_Scratch* scratch,
+                                   size_t num_points,
+                                   size_t capacity);
+
+static void iscc_hnsw_free_scratch(iscc_hnsw_Scratch* scratch);
+
+static uint64_t iscc_hnsw_data_hash(const scc_DataSet* data_set);
+
+static bool iscc_hnsw_save_index(const iscc_hnsw_Index* index,
+                                 const char* index_file);
+
+static bool iscc_hnsw_load_index(iscc_hnsw_Index* index,
+                                 const char* index_file);
+
+static bool iscc_hnsw_check_links(const iscc_hnsw_Index* index);
+
+static inline uint32_t* iscc_hnsw_links(const iscc_hnsw_Index* index,
+                                        uint32_t node,
+                                        uint32_t level);
+
+static inline double iscc_hnsw_node_sq_dist(const iscc_hnsw_Index* index,
+                                            const double* query_coords,
+                                            uint32_t node);
+
+static inline void iscc_hnsw_heap_push(iscc_hnsw_Cand* heap,
+                                       size_t* len,
+                                       iscc_hnsw_Cand add,
+                                       bool max_heap);
+
+static inline iscc_hnsw_Cand iscc_hnsw_heap_pop(iscc_hnsw_Cand* heap,
+                                                size_t* len,
+                                                bool max_heap);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_hnsw_set_parameters(const uint32_t m,
+                              const uint32_t ef_construction,
+                              const uint32_t ef_search,
+                              const char* const index_file)
+{
+	return iscc_hnsw_fill_settings(m, ef_construction, ef_search, index_file, &iscc_hnsw_settings);
+}
+
+
+scc_ErrorCode iscc_hnsw_make_settings(const uint32_t m,
+                                      const uint32_t ef_construction,
+                                      const uint32_t ef_search,
+                                      const char* const index_file,
+                                      iscc_hnsw_Settings** const out_settings)
+{
+	assert(out_settings != NULL);
+
+	*out_settings = malloc(sizeof(iscc_hnsw_Settings));
+	if (*out_settings == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	if (!iscc_hnsw_fill_settings(m, ef_construction, ef_search, index_file, *out_settings)) {
+		free(*out_settings);
+		*out_settings = NULL;
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid HNSW parameters.");
+	}
+
+	return iscc_no_error();
+}
+
+
+bool iscc_hnsw_init_nn_search_object(void* const data_set,
+                                     const size_t len_search_indices,
+                                     const scc_PointIndex search_indices[const],
+                                     iscc_NNSearchObject** const out_nn_search_object)
+{
+	assert(iscc_imp_check_data_set(data_set, 0));
+	assert(len_search_indices > 0);
+	assert(out_nn_search_object != NULL);
+
+	if (len_search_indices >= UINT32_MAX) return false;
+	// The index is built on double precision coordinates
+	if (((const scc_DataSet*) data_set)->data_type != ISCC_DT_DOUBLE) return false;
+
+	*out_nn_search_object = malloc(sizeof(iscc_NNSearchObject));
+	if (*out_nn_search_object == NULL) return false;
+
+	(*out_nn_search_object)->nn_search_version = ISCC_HNSW_NN_SEARCH_STRUCT_VERSION;
+	if (!iscc_hnsw_init_index(iscc_hnsw_get_settings(), data_set, len_search_indices, search_indices,
+	                          &(*out_nn_search_object)->index)) {
+		free(*out_nn_search_object);
+		*out_nn_search_object = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool iscc_hnsw_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                       const size_t len_query_indices,
+                                       const scc_PointIndex query_indices[const],
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double radius,
+                                       size_t* const out_num_ok_queries,
+                                       scc_PointIndex out_query_indices[const],
+                                       scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_HNSW_NN_SEARCH_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->index.num_points);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	iscc_hnsw_Index* const index = &nn_search_object->index;
+
+	// Scratch is allocated here as the search ranges run in parallel regions
+	const size_t num_threads = (size_t) iscc_get_num_threads();
+	size_t num_scratch = 0;
+	if (index->links0 != NULL) {
+		num_scratch = num_threads;
+		const size_t ef = (index->ef_search > k) ? index->ef_search : k;
+		index->scratch = calloc(num_scratch, sizeof(iscc_hnsw_Scratch));
+		if (index->scratch == NULL) return false;
+		for (size_t t = 0; t < num_scratch; ++t) {
+			if (!iscc_hnsw_init_scratch(&index->scratch[t], index->num_points, ef + 2 * (size_t) index->m + 1)) {
+				for (size_t u = 0; u <= t; ++u) iscc_hnsw_free_scratch(&index->scratch[u]);
+				free(index->scratch);
+				index->scratch = NULL;
+				return false;
+			}
+		}
+	}
+
+	const bool search_ok = iscc_nn_search_in_chunks(index,
+	                                                iscc_hnsw_search_range,
+	                                                num_threads,
+	                                                len_query_indices,
+	                                                query_indices,
+	                                                k,
+	                                                radius_search,
+	                                                radius,
+	                                                out_num_ok_queries,
+	                                                out_query_indices,
+	                                                out_nn_indices);
+
+	for (size_t t = 0; t < num_scratch; ++t) {
+		iscc_hnsw_free_scratch(&index->scratch[t]);
+	}
+	free(index->scratch);
+	index->scratch = NULL;
+
+	return search_ok;
+}
+
+
+bool iscc_hnsw_close_nn_search_object(iscc_NNSearchObject** const nn_search_object)
+{
+	if (nn_search_object != NULL && *nn_search_object != NULL) {
+		assert((*nn_search_object)->nn_search_version == ISCC_HNSW_NN_SEARCH_STRUCT_VERSION);
+		iscc_hnsw_free_index(&(*nn_search_object)->index);
+		free(*nn_search_object);
+		*nn_search_object = NULL;
+	}
+	return true;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static bool iscc_hnsw_fill_settings(const uint32_t m,
+                                    const uint32_t ef_construction,
+                                    const uint32_t ef_search,
+                                    const char* const index_file,
+                                    iscc_hnsw_Settings* const out_settings)
+{
+	assert(out_settings != NULL);
+
+	if (m == 1) return false;
+	if ((index_file != NULL) && (strlen(index_file) >= ISCC_HNSW_MAX_PATH)) return false;
+
+	out_settings->m = (m == 0) ? ISCC_HNSW_DEFAULT_M : m;
+	out_settings->ef_construction = (ef_construction == 0) ? ISCC_HNSW_DEFAULT_EF_CONSTRUCTION : ef_construction;
+	out_settings->ef_search = (ef_search == 0) ? ISCC_HNSW_DEFAULT_EF_SEARCH : ef_search;
+	out_settings->use_index_file = (index_file != NULL);
+	if (index_file != NULL) {
+		strcpy(out_settings->index_file, index_file);
+	}
+
+	return true;
+}
+
+
+// The functions of an HNSW backend are called with the backend's settings as user data
+static const iscc_hnsw_Settings* iscc_hnsw_get_settings(void)
+{
+	const iscc_hnsw_Settings* const backend_settings = scc_get_dist_backend_user_data();
+	return (backend_settings != NULL) ? backend_settings : &iscc_hnsw_settings;
+}
+
+
+static bool iscc_hnsw_init_index(const iscc_hnsw_Settings* const settings,
+                                 const scc_DataSet* const data_set,
+                                 const size_t len_search_indices,
+                                 const scc_PointIndex search_indices[const],
+                                 iscc_hnsw_Index* const out_index)
+{
+	assert(settings != NULL);
+	assert(data_set != NULL);
+	assert(len_search_indices > 0);
+	assert(out_index != NULL);
+
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+
+	*out_index = (iscc_hnsw_Index) {
+		.sq_dist = iscc_get_sq_dist_kernel(),
+		.data_set = data_set,
+		.num_points = len_search_indices,
+		.num_dimensions = num_dimensions,
+		.m = settings->m,
+		.ef_construction = settings->ef_construction,
+		.ef_search = settings->ef_search,
+		.point_indices = malloc(sizeof(scc_PointIndex[len_search_indices])),
+		.coords = malloc(sizeof(double[len_search_indices * num_dimensions])),
+	};
+
+	if ((out_index->point_indices == NULL) || (out_index->coords == NULL)) {
+		iscc_hnsw_free_index(out_index);
+		return false;
+	}
+
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		const size_t row = (search_indices == NULL) ? i : (size_t) search_indices[i];
+		assert(row < data_set->num_data_points);
+		out_index->point_indices[i] = (scc_PointIndex) row;
+		memcpy(out_index->coords + i * num_dimensions,
+		       data_set->data_matrix + row * num_dimensions,
+		       sizeof(double[num_dimensions]));
+	}
+
+	if (len_search_indices <= ISCC_HNSW_BRUTE_FORCE_LIMIT) {
+		return true;
+	}
+
+	// Only indices over all data points are stored, other search sets are rarely reused
+	const bool use_index_file = settings->use_index_file && (search_indices == NULL);
+	if (use_index_file && iscc_hnsw_load_index(out_index, settings->index_file)) {
+		return true;
+	}
+
+	if (!iscc_hnsw_build(out_index)) {
+		iscc_hnsw_free_index(out_index);
+		return false;
+	}
+
+	if (use_index_file) {
+		// A failed write only means the index is rebuilt next time
+		iscc_hnsw_save_index(out_index, settings->index_file);
+	}
+
+	return true;
+}
+
+
+static void iscc_hnsw_free_index(iscc_hnsw_Index* const index)
+{
+	assert(index != NULL);
+	free(index->point_indices);
+	free(index->coords);
+	free(index->levels);
+	free(index->links0);
+	free(index->upper_offset);
+	free(index->upper_links);
+	*index = (iscc_hnsw_Index) { .data_set = NULL };
+}
+
+
+// Allocates the link storage given `levels`, all nodes start without links
+static bool iscc_hnsw_alloc_links(iscc_hnsw_Index* const index)
+{
+	assert(index->levels != NULL);
+
+	const size_t num_points = index->num_points;
+	const size_t m = index->m;
+
+	index->upper_offset = malloc(sizeof(size_t[num_points]));
+	if (index->upper_offset == NULL) return false;
+
+	index->len_upper_links = 0;
+	for (size_t i = 0; i < num_points; ++i) {
+		index->upper_offset[i] = index->len_upper_links;
+		index->len_upper_links += (size_t) index->levels[i] * (1 + m);
+	}
+
+	index->links0 = calloc(num_points * (1 + 2 * m), sizeof(uint32_t));
+	index->upper_links = calloc(index->len_upper_links + 1, sizeof(uint32_t));
+
+	return (index->links0 != NULL) && (index->upper_links != NULL);
+}
+
+
+static bool iscc_hnsw_build(iscc_hnsw_Index* const index)
+{
+	const size_t num_points = index->num_points;
+
+	index->levels = malloc(sizeof(uint32_t[num_points]));
+	if (index->levels == NULL) return false;
+
+	// Levels are drawn from a geometric distribution with parameter `1 / m`
+	uint64_t rng_state = ISCC_HNSW_RNG_SEED;
+	const double level_mult = 1.0 / log((double) index->m);
+	for (size_t i = 0; i < num_points; ++i) {
+		const double unif = ((double) (iscc_rand(&rng_state) >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+		const double level = -log(unif) * level_mult;
+		index->levels[i] = (level < ISCC_HNSW_MAX_LEVEL) ? (uint32_t) level : ISCC_HNSW_MAX_LEVEL;
+	}
+
+	if (!iscc_hnsw_alloc_links(index)) return false;
+
+	iscc_hnsw_Scratch scratch;
+	// Search results followed by the links of a neighbor being pruned
+	const size_t work_len = (size_t) index->ef_construction + 2 * (size_t) index->m + 1;
+	iscc_hnsw_Cand* const work = malloc(sizeof(iscc_hnsw_Cand[work_len]));
+	if ((work == NULL) || !iscc_hnsw_init_scratch(&scratch, num_points, index->ef_construction + 2 * (size_t) index->m + 1)) {
+		free(work);
+		return false;
+	}
+
+	index->entry_point = 0;
+	index->max_level = index->levels[0];
+	for (uint32_t node = 1; node < (uint32_t) num_points; ++node) {
+		iscc_hnsw_insert(index, &scratch, work, node);
+	}
+
+	iscc_hnsw_free_scratch(&scratch);
+	free(work);
+
+	return true;
+}
+
+
+static void iscc_hnsw_insert(iscc_hnsw_Index* const index,
+                             iscc_hnsw_Scratch* const scratch,
+                             iscc_hnsw_Cand* const work,
+                             const uint32_t node)
+{
+	const double* const node_coords = index->coords + (size_t) node * index->num_dimensions;
+	const uint32_t node_level = index->levels[node];
+
+	uint32_t entry_point = index->entry_point;
+	if (node_level < index->max_level) {
+		entry_point = iscc_hnsw_greedy_search(index, node_coords, node_level + 1);
+	}
+
+	uint32_t level = (node_level < index->max_level) ? node_level : index->max_level;
+	while (true) {
+		iscc_hnsw_search_level(index, scratch, node_coords, entry_point, index->ef_construction, level);
+		const size_t num_cands = iscc_hnsw_sorted_results(scratch, work);
+		entry_point = work[0].node;
+
+		const size_t num_neighbors = iscc_hnsw_select_neighbors(index, work, num_cands, index->m);
+		uint32_t* const node_links = iscc_hnsw_links(index, node, level);
+		node_links[0] = (uint32_t) num_neighbors;
+		for (size_t i = 0; i < num_neighbors; ++i) {
+			node_links[1 + i] = work[i].node;
+		}
+		for (size_t i = 0; i < num_neighbors; ++i) {
+			iscc_hnsw_connect(index, work + num_cands, node, node_links[1 + i], level);
+		}
+
+		if (level == 0) break;
+		--level;
+	}
+
+	if (node_level > index->max_level) {
+		index->entry_point = node;
+		index->max_level = node_level;
+	}
+}
+
+
+// Adds `node` to the links of `neighbor`, pruning them if full
+static void iscc_hnsw_connect(iscc_hnsw_Index* const index,
+                              iscc_hnsw_Cand* const work,
+                              const uint32_t node,
+                              const uint32_t neighbor,
+                              const uint32_t level)
+{
+	const size_t max_neighbors = (level == 0) ? 2 * (size_t) index->m : index->m;
+	uint32_t* const links = iscc_hnsw_links(index, neighbor, level);
+
+	if (links[0] < max_neighbors) {
+		links[1 + links[0]] = node;
+		++links[0];
+		return;
+	}
+
+	const double* const neighbor_coords = index->coords + (size_t) neighbor * index->num_dimensions;
+	size_t num_cands = 0;
+	for (uint32_t i = 0; i <= links[0]; ++i) {
+		const uint32_t cand = (i < links[0]) ? links[1 + i] : node;
+		const iscc_hnsw_Cand add = { .sq_dist = iscc_hnsw_node_sq_dist(index, neighbor_coords, cand), .node = cand };
+		// Insertion sort, the lists are short
+		size_t j = num_cands;
+		for (; (j > 0) && (work[j - 1].sq_dist > add.sq_dist); --j) {
+			work[j] = work[j - 1];
+		}
+		work[j] = add;
+		++num_cands;
+	}
+
+	const size_t num_neighbors = iscc_hnsw_select_neighbors(index, work, num_cands, max_neighbors);
+	links[0] = (uint32_t) num_neighbors;
+	for (size_t i = 0; i < num_neighbors; ++i) {
+		links[1 + i] = work[i].node;
+	}
+}
+
+
+/* Selects neighbors with the heuristic of Malkov & Yashunin: a candidate is
+ * kept only if it is closer to the base point than to every kept neighbor,
+ * which keeps links in different directions. `cands` must be sorted by
+ * distance; the selected neighbors are moved to the front. */
+static size_t iscc_hnsw_select_neighbors(const iscc_hnsw_Index* const index,
+                                         iscc_hnsw_Cand* const cands,
+                                         const size_t num_cands,
+                                         const size_t max_neighbors)
+{
+	size_t num_selected = 0;
+	for (size_t c = 0; (c < num_cands) && (num_selected < max_neighbors); ++c) {
+		const double* const cand_coords = index->coords + (size_t) cands[c].node * index->num_dimensions;
+		bool keep = true;
+		for (size_t s = 0; s < num_selected; ++s) {
+			if (iscc_hnsw_node_sq_dist(index, cand_coords, cands[s].node) < cands[c].sq_dist) {
+				keep = false;
+				break;
+			}
+		}
+		if (keep) {
+			cands[num_selected] = cands[c];
+			++num_selected;
+		}
+	}
+	return num_selected;
+}
+
+
+// Greedy descent from the entry point down to `level_stop`, returns the closest node found
+static uint32_t iscc_hnsw_greedy_search(const iscc_hnsw_Index* const index,
+                                        const double* const query_coords,
+                                        const uint32_t level_stop)
+{
+	uint32_t current = index->entry_point;
+	double current_sq_dist = iscc_hnsw_node_sq_dist(index, query_coords, current);
+	for (uint32_t level = index->max_level; level >= level_stop; --level) {
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			const uint32_t* const links = iscc_hnsw_links(index, current, level);
+			for (uint32_t i = 1; i <= links[0]; ++i) {
+				const double sq_dist = iscc_hnsw_node_sq_dist(index, query_coords, links[i]);
+				if (sq_dist < current_sq_dist) {
+					current_sq_dist = sq_dist;
+					current = links[i];
+					changed = true;
+				}
+			}
+		}
+		if (level == 0) break;
+	}
+	return current;
+}
+
+
+// Beam search of width `ef` on `level`, the result is left in `scratch->results`
+static void iscc_hnsw_search_level(const iscc_hnsw_Index* const index,
+                                   iscc_hnsw_Scratch* const scratch,
+                                   const double* const query_coords,
+                                   const uint32_t entry_point,
+                                   const size_t ef,
+                                   const uint32_t level)
+{
+	assert(ef > 0);
+	assert(ef < scratch->capacity);
+
+	++scratch->visit_tag;
+	if (scratch->visit_tag == 0) {
+		memset(scratch->visited, 0, sizeof(uint32_t[index->num_points]));
+		scratch->visit_tag = 1;
+	}
+	const uint32_t tag = scratch->visit_tag;
+
+	scratch->num_candidates = 0;
+	scratch->num_results = 0;
+
+	const iscc_hnsw_Cand entry = { .sq_dist = iscc_hnsw_node_sq_dist(index, query_coords, entry_point), .node = entry_point };
+	scratch->visited[entry_point] = tag;
+	iscc_hnsw_heap_push(scratch->candidates, &scratch->num_candidates, entry, false);
+	iscc_hnsw_heap_push(scratch->results, &scratch->num_results, entry, true);
+
+	while (scratch->num_candidates > 0) {
+		const iscc_hnsw_Cand current = iscc_hnsw_heap_pop(scratch->candidates, &scratch->num_candidates, false);
+		if ((scratch->num_results >= ef) && (current.sq_dist > scratch->results[0].sq_dist)) break;
+
+		const uint32_t* const links = iscc_hnsw_links(index, current.node, level);
+		for (uint32_t i = 1; i <= links[0]; ++i) {
+			const uint32_t next = links[i];
+			if (scratch->visited[next] == tag) continue;
+			scratch->visited[next] = tag;
+
+			const double sq_dist = iscc_hnsw_node_sq_dist(index, query_coords, next);
+			if ((scratch->num_results < ef) || (sq_dist < scratch->results[0].sq_dist)) {
+				const iscc_hnsw_Cand add = { .sq_dist = sq_dist, .node = next };
+				iscc_hnsw_heap_push(scratch->results, &scratch->num_results, add, true);
+				if (scratch->num_results > ef) {
+					iscc_hnsw_heap_pop(scratch->results, &scratch->num_results, true);
+				}
+
+				if (scratch->num_candidates == scratch->capacity) {
+					// Candidates farther than the worst result are never expanded
+					const double bound = scratch->results[0].sq_dist;
+					size_t num_kept = 0;
+					for (size_t c = 0; c < scratch->num_candidates; ++c) {
+						if (scratch->candidates[c].sq_dist <= bound) {
+							iscc_hnsw_heap_push(scratch->candidates, &num_kept, scratch->candidates[c], false);
+						}
+					}
+					scratch->num_candidates = num_kept;
+					if (num_kept == scratch->capacity) continue;
+				}
+				iscc_hnsw_heap_push(scratch->candidates, &scratch->num_candidates, add, false);
+			}
+		}
+	}
+}
+
+
+// Empties the result heap into `out_sorted` in ascending order
+static size_t iscc_hnsw_sorted_results(iscc_hnsw_Scratch* const scratch,
+                                       iscc_hnsw_Cand* const out_sorted)
+{
+	const size_t num_results = scratch->num_results;
+	for (size_t i = num_results; i > 0; --i) {
+		out_sorted[i - 1] = iscc_hnsw_heap_pop(scratch->results, &scratch->num_results, true);
+	}
+	return num_results;
+}
+
+
+static size_t iscc_hnsw_search_range(const void* const search_object,
+                                     const size_t len_query_indices,
+                                     const scc_PointIndex query_indices[const],
+                                     const size_t query_offset,
+                                     const uint32_t k,
+                                     const bool radius_search,
+                                     const double radius,
+                                     double sort_scratch[const],
+                                     scc_PointIndex out_query_indices[const],
+                                     scc_PointIndex out_nn_indices[const])
+{
+	const iscc_hnsw_Index* const index = search_object;
+	const scc_DataSet* const data_set = index->data_set;
+	const double radius_sq = radius_search ? radius * radius : HUGE_VAL;
+
+	iscc_hnsw_Scratch* scratch = NULL;
+	if (index->links0 != NULL) {
+		scratch = &index->scratch[iscc_get_thread_num()];
+	}
+
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+		assert(query < data_set->num_data_points);
+		const double* const query_coords = &data_set->data_matrix[query * data_set->num_dimensions];
+
+		uint32_t found = 0;
+		bool graph_searched = false;
+		if (scratch != NULL) {
+			const size_t ef = (index->ef_search > k) ? index->ef_search : k;
+			const uint32_t entry_point = iscc_hnsw_greedy_search(index, query_coords, 1);
+			iscc_hnsw_search_level(index, scratch, query_coords, entry_point, ef, 0);
+
+			// Fewer than `k` results only if the graph is disconnected, then use brute force
+			if (scratch->num_results >= k) {
+				graph_searched = true;
+				while (scratch->num_results > k) {
+					iscc_hnsw_heap_pop(scratch->results, &scratch->num_results, true);
+				}
+				for (uint32_t i = k; i > 0; --i) {
+					const iscc_hnsw_Cand nn = iscc_hnsw_heap_pop(scratch->results, &scratch->num_results, true);
+					sort_scratch[i - 1] = nn.sq_dist;
+					index_write[i - 1] = index->point_indices[nn.node];
+				}
+				found = (sort_scratch[k - 1] <= radius_sq) ? k : 0;
+			}
+		}
+
+		if (!graph_searched) {
+			found = iscc_hnsw_brute_force(index, query_coords, k, radius_sq, sort_scratch, index_write);
+		}
+
+		assert(found == k || out_query_indices != NULL);
+		if (found == k) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	return num_ok_queries;
+}
+
+
+// Linear scan over all points, returns the number of points found within the radius (at most `k`)
+static uint32_t iscc_hnsw_brute_force(const iscc_hnsw_Index* const index,
+                                      const double* const query_coords,
+                                      const uint32_t k,
+                                      const double radius_sq,
+                                      double dist_list[const],
+                                      scc_PointIndex index_list[const])
+{
+	uint32_t found = 0;
+	for (uint32_t node = 0; node < (uint32_t) index->num_points; ++node) {
+		const double sq_dist = iscc_hnsw_node_sq_dist(index, query_coords, node);
+		if (sq_dist > radius_sq) continue;
+		if (found < k) {
+			iscc_add_dist_to_list(sq_dist, index->point_indices[node], dist_list + found, index_list + found, dist_list);
+			++found;
+		} else if (sq_dist < dist_list[k - 1]) {
+			iscc_add_dist_to_list(sq_dist, index->point_indices[node], dist_list + k - 1, index_list + k - 1, dist_list);
+		}
+	}
+	return found;
+}
+
+
+static bool iscc_hnsw_init_scratch(iscc_hnsw_Scratch* const scratch,
+                                   const size_t num_points,
+                                   const size_t capacity)
+{
+	*scratch = (iscc_hnsw_Scratch) {
+		.visited = calloc(num_points, sizeof(uint32_t)),
+		.visit_tag = 0,
+		.capacity = capacity,
+		.num_candidates = 0,
+		.candidates = malloc(sizeof(iscc_hnsw_Cand[capacity])),
+		.num_results = 0,
+		.results = malloc(sizeof(iscc_hnsw_Cand[capacity + 1])),
+	};
+	if ((scratch->visited == NULL) || (scratch->candidates == NULL) || (scratch->results == NULL)) {
+		iscc_hnsw_free_scratch(scratch);
+		return false;
+	}
+	return true;
+}
+
+
+static void iscc_hnsw_free_scratch(iscc_hnsw_Scratch* const scratch)
+{
+	free(scratch->visited);
+	free(scratch->candidates);
+	free(scratch->results);
+	*scratch = (iscc_hnsw_Scratch) { .visited = NULL };
+}
+
+
+// FNV-1a over the data matrix, identifies the population an index was built for
+static uint64_t iscc_hnsw_data_hash(const scc_DataSet* const data_set)
+{
+	const unsigned char* const bytes = (const unsigned char*) data_set->data_matrix;
+	const size_t len_bytes = sizeof(double[data_set->num_data_points * data_set->num_dimensions]);
+	uint64_t hash = 0xCBF29CE484222325u;
+	for (size_t i = 0; i < len_bytes; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3u;
+	}
+	return hash;
+}
+
+
+/* File layout (native byte order): magic, format version, size of
+ * `scc_PointIndex`, number of data points, number of dimensions, data hash,
+ * `m`, `ef_construction`, entry point, max level, `levels`, `links0` and
+ * `upper_links`. */
+
+static bool iscc_hnsw_save_index(const iscc_hnsw_Index* const index,
+                                 const char* const index_file)
+{
+	FILE* const file = fopen(index_file, "wb");
+	if (file == NULL) return false;
+
+	const uint32_t pointindex_size = (uint32_t) sizeof(scc_PointIndex);
+	const uint64_t num_points = (uint64_t) index->num_points;
+	const uint64_t num_dimensions = (uint64_t) index->num_dimensions;
+	const uint64_t data_hash = iscc_hnsw_data_hash(index->data_set);
+	const size_t len_links0 = index->num_points * (1 + 2 * (size_t) index->m);
+
+	bool ok = (fwrite(ISCC_HNSW_FILE_MAGIC, sizeof ISCC_HNSW_FILE_MAGIC, 1, file) == 1) &&
+	          (fwrite(&ISCC_HNSW_FILE_VERSION, sizeof(uint32_t), 1, file) == 1) &&
+	          (fwrite(&pointindex_size, sizeof(uint32_t), 1, file) == 1) &&
+	          (fwrite(&num_points, sizeof(uint64_t), 1, file) == 1) &&
+	          (fwrite(&num_dimensions, sizeof(uint64_t), 1, file) == 1) &&
+	          (fwrite(&data_hash, sizeof(uint64_t), 1, file) == 1) &&
+	          (fwrite(&index->m, sizeof(uint32_t), 1, file) == 1) &&
+	          (fwrite(&index->ef_construction, sizeof(uint32_t), 1, file) == 1) &&
+	          (fwrite(&index->entry_point, sizeof(uint32_t), 1, file) == 1) &&
+	          (fwrite(&index->max_level, sizeof(uint32_t), 1, file) == 1) &&
+	          (fwrite(index->levels, sizeof(uint32_t), index->num_points, file) == index->num_points) &&
+	          (fwrite(index->links0, sizeof(uint32_t), len_links0, file) == len_links0) &&
+	          (fwrite(index->upper_links, sizeof(uint32_t), index->len_upper_links, file) == index->len_upper_links);
+
+	if (fclose(file) != 0) ok = false;
+	if (!ok) remove(index_file);
+
+	return ok;
+}
+
+
+static bool iscc_hnsw_load_index(iscc_hnsw_Index* const index,
+                                 const char* const index_file)
+{
+	assert(index->levels == NULL);
+
+	FILE* const file = fopen(index_file, "rb");
+	if (file == NULL) return false;
+
+	char magic[sizeof ISCC_HNSW_FILE_MAGIC];
+	uint32_t file_version;
+	uint32_t pointindex_size;
+	uint64_t num_points;
+	uint64_t num_dimensions;
+	uint64_t data_hash;
+	uint32_t m;
+	uint32_t ef_construction;
+
+	bool ok = (fread(magic, sizeof magic, 1, file) == 1) &&
+	          (fread(&file_version, sizeof(uint32_t), 1, file) == 1) &&
+	          (fread(&pointindex_size, sizeof(uint32_t), 1, file) == 1) &&
+	          (fread(&num_points, sizeof(uint64_t), 1, file) == 1) &&
+	          (fread(&num_dimensions, sizeof(uint64_t), 1, file) == 1) &&
+	          (fread(&data_hash, sizeof(uint64_t), 1, file) == 1) &&
+	          (fread(&m, sizeof(uint32_t), 1, file) == 1) &&
+	          (fread(&ef_construction, sizeof(uint32_t), 1, file) == 1) &&
+	          (fread(&index->entry_point, sizeof(uint32_t), 1, file) == 1) &&
+	          (fread(&index->max_level, sizeof(uint32_t), 1, file) == 1);
+
+	ok = ok &&
+	     (memcmp(magic, ISCC_HNSW_FILE_MAGIC, sizeof magic) == 0) &&
+	     (file_version == ISCC_HNSW_FILE_VERSION) &&
+	     (pointindex_size == sizeof(scc_PointIndex)) &&
+	     (num_points == (uint64_t) index->num_points) &&
+	     (num_dimensions == (uint64_t) index->num_dimensions) &&
+	     (m == index->m) &&
+	     (ef_construction == index->ef_construction) &&
+	     (index->entry_point < index->num_points) &&
+	     (index->max_level <= ISCC_HNSW_MAX_LEVEL) &&
+	     (data_hash == iscc_hnsw_data_hash(index->data_set));
+
+	if (ok) {
+		index->levels = malloc(sizeof(uint32_t[index->num_points]));
+		ok = (index->levels != NULL) &&
+		     (fread(index->levels, sizeof(uint32_t), index->num_points, file) == index->num_points);
+	}
+	for (size_t i = 0; ok && (i < index->num_points); ++i) {
+		ok = (index->levels[i] <= index->max_level);
+	}
+
+	const size_t len_links0 = index->num_points * (1 + 2 * (size_t) index->m);
+	ok = ok &&
+	     iscc_hnsw_alloc_links(index) &&
+	     (fread(index->links0, sizeof(uint32_t), len_links0, file) == len_links0) &&
+	     (fread(index->upper_links, sizeof(uint32_t), index->len_upper_links, file) == index->len_upper_links) &&
+	     (fgetc(file) == EOF) &&
+	     iscc_hnsw_check_links(index);
+
+	fclose(file);
+
+	if (!ok) {
+		free(index->levels);
+		free(index->links0);
+		free(index->upper_offset);
+		free(index->upper_links);
+		index->levels = NULL;
+		index->links0 = NULL;
+		index->upper_offset = NULL;
+		index->upper_links = NULL;
+		index->len_upper_links = 0;
+		index->entry_point = 0;
+		index->max_level = 0;
+	}
+
+	return ok;
+}
+
+
+/* A loaded index is only searched if every link count fits its block and
+ * every neighbor exists on the level it is linked from, so that a corrupt
+ * file cannot make the search read outside the link tables. */
+
+static bool iscc_hnsw_check_links(const iscc_hnsw_Index* const index)
+{
+	assert(index->levels != NULL);
+	assert(index->links0 != NULL);
+
+	if (index->levels[index->entry_point] != index->max_level) return false;
+
+	for (size_t i = 0; i < index->num_points; ++i) {
+		const uint32_t node = (uint32_t) i;
+		for (uint32_t level = 0; level <= index->levels[i]; ++level) {
+			const uint32_t* const links = iscc_hnsw_links(index, node, level);
+			const uint32_t max_links = (level == 0) ? 2 * index->m : index->m;
+			if (links[0] > max_links) return false;
+			for (uint32_t j = 1; j <= links[0]; ++j) {
+				if (links[j] >= index->num_points) return false;
+				if (index->levels[links[j]] < level) return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+static inline uint32_t* iscc_hnsw_links(const iscc_hnsw_Index* const index,
+                                        const uint32_t node,
+                                        const uint32_t level)
+{
+	assert(level <= index->levels[node]);
+	if (level == 0) {
+		return index->links0 + (size_t) node * (1 + 2 * (size_t) index->m);
+	}
+	return index->upper_links + index->upper_offset[node] + (size_t) (level - 1) * (1 + (size_t) index->m);
+}
+
+
+static inline double iscc_hnsw_node_sq_dist(const iscc_hnsw_Index* const index,
+                                            const double* const query_coords,
+                                            const uint32_t node)
+{
+	return index->sq_dist(query_coords, index->coords + (size_t) node * index->num_dimensions, index->num_dimensions);
+}
+
+
+static inline bool iscc_hnsw_heap_before(const iscc_hnsw_Cand a,
+                                         const iscc_hnsw_Cand b,
+                                         const bool max_heap)
+{
+	return max_heap ? (a.sq_dist > b.sq_dist) : (a.sq_dist < b.sq_dist);
+}
+
+
+static inline void iscc_hnsw_heap_push(iscc_hnsw_Cand* const heap,
+                                       size_t* const len,
+                                       const iscc_hnsw_Cand add,
+                                       const bool max_heap)
+{
+	size_t i = *len;
+	++(*len);
+	while (i > 0) {
+		const size_t parent = (i - 1) / 2;
+		if (!iscc_hnsw_heap_before(add, heap[parent], max_heap)) break;
+		heap[i] = heap[parent];
+		i = parent;
+	}
+	heap[i] = add;
+}
+
+
+static inline iscc_hnsw_Cand iscc_hnsw_heap_pop(iscc_hnsw_Cand* const heap,
+                                                size_t* const len,
+                                                const bool max_heap)
+{
+	assert(*len > 0);
+	const iscc_hnsw_Cand top = heap[0];
+	--(*len);
+	const iscc_hnsw_Cand last = heap[*len];
+	size_t i = 0;
+	while (true) {
+		size_t child = 2 * i + 1;
+		if (child >= *len) break;
+		if ((child + 1 < *len) && iscc_hnsw_heap_before(heap[child + 1], heap[child], max_heap)) ++child;
+		if (!iscc_hnsw_heap_before(heap[child], last, max_heap)) break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = last;
+	return top;
+}
@@ -0,0 +1,94 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_DIST_SEARCH_HNSW_HG
+#define SCC_DIST_SEARCH_HNSW_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "../include/scclust_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Settings
+// =============================================================================
+
+/* Sets the parameters used by search objects created after the call. Zero
+ * selects the default for `m`, `ef_construction` and `ef_search`. If
+ * `index_file` is not NULL, indices over all data points are read from
+ * and written to this file. See `scc_set_hnsw_dist_search`. */
+bool iscc_hnsw_set_parameters(uint32_t m,
+                              uint32_t ef_construction,
+                              uint32_t ef_search,
+                              const char* index_file);
+
+typedef struct iscc_hnsw_Settings iscc_hnsw_Settings;
+
+/* Allocates settings with the same parameters as `iscc_hnsw_set_parameters`,
+ * to be the `user_data` of a distance backend with the HNSW functions. The
+ * search objects of such a backend use these settings rather than the
+ * global ones. Free with `free`. */
+scc_ErrorCode iscc_hnsw_make_settings(uint32_t m,
+                                      uint32_t ef_construction,
+                                      uint32_t ef_search,
+                                      const char* index_file,
+                                      iscc_hnsw_Settings** out_settings);
+
+
+// =============================================================================
+// Nearest neighbor search functions
+// =============================================================================
+
+/* Approximate nearest neighbor search with a hierarchical navigable small
+ * world (HNSW) graph over the search points. The functions follow the
+ * semantics of the `iscc_imp_*` search functions and accept only
+ * `scc_DataSet` data sets, but the returned neighbors may differ from the
+ * exact nearest neighbors. */
+
+bool iscc_hnsw_init_nn_search_object(void* data_set,
+                                     size_t len_search_indices,
+                                     const scc_PointIndex search_indices[],
+                                     iscc_NNSearchObject** out_nn_search_object);
+
+// `out_nn_indices` must be of length `k * len_query_indices`
+bool iscc_hnsw_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
+                                       size_t len_query_indices,
+                                       const scc_PointIndex query_indices[],
+                                       uint32_t k,
+                                       bool radius_search,
+                                       double radius,
+                                       size_t* out_num_ok_queries,
+                                       scc_PointIndex out_query_indices[],
+                                       scc_PointIndex out_nn_indices[]);
+
+bool iscc_hnsw_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_DIST_SEARCH_HNSW_HG
@@ -24,9 +24,14 @@
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "../include/scclust.h"
 #include "data_set_struct.h"
+#include "dist_kernels.h"
+#include "dist_search_list.h"
+#include "parallel.h"
 #include "scclust_types.h"
 
 
@@ -34,25 +39,309 @@
 // Distance calculations
 // =============================================================================
 
-static inline double iscc_get_sq_dist(const scc_DataSet* const data_set,
+static inline double iscc_get_sq_dist(const iscc_SqDistKernel sq_dist,
+                                      const scc_DataSet* const data_set,
                                       const size_t index1,
                                       const size_t index2)
 {
+	assert(sq_dist != NULL);
 	assert(index1 < data_set->num_data_points);
 	assert(index2 < data_set->num_data_points);
 
-	const double* data1 = &data_set->data_matrix[index1 * data_set->num_dimensions];
-	const double* const data1_stop = data1 + data_set->num_dimensions;
-	const double* data2 = &data_set->data_matrix[index2 * data_set->num_dimensions];
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	switch (data_set->data_type) {
+		case ISCC_DT_FLOAT:
+			return iscc_sq_dist_float(&data_set->float_matrix[index1 * num_dimensions],
+			                          &data_set->float_matrix[index2 * num_dimensions],
+			                          num_dimensions);
+		case ISCC_DT_UINT8:
+			return data_set->uint8_scale * data_set->uint8_scale *
+			       (double) iscc_sq_dist_uint8(&data_set->uint8_matrix[index1 * num_dimensions],
+			                                   &data_set->uint8_matrix[index2 * num_dimensions],
+			                                   num_dimensions);
+		default:
+			assert(data_set->data_type == ISCC_DT_DOUBLE);
+			return sq_dist(&data_set->data_matrix[index1 * num_dimensions],
+			               &data_set->data_matrix[index2 * num_dimensions],
+			               num_dimensions);
+	}
+}
+
+
+// Squared distance using the double precision copy of a low precision data set
+static inline double iscc_get_rerank_sq_dist(const iscc_SqDistKernel sq_dist,
+                                             const scc_DataSet* const data_set,
+                                             const size_t index1,
+                                             const size_t index2)
+{
+	assert(sq_dist != NULL);
+	assert(data_set->rerank_matrix != NULL);
+	assert(index1 < data_set->num_data_points);
+	assert(index2 < data_set->num_data_points);
 
-	double tmp_dist = 0.0;
-	while (data1 != data1_stop) {
-		const double value_diff = (*data1 - *data2);
-		++data1;
-		++data2;
-		tmp_dist += value_diff * value_diff;
+	return sq_dist(&data_set->rerank_matrix[index1 * data_set->num_dimensions],
+	               &data_set->rerank_matrix[index2 * data_set->num_dimensions],
+	               data_set->num_dimensions);
+}
+
+
+// Copy the coordinates of a point into `out_coords` (with stride `stride`) and return its squared norm
+static inline double iscc_load_point(const scc_DataSet* const data_set,
+                                     const size_t point,
+                                     double* const out_coords,
+                                     const size_t stride)
+{
+	assert(point < data_set->num_data_points);
+
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	double norm = 0.0;
+	switch (data_set->data_type) {
+		case ISCC_DT_FLOAT:
+		{
+			const float* const point_data = &data_set->float_matrix[point * num_dimensions];
+			for (size_t k = 0; k < num_dimensions; ++k) {
+				out_coords[k * stride] = (double) point_data[k];
+				norm += out_coords[k * stride] * out_coords[k * stride];
+			}
+			break;
+		}
+		case ISCC_DT_UINT8:
+		{
+			const uint8_t* const point_data = &data_set->uint8_matrix[point * num_dimensions];
+			for (size_t k = 0; k < num_dimensions; ++k) {
+				out_coords[k * stride] = data_set->uint8_scale * (double) point_data[k];
+				norm += out_coords[k * stride] * out_coords[k * stride];
+			}
+			break;
+		}
+		default:
+		{
+			assert(data_set->data_type == ISCC_DT_DOUBLE);
+			const double* const point_data = &data_set->data_matrix[point * num_dimensions];
+			for (size_t k = 0; k < num_dimensions; ++k) {
+				out_coords[k * stride] = point_data[k];
+				norm += point_data[k] * point_data[k];
+			}
+			break;
+		}
+	}
+	return norm;
+}
+
+
+// =============================================================================
+// Distance tiles
+// =============================================================================
+
+/* Distances between two sets of points are derived in tiles. The query and
+ * column points of a tile are gathered into contiguous panels together with
+ * their squared norms, and the squared distances are derived with the
+ * expansion ||a||^2 + ||b||^2 - 2<a,b>. The inner products are computed
+ * with a 4x4 register-blocked micro-kernel. The column panel is stored
+ * dimension-major so the four columns of a block are adjacent in memory.
+ *
+ * The expansion suffers from cancellation when the distance is small
+ * relative to the norms; such distances are recomputed directly.
+ */
+
+// Upper bound on panel sizes (in number of doubles)
+#define ISCC_TILE_QUERY_PANEL_DOUBLES 8192
+#define ISCC_TILE_COLUMN_PANEL_DOUBLES 32768
+#define ISCC_TILE_MAX_QUERY_ROWS 64
+#define ISCC_TILE_MAX_COLUMN_COLS 256
+
+// Recompute squared distances smaller than this fraction of the norms
+static const double ISCC_TILE_RECOMPUTE_TOL = 1e-6;
+
+typedef struct iscc_DistTiles iscc_DistTiles;
+struct iscc_DistTiles {
+	const scc_DataSet* data_set;
+	iscc_SqDistKernel sq_dist;
+	size_t max_query_rows;
+	size_t max_column_cols;
+	double* query_panel;
+	double* query_norms;
+	size_t* query_points;
+	double* column_panel;
+	double* column_norms;
+	size_t* column_points;
+	double* tile_out;
+};
+
+
+static size_t iscc_tile_panel_size(const size_t len_indices,
+                                   const size_t max_size,
+                                   const size_t panel_doubles,
+                                   const size_t num_dimensions)
+{
+	size_t panel_size = panel_doubles / num_dimensions;
+	if (panel_size > max_size) panel_size = max_size;
+	panel_size -= panel_size % 4;
+	if (panel_size < 4) panel_size = 4;
+	if (panel_size > len_indices) panel_size = len_indices;
+	return panel_size;
+}
+
+
+static void iscc_free_dist_tiles(iscc_DistTiles* const tiles)
+{
+	assert(tiles != NULL);
+	free(tiles->query_panel);
+	free(tiles->query_norms);
+	free(tiles->query_points);
+	free(tiles->column_panel);
+	free(tiles->column_norms);
+	free(tiles->column_points);
+	free(tiles->tile_out);
+	*tiles = (iscc_DistTiles) { .data_set = NULL };
+}
+
+
+static bool iscc_init_dist_tiles(const scc_DataSet* const data_set,
+                                 const size_t len_query_indices,
+                                 const size_t len_column_indices,
+                                 iscc_DistTiles* const out_tiles)
+{
+	assert(data_set != NULL);
+	assert(len_query_indices > 0);
+	assert(len_column_indices > 0);
+	assert(out_tiles != NULL);
+
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	const size_t max_query_rows = iscc_tile_panel_size(len_query_indices,
+	                                                   ISCC_TILE_MAX_QUERY_ROWS,
+	                                                   ISCC_TILE_QUERY_PANEL_DOUBLES,
+	                                                   num_dimensions);
+	const size_t max_column_cols = iscc_tile_panel_size(len_column_indices,
+	                                                    ISCC_TILE_MAX_COLUMN_COLS,
+	                                                    ISCC_TILE_COLUMN_PANEL_DOUBLES,
+	                                                    num_dimensions);
+
+	*out_tiles = (iscc_DistTiles) {
+		.data_set = data_set,
+		.sq_dist = iscc_get_sq_dist_kernel(),
+		.max_query_rows = max_query_rows,
+		.max_column_cols = max_column_cols,
+		.query_panel = malloc(sizeof(double[max_query_rows * num_dimensions])),
+		.query_norms = malloc(sizeof(double[max_query_rows])),
+		.query_points = malloc(sizeof(size_t[max_query_rows])),
+		.column_panel = malloc(sizeof(double[max_column_cols * num_dimensions])),
+		.column_norms = malloc(sizeof(double[max_column_cols])),
+		.column_points = malloc(sizeof(size_t[max_column_cols])),
+		.tile_out = malloc(sizeof(double[max_query_rows * max_column_cols])),
+	};
+
+	if ((out_tiles->query_panel == NULL) ||
+	        (out_tiles->query_norms == NULL) ||
+	        (out_tiles->query_points == NULL) ||
+	        (out_tiles->column_panel == NULL) ||
+	        (out_tiles->column_norms == NULL) ||
+	        (out_tiles->column_points == NULL) ||
+	        (out_tiles->tile_out == NULL)) {
+		iscc_free_dist_tiles(out_tiles);
+		return false;
+	}
+
+	return true;
+}
+
+
+static void iscc_gather_query_panel(iscc_DistTiles* const tiles,
+                                    const scc_PointIndex indices[const],
+                                    const size_t start,
+                                    const size_t len)
+{
+	assert(len <= tiles->max_query_rows);
+	const size_t num_dimensions = (size_t) tiles->data_set->num_dimensions;
+
+	for (size_t i = 0; i < len; ++i) {
+		const size_t point = (indices == NULL) ? start + i : (size_t) indices[start + i];
+		tiles->query_points[i] = point;
+		tiles->query_norms[i] = iscc_load_point(tiles->data_set, point, tiles->query_panel + i * num_dimensions, 1);
+	}
+}
+
+
+static void iscc_gather_column_panel(iscc_DistTiles* const tiles,
+                                     const scc_PointIndex indices[const],
+                                     const size_t start,
+                                     const size_t len)
+{
+	assert(len <= tiles->max_column_cols);
+
+	for (size_t j = 0; j < len; ++j) {
+		const size_t point = (indices == NULL) ? start + j : (size_t) indices[start + j];
+		tiles->column_points[j] = point;
+		tiles->column_norms[j] = iscc_load_point(tiles->data_set, point, tiles->column_panel + j, len);
+	}
+}
+
+
+static inline double iscc_tile_dist_from_dot(const iscc_DistTiles* const tiles,
+                                             const size_t q,
+                                             const size_t c,
+                                             const double dot)
+{
+	const double norm_sum = tiles->query_norms[q] + tiles->column_norms[c];
+	const double sq_dist = norm_sum - 2.0 * dot;
+	if (sq_dist > ISCC_TILE_RECOMPUTE_TOL * norm_sum) {
+		return sqrt(sq_dist);
+	}
+	return sqrt(iscc_get_sq_dist(tiles->sq_dist, tiles->data_set, tiles->query_points[q], tiles->column_points[c]));
+}
+
+
+static void iscc_compute_dist_tile(const iscc_DistTiles* const tiles,
+                                   const size_t len_query,
+                                   const size_t len_column,
+                                   double output_dists[const],
+                                   const size_t output_stride)
+{
+	assert(len_query <= tiles->max_query_rows);
+	assert(len_column <= tiles->max_column_cols);
+
+	const size_t num_dimensions = (size_t) tiles->data_set->num_dimensions;
+	const double* const q_panel = tiles->query_panel;
+	const double* const c_panel = tiles->column_panel;
+	const size_t q_blocked = len_query - (len_query % 4);
+	const size_t c_blocked = len_column - (len_column % 4);
+
+	for (size_t q = 0; q < q_blocked; q += 4) {
+		const double* const q0 = q_panel + q * num_dimensions;
+		const double* const q1 = q0 + num_dimensions;
+		const double* const q2 = q1 + num_dimensions;
+		const double* const q3 = q2 + num_dimensions;
+
+		for (size_t c = 0; c < c_blocked; c += 4) {
+			double acc[4][4] = { { 0.0 } };
+			const double* c_col = c_panel + c;
+			for (size_t k = 0; k < num_dimensions; ++k, c_col += len_column) {
+				for (size_t j = 0; j < 4; ++j) {
+					acc[0][j] += q0[k] * c_col[j];
+					acc[1][j] += q1[k] * c_col[j];
+					acc[2][j] += q2[k] * c_col[j];
+					acc[3][j] += q3[k] * c_col[j];
+				}
+			}
+			for (size_t i = 0; i < 4; ++i) {
+				for (size_t j = 0; j < 4; ++j) {
+					output_dists[(q + i) * output_stride + c + j] = iscc_tile_dist_from_dot(tiles, q + i, c + j, acc[i][j]);
+				}
+			}
+		}
+	}
+
+	// Edges not covered by the 4x4 blocks
+	for (size_t q = 0; q < len_query; ++q) {
+		const double* const q_row = q_panel + q * num_dimensions;
+		for (size_t c = (q < q_blocked) ? c_blocked : 0; c < len_column; ++c) {
+			double dot = 0.0;
+			for (size_t k = 0; k < num_dimensions; ++k) {
+				dot += q_row[k] * c_panel[k * len_column + c];
+			}
+			output_dists[q * output_stride + c] = iscc_tile_dist_from_dot(tiles, q, c, dot);
+		}
 	}
-	return tmp_dist;
 }
 
 
@@ -80,22 +369,38 @@ bool iscc_imp_get_dist_matrix(void* const data_set,
 	assert(len_point_indices > 1);
 	assert(output_dists != NULL);
 
-	if (point_indices == NULL) {
-		for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
-			for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, p1, p2));
-				++output_dists;
-			}
-		}
-	} else {
-		for (size_t p1 = 0; p1 < len_point_indices; ++p1) {
-			for (size_t p2 = p1 + 1; p2 < len_point_indices; ++p2) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) point_indices[p1], (size_t) point_indices[p2]));
-				++output_dists;
+	iscc_DistTiles tiles;
+	if (!iscc_init_dist_tiles(data_set, len_point_indices, len_point_indices, &tiles)) return false;
+
+	for (size_t q_start = 0; q_start < len_point_indices; q_start += tiles.max_query_rows) {
+		size_t q_len = len_point_indices - q_start;
+		if (q_len > tiles.max_query_rows) q_len = tiles.max_query_rows;
+		iscc_gather_query_panel(&tiles, point_indices, q_start, q_len);
+
+		// Only tiles with parts above the diagonal are needed
+		for (size_t c_start = q_start - (q_start % tiles.max_column_cols); c_start < len_point_indices; c_start += tiles.max_column_cols) {
+			size_t c_len = len_point_indices - c_start;
+			if (c_len > tiles.max_column_cols) c_len = tiles.max_column_cols;
+			iscc_gather_column_panel(&tiles, point_indices, c_start, c_len);
+			iscc_compute_dist_tile(&tiles, q_len, c_len, tiles.tile_out, c_len);
+
+			// Copy upper triangle into the packed output
+			for (size_t q = 0; q < q_len; ++q) {
+				const size_t p1 = q_start + q;
+				size_t p2 = p1 + 1;
+				if (p2 < c_start) p2 = c_start;
+				if (p2 >= c_start + c_len) continue;
+				// Position of (p1, p2) in the packed upper triangle
+				const size_t out_pos = p1 * len_point_indices - (p1 * (p1 + 1)) / 2 + p2 - p1 - 1;
+				memcpy(output_dists + out_pos,
+				       tiles.tile_out + q * c_len + (p2 - c_start),
+				       sizeof(double[c_start + c_len - p2]));
 			}
 		}
 	}
 
+	iscc_free_dist_tiles(&tiles);
+
 	return true;
 }
 
@@ -112,39 +417,25 @@ bool iscc_imp_get_dist_rows(void* const data_set,
 	assert(len_column_indices > 0);
 	assert(output_dists != NULL);
 
-	if ((query_indices != NULL) && (column_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) query_indices[q], (size_t) column_indices[c]));
-				++output_dists;
-			}
-		}
-
-	} else if ((query_indices == NULL) && (column_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, q, (size_t) column_indices[c]));
-				++output_dists;
-			}
-		}
+	iscc_DistTiles tiles;
+	if (!iscc_init_dist_tiles(data_set, len_query_indices, len_column_indices, &tiles)) return false;
 
-	} else if ((query_indices != NULL) && (column_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, (size_t) query_indices[q], c));
-				++output_dists;
-			}
-		}
+	// Column panels in the outer loop so each is gathered only once
+	for (size_t c_start = 0; c_start < len_column_indices; c_start += tiles.max_column_cols) {
+		size_t c_len = len_column_indices - c_start;
+		if (c_len > tiles.max_column_cols) c_len = tiles.max_column_cols;
+		iscc_gather_column_panel(&tiles, column_indices, c_start, c_len);
 
-	} else if ((query_indices == NULL) && (column_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			for (size_t c = 0; c < len_column_indices; ++c) {
-				*output_dists = sqrt(iscc_get_sq_dist(data_set, q, c));
-				++output_dists;
-			}
+		for (size_t q_start = 0; q_start < len_query_indices; q_start += tiles.max_query_rows) {
+			size_t q_len = len_query_indices - q_start;
+			if (q_len > tiles.max_query_rows) q_len = tiles.max_query_rows;
+			iscc_gather_query_panel(&tiles, query_indices, q_start, q_len);
+			iscc_compute_dist_tile(&tiles, q_len, c_len, output_dists + q_start * len_column_indices + c_start, len_column_indices);
 		}
 	}
 
+	iscc_free_dist_tiles(&tiles);
+
 	return true;
 }
 
@@ -153,14 +444,186 @@ bool iscc_imp_get_dist_rows(void* const data_set,
 // Max dist functions implementations
 // =============================================================================
 
+/* Search sets with at least `ISCC_MAXDIST_MIN_BOXED` points of a double
+ * precision data set are split at the median along the dimension with the
+ * largest spread until the groups contain at most `ISCC_MAXDIST_LEAF_SIZE`
+ * points, and the bounding box of each group is stored. The distance between
+ * a query and the farthest corner of a box bounds the distances to the points
+ * in the group. A query first scans the group with the largest bound, and
+ * then only the groups whose bounds are not below the farthest distance
+ * found. Ties are resolved by the position in `search_indices`, so the
+ * result is the same as a full scan. The bounds are rounded, so groups are
+ * skipped only when their bound is below the distance by `ISCC_MAXDIST_BOUND_TOL`. */
+
+#define ISCC_MAXDIST_LEAF_SIZE 32
+
+static const size_t ISCC_MAXDIST_MIN_BOXED = 256;
+
+static const double ISCC_MAXDIST_BOUND_TOL = 1e-9;
+
+// Minimum number of query-search pairs to search for the farthest points in parallel
+static const size_t ISCC_MAXDIST_MIN_PARALLEL_WORK = 1 << 18;
+
 struct iscc_MaxDistObject {
 	int32_t max_dist_version;
+	iscc_SqDistKernel sq_dist;
 	scc_DataSet* data_set;
 	size_t len_search_indices;
 	const scc_PointIndex* search_indices;
+	size_t num_leaves;
+	size_t* leaf_positions;
+	size_t* leaf_starts;
+	double* leaf_boxes;
 };
 
-static const int32_t ISCC_MAXDIST_STRUCT_VERSION = 722439001;
+static const int32_t ISCC_MAXDIST_STRUCT_VERSION = 722439002;
+
+
+static inline size_t iscc_max_dist_row(const iscc_MaxDistObject* const max_dist_object,
+                                       const size_t position)
+{
+	return (max_dist_object->search_indices == NULL) ? position : (size_t) max_dist_object->search_indices[position];
+}
+
+
+// Partially sorts `positions` along `dim` so that element `nth` is at its sorted position
+static void iscc_max_dist_select(const iscc_MaxDistObject* const max_dist_object,
+                                 const size_t dim,
+                                 size_t* const positions,
+                                 const size_t len,
+                                 const size_t nth)
+{
+	assert(nth < len);
+
+	const double* const data_matrix = max_dist_object->data_set->data_matrix;
+	const size_t num_dimensions = (size_t) max_dist_object->data_set->num_dimensions;
+
+	size_t left = 0;
+	size_t right = len - 1;
+	while (left < right) {
+		const double pivot = data_matrix[iscc_max_dist_row(max_dist_object, positions[left + (right - left) / 2]) * num_dimensions + dim];
+		size_t less_stop = left;
+		size_t greater_start = right + 1;
+		size_t i = left;
+		while (i < greater_start) {
+			const double value = data_matrix[iscc_max_dist_row(max_dist_object, positions[i]) * num_dimensions + dim];
+			if (value < pivot) {
+				const size_t tmp = positions[less_stop];
+				positions[less_stop] = positions[i];
+				positions[i] = tmp;
+				++less_stop;
+				++i;
+			} else if (value > pivot) {
+				--greater_start;
+				const size_t tmp = positions[greater_start];
+				positions[greater_start] = positions[i];
+				positions[i] = tmp;
+			} else {
+				++i;
+			}
+		}
+
+		if (nth < less_stop) {
+			right = less_stop - 1;
+		} else if (nth >= greater_start) {
+			left = greater_start;
+		} else {
+			return;
+		}
+	}
+}
+
+
+// Splits `leaf_positions[start:stop]` into leaves and stores their bounding boxes
+static void iscc_max_dist_split(iscc_MaxDistObject* const max_dist_object,
+                                const size_t start,
+                                const size_t stop)
+{
+	assert(start < stop);
+
+	const double* const data_matrix = max_dist_object->data_set->data_matrix;
+	const size_t num_dimensions = (size_t) max_dist_object->data_set->num_dimensions;
+	size_t* const positions = max_dist_object->leaf_positions + start;
+	const size_t len = stop - start;
+
+	double* const box_lower = max_dist_object->leaf_boxes + 2 * num_dimensions * max_dist_object->num_leaves;
+	double* const box_upper = box_lower + num_dimensions;
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		box_lower[d] = box_upper[d] = data_matrix[iscc_max_dist_row(max_dist_object, positions[0]) * num_dimensions + d];
+	}
+	for (size_t i = 1; i < len; ++i) {
+		const double* const point_data = &data_matrix[iscc_max_dist_row(max_dist_object, positions[i]) * num_dimensions];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			if (point_data[d] < box_lower[d]) box_lower[d] = point_data[d];
+			if (point_data[d] > box_upper[d]) box_upper[d] = point_data[d];
+		}
+	}
+
+	if (len <= ISCC_MAXDIST_LEAF_SIZE) {
+		max_dist_object->leaf_starts[max_dist_object->num_leaves] = start;
+		++max_dist_object->num_leaves;
+		return;
+	}
+
+	// The box of a split group is overwritten by its first leaf
+	size_t split_dim = 0;
+	for (size_t d = 1; d < num_dimensions; ++d) {
+		if (box_upper[d] - box_lower[d] > box_upper[split_dim] - box_lower[split_dim]) split_dim = d;
+	}
+
+	const size_t mid = len / 2;
+	iscc_max_dist_select(max_dist_object, split_dim, positions, len, mid);
+	iscc_max_dist_split(max_dist_object, start, start + mid);
+	iscc_max_dist_split(max_dist_object, start + mid, stop);
+}
+
+
+// Finds the farthest search point from `query` using the leaf boxes
+static void iscc_max_dist_boxed(const iscc_MaxDistObject* const max_dist_object,
+                                const size_t query,
+                                double leaf_bounds[const],
+                                scc_PointIndex* const out_max_index,
+                                double* const out_max_dist)
+{
+	const iscc_SqDistKernel sq_dist = max_dist_object->sq_dist;
+	const scc_DataSet* const data_set = max_dist_object->data_set;
+	const size_t num_dimensions = (size_t) data_set->num_dimensions;
+	const size_t num_leaves = max_dist_object->num_leaves;
+	const double* const query_data = &data_set->data_matrix[query * num_dimensions];
+
+	size_t first_leaf = 0;
+	for (size_t l = 0; l < num_leaves; ++l) {
+		const double* const box_lower = max_dist_object->leaf_boxes + 2 * num_dimensions * l;
+		const double* const box_upper = box_lower + num_dimensions;
+		double bound = 0.0;
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			const double to_lower = query_data[d] - box_lower[d];
+			const double to_upper = box_upper[d] - query_data[d];
+			const double farthest = (to_lower > to_upper) ? to_lower : to_upper;
+			bound += farthest * farthest;
+		}
+		leaf_bounds[l] = bound * (1.0 + ISCC_MAXDIST_BOUND_TOL);
+		if (leaf_bounds[l] > leaf_bounds[first_leaf]) first_leaf = l;
+	}
+
+	double max_dist = -1.0;
+	size_t max_position = 0;
+	for (size_t i = 0; i <= num_leaves; ++i) {
+		const size_t l = (i == 0) ? first_leaf : i - 1;
+		if ((i > 0) && ((l == first_leaf) || (leaf_bounds[l] < max_dist))) continue;
+		for (size_t p = max_dist_object->leaf_starts[l]; p < max_dist_object->leaf_starts[l + 1]; ++p) {
+			const size_t position = max_dist_object->leaf_positions[p];
+			const double tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, iscc_max_dist_row(max_dist_object, position));
+			if ((max_dist < tmp_dist) || (!(tmp_dist < max_dist) && (position < max_position))) {
+				max_dist = tmp_dist;
+				max_position = position;
+			}
+		}
+	}
+
+	*out_max_index = (scc_PointIndex) iscc_max_dist_row(max_dist_object, max_position);
+	*out_max_dist = sqrt(max_dist);
+}
 
 
 bool iscc_imp_init_max_dist_object(void* const data_set,
@@ -172,46 +635,80 @@ bool iscc_imp_init_max_dist_object(void* const data_set,
 	assert(len_search_indices > 0);
 	assert(out_max_dist_object != NULL);
 
-	*out_max_dist_object = malloc(sizeof(iscc_MaxDistObject));
-	if (*out_max_dist_object == NULL) return false;
+	iscc_MaxDistObject* const max_dist_object = malloc(sizeof(iscc_MaxDistObject));
+	if (max_dist_object == NULL) return false;
 
-	**out_max_dist_object = (iscc_MaxDistObject) {
+	*max_dist_object = (iscc_MaxDistObject) {
 		.max_dist_version = ISCC_MAXDIST_STRUCT_VERSION,
+		.sq_dist = iscc_get_sq_dist_kernel(),
 		.data_set = data_set,
 		.len_search_indices = len_search_indices,
 		.search_indices = search_indices,
+		.num_leaves = 0,
+		.leaf_positions = NULL,
+		.leaf_starts = NULL,
+		.leaf_boxes = NULL,
 	};
 
+	const scc_DataSet* const data_set_cast = data_set;
+	if ((data_set_cast->data_type == ISCC_DT_DOUBLE) && (len_search_indices >= ISCC_MAXDIST_MIN_BOXED)) {
+		// Leaves have at least `ISCC_MAXDIST_LEAF_SIZE / 2` points
+		const size_t max_leaves = len_search_indices / (ISCC_MAXDIST_LEAF_SIZE / 2);
+		const size_t num_dimensions = (size_t) data_set_cast->num_dimensions;
+		max_dist_object->leaf_positions = malloc(sizeof(size_t[len_search_indices]));
+		max_dist_object->leaf_starts = malloc(sizeof(size_t[max_leaves + 1]));
+		max_dist_object->leaf_boxes = malloc(sizeof(double[2 * num_dimensions * max_leaves]));
+		if ((max_dist_object->leaf_positions == NULL) || (max_dist_object->leaf_starts == NULL) ||
+		        (max_dist_object->leaf_boxes == NULL)) {
+			iscc_MaxDistObject* tmp_object = max_dist_object;
+			iscc_imp_close_max_dist_object(&tmp_object);
+			return false;
+		}
+
+		for (size_t i = 0; i < len_search_indices; ++i) {
+			max_dist_object->leaf_positions[i] = i;
+		}
+		iscc_max_dist_split(max_dist_object, 0, len_search_indices);
+		assert(max_dist_object->num_leaves <= max_leaves);
+		max_dist_object->leaf_starts[max_dist_object->num_leaves] = len_search_indices;
+	}
+
+	*out_max_dist_object = max_dist_object;
+
 	return true;
 }
 
 
-bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
-                           const size_t len_query_indices,
-                           const scc_PointIndex query_indices[const],
-                           scc_PointIndex out_max_indices[const],
-                           double out_max_dists[const])
+// Finds the farthest search points from the queries at positions `q_start` to `q_stop`
+static void iscc_max_dist_queries(const iscc_MaxDistObject* const max_dist_object,
+                                  const size_t q_start,
+                                  const size_t q_stop,
+                                  const scc_PointIndex query_indices[const],
+                                  double leaf_bounds[const],
+                                  scc_PointIndex out_max_indices[const],
+                                  double out_max_dists[const])
 {
-	assert(max_dist_object != NULL);
-	assert(max_dist_object->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
+	const iscc_SqDistKernel sq_dist = max_dist_object->sq_dist;
 	scc_DataSet* const data_set = max_dist_object->data_set;
 	const size_t len_search_indices = max_dist_object->len_search_indices;
 	const scc_PointIndex* const search_indices = max_dist_object->search_indices;
 
-	assert(iscc_imp_check_data_set(data_set, 0));
-	assert(len_search_indices > 0);
-	assert(len_query_indices > 0);
-	assert(out_max_indices != NULL);
-	assert(out_max_dists != NULL);
+	if (max_dist_object->num_leaves > 0) {
+		for (size_t q = q_start; q < q_stop; ++q) {
+			const size_t query = (query_indices == NULL) ? q : (size_t) query_indices[q];
+			iscc_max_dist_boxed(max_dist_object, query, leaf_bounds, &out_max_indices[q], &out_max_dists[q]);
+		}
+		return;
+	}
 
 	double tmp_dist;
 	double max_dist;
 
 	if ((query_indices != NULL) && (search_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
+		for (size_t q = q_start; q < q_stop; ++q) {
 			max_dist = -1.0;
 			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, (size_t) query_indices[q], (size_t) search_indices[s]);
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, (size_t) query_indices[q], (size_t) search_indices[s]);
 				if (max_dist < tmp_dist) {
 					max_dist = tmp_dist;
 					out_max_indices[q] = search_indices[s];
@@ -221,10 +718,10 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
 		}
 
 	} else if ((query_indices == NULL) && (search_indices != NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
+		for (size_t q = q_start; q < q_stop; ++q) {
 			max_dist = -1.0;
 			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, q, (size_t) search_indices[s]);
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, q, (size_t) search_indices[s]);
 				if (max_dist < tmp_dist) {
 					max_dist = tmp_dist;
 					out_max_indices[q] = search_indices[s];
@@ -234,10 +731,10 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
 		}
 
 	} else if ((query_indices != NULL) && (search_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
+		for (size_t q = q_start; q < q_stop; ++q) {
 			max_dist = -1.0;
 			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, (size_t) query_indices[q], s);
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, (size_t) query_indices[q], s);
 				if (max_dist < tmp_dist) {
 					max_dist = tmp_dist;
 					out_max_indices[q] = (scc_PointIndex) s;
@@ -247,10 +744,10 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
 		}
 
 	} else if ((query_indices == NULL) && (search_indices == NULL)) {
-		for (size_t q = 0; q < len_query_indices; ++q) {
+		for (size_t q = q_start; q < q_stop; ++q) {
 			max_dist = -1.0;
 			for (size_t s = 0; s < len_search_indices; ++s) {
-				tmp_dist = iscc_get_sq_dist(data_set, q, s);
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, q, s);
 				if (max_dist < tmp_dist) {
 					max_dist = tmp_dist;
 					out_max_indices[q] = (scc_PointIndex) s;
@@ -260,6 +757,47 @@ bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
 		}
 	}
 
+}
+
+
+bool iscc_imp_get_max_dist(iscc_MaxDistObject* const max_dist_object,
+                           const size_t len_query_indices,
+                           const scc_PointIndex query_indices[const],
+                           scc_PointIndex out_max_indices[const],
+                           double out_max_dists[const])
+{
+	assert(max_dist_object != NULL);
+	assert(max_dist_object->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
+	assert(iscc_imp_check_data_set(max_dist_object->data_set, 0));
+	assert(max_dist_object->len_search_indices > 0);
+	assert(len_query_indices > 0);
+	assert(out_max_indices != NULL);
+	assert(out_max_dists != NULL);
+
+	// The queries are split into one contiguous chunk per thread when there is enough work
+	size_t num_chunks = 1;
+	if (len_query_indices * max_dist_object->len_search_indices >= ISCC_MAXDIST_MIN_PARALLEL_WORK) {
+		num_chunks = (size_t) iscc_get_num_threads();
+		if (num_chunks > len_query_indices) num_chunks = len_query_indices;
+	}
+
+	const size_t num_leaves = max_dist_object->num_leaves;
+	double* const leaf_bounds = (num_leaves > 0) ? malloc(sizeof(double[num_chunks * num_leaves])) : NULL;
+	if ((num_leaves > 0) && (leaf_bounds == NULL)) return false;
+
+	ISCC_OMP(parallel for num_threads((int) num_chunks) if(num_chunks > 1) schedule(static, 1))
+	for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+		iscc_max_dist_queries(max_dist_object,
+		                      (chunk * len_query_indices) / num_chunks,
+		                      ((chunk + 1) * len_query_indices) / num_chunks,
+		                      query_indices,
+		                      (leaf_bounds == NULL) ? NULL : leaf_bounds + chunk * num_leaves,
+		                      out_max_indices,
+		                      out_max_dists);
+	}
+
+	free(leaf_bounds);
+
 	return true;
 }
 
@@ -268,6 +806,9 @@ bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
 {
 	if (max_dist_object != NULL && *max_dist_object != NULL) {
 		assert((*max_dist_object)->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
+		free((*max_dist_object)->leaf_positions);
+		free((*max_dist_object)->leaf_starts);
+		free((*max_dist_object)->leaf_boxes);
 		free(*max_dist_object);
 		*max_dist_object = NULL;
 	}
@@ -275,12 +816,102 @@ bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
 }
 
 
+// =============================================================================
+// Chunked nearest neighbor search
+// =============================================================================
+
+// Minimum number of queries per thread
+static const size_t ISCC_NN_SEARCH_MIN_CHUNK = 64;
+
+
+bool iscc_nn_search_in_chunks(const void* const search_object,
+                              const iscc_NNSearchRange search_range,
+                              const size_t num_threads,
+                              const size_t len_query_indices,
+                              const scc_PointIndex query_indices[const],
+                              const uint32_t k,
+                              const bool radius_search,
+                              const double radius,
+                              size_t* const out_num_ok_queries,
+                              scc_PointIndex out_query_indices[const],
+                              scc_PointIndex out_nn_indices[const])
+{
+	assert(search_object != NULL);
+	assert(search_range != NULL);
+	assert(num_threads > 0);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	/* The queries are split into one contiguous chunk per thread. Each chunk
+	 * writes its results to its own part of the output arrays, compacted
+	 * within the chunk. The chunks are then moved together in order, so the
+	 * output is identical to a serial search. */
+
+	size_t num_chunks = num_threads;
+	if (num_chunks > len_query_indices / ISCC_NN_SEARCH_MIN_CHUNK) {
+		num_chunks = len_query_indices / ISCC_NN_SEARCH_MIN_CHUNK;
+	}
+	if (num_chunks < 1) num_chunks = 1;
+
+	double* const sort_scratch = malloc(sizeof(double[num_chunks * k]));
+	size_t* const chunk_num_ok = malloc(sizeof(size_t[num_chunks]));
+	if ((sort_scratch == NULL) || (chunk_num_ok == NULL)) {
+		free(sort_scratch);
+		free(chunk_num_ok);
+		return false;
+	}
+
+	ISCC_OMP(parallel for num_threads((int) num_chunks) schedule(static, 1))
+	for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+		const size_t q_start = (chunk * len_query_indices) / num_chunks;
+		const size_t q_stop = ((chunk + 1) * len_query_indices) / num_chunks;
+		chunk_num_ok[chunk] = search_range(search_object,
+		                                   q_stop - q_start,
+		                                   (query_indices == NULL) ? NULL : query_indices + q_start,
+		                                   q_start,
+		                                   k,
+		                                   radius_search,
+		                                   radius,
+		                                   sort_scratch + chunk * k,
+		                                   (out_query_indices == NULL) ? NULL : out_query_indices + q_start,
+		                                   out_nn_indices + q_start * k);
+	}
+
+	size_t num_ok_queries = chunk_num_ok[0];
+	for (size_t chunk = 1; chunk < num_chunks; ++chunk) {
+		const size_t q_start = (chunk * len_query_indices) / num_chunks;
+		assert(num_ok_queries <= q_start);
+		if ((num_ok_queries < q_start) && (chunk_num_ok[chunk] > 0)) {
+			memmove(out_nn_indices + num_ok_queries * k,
+			        out_nn_indices + q_start * k,
+			        sizeof(scc_PointIndex[chunk_num_ok[chunk] * k]));
+			if (out_query_indices != NULL) {
+				memmove(out_query_indices + num_ok_queries,
+				        out_query_indices + q_start,
+				        sizeof(scc_PointIndex[chunk_num_ok[chunk]]));
+			}
+		}
+		num_ok_queries += chunk_num_ok[chunk];
+	}
+
+	*out_num_ok_queries = num_ok_queries;
+
+	free(sort_scratch);
+	free(chunk_num_ok);
+
+	return true;
+}
+
+
 // =============================================================================
 // Nearest neighbor search functions implementations
 // =============================================================================
 
 struct iscc_NNSearchObject {
 	int32_t nn_search_version;
+	iscc_SqDistKernel sq_dist;
 	scc_DataSet* data_set;
 	size_t len_search_indices;
 	const scc_PointIndex* search_indices;
@@ -289,25 +920,6 @@ struct iscc_NNSearchObject {
 static const int32_t ISCC_NN_SEARCH_STRUCT_VERSION = 722294001;
 
 
-static inline void iscc_add_dist_to_list(const double add_dist,
-                                         const scc_PointIndex add_index,
-                                         double* dist_list,
-                                         scc_PointIndex* index_list,
-                                         const double* const dist_list_start)
-{
-	assert(dist_list != NULL);
-	assert(index_list != NULL);
-	assert(dist_list_start != NULL);
-
-	for (; (dist_list != dist_list_start) && (add_dist < dist_list[-1]); --dist_list, --index_list) {
-		dist_list[0] = dist_list[-1];
-		index_list[0] = index_list[-1];
-	}
-	dist_list[0] = add_dist;
-	index_list[0] = add_index;
-}
-
-
 bool iscc_imp_init_nn_search_object(void* const data_set,
                                     const size_t len_search_indices,
                                     const scc_PointIndex search_indices[const],
@@ -322,6 +934,7 @@ bool iscc_imp_init_nn_search_object(void* const data_set,
 
 	**out_nn_search_object = (iscc_NNSearchObject) {
 		.nn_search_version = ISCC_NN_SEARCH_STRUCT_VERSION,
+		.sq_dist = iscc_get_sq_dist_kernel(),
 		.data_set = data_set,
 		.len_search_indices = len_search_indices,
 		.search_indices = search_indices,
@@ -331,42 +944,115 @@ bool iscc_imp_init_nn_search_object(void* const data_set,
 }
 
 
-bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
-                                      const size_t len_query_indices,
-                                      const scc_PointIndex query_indices[const],
-                                      const uint32_t k,
-                                      const bool radius_search,
-                                      const double radius,
-                                      size_t* const out_num_ok_queries,
-                                      scc_PointIndex out_query_indices[const],
-                                      scc_PointIndex out_nn_indices[const])
+// Searches a contiguous range of queries using neighbor heaps (for large `k`), see `iscc_imp_nn_search_range`
+static size_t iscc_imp_nn_search_range_heap(const iscc_NNSearchObject* const nn_search_object,
+                                            const size_t len_query_indices,
+                                            const scc_PointIndex query_indices[const],
+                                            const size_t query_offset,
+                                            const uint32_t k,
+                                            const bool radius_search,
+                                            const double radius,
+                                            double sort_scratch[const],
+                                            scc_PointIndex out_query_indices[const],
+                                            scc_PointIndex out_nn_indices[const])
 {
-	assert(nn_search_object != NULL);
-	assert(nn_search_object->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
-	scc_DataSet* const data_set = nn_search_object->data_set;
+	const iscc_SqDistKernel sq_dist = nn_search_object->sq_dist;
+	const scc_DataSet* const data_set = nn_search_object->data_set;
 	const size_t len_search_indices = nn_search_object->len_search_indices;
 	const scc_PointIndex* const search_indices = nn_search_object->search_indices;
 
-	assert(iscc_imp_check_data_set(data_set, 0));
-	assert(len_search_indices > 0);
-	assert(len_query_indices > 0);
-	assert(k > 0);
-	assert(k <= len_search_indices);
-	assert(!radius_search || (radius > 0.0));
-	assert(out_num_ok_queries != NULL);
-	assert(out_nn_indices != NULL);
+	/* The heap keys are positions in `search_indices`, so ties are ordered as
+	 * in the sorted lists. They are replaced by the point indices when done. */
+
+	double tmp_dist;
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+	const double radius_sq = radius * radius;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+		size_t s = 0;
+		uint32_t found = 0;
+
+		for (; (s < len_search_indices) && (found < k); ++s) {
+			const size_t search_point = (search_indices == NULL) ? s : (size_t) search_indices[s];
+			tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, search_point);
+			if (radius_search && (tmp_dist > radius_sq)) continue;
+			iscc_push_dist_heap(tmp_dist, (scc_PointIndex) s, found, sort_scratch, index_write);
+			++found;
+		}
+
+		for (; s < len_search_indices; ++s) {
+			assert(found == k);
+			const size_t search_point = (search_indices == NULL) ? s : (size_t) search_indices[s];
+			tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, search_point);
+			if (tmp_dist >= sort_scratch[0]) continue;
+			iscc_replace_dist_heap_top(tmp_dist, (scc_PointIndex) s, k, sort_scratch, index_write);
+		}
+
+		assert(found == k || out_query_indices != NULL);
+		if (found == k) {
+			iscc_sort_dist_heap(k, sort_scratch, index_write);
+			if (search_indices != NULL) {
+				for (uint32_t i = 0; i < k; ++i) {
+					index_write[i] = search_indices[index_write[i]];
+				}
+			}
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	return num_ok_queries;
+}
+
+
+// Searches a contiguous range of queries, returns the number of queries with `k` neighbors
+static size_t iscc_imp_nn_search_range(const void* const search_object,
+                                       const size_t len_query_indices,
+                                       const scc_PointIndex query_indices[const],
+                                       const size_t query_offset,
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double radius,
+                                       double sort_scratch[const],
+                                       scc_PointIndex out_query_indices[const],
+                                       scc_PointIndex out_nn_indices[const])
+{
+	const iscc_NNSearchObject* const nn_search_object = search_object;
+	if (k >= ISCC_DIST_HEAP_MIN_K) {
+		return iscc_imp_nn_search_range_heap(nn_search_object,
+		                                     len_query_indices,
+		                                     query_indices,
+		                                     query_offset,
+		                                     k,
+		                                     radius_search,
+		                                     radius,
+		                                     sort_scratch,
+		                                     out_query_indices,
+		                                     out_nn_indices);
+	}
+
+	const iscc_SqDistKernel sq_dist = nn_search_object->sq_dist;
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+	const size_t len_search_indices = nn_search_object->len_search_indices;
+	const scc_PointIndex* const search_indices = nn_search_object->search_indices;
 
 	double tmp_dist;
 	size_t num_ok_queries = 0;
 	scc_PointIndex* index_write = out_nn_indices;
-	double* const sort_scratch = malloc(sizeof(double[k]));
-	if (sort_scratch == NULL) return false;
 	double* const sort_scratch_end = sort_scratch + k - 1;
 	const double radius_sq = radius * radius;
 
 	if (search_indices == NULL) {
 		for (size_t q = 0; q < len_query_indices; ++q) {
-			size_t query = q;
+			size_t query = query_offset + q;
 			if (query_indices != NULL) {
 				query = (size_t) query_indices[q];
 			}
@@ -377,14 +1063,14 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 			if (radius_search) {
 				found = 0;
 				for (; (s < len_search_indices) && (found < k); ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, s);
+					tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, s);
 					if (tmp_dist > radius_sq) continue;
 					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch + found, index_write + found, sort_scratch);
 					++found;
 				}
 			} else {
 				for (; s < k; ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, s);
+					tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, s);
 					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch + s, index_write + s, sort_scratch);
 				}
 				found = k;
@@ -392,7 +1078,7 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 
 			for (; s < len_search_indices; ++s) {
 				assert(found == k);
-				tmp_dist = iscc_get_sq_dist(data_set, query, s);
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, s);
 				if (tmp_dist >= *sort_scratch_end) continue;
 				iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) s, sort_scratch_end, index_write_end, sort_scratch);
 			}
@@ -409,7 +1095,7 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 	} else {
 		assert(search_indices != NULL);
 		for (size_t q = 0; q < len_query_indices; ++q) {
-			size_t query = q;
+			size_t query = query_offset + q;
 			if (query_indices != NULL) {
 				query = (size_t) query_indices[q];
 			}
@@ -420,14 +1106,14 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 			if (radius_search) {
 				found = 0;
 				for (; (s < len_search_indices) && (found < k); ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
+					tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, (size_t) search_indices[s]);
 					if (tmp_dist > radius_sq) continue;
 					iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch + found, index_write + found, sort_scratch);
 					++found;
 				}
 			} else {
 				for (; s < k; ++s) {
-					tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
+					tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, (size_t) search_indices[s]);
 					iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch + s, index_write + s, sort_scratch);
 				}
 				found = k;
@@ -435,7 +1121,7 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 
 			for (; s < len_search_indices; ++s) {
 				assert(found == k);
-				tmp_dist = iscc_get_sq_dist(data_set, query, (size_t) search_indices[s]);
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, (size_t) search_indices[s]);
 				if (tmp_dist >= *sort_scratch_end) continue;
 				iscc_add_dist_to_list(tmp_dist, search_indices[s], sort_scratch_end, index_write_end, sort_scratch);
 			}
@@ -451,11 +1137,198 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 		}
 	}
 
-	*out_num_ok_queries = num_ok_queries;
+	return num_ok_queries;
+}
 
-	free(sort_scratch);
 
-	return true;
+// =============================================================================
+// Re-ranked nearest neighbor search
+// =============================================================================
+
+/* Low precision data sets with a double precision copy are searched in two
+ * steps. The nearest candidates are first found using the low precision
+ * distances, and the `k` neighbors are then picked among the candidates
+ * using exact distances. The candidate lists are `2k + 8` long, which
+ * covers the neighbors reordered by the rounding. */
+
+typedef struct iscc_RerankSearch iscc_RerankSearch;
+struct iscc_RerankSearch {
+	const iscc_NNSearchObject* nn_search_object;
+	size_t num_candidates;
+	double* candidate_dists;
+	scc_PointIndex* candidate_indices;
+};
+
+
+static size_t iscc_imp_nn_search_range_rerank(const void* const search_object,
+                                              const size_t len_query_indices,
+                                              const scc_PointIndex query_indices[const],
+                                              const size_t query_offset,
+                                              const uint32_t k,
+                                              const bool radius_search,
+                                              const double radius,
+                                              double sort_scratch[const],
+                                              scc_PointIndex out_query_indices[const],
+                                              scc_PointIndex out_nn_indices[const])
+{
+	const iscc_RerankSearch* const rerank_search = search_object;
+	const iscc_NNSearchObject* const nn_search_object = rerank_search->nn_search_object;
+	const iscc_SqDistKernel sq_dist = nn_search_object->sq_dist;
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+	const size_t len_search_indices = nn_search_object->len_search_indices;
+	const scc_PointIndex* const search_indices = nn_search_object->search_indices;
+	const size_t num_candidates = rerank_search->num_candidates;
+
+	// One candidate list per thread
+	const size_t thread = (size_t) iscc_get_thread_num();
+	double* const cand_dists = rerank_search->candidate_dists + thread * num_candidates;
+	scc_PointIndex* const cand_indices = rerank_search->candidate_indices + thread * num_candidates;
+	double* const cand_dists_end = cand_dists + num_candidates - 1;
+	scc_PointIndex* const cand_indices_end = cand_indices + num_candidates - 1;
+
+	double tmp_dist;
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+	double* const sort_scratch_end = sort_scratch + k - 1;
+	const double radius_sq = radius * radius;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+
+		size_t s = 0;
+		for (; s < num_candidates; ++s) {
+			const scc_PointIndex search_point = (search_indices == NULL) ? (scc_PointIndex) s : search_indices[s];
+			tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, (size_t) search_point);
+			iscc_add_dist_to_list(tmp_dist, search_point, cand_dists + s, cand_indices + s, cand_dists);
+		}
+		for (; s < len_search_indices; ++s) {
+			const scc_PointIndex search_point = (search_indices == NULL) ? (scc_PointIndex) s : search_indices[s];
+			tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, (size_t) search_point);
+			if (tmp_dist >= *cand_dists_end) continue;
+			iscc_add_dist_to_list(tmp_dist, search_point, cand_dists_end, cand_indices_end, cand_dists);
+		}
+
+		scc_PointIndex* const index_write_end = index_write + k - 1;
+		size_t c = 0;
+		for (; c < k; ++c) {
+			tmp_dist = iscc_get_rerank_sq_dist(sq_dist, data_set, query, (size_t) cand_indices[c]);
+			iscc_add_dist_to_list(tmp_dist, cand_indices[c], sort_scratch + c, index_write + c, sort_scratch);
+		}
+		for (; c < num_candidates; ++c) {
+			tmp_dist = iscc_get_rerank_sq_dist(sq_dist, data_set, query, (size_t) cand_indices[c]);
+			if (tmp_dist >= *sort_scratch_end) continue;
+			iscc_add_dist_to_list(tmp_dist, cand_indices[c], sort_scratch_end, index_write_end, sort_scratch);
+		}
+
+		if (radius_search && (*sort_scratch_end > radius_sq)) {
+			assert(out_query_indices != NULL);
+			continue;
+		}
+		if (out_query_indices != NULL) {
+			out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+		}
+		++num_ok_queries;
+		index_write += k;
+	}
+
+	return num_ok_queries;
+}
+
+
+static bool iscc_imp_rerank_nn_search(const iscc_NNSearchObject* const nn_search_object,
+                                      const size_t len_query_indices,
+                                      const scc_PointIndex query_indices[const],
+                                      const uint32_t k,
+                                      const bool radius_search,
+                                      const double radius,
+                                      size_t* const out_num_ok_queries,
+                                      scc_PointIndex out_query_indices[const],
+                                      scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object->data_set->rerank_matrix != NULL);
+
+	size_t num_candidates = 2 * (size_t) k + 8;
+	if (num_candidates > nn_search_object->len_search_indices) {
+		num_candidates = nn_search_object->len_search_indices;
+	}
+	const size_t num_threads = (size_t) iscc_get_num_threads();
+
+	iscc_RerankSearch rerank_search = {
+		.nn_search_object = nn_search_object,
+		.num_candidates = num_candidates,
+		.candidate_dists = malloc(sizeof(double[num_threads * num_candidates])),
+		.candidate_indices = malloc(sizeof(scc_PointIndex[num_threads * num_candidates])),
+	};
+
+	bool search_ok = false;
+	if ((rerank_search.candidate_dists != NULL) && (rerank_search.candidate_indices != NULL)) {
+		search_ok = iscc_nn_search_in_chunks(&rerank_search,
+		                                     iscc_imp_nn_search_range_rerank,
+		                                     num_threads,
+		                                     len_query_indices,
+		                                     query_indices,
+		                                     k,
+		                                     radius_search,
+		                                     radius,
+		                                     out_num_ok_queries,
+		                                     out_query_indices,
+		                                     out_nn_indices);
+	}
+
+	free(rerank_search.candidate_dists);
+	free(rerank_search.candidate_indices);
+
+	return search_ok;
+}
+
+
+bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                      const size_t len_query_indices,
+                                      const scc_PointIndex query_indices[const],
+                                      const uint32_t k,
+                                      const bool radius_search,
+                                      const double radius,
+                                      size_t* const out_num_ok_queries,
+                                      scc_PointIndex out_query_indices[const],
+                                      scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
+	assert(iscc_imp_check_data_set(nn_search_object->data_set, 0));
+	assert(nn_search_object->len_search_indices > 0);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->len_search_indices);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	if (nn_search_object->data_set->rerank_matrix != NULL) {
+		return iscc_imp_rerank_nn_search(nn_search_object,
+		                                 len_query_indices,
+		                                 query_indices,
+		                                 k,
+		                                 radius_search,
+		                                 radius,
+		                                 out_num_ok_queries,
+		                                 out_query_indices,
+		                                 out_nn_indices);
+	}
+
+	return iscc_nn_search_in_chunks(nn_search_object,
+	                                iscc_imp_nn_search_range,
+	                                (size_t) iscc_get_num_threads(),
+	                                len_query_indices,
+	                                query_indices,
+	                                k,
+	                                radius_search,
+	                                radius,
+	                                out_num_ok_queries,
+	                                out_query_indices,
+	                                out_nn_indices);
 }
 
 
@@ -468,3 +1341,227 @@ bool iscc_imp_close_nn_search_object(iscc_NNSearchObject** const nn_search_objec
 	}
 	return true;
 }
+
+
+// =============================================================================
+// Type constrained nearest neighbor search
+// =============================================================================
+
+/* The per-type lists are filled in increasing index order but should be
+ * ordered as when the type groups are searched in decreasing index order,
+ * so ties are inserted ahead of equal distances and a point with the same
+ * distance as the last element replaces it. Lists of length at least
+ * `ISCC_DIST_HEAP_MIN_K` are kept as heaps and sorted when a query is done. */
+
+typedef struct iscc_TypeNNSearch iscc_TypeNNSearch;
+struct iscc_TypeNNSearch {
+	iscc_SqDistKernel sq_dist;
+	const scc_DataSet* data_set;
+	const scc_TypeLabel* type_labels;
+	const uint32_t* type_k;
+	uint_fast16_t num_types;
+	uint32_t k_all;
+	const size_t* list_offset;
+	uint32_t* list_fill;
+};
+
+
+static size_t iscc_imp_type_nn_search_range(const void* const search_object,
+                                            const size_t len_query_indices,
+                                            const scc_PointIndex query_indices[const],
+                                            const size_t query_offset,
+                                            const uint32_t row_width,
+                                            const bool radius_search,
+                                            const double radius,
+                                            double sort_scratch[const],
+                                            scc_PointIndex out_query_indices[const],
+                                            scc_PointIndex out_nn_indices[const])
+{
+	const iscc_TypeNNSearch* const type_search = search_object;
+	const iscc_SqDistKernel sq_dist = type_search->sq_dist;
+	const scc_DataSet* const data_set = type_search->data_set;
+	const scc_TypeLabel* const type_labels = type_search->type_labels;
+	const uint32_t* const type_k = type_search->type_k;
+	const uint_fast16_t num_types = type_search->num_types;
+	const uint32_t k_all = type_search->k_all;
+	const size_t* const list_offset = type_search->list_offset;
+	const size_t num_data_points = data_set->num_data_points;
+	const bool rerank = (data_set->rerank_matrix != NULL);
+
+	// Fill counts of the lists, one set per thread
+	uint32_t* const list_fill = type_search->list_fill + ((size_t) iscc_get_thread_num()) * num_types;
+
+	const size_t all_offset = (size_t) row_width - k_all;
+	double* const all_dists = sort_scratch + all_offset;
+	double* const all_dists_end = all_dists + k_all - 1;
+
+	double tmp_dist;
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+	const double radius_sq = radius * radius;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+
+		for (uint_fast16_t t = 0; t < num_types; ++t) {
+			list_fill[t] = 0;
+		}
+		scc_PointIndex* const all_indices = index_write + all_offset;
+		scc_PointIndex* const all_indices_end = all_indices + k_all - 1;
+
+		for (size_t p = 0; p < num_data_points; ++p) {
+			if (rerank) {
+				tmp_dist = iscc_get_rerank_sq_dist(sq_dist, data_set, query, p);
+			} else {
+				tmp_dist = iscc_get_sq_dist(sq_dist, data_set, query, p);
+			}
+
+			const scc_TypeLabel type = type_labels[p];
+			const uint32_t k = type_k[type];
+			if (k >= ISCC_DIST_HEAP_MIN_K) {
+				// Keys decrease with `p`, so later points go ahead of ties
+				double* const t_dists = sort_scratch + list_offset[type];
+				scc_PointIndex* const t_keys = index_write + list_offset[type];
+				const scc_PointIndex key = ISCC_POINTINDEX_MAX_PI - (scc_PointIndex) p;
+				if (list_fill[type] < k) {
+					iscc_push_dist_heap(tmp_dist, key, list_fill[type], t_dists, t_keys);
+					++list_fill[type];
+				} else if (iscc_dist_heap_less(tmp_dist, key, t_dists[0], t_keys[0])) {
+					iscc_replace_dist_heap_top(tmp_dist, key, k, t_dists, t_keys);
+				}
+			} else if (k > 0) {
+				double* const t_dists = sort_scratch + list_offset[type];
+				scc_PointIndex* const t_indices = index_write + list_offset[type];
+				if (list_fill[type] < k) {
+					iscc_add_dist_to_list_before_ties(tmp_dist, (scc_PointIndex) p, t_dists + list_fill[type], t_indices + list_fill[type], t_dists);
+					++list_fill[type];
+				} else if (tmp_dist <= t_dists[k - 1]) {
+					iscc_add_dist_to_list_before_ties(tmp_dist, (scc_PointIndex) p, t_dists + k - 1, t_indices + k - 1, t_dists);
+				}
+			}
+
+			if (k_all >= ISCC_DIST_HEAP_MIN_K) {
+				if (p < k_all) {
+					iscc_push_dist_heap(tmp_dist, (scc_PointIndex) p, p, all_dists, all_indices);
+				} else if (tmp_dist < all_dists[0]) {
+					iscc_replace_dist_heap_top(tmp_dist, (scc_PointIndex) p, k_all, all_dists, all_indices);
+				}
+			} else if (k_all > 0) {
+				if (p < k_all) {
+					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) p, all_dists + p, all_indices + p, all_dists);
+				} else if (tmp_dist < *all_dists_end) {
+					iscc_add_dist_to_list(tmp_dist, (scc_PointIndex) p, all_dists_end, all_indices_end, all_dists);
+				}
+			}
+		}
+
+		// Sort the heaps into lists
+		for (uint_fast16_t t = 0; t < num_types; ++t) {
+			if (type_k[t] >= ISCC_DIST_HEAP_MIN_K) {
+				scc_PointIndex* const t_keys = index_write + list_offset[t];
+				iscc_sort_dist_heap(type_k[t], sort_scratch + list_offset[t], t_keys);
+				for (uint32_t i = 0; i < type_k[t]; ++i) {
+					t_keys[i] = ISCC_POINTINDEX_MAX_PI - t_keys[i];
+				}
+			}
+		}
+		if (k_all >= ISCC_DIST_HEAP_MIN_K) {
+			iscc_sort_dist_heap(k_all, all_dists, all_indices);
+		}
+
+		if (radius_search) {
+			assert(out_query_indices != NULL);
+			bool within_radius = (k_all == 0) || (*all_dists_end <= radius_sq);
+			for (uint_fast16_t t = 0; within_radius && (t < num_types); ++t) {
+				assert(list_fill[t] == type_k[t]);
+				if (type_k[t] > 0) {
+					within_radius = (sort_scratch[list_offset[t] + type_k[t] - 1] <= radius_sq);
+				}
+			}
+			if (!within_radius) continue;
+		}
+
+		if (out_query_indices != NULL) {
+			out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+		}
+		++num_ok_queries;
+		index_write += row_width;
+	}
+
+	return num_ok_queries;
+}
+
+
+bool iscc_imp_type_nearest_neighbor_search(void* const data_set,
+                                           const size_t len_query_indices,
+                                           const scc_PointIndex query_indices[const],
+                                           const scc_TypeLabel type_labels[const],
+                                           const uint_fast16_t num_types,
+                                           const uint32_t type_k[const],
+                                           const uint32_t k_all,
+                                           const bool radius_search,
+                                           const double radius,
+                                           size_t* const out_num_ok_queries,
+                                           scc_PointIndex out_query_indices[const],
+                                           scc_PointIndex out_nn_indices[const])
+{
+	assert(iscc_imp_check_data_set(data_set, 0));
+	assert(len_query_indices > 0);
+	assert(type_labels != NULL);
+	assert(num_types > 0);
+	assert(type_k != NULL);
+	assert(k_all <= ((scc_DataSet*) data_set)->num_data_points);
+	assert(!radius_search || (radius > 0.0));
+	assert(!radius_search || (out_query_indices != NULL));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	const size_t num_threads = (size_t) iscc_get_num_threads();
+	size_t* const list_offset = malloc(sizeof(size_t[num_types]));
+	uint32_t* const list_fill = malloc(sizeof(uint32_t[num_threads * num_types]));
+	if ((list_offset == NULL) || (list_fill == NULL)) {
+		free(list_offset);
+		free(list_fill);
+		return false;
+	}
+
+	size_t row_width = 0;
+	for (uint_fast16_t t = 0; t < num_types; ++t) {
+		list_offset[t] = row_width;
+		row_width += type_k[t];
+	}
+	row_width += k_all;
+	assert(row_width > 0);
+	assert(row_width <= UINT32_MAX);
+
+	const iscc_TypeNNSearch type_search = {
+		.sq_dist = iscc_get_sq_dist_kernel(),
+		.data_set = data_set,
+		.type_labels = type_labels,
+		.type_k = type_k,
+		.num_types = num_types,
+		.k_all = k_all,
+		.list_offset = list_offset,
+		.list_fill = list_fill,
+	};
+
+	const bool search_ok = iscc_nn_search_in_chunks(&type_search,
+	                                                iscc_imp_type_nn_search_range,
+	                                                num_threads,
+	                                                len_query_indices,
+	                                                query_indices,
+	                                                (uint32_t) row_width,
+	                                                radius_search,
+	                                                radius,
+	                                                out_num_ok_queries,
+	                                                out_query_indices,
+	                                                out_nn_indices);
+
+	free(list_offset);
+	free(list_fill);
+
+	return search_ok;
+}
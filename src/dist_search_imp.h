@@ -96,6 +96,80 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
 bool iscc_imp_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
 
 
+// =============================================================================
+// Type constrained nearest neighbor search
+// =============================================================================
+
+/** Searches the nearest neighbors of each type in one pass.
+ *
+ *  For each query, finds the `type_k[t]` nearest neighbors among the points of
+ *  type `t` for all types, and the `k_all` nearest neighbors among all points.
+ *  Each data point is visited once per query. The row of a query holds the lists
+ *  of the types with `type_k[t] > 0` in type order, followed by the list of all
+ *  points (if `k_all > 0`). The lists are the ones #iscc_imp_nearest_neighbor_search
+ *  gives with search sets sorted in decreasing index order (one per type) and
+ *  with all points, respectively. With `radius_search`, queries where any list
+ *  reaches beyond `radius` are dropped. Low precision data sets with a double
+ *  precision copy are searched using the double precision distances.
+ *
+ *  `out_nn_indices` must be of length `(sum(type_k) + k_all) * len_query_indices`.
+ */
+bool iscc_imp_type_nearest_neighbor_search(void* data_set,
+                                           size_t len_query_indices,
+                                           const scc_PointIndex query_indices[],
+                                           const scc_TypeLabel type_labels[],
+                                           uint_fast16_t num_types,
+                                           const uint32_t type_k[],
+                                           uint32_t k_all,
+                                           bool radius_search,
+                                           double radius,
+                                           size_t* out_num_ok_queries,
+                                           scc_PointIndex out_query_indices[],
+                                           scc_PointIndex out_nn_indices[]);
+
+
+// =============================================================================
+// Chunked nearest neighbor search
+// =============================================================================
+
+/** Searches a contiguous range of queries.
+ *
+ *  Query `q` is `query_indices[q]`, or `query_offset + q` if `query_indices`
+ *  is `NULL`. Results are written compacted (as in #iscc_imp_nearest_neighbor_search)
+ *  and the number of queries with `k` neighbors is returned. `sort_scratch` is
+ *  of length `k`.
+ */
+typedef size_t (*iscc_NNSearchRange)(const void* search_object,
+                                     size_t len_query_indices,
+                                     const scc_PointIndex query_indices[],
+                                     size_t query_offset,
+                                     uint32_t k,
+                                     bool radius_search,
+                                     double radius,
+                                     double sort_scratch[],
+                                     scc_PointIndex out_query_indices[],
+                                     scc_PointIndex out_nn_indices[]);
+
+/** Runs a nearest neighbor search in parallel.
+ *
+ *  Splits the queries into at most `num_threads` chunks and calls #search_range
+ *  on each chunk. The output is identical to calling #search_range once with
+ *  all queries. `num_threads` should be the value the caller used to size any
+ *  per-thread scratch that #search_range indexes by #iscc_get_thread_num.
+ */
+bool iscc_nn_search_in_chunks(const void* search_object,
+                              iscc_NNSearchRange search_range,
+                              size_t num_threads,
+                              size_t len_query_indices,
+                              const scc_PointIndex query_indices[],
+                              uint32_t k,
+                              bool radius_search,
+                              double radius,
+                              size_t* out_num_ok_queries,
+                              scc_PointIndex out_query_indices[],
+                              scc_PointIndex out_nn_indices[]);
+
+
 #ifdef __cplusplus
 }
 #endif
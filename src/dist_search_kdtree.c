@@ -0,0 +1,453 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "dist_search_kdtree.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
+#include "data_set_struct.h"
+#include "dist_kernels.h"
+#include "dist_search_imp.h"
+#include "dist_search_list.h"
+#include "parallel.h"
+#include "scclust_types.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+/* The tree is built by splitting at the median along the dimension with
+ * largest spread until nodes contain at most `ISCC_KDT_LEAF_SIZE` points.
+ * The search points are stored in tree order (both their indices and a copy
+ * of their coordinates), so every node covers a contiguous range. The two
+ * children of a node are stored next to each other. */
+
+#define ISCC_KDT_LEAF_SIZE 16
+
+typedef struct iscc_kdt_Node iscc_kdt_Node;
+struct iscc_kdt_Node {
+	size_t start;
+	size_t stop;
+	size_t left_child; // 0 if leaf (root is never a child), right child is `left_child + 1`
+	double split_value;
+	uint_fast16_t split_dim;
+};
+
+struct iscc_NNSearchObject {
+	int32_t nn_search_version;
+	iscc_SqDistKernel sq_dist;
+	const scc_DataSet* data_set;
+	size_t num_points;
+	scc_PointIndex* point_indices;
+	double* coords;
+	iscc_kdt_Node* nodes;
+};
+
+static const int32_t ISCC_KDT_NN_SEARCH_STRUCT_VERSION = 722518001;
+
+typedef struct iscc_kdt_Query iscc_kdt_Query;
+struct iscc_kdt_Query {
+	const double* query_coords;
+	uint32_t k;
+	uint32_t found;
+	double radius_sq;
+	double* dist_list;
+	scc_PointIndex* index_list;
+};
+
+
+// =============================================================================
+// Internal function prototypes
+// =============================================================================
+
+static size_t iscc_kdt_build(iscc_NNSearchObject* nn_search_object,
+                             size_t* point_rows,
+                             size_t node,
+                             size_t next_free_node,
+                             size_t start,
+                             size_t stop);
+
+static void iscc_kdt_select(const double* data_matrix,
+                            size_t num_dimensions,
+                            uint_fast16_t dim,
+                            size_t* point_rows,
+                            size_t len,
+                            size_t nth);
+
+static size_t iscc_kdt_search_range(const void* search_object,
+                                    size_t len_query_indices,
+                                    const scc_PointIndex query_indices[],
+                                    size_t query_offset,
+                                    uint32_t k,
+                                    bool radius_search,
+                                    double radius,
+                                    double sort_scratch[],
+                                    scc_PointIndex out_query_indices[],
+                                    scc_PointIndex out_nn_indices[]);
+
+static void iscc_kdt_search_node(const iscc_NNSearchObject* nn_search_object,
+                                 size_t node,
+                                 iscc_kdt_Query* query);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+bool iscc_kdt_init_nn_search_object(void* const data_set,
+                                    const size_t len_search_indices,
+                                    const scc_PointIndex search_indices[const],
+                                    iscc_NNSearchObject** const out_nn_search_object)
+{
+	assert(iscc_imp_check_data_set(data_set, 0));
+	assert(len_search_indices > 0);
+	assert(out_nn_search_object != NULL);
+
+	const scc_DataSet* const data_set_cast = data_set;
+	const size_t num_dimensions = (size_t) data_set_cast->num_dimensions;
+
+	// The tree is built on double precision coordinates
+	if (data_set_cast->data_type != ISCC_DT_DOUBLE) return false;
+
+	// Leaves have at least `(ISCC_KDT_LEAF_SIZE + 1) / 2` points
+	const size_t max_nodes = 2 * (len_search_indices / ((ISCC_KDT_LEAF_SIZE + 1) / 2)) + 1;
+
+	iscc_NNSearchObject* tree = malloc(sizeof(iscc_NNSearchObject));
+	size_t* const point_rows = malloc(sizeof(size_t[len_search_indices]));
+	if (tree != NULL) {
+		*tree = (iscc_NNSearchObject) {
+			.nn_search_version = ISCC_KDT_NN_SEARCH_STRUCT_VERSION,
+			.sq_dist = iscc_get_sq_dist_kernel(),
+			.data_set = data_set_cast,
+			.num_points = len_search_indices,
+			.point_indices = malloc(sizeof(scc_PointIndex[len_search_indices])),
+			.coords = malloc(sizeof(double[len_search_indices * num_dimensions])),
+			.nodes = malloc(sizeof(iscc_kdt_Node[max_nodes])),
+		};
+	}
+
+	if ((tree == NULL) || (point_rows == NULL) || (tree->point_indices == NULL) ||
+	        (tree->coords == NULL) || (tree->nodes == NULL)) {
+		free(point_rows);
+		iscc_kdt_close_nn_search_object(&tree);
+		return false;
+	}
+
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		point_rows[i] = (search_indices == NULL) ? i : (size_t) search_indices[i];
+		assert(point_rows[i] < data_set_cast->num_data_points);
+	}
+
+	const size_t num_nodes = iscc_kdt_build(tree, point_rows, 0, 1, 0, len_search_indices);
+	assert(num_nodes <= max_nodes);
+	(void) num_nodes; // If NDEBUG
+
+	for (size_t i = 0; i < len_search_indices; ++i) {
+		tree->point_indices[i] = (scc_PointIndex) point_rows[i];
+		const double* const point_data = &data_set_cast->data_matrix[point_rows[i] * num_dimensions];
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			tree->coords[i * num_dimensions + d] = point_data[d];
+		}
+	}
+
+	free(point_rows);
+
+	*out_nn_search_object = tree;
+
+	return true;
+}
+
+
+bool iscc_kdt_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                      const size_t len_query_indices,
+                                      const scc_PointIndex query_indices[const],
+                                      const uint32_t k,
+                                      const bool radius_search,
+                                      const double radius,
+                                      size_t* const out_num_ok_queries,
+                                      scc_PointIndex out_query_indices[const],
+                                      scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(nn_search_object->nn_search_version == ISCC_KDT_NN_SEARCH_STRUCT_VERSION);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(k <= nn_search_object->num_points);
+	assert(!radius_search || (radius > 0.0));
+	assert(out_num_ok_queries != NULL);
+	assert(out_nn_indices != NULL);
+
+	return iscc_nn_search_in_chunks(nn_search_object,
+	                                iscc_kdt_search_range,
+	                                (size_t) iscc_get_num_threads(),
+	                                len_query_indices,
+	                                query_indices,
+	                                k,
+	                                radius_search,
+	                                radius,
+	                                out_num_ok_queries,
+	                                out_query_indices,
+	                                out_nn_indices);
+}
+
+
+bool iscc_kdt_close_nn_search_object(iscc_NNSearchObject** const nn_search_object)
+{
+	if (nn_search_object != NULL && *nn_search_object != NULL) {
+		assert((*nn_search_object)->nn_search_version == ISCC_KDT_NN_SEARCH_STRUCT_VERSION);
+		free((*nn_search_object)->point_indices);
+		free((*nn_search_object)->coords);
+		free((*nn_search_object)->nodes);
+		free(*nn_search_object);
+		*nn_search_object = NULL;
+	}
+	return true;
+}
+
+
+uint_fast16_t iscc_kdt_split_at_median(const scc_DataSet* const data_set,
+                                       size_t point_rows[const],
+                                       const size_t len_point_rows)
+{
+	assert(data_set != NULL);
+	assert(point_rows != NULL);
+	assert(len_point_rows > 1);
+
+	const double* const data_matrix = data_set->data_matrix;
+	const uint_fast16_t num_dimensions = data_set->num_dimensions;
+
+	uint_fast16_t split_dim = 0;
+	double max_spread = -1.0;
+	for (uint_fast16_t d = 0; d < num_dimensions; ++d) {
+		double min_value = data_matrix[point_rows[0] * num_dimensions + d];
+		double max_value = min_value;
+		for (size_t i = 1; i < len_point_rows; ++i) {
+			const double value = data_matrix[point_rows[i] * num_dimensions + d];
+			if (value < min_value) min_value = value;
+			if (value > max_value) max_value = value;
+		}
+		if (max_value - min_value > max_spread) {
+			max_spread = max_value - min_value;
+			split_dim = d;
+		}
+	}
+
+	iscc_kdt_select(data_matrix, num_dimensions, split_dim, point_rows, len_point_rows, len_point_rows / 2);
+
+	return split_dim;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+// Builds the subtree at `node` over `point_rows[start:stop]`, returns next free node
+static size_t iscc_kdt_build(iscc_NNSearchObject* const nn_search_object,
+                             size_t* const point_rows,
+                             const size_t node,
+                             size_t next_free_node,
+                             const size_t start,
+                             const size_t stop)
+{
+	assert(start < stop);
+
+	iscc_kdt_Node* const this_node = &nn_search_object->nodes[node];
+	*this_node = (iscc_kdt_Node) {
+		.start = start,
+		.stop = stop,
+		.left_child = 0,
+		.split_value = 0.0,
+		.split_dim = 0,
+	};
+
+	if (stop - start <= ISCC_KDT_LEAF_SIZE) return next_free_node;
+
+	const uint_fast16_t split_dim = iscc_kdt_split_at_median(nn_search_object->data_set, point_rows + start, stop - start);
+	const size_t mid = start + (stop - start) / 2;
+	const double* const data_matrix = nn_search_object->data_set->data_matrix;
+	const uint_fast16_t num_dimensions = nn_search_object->data_set->num_dimensions;
+
+	this_node->split_dim = split_dim;
+	this_node->split_value = data_matrix[point_rows[mid] * num_dimensions + split_dim];
+	this_node->left_child = next_free_node;
+	next_free_node += 2;
+
+	next_free_node = iscc_kdt_build(nn_search_object, point_rows, this_node->left_child, next_free_node, start, mid);
+	next_free_node = iscc_kdt_build(nn_search_object, point_rows, this_node->left_child + 1, next_free_node, mid, stop);
+
+	return next_free_node;
+}
+
+
+/* Partially sorts `point_rows` along `dim` so that element `nth` is in its
+ * sorted position. Uses three-way partitioning so that many identical values
+ * (common with discrete covariates) do not degrade performance. */
+static void iscc_kdt_select(const double* const data_matrix,
+                            const size_t num_dimensions,
+                            const uint_fast16_t dim,
+                            size_t* const point_rows,
+                            const size_t len,
+                            const size_t nth)
+{
+	assert(nth < len);
+
+	size_t left = 0;
+	size_t right = len - 1;
+	while (left < right) {
+		const double pivot = data_matrix[point_rows[left + (right - left) / 2] * num_dimensions + dim];
+		size_t less_stop = left;
+		size_t greater_start = right + 1;
+		size_t i = left;
+		while (i < greater_start) {
+			const double value = data_matrix[point_rows[i] * num_dimensions + dim];
+			if (value < pivot) {
+				const size_t tmp = point_rows[less_stop];
+				point_rows[less_stop] = point_rows[i];
+				point_rows[i] = tmp;
+				++less_stop;
+				++i;
+			} else if (value > pivot) {
+				--greater_start;
+				const size_t tmp = point_rows[greater_start];
+				point_rows[greater_start] = point_rows[i];
+				point_rows[i] = tmp;
+			} else {
+				++i;
+			}
+		}
+
+		if (nth < less_stop) {
+			right = less_stop - 1;
+		} else if (nth >= greater_start) {
+			left = greater_start;
+		} else {
+			return;
+		}
+	}
+}
+
+
+static size_t iscc_kdt_search_range(const void* const search_object,
+                                    const size_t len_query_indices,
+                                    const scc_PointIndex query_indices[const],
+                                    const size_t query_offset,
+                                    const uint32_t k,
+                                    const bool radius_search,
+                                    const double radius,
+                                    double sort_scratch[const],
+                                    scc_PointIndex out_query_indices[const],
+                                    scc_PointIndex out_nn_indices[const])
+{
+	const iscc_NNSearchObject* const nn_search_object = search_object;
+	const scc_DataSet* const data_set = nn_search_object->data_set;
+
+	size_t num_ok_queries = 0;
+	scc_PointIndex* index_write = out_nn_indices;
+
+	for (size_t q = 0; q < len_query_indices; ++q) {
+		size_t query = query_offset + q;
+		if (query_indices != NULL) {
+			query = (size_t) query_indices[q];
+		}
+		assert(query < data_set->num_data_points);
+
+		iscc_kdt_Query query_state = {
+			.query_coords = &data_set->data_matrix[query * data_set->num_dimensions],
+			.k = k,
+			.found = 0,
+			.radius_sq = radius_search ? radius * radius : HUGE_VAL,
+			.dist_list = sort_scratch,
+			.index_list = index_write,
+		};
+
+		iscc_kdt_search_node(nn_search_object, 0, &query_state);
+
+		assert(query_state.found == k || out_query_indices != NULL);
+		if (query_state.found == k) {
+			if (out_query_indices != NULL) {
+				out_query_indices[num_ok_queries] = (scc_PointIndex) query;
+			}
+			++num_ok_queries;
+			index_write += k;
+		}
+	}
+
+	return num_ok_queries;
+}
+
+
+// Whether a point (or subtree) at squared distance `sq_dist` may enter the list
+static inline bool iscc_kdt_within_bound(const iscc_kdt_Query* const query,
+                                         const double sq_dist)
+{
+	if (query->found < query->k) {
+		return sq_dist <= query->radius_sq;
+	}
+	return sq_dist < query->dist_list[query->k - 1];
+}
+
+
+static void iscc_kdt_search_node(const iscc_NNSearchObject* const nn_search_object,
+                                 const size_t node,
+                                 iscc_kdt_Query* const query)
+{
+	const iscc_kdt_Node* const this_node = &nn_search_object->nodes[node];
+	const size_t num_dimensions = (size_t) nn_search_object->data_set->num_dimensions;
+
+	if (this_node->left_child == 0) {
+		for (size_t i = this_node->start; i < this_node->stop; ++i) {
+			const double sq_dist = nn_search_object->sq_dist(query->query_coords,
+			                                                 nn_search_object->coords + i * num_dimensions,
+			                                                 num_dimensions);
+			if (!iscc_kdt_within_bound(query, sq_dist)) continue;
+			if (query->found < query->k) {
+				iscc_add_dist_to_list(sq_dist,
+				                      nn_search_object->point_indices[i],
+				                      query->dist_list + query->found,
+				                      query->index_list + query->found,
+				                      query->dist_list);
+				++(query->found);
+			} else {
+				iscc_add_dist_to_list(sq_dist,
+				                      nn_search_object->point_indices[i],
+				                      query->dist_list + query->k - 1,
+				                      query->index_list + query->k - 1,
+				                      query->dist_list);
+			}
+		}
+		return;
+	}
+
+	const double plane_diff = query->query_coords[this_node->split_dim] - this_node->split_value;
+	const size_t near_child = (plane_diff <= 0.0) ? this_node->left_child : this_node->left_child + 1;
+	const size_t far_child = (plane_diff <= 0.0) ? this_node->left_child + 1 : this_node->left_child;
+
+	iscc_kdt_search_node(nn_search_object, near_child, query);
+	if (iscc_kdt_within_bound(query, plane_diff * plane_diff)) {
+		iscc_kdt_search_node(nn_search_object, far_child, query);
+	}
+}
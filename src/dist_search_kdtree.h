@@ -0,0 +1,82 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_DIST_SEARCH_KDTREE_HG
+#define SCC_DIST_SEARCH_KDTREE_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "../include/scclust_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Nearest neighbor search functions
+// =============================================================================
+
+/* Nearest neighbor search with a kd-tree over the search points. The functions
+ * follow the semantics of the `iscc_imp_*` search functions and accept only
+ * `scc_DataSet` data sets. See `scc_set_kdtree_dist_search`. */
+
+bool iscc_kdt_init_nn_search_object(void* data_set,
+                                    size_t len_search_indices,
+                                    const scc_PointIndex search_indices[],
+                                    iscc_NNSearchObject** out_nn_search_object);
+
+// `out_nn_indices` must be of length `k * len_query_indices`
+bool iscc_kdt_nearest_neighbor_search(iscc_NNSearchObject* nn_search_object,
+                                      size_t len_query_indices,
+                                      const scc_PointIndex query_indices[],
+                                      uint32_t k,
+                                      bool radius_search,
+                                      double radius,
+                                      size_t* out_num_ok_queries,
+                                      scc_PointIndex out_query_indices[],
+                                      scc_PointIndex out_nn_indices[]);
+
+bool iscc_kdt_close_nn_search_object(iscc_NNSearchObject** nn_search_object);
+
+
+// =============================================================================
+// Tree building helpers
+// =============================================================================
+
+/** Split points at the median.
+ *
+ *  Finds the dimension with the largest spread among the data points with
+ *  rows `point_rows` in `data_set`, and partially sorts `point_rows` along
+ *  this dimension so that element `len_point_rows / 2` is at its sorted
+ *  position. Returns the dimension.
+ */
+uint_fast16_t iscc_kdt_split_at_median(const scc_DataSet* data_set,
+                                       size_t point_rows[],
+                                       size_t len_point_rows);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_DIST_SEARCH_KDTREE_HG
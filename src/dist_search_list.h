@@ -0,0 +1,195 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_DIST_SEARCH_LIST_HG
+#define SCC_DIST_SEARCH_LIST_HG
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/scclust.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Sorted neighbor lists
+// =============================================================================
+
+/* Helpers shared by the built-in nearest neighbor searches. A neighbor list
+ * is a pair of arrays, distances and point indices, sorted by distance. */
+
+/** Insert a neighbor into a sorted list.
+ *
+ *  `dist_list` and `index_list` point to the free slot at the end of the list
+ *  (or to the last element when the list is full, which is then dropped).
+ *  Elements larger than `add_dist` are shifted one step towards the end.
+ *  Ties are kept in insertion order.
+ */
+static inline void iscc_add_dist_to_list(const double add_dist,
+                                         const scc_PointIndex add_index,
+                                         double* dist_list,
+                                         scc_PointIndex* index_list,
+                                         const double* const dist_list_start)
+{
+	assert(dist_list != NULL);
+	assert(index_list != NULL);
+	assert(dist_list_start != NULL);
+
+	for (; (dist_list != dist_list_start) && (add_dist < dist_list[-1]); --dist_list, --index_list) {
+		dist_list[0] = dist_list[-1];
+		index_list[0] = index_list[-1];
+	}
+	dist_list[0] = add_dist;
+	index_list[0] = add_index;
+}
+
+
+/** Insert a neighbor into a sorted list, ahead of its ties.
+ *
+ *  As #iscc_add_dist_to_list, except that `add_index` is placed before
+ *  elements with the same distance. Adding points in increasing index order
+ *  gives the same list as #iscc_add_dist_to_list gives with decreasing order.
+ */
+static inline void iscc_add_dist_to_list_before_ties(const double add_dist,
+                                                     const scc_PointIndex add_index,
+                                                     double* dist_list,
+                                                     scc_PointIndex* index_list,
+                                                     const double* const dist_list_start)
+{
+	assert(dist_list != NULL);
+	assert(index_list != NULL);
+	assert(dist_list_start != NULL);
+
+	for (; (dist_list != dist_list_start) && (add_dist <= dist_list[-1]); --dist_list, --index_list) {
+		dist_list[0] = dist_list[-1];
+		index_list[0] = index_list[-1];
+	}
+	dist_list[0] = add_dist;
+	index_list[0] = add_index;
+}
+
+
+// =============================================================================
+// Neighbor heaps
+// =============================================================================
+
+/* For large `k`, insertion into a sorted list costs O(k) per accepted point.
+ * A neighbor heap is instead a binary max-heap of length `k`, with the
+ * farthest neighbor at the root, so each accepted point costs O(log k). The
+ * heap is sorted once when the search of a query is done.
+ *
+ * Elements are ordered by distance and then by `key`. With keys given by
+ * the order the points are visited, the sorted heap is identical to the list
+ * built by #iscc_add_dist_to_list. */
+
+// Smallest `k` where the searches use heaps rather than sorted lists
+static const uint32_t ISCC_DIST_HEAP_MIN_K = 64;
+
+
+static inline bool iscc_dist_heap_less(const double dist1,
+                                       const scc_PointIndex key1,
+                                       const double dist2,
+                                       const scc_PointIndex key2)
+{
+	return (dist1 < dist2) || (!(dist2 < dist1) && (key1 < key2));
+}
+
+
+/** Add an element to a heap that is not full.
+ *
+ *  `len_heap` is the number of elements before the addition.
+ */
+static inline void iscc_push_dist_heap(const double add_dist,
+                                       const scc_PointIndex add_key,
+                                       size_t len_heap,
+                                       double dist_heap[const],
+                                       scc_PointIndex key_heap[const])
+{
+	assert(dist_heap != NULL);
+	assert(key_heap != NULL);
+
+	while (len_heap > 0) {
+		const size_t parent = (len_heap - 1) / 2;
+		if (!iscc_dist_heap_less(dist_heap[parent], key_heap[parent], add_dist, add_key)) break;
+		dist_heap[len_heap] = dist_heap[parent];
+		key_heap[len_heap] = key_heap[parent];
+		len_heap = parent;
+	}
+	dist_heap[len_heap] = add_dist;
+	key_heap[len_heap] = add_key;
+}
+
+
+/** Replace the root (the farthest element) of a heap.
+ *
+ *  The caller checks that the new element is closer than the root.
+ */
+static inline void iscc_replace_dist_heap_top(const double add_dist,
+                                              const scc_PointIndex add_key,
+                                              const size_t len_heap,
+                                              double dist_heap[const],
+                                              scc_PointIndex key_heap[const])
+{
+	assert(len_heap > 0);
+	assert(dist_heap != NULL);
+	assert(key_heap != NULL);
+
+	size_t pos = 0;
+	for (size_t child = 1; child < len_heap; child = 2 * pos + 1) {
+		if ((child + 1 < len_heap) && iscc_dist_heap_less(dist_heap[child], key_heap[child], dist_heap[child + 1], key_heap[child + 1])) {
+			++child;
+		}
+		if (!iscc_dist_heap_less(add_dist, add_key, dist_heap[child], key_heap[child])) break;
+		dist_heap[pos] = dist_heap[child];
+		key_heap[pos] = key_heap[child];
+		pos = child;
+	}
+	dist_heap[pos] = add_dist;
+	key_heap[pos] = add_key;
+}
+
+
+// Sort a heap in increasing order (the heap property is lost)
+static inline void iscc_sort_dist_heap(size_t len_heap,
+                                       double dist_heap[const],
+                                       scc_PointIndex key_heap[const])
+{
+	assert(dist_heap != NULL);
+	assert(key_heap != NULL);
+
+	while (len_heap > 1) {
+		--len_heap;
+		const double last_dist = dist_heap[len_heap];
+		const scc_PointIndex last_key = key_heap[len_heap];
+		dist_heap[len_heap] = dist_heap[0];
+		key_heap[len_heap] = key_heap[0];
+		iscc_replace_dist_heap_top(last_dist, last_key, len_heap, dist_heap, key_heap);
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_DIST_SEARCH_LIST_HG
@@ -23,16 +23,19 @@
 #include <assert.h>
 #include <stdio.h>
 #include "../include/scclust.h"
+#include "parallel.h"
 
 
 // =============================================================================
 // Internal variables
 // =============================================================================
 
-static scc_ErrorCode iscc_error_code = SCC_ER_OK;
-static const char* iscc_error_msg = NULL;
-static const char* iscc_error_file = "unknown file";
-static int iscc_error_line = -1;
+/* The error state is kept per thread, so clusterings made concurrently in
+ * different threads do not overwrite each other's errors. */
+static ISCC_THREAD_LOCAL scc_ErrorCode iscc_error_code = SCC_ER_OK;
+static ISCC_THREAD_LOCAL const char* iscc_error_msg = NULL;
+static ISCC_THREAD_LOCAL const char* iscc_error_file = "unknown file";
+static ISCC_THREAD_LOCAL int iscc_error_line = -1;
 
 
 // =============================================================================
@@ -64,6 +67,30 @@ void iscc_reset_error(void)
 }
 
 
+iscc_ErrorState iscc_get_error_state(void)
+{
+	return (iscc_ErrorState) {
+		.error_code = iscc_error_code,
+		.msg = iscc_error_msg,
+		.file = iscc_error_file,
+		.line = iscc_error_line,
+	};
+}
+
+
+scc_ErrorCode iscc_set_error_state(const iscc_ErrorState* const state)
+{
+	assert(state != NULL);
+
+	iscc_error_code = state->error_code;
+	iscc_error_msg = state->msg;
+	iscc_error_file = state->file;
+	iscc_error_line = state->line;
+
+	return state->error_code;
+}
+
+
 bool scc_get_latest_error(const size_t len_error_message_buffer,
                           char error_message_buffer[const])
 {
@@ -35,6 +35,21 @@
 #define iscc_no_error() (SCC_ER_OK)
 
 
+// =============================================================================
+// Structs
+// =============================================================================
+
+/* The error state of a thread. Messages and file names are string literals,
+ * so the state can be passed to other threads. */
+typedef struct iscc_ErrorState iscc_ErrorState;
+struct iscc_ErrorState {
+	scc_ErrorCode error_code;
+	const char* msg;
+	const char* file;
+	int line;
+};
+
+
 // =============================================================================
 // Function prototypes
 // =============================================================================
@@ -46,5 +61,11 @@ scc_ErrorCode iscc_make_error__(scc_ErrorCode ec,
 
 void iscc_reset_error(void);
 
+// Error state of the calling thread
+iscc_ErrorState iscc_get_error_state(void);
+
+// Sets the error state of the calling thread, e.g., to the state of a worker thread, and returns its error code
+scc_ErrorCode iscc_set_error_state(const iscc_ErrorState* state);
+
 
 #endif // ifndef SCC_ERROR_HG
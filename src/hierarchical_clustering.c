@@ -26,13 +26,33 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "dist_search.h"
 #include "clustering_struct.h"
+#include "dist_search_balltree.h"
+#include "dist_search_imp.h"
 #include "error.h"
+#include "parallel.h"
 #include "scclust_types.h"
 
-// Maximum number of data points to check when finding centers.
-static const uint_fast16_t ISCC_HI_NUM_TO_CHECK = 100;
+// Minimum number of data points to split clusters in parallel.
+static const size_t ISCC_HI_MIN_PARALLEL_SIZE = 4096;
+
+// Number of clusters per thread to split serially before the threads start.
+static const size_t ISCC_HI_TASKS_PER_THREAD = 8;
+
+// Minimum number of edges to sort with radix sort rather than `qsort`.
+static const size_t ISCC_HI_RADIX_MIN_SIZE = 256;
+
+#define ISCC_M_HI_OPTIONS_STRUCT_VERSION 722726001
+static const int32_t ISCC_HI_OPTIONS_STRUCT_VERSION = ISCC_M_HI_OPTIONS_STRUCT_VERSION;
+
+const scc_HierarchicalOptions scc_default_hierarchical_options = {
+	.options_version = ISCC_M_HI_OPTIONS_STRUCT_VERSION, // GCC error if not init with macro
+	.dist_backend = NULL,
+	.center_search_points = 100,
+	.center_search_rounds = 0,
+};
 
 
 // =============================================================================
@@ -69,6 +89,10 @@ struct iscc_hi_WorkArea {
 	uint_fast16_t* const vertex_markers;
 	iscc_hi_DistanceEdge* const edge_store1;
 	iscc_hi_DistanceEdge* const edge_store2;
+	uint64_t* const sort_keys;
+	scc_PointIndex* const sort_heads;
+	const size_t num_to_check;       // Maximum number of points to start the center search from
+	const uint32_t max_center_rounds; // Maximum number of center search rounds (zero: no maximum)
 };
 
 
@@ -83,12 +107,48 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* in_cl,
                                            iscc_hi_ClusterStack* out_cl_stack,
                                            size_t* out_size_largest_cluster);
 
+static iscc_hi_WorkArea iscc_hi_init_work_area(uint32_t size_constraint,
+                                               size_t size_largest_cluster,
+                                               uint_fast16_t vertex_markers[],
+                                               size_t num_to_check,
+                                               uint32_t max_center_rounds);
+
+static bool iscc_hi_check_work_area(const iscc_hi_WorkArea* work_area);
+
+static void iscc_hi_free_work_area(iscc_hi_WorkArea* work_area);
+
+static bool iscc_hi_dist_functions_thread_safe(void);
+
+static scc_ErrorCode iscc_hi_hierarchical_clustering(void* data_set,
+                                                     scc_Clustering* clustering,
+                                                     uint32_t size_constraint,
+                                                     bool batch_assign,
+                                                     size_t num_to_check,
+                                                     uint32_t max_center_rounds);
+
 static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* cl_stack,
-                                                         scc_Clustering* cl,
+                                                         scc_Clabel cluster_label[],
                                                          void* data_set,
                                                          iscc_hi_WorkArea* work_area,
                                                          uint32_t size_constraint,
-                                                         bool batch_assign);
+                                                         bool batch_assign,
+                                                         size_t* out_num_clusters);
+
+static scc_ErrorCode iscc_hi_run_parallel_clustering(iscc_hi_ClusterStack* cl_stack,
+                                                     scc_Clustering* cl,
+                                                     void* data_set,
+                                                     uint32_t size_constraint,
+                                                     bool batch_assign,
+                                                     size_t num_to_check,
+                                                     uint32_t max_center_rounds,
+                                                     int num_threads);
+
+static scc_ErrorCode iscc_hi_split_into_tasks(iscc_hi_ClusterStack* cl_stack,
+                                              void* data_set,
+                                              iscc_hi_WorkArea* work_area,
+                                              uint32_t size_constraint,
+                                              bool batch_assign,
+                                              size_t num_tasks);
 
 static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* cl_stack,
                                            iscc_hi_ClusterItem** cl);
@@ -150,8 +210,17 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cl,
 static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* cl,
                                           scc_PointIndex center,
                                           const double row_dists[static cl->size],
+                                          uint64_t sort_keys[],
+                                          scc_PointIndex sort_heads[],
                                           iscc_hi_DistanceEdge edge_store[static cl->size]);
 
+static void iscc_hi_radix_sort_edges(size_t len_edges,
+                                     uint64_t keys[static len_edges],
+                                     scc_PointIndex heads[static len_edges],
+                                     uint64_t keys_buffer[static len_edges],
+                                     scc_PointIndex heads_buffer[static len_edges],
+                                     iscc_hi_DistanceEdge out_edges[static len_edges]);
+
 static int iscc_hi_compare_dist_edges(const void* a,
                                       const void* b);
 
@@ -165,6 +234,59 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
                                           const uint32_t size_constraint,
                                           const bool batch_assign)
 {
+	return scc_hierarchical_clustering_with_options(data_set,
+	                                                clustering,
+	                                                size_constraint,
+	                                                batch_assign,
+	                                                &scc_default_hierarchical_options);
+}
+
+
+scc_ErrorCode scc_hierarchical_clustering_with_options(void* const data_set,
+                                                       scc_Clustering* const clustering,
+                                                       const uint32_t size_constraint,
+                                                       const bool batch_assign,
+                                                       const scc_HierarchicalOptions* const options)
+{
+	if (options == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid options.");
+	}
+	if (options->options_version != ISCC_HI_OPTIONS_STRUCT_VERSION) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Incompatible scc_HierarchicalOptions version.");
+	}
+	if (options->center_search_points == 0) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Center search must start from at least one point.");
+	}
+	if ((options->dist_backend != NULL) && !iscc_is_dist_backend(options->dist_backend)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid distance backend.");
+	}
+
+	const scc_DistBackend* const previous_backend = iscc_set_active_dist_backend(options->dist_backend);
+	const scc_ErrorCode ec = iscc_hi_hierarchical_clustering(data_set,
+	                                                         clustering,
+	                                                         size_constraint,
+	                                                         batch_assign,
+	                                                         (size_t) options->center_search_points,
+	                                                         options->center_search_rounds);
+	iscc_set_active_dist_backend(previous_backend);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_hi_hierarchical_clustering(void* const data_set,
+                                                     scc_Clustering* const clustering,
+                                                     const uint32_t size_constraint,
+                                                     const bool batch_assign,
+                                                     const size_t num_to_check,
+                                                     const uint32_t max_center_rounds)
+{
+	assert(num_to_check > 0);
+
 	if (!iscc_check_input_clustering(clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
 	}
@@ -202,38 +324,43 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 	assert(cl_stack.clusters != NULL);
 	assert(cl_stack.pointindex_store != NULL);
 
-	const size_t size_pointindex_array = (size_constraint > ISCC_HI_NUM_TO_CHECK) ? size_constraint : ISCC_HI_NUM_TO_CHECK;
-	const size_t size_dist_array = ((2 * size_largest_cluster) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_largest_cluster) : ISCC_HI_NUM_TO_CHECK;
-	iscc_hi_WorkArea work_area = {
-		.pointindex_array1 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.pointindex_array2 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.dist_array = malloc(sizeof(double[size_dist_array])),
-		.vertex_markers = calloc(clustering->num_data_points, sizeof(uint_fast16_t)),
-		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
-		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
-	};
+	const int num_threads = iscc_get_num_threads();
+	if ((num_threads > 1) && (clustering->num_data_points >= ISCC_HI_MIN_PARALLEL_SIZE) &&
+	        iscc_hi_dist_functions_thread_safe()) {
+		ec = iscc_hi_run_parallel_clustering(&cl_stack,
+		                                     clustering,
+		                                     data_set,
+		                                     size_constraint,
+		                                     batch_assign,
+		                                     num_to_check,
+		                                     max_center_rounds,
+		                                     num_threads);
+	} else {
+		uint_fast16_t* const vertex_markers = calloc(clustering->num_data_points, sizeof(uint_fast16_t));
+		iscc_hi_WorkArea work_area = iscc_hi_init_work_area(size_constraint,
+		                                                     size_largest_cluster,
+		                                                     vertex_markers,
+		                                                     num_to_check,
+		                                                     max_center_rounds);
+
+		if ((vertex_markers == NULL) || !iscc_hi_check_work_area(&work_area)) {
+			ec = iscc_make_error(SCC_ER_NO_MEMORY);
+		}
 
-	if ((work_area.pointindex_array1 == NULL) || (work_area.pointindex_array2 == NULL) ||
-	        (work_area.dist_array == NULL) || (work_area.vertex_markers == NULL) ||
-	        (work_area.edge_store1 == NULL) || (work_area.edge_store2 == NULL)) {
-		ec = iscc_make_error(SCC_ER_NO_MEMORY);
-	}
+		if (ec == SCC_ER_OK) {
+			ec = iscc_hi_run_hierarchical_clustering(&cl_stack,
+			                                         clustering->cluster_label,
+			                                         data_set,
+			                                         &work_area,
+			                                         size_constraint,
+			                                         batch_assign,
+			                                         &clustering->num_clusters);
+		}
 
-	if (ec == SCC_ER_OK) {
-		ec = iscc_hi_run_hierarchical_clustering(&cl_stack,
-		                                         clustering,
-		                                         data_set,
-		                                         &work_area,
-		                                         size_constraint,
-		                                         batch_assign);
+		iscc_hi_free_work_area(&work_area);
+		free(vertex_markers);
 	}
 
-	free(work_area.pointindex_array1);
-	free(work_area.pointindex_array2);
-	free(work_area.dist_array);
-	free(work_area.vertex_markers);
-	free(work_area.edge_store1);
-	free(work_area.edge_store2);
 	free(cl_stack.clusters);
 	free(cl_stack.pointindex_store);
 
@@ -241,10 +368,6 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 }
 
 
-// =============================================================================
-// Internal function implementations
-// =============================================================================
-
 static scc_ErrorCode iscc_hi_empty_cl_stack(const size_t num_data_points,
                                             iscc_hi_ClusterStack* const out_cl_stack)
 {
@@ -335,22 +458,90 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* const in_cl,
 }
 
 
+static iscc_hi_WorkArea iscc_hi_init_work_area(const uint32_t size_constraint,
+                                               const size_t size_largest_cluster,
+                                               uint_fast16_t vertex_markers[const],
+                                               const size_t num_to_check,
+                                               const uint32_t max_center_rounds)
+{
+	assert(size_constraint >= 2);
+	assert(size_largest_cluster > 0);
+	assert(num_to_check > 0);
+
+	// No cluster has more members than the largest, so starting points beyond that are never used
+	const size_t num_checked = (num_to_check < size_largest_cluster) ? num_to_check : size_largest_cluster;
+	const size_t size_pointindex_array = (size_constraint > num_checked) ? size_constraint : num_checked;
+	const size_t size_dist_array = ((2 * size_largest_cluster) > num_checked) ? (2 * size_largest_cluster) : num_checked;
+	return (iscc_hi_WorkArea) {
+		.pointindex_array1 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
+		.pointindex_array2 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
+		.dist_array = malloc(sizeof(double[size_dist_array])),
+		.vertex_markers = vertex_markers,
+		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
+		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
+		.sort_keys = malloc(sizeof(uint64_t[2 * size_largest_cluster])),
+		.sort_heads = malloc(sizeof(scc_PointIndex[2 * size_largest_cluster])),
+		.num_to_check = num_checked,
+		.max_center_rounds = max_center_rounds,
+	};
+}
+
+
+static bool iscc_hi_check_work_area(const iscc_hi_WorkArea* const work_area)
+{
+	assert(work_area != NULL);
+	return (work_area->pointindex_array1 != NULL) && (work_area->pointindex_array2 != NULL) &&
+	       (work_area->dist_array != NULL) && (work_area->vertex_markers != NULL) &&
+	       (work_area->edge_store1 != NULL) && (work_area->edge_store2 != NULL) &&
+	       (work_area->sort_keys != NULL) && (work_area->sort_heads != NULL);
+}
+
+
+// Frees the work area, except `vertex_markers` which may be shared
+static void iscc_hi_free_work_area(iscc_hi_WorkArea* const work_area)
+{
+	assert(work_area != NULL);
+	free(work_area->pointindex_array1);
+	free(work_area->pointindex_array2);
+	free(work_area->dist_array);
+	free(work_area->edge_store1);
+	free(work_area->edge_store2);
+	free(work_area->sort_keys);
+	free(work_area->sort_heads);
+}
+
+
+// The built-in distance functions may be called concurrently
+static bool iscc_hi_dist_functions_thread_safe(void)
+{
+	const iscc_dist_functions_struct* const dist_functions = iscc_get_dist_functions();
+	return (dist_functions->get_dist_rows == iscc_imp_get_dist_rows) &&
+	       (((dist_functions->init_max_dist_object == iscc_imp_init_max_dist_object) &&
+	         (dist_functions->get_max_dist == iscc_imp_get_max_dist) &&
+	         (dist_functions->close_max_dist_object == iscc_imp_close_max_dist_object)) ||
+	        ((dist_functions->init_max_dist_object == iscc_bt_init_max_dist_object) &&
+	         (dist_functions->get_max_dist == iscc_bt_get_max_dist) &&
+	         (dist_functions->close_max_dist_object == iscc_bt_close_max_dist_object)));
+}
+
+
 static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* const cl_stack,
-                                                         scc_Clustering* const cl,
+                                                         scc_Clabel cluster_label[const],
                                                          void* const data_set,
                                                          iscc_hi_WorkArea* const work_area,
                                                          const uint32_t size_constraint,
-                                                         const bool batch_assign)
+                                                         const bool batch_assign,
+                                                         size_t* const out_num_clusters)
 {
 	assert(cl_stack != NULL);
 	assert(cl_stack->items > 0);
 	assert(cl_stack->items <= cl_stack->capacity);
 	assert(cl_stack->clusters != NULL);
-	assert(cl_stack->pointindex_store != NULL);
-	assert(iscc_check_input_clustering(cl));
-	assert(iscc_check_data_set(data_set, cl->num_data_points));
+	assert(cluster_label != NULL);
+	assert(iscc_check_data_set(data_set, 0));
 	assert(work_area != NULL);
 	assert(size_constraint >= 2);
+	assert(out_num_clusters != NULL);
 
 	scc_ErrorCode ec;
 	scc_Clabel current_label = 0;
@@ -363,7 +554,7 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 					return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
 				}
 				for (size_t v = 0; v < current_cluster->size; ++v) {
-					cl->cluster_label[current_cluster->members[v]] = current_label;
+					cluster_label[current_cluster->members[v]] = current_label;
 				}
 				++current_label;
 			}
@@ -373,6 +564,8 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 			if ((ec = iscc_hi_push_to_stack(cl_stack, &new_cluster)) != SCC_ER_OK) {
 				return ec;
 			}
+			// Pushing may reallocate the stack
+			current_cluster = &cl_stack->clusters[cl_stack->items - 2];
 			if ((ec = iscc_hi_break_cluster_into_two(current_cluster,
 			                                         data_set,
 			                                         work_area,
@@ -384,7 +577,7 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 		}
 	}
 
-	cl->num_clusters = (size_t) current_label;
+	*out_num_clusters = (size_t) current_label;
 
 	assert(cl_stack->items == 0);
 
@@ -392,6 +585,204 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 }
 
 
+static scc_ErrorCode iscc_hi_run_parallel_clustering(iscc_hi_ClusterStack* const cl_stack,
+                                                     scc_Clustering* const cl,
+                                                     void* const data_set,
+                                                     const uint32_t size_constraint,
+                                                     const bool batch_assign,
+                                                     const size_t num_to_check,
+                                                     const uint32_t max_center_rounds,
+                                                     const int num_threads)
+{
+	assert(cl_stack != NULL);
+	assert(cl_stack->items > 0);
+	assert(iscc_check_input_clustering(cl));
+	assert(iscc_check_data_set(data_set, cl->num_data_points));
+	assert(size_constraint >= 2);
+	assert(num_threads > 1);
+
+	/* How a cluster is split depends only on its members and on its own
+	 * marker, not on when it is split. The largest clusters are first split
+	 * serially until there are `ISCC_HI_TASKS_PER_THREAD` clusters per thread,
+	 * keeping the stack in the order the serial clustering would pop it. Each
+	 * cluster on the stack is then clustered by one thread with its own work
+	 * area and stack, labeling its clusters from zero. The `vertex_markers`
+	 * are shared, as the clusters have no points in common. Finally, the
+	 * labels are offset by the number of clusters above on the stack, which
+	 * gives the labels of the serial clustering. */
+
+	scc_ErrorCode ec = iscc_no_error();
+	uint_fast16_t* const vertex_markers = calloc(cl->num_data_points, sizeof(uint_fast16_t));
+	if (vertex_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	size_t size_largest_cluster = 0;
+	for (size_t c = 0; c < cl_stack->items; ++c) {
+		if (cl_stack->clusters[c].size > size_largest_cluster) size_largest_cluster = cl_stack->clusters[c].size;
+	}
+
+	iscc_hi_WorkArea work_area = iscc_hi_init_work_area(size_constraint,
+	                                                    size_largest_cluster,
+	                                                    vertex_markers,
+	                                                    num_to_check,
+	                                                    max_center_rounds);
+	if (!iscc_hi_check_work_area(&work_area)) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	if (ec == SCC_ER_OK) {
+		ec = iscc_hi_split_into_tasks(cl_stack,
+		                              data_set,
+		                              &work_area,
+		                              size_constraint,
+		                              batch_assign,
+		                              ISCC_HI_TASKS_PER_THREAD * (size_t) num_threads);
+	}
+	iscc_hi_free_work_area(&work_area);
+
+	const size_t num_tasks = cl_stack->items;
+	size_t* const task_num_clusters = malloc(sizeof(size_t[num_tasks]));
+	if ((ec == SCC_ER_OK) && (task_num_clusters == NULL)) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	if (ec != SCC_ER_OK) {
+		free(task_num_clusters);
+		free(vertex_markers);
+		return ec;
+	}
+
+	size_largest_cluster = 0;
+	for (size_t t = 0; t < num_tasks; ++t) {
+		if (cl_stack->clusters[t].size > size_largest_cluster) size_largest_cluster = cl_stack->clusters[t].size;
+	}
+
+	const scc_DistBackend* const dist_backend = iscc_active_dist_backend;
+	iscc_ErrorState task_error = { .error_code = SCC_ER_OK };
+
+	ISCC_OMP(parallel num_threads(num_threads))
+	{
+		const scc_DistBackend* const worker_backend = iscc_set_active_dist_backend(dist_backend);
+		iscc_hi_WorkArea worker_area = iscc_hi_init_work_area(size_constraint,
+		                                                      size_largest_cluster,
+		                                                      vertex_markers,
+		                                                      num_to_check,
+		                                                      max_center_rounds);
+		// Each item on the stack has at least `size_constraint` points, plus one pushed before splitting
+		iscc_hi_ClusterStack worker_stack = {
+			.capacity = 2 + size_largest_cluster / size_constraint,
+			.items = 0,
+			.clusters = malloc(sizeof(iscc_hi_ClusterItem[2 + size_largest_cluster / size_constraint])),
+			.pointindex_store = NULL,
+		};
+
+		scc_ErrorCode worker_ec = SCC_ER_OK;
+		if (!iscc_hi_check_work_area(&worker_area) || (worker_stack.clusters == NULL)) {
+			worker_ec = iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+
+		ISCC_OMP(for schedule(dynamic, 1))
+		for (size_t t = 0; t < num_tasks; ++t) {
+			if (worker_ec != SCC_ER_OK) continue;
+			worker_stack.items = 1;
+			worker_stack.clusters[0] = cl_stack->clusters[t];
+			worker_ec = iscc_hi_run_hierarchical_clustering(&worker_stack,
+			                                                cl->cluster_label,
+			                                                data_set,
+			                                                &worker_area,
+			                                                size_constraint,
+			                                                batch_assign,
+			                                                &task_num_clusters[t]);
+		}
+
+		// The error state is per thread, so it is copied for the calling thread
+		if (worker_ec != SCC_ER_OK) {
+			ISCC_OMP(critical(iscc_hi_task_error))
+			task_error = iscc_get_error_state();
+		}
+
+		iscc_hi_free_work_area(&worker_area);
+		free(worker_stack.clusters);
+		iscc_set_active_dist_backend(worker_backend);
+	}
+
+	free(vertex_markers);
+
+	if (task_error.error_code != SCC_ER_OK) {
+		free(task_num_clusters);
+		return iscc_set_error_state(&task_error);
+	}
+
+	// The serial clustering pops the top of the stack first
+	size_t num_clusters = 0;
+	for (size_t t = num_tasks; t > 0; --t) {
+		const size_t task_offset = num_clusters;
+		num_clusters += task_num_clusters[t - 1];
+		task_num_clusters[t - 1] = task_offset;
+	}
+	if (num_clusters > (size_t) SCC_CLABEL_MAX) {
+		free(task_num_clusters);
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+	}
+
+	ISCC_OMP(parallel for num_threads(num_threads) schedule(dynamic, 16))
+	for (size_t t = 0; t < num_tasks; ++t) {
+		const iscc_hi_ClusterItem* const task = &cl_stack->clusters[t];
+		const scc_Clabel task_offset = (scc_Clabel) task_num_clusters[t];
+		for (size_t v = 0; v < task->size; ++v) {
+			cl->cluster_label[task->members[v]] += task_offset;
+		}
+	}
+
+	cl->num_clusters = num_clusters;
+	cl_stack->items = 0;
+
+	free(task_num_clusters);
+
+	return iscc_no_error();
+}
+
+
+// Splits the largest clusters on the stack until it holds `num_tasks` clusters or no cluster can be split
+static scc_ErrorCode iscc_hi_split_into_tasks(iscc_hi_ClusterStack* const cl_stack,
+                                              void* const data_set,
+                                              iscc_hi_WorkArea* const work_area,
+                                              const uint32_t size_constraint,
+                                              const bool batch_assign,
+                                              const size_t num_tasks)
+{
+	assert(cl_stack != NULL);
+	assert(cl_stack->items > 0);
+	assert(work_area != NULL);
+	assert(size_constraint >= 2);
+
+	scc_ErrorCode ec;
+	while (cl_stack->items < num_tasks) {
+		size_t largest = 0;
+		for (size_t c = 1; c < cl_stack->items; ++c) {
+			if (cl_stack->clusters[c].size > cl_stack->clusters[largest].size) largest = c;
+		}
+		if (cl_stack->clusters[largest].size < (2 * size_constraint)) break;
+
+		iscc_hi_ClusterItem* new_cluster = NULL; // Initialize to avoid gcc warning
+		if ((ec = iscc_hi_push_to_stack(cl_stack, &new_cluster)) != SCC_ER_OK) {
+			return ec;
+		}
+
+		// The new cluster is popped right after the cluster it is split from
+		iscc_hi_ClusterItem* const clusters = cl_stack->clusters;
+		memmove(clusters + largest + 2, clusters + largest + 1, sizeof(iscc_hi_ClusterItem[cl_stack->items - largest - 2]));
+		if ((ec = iscc_hi_break_cluster_into_two(&clusters[largest],
+		                                         data_set,
+		                                         work_area,
+		                                         size_constraint,
+		                                         batch_assign,
+		                                         &clusters[largest + 1])) != SCC_ER_OK) {
+			return ec;
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
 static scc_ErrorCode iscc_hi_push_to_stack(iscc_hi_ClusterStack* const cl_stack,
                                            iscc_hi_ClusterItem** const cl)
 {
@@ -717,12 +1108,17 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 
 	const uint_fast16_t curr_marker = iscc_hi_get_next_marker(cl, vertex_markers);
 
-	size_t step = cl->size / ISCC_HI_NUM_TO_CHECK;
+	/* The search starts from every `step`th member rather than a random
+	 * sample. This gives the same clustering as earlier versions with the
+	 * default setting, does not depend on which thread splits the cluster,
+	 * and spreads the points over the member order, which follows the
+	 * previous split. */
+	size_t step = cl->size / work_area->num_to_check;
 	if (step < 2) step = 2;
 	// num_to_check = ceil(size / step) = floor((size + step - 1) / step) = 1 + floor((size - 1) / step)
-	uint_fast16_t num_to_check = ((uint_fast16_t) (1 + (cl->size - 1) / step));
-	num_to_check = (ISCC_HI_NUM_TO_CHECK < num_to_check) ? ISCC_HI_NUM_TO_CHECK : num_to_check;
-	assert(num_to_check <= ISCC_HI_NUM_TO_CHECK);
+	size_t num_to_check = 1 + (cl->size - 1) / step;
+	num_to_check = (work_area->num_to_check < num_to_check) ? work_area->num_to_check : num_to_check;
+	assert(num_to_check <= work_area->num_to_check);
 
 	for (size_t i = 0; i < num_to_check; ++i) {
 		to_check[i] = cl->members[i * step];
@@ -735,14 +1131,16 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 	}
 
 	double max_dist = -1.0;
-	while (num_to_check > 0) {
+	for (uint32_t round = 0; num_to_check > 0; ++round) {
+		if ((work_area->max_center_rounds > 0) && (round == work_area->max_center_rounds)) break;
+
 		if (!iscc_get_max_dist(max_dist_object, num_to_check, to_check, max_indices, max_dists)) {
 			iscc_close_max_dist_object(&max_dist_object);
 			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
 
-		uint_fast16_t write_in_to_check = 0;
-		for (uint_fast16_t i = 0; i < num_to_check; ++i) {
+		size_t write_in_to_check = 0;
+		for (size_t i = 0; i < num_to_check; ++i) {
 			if (max_dists[i] > max_dist) {
 				max_dist = max_dists[i];
 				*out_center1 = to_check[i];
@@ -795,8 +1193,8 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	iscc_hi_sort_edge_list(cl, center1, row_dists, work_area->edge_store1);
-	iscc_hi_sort_edge_list(cl, center2, row_dists + cl->size, work_area->edge_store2);
+	iscc_hi_sort_edge_list(cl, center1, row_dists, work_area->sort_keys, work_area->sort_heads, work_area->edge_store1);
+	iscc_hi_sort_edge_list(cl, center2, row_dists + cl->size, work_area->sort_keys, work_area->sort_heads, work_area->edge_store2);
 
 	return iscc_no_error();
 }
@@ -805,6 +1203,8 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* const cl,
                                           const scc_PointIndex center,
                                           const double row_dists[const static cl->size],
+                                          uint64_t sort_keys[const],
+                                          scc_PointIndex sort_heads[const],
                                           iscc_hi_DistanceEdge edge_store[const static cl->size])
 {
 	assert(cl != NULL);
@@ -813,19 +1213,48 @@ static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* const cl,
 	assert(row_dists != NULL);
 	assert(edge_store != NULL);
 
-	iscc_hi_DistanceEdge* write_edge = edge_store + 1;
-	for (size_t i = 0; i < cl->size; ++i) {
-		if (cl->members[i] == center) continue;
-		write_edge->head = cl->members[i];
-		write_edge->distance = row_dists[i];
-		++write_edge;
-	}
+	const size_t len_edges = cl->size - 1;
 
-	assert(write_edge == (edge_store + cl->size));
+	if (len_edges < ISCC_HI_RADIX_MIN_SIZE) {
+		iscc_hi_DistanceEdge* write_edge = edge_store + 1;
+		for (size_t i = 0; i < cl->size; ++i) {
+			if (cl->members[i] == center) continue;
+			write_edge->head = cl->members[i];
+			write_edge->distance = row_dists[i];
+			++write_edge;
+		}
 
-	qsort(edge_store + 1, cl->size - 1, sizeof(iscc_hi_DistanceEdge), iscc_hi_compare_dist_edges);
+		assert(write_edge == (edge_store + cl->size));
 
-	iscc_hi_DistanceEdge* const edge_stop = edge_store + cl->size - 1;
+		qsort(edge_store + 1, len_edges, sizeof(iscc_hi_DistanceEdge), iscc_hi_compare_dist_edges);
+	} else {
+		assert(sort_keys != NULL);
+		assert(sort_heads != NULL);
+
+		/* The bits of a non-negative double are ordered as the double. Flipping
+		 * the sign bit of positive values, and all bits of negative values,
+		 * orders all doubles as unsigned integers. */
+		size_t write = 0;
+		for (size_t i = 0; i < cl->size; ++i) {
+			if (cl->members[i] == center) continue;
+			uint64_t key;
+			memcpy(&key, &row_dists[i], sizeof(uint64_t));
+			sort_keys[write] = (key >> 63) ? ~key : (key | (UINT64_C(1) << 63));
+			sort_heads[write] = cl->members[i];
+			++write;
+		}
+
+		assert(write == len_edges);
+
+		iscc_hi_radix_sort_edges(len_edges,
+		                         sort_keys,
+		                         sort_heads,
+		                         sort_keys + len_edges,
+		                         sort_heads + len_edges,
+		                         edge_store + 1);
+	}
+
+	iscc_hi_DistanceEdge* const edge_stop = edge_store + len_edges;
 	for (iscc_hi_DistanceEdge* edge = edge_store; edge != edge_stop; ++edge) {
 		edge->next_dist = edge + 1;
 	}
@@ -833,6 +1262,67 @@ static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* const cl,
 }
 
 
+// Sorts edges by key with a stable LSD radix sort on bytes, skipping bytes that all keys share
+static void iscc_hi_radix_sort_edges(const size_t len_edges,
+                                     uint64_t keys[const static len_edges],
+                                     scc_PointIndex heads[const static len_edges],
+                                     uint64_t keys_buffer[const static len_edges],
+                                     scc_PointIndex heads_buffer[const static len_edges],
+                                     iscc_hi_DistanceEdge out_edges[const static len_edges])
+{
+	assert(len_edges > 0);
+	assert(keys != NULL);
+	assert(heads != NULL);
+	assert(keys_buffer != NULL);
+	assert(heads_buffer != NULL);
+	assert(out_edges != NULL);
+
+	size_t counts[8][256] = { { 0 } };
+	for (size_t i = 0; i < len_edges; ++i) {
+		const uint64_t key = keys[i];
+		for (unsigned byte = 0; byte < 8; ++byte) {
+			++counts[byte][(key >> (8 * byte)) & 0xFF];
+		}
+	}
+
+	uint64_t* from_keys = keys;
+	scc_PointIndex* from_heads = heads;
+	uint64_t* to_keys = keys_buffer;
+	scc_PointIndex* to_heads = heads_buffer;
+	for (unsigned byte = 0; byte < 8; ++byte) {
+		size_t* const byte_counts = counts[byte];
+		if (byte_counts[(from_keys[0] >> (8 * byte)) & 0xFF] == len_edges) continue;
+
+		size_t offset = 0;
+		for (size_t digit = 0; digit < 256; ++digit) {
+			const size_t count = byte_counts[digit];
+			byte_counts[digit] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < len_edges; ++i) {
+			const size_t pos = byte_counts[(from_keys[i] >> (8 * byte)) & 0xFF]++;
+			to_keys[pos] = from_keys[i];
+			to_heads[pos] = from_heads[i];
+		}
+
+		uint64_t* const tmp_keys = from_keys;
+		from_keys = to_keys;
+		to_keys = tmp_keys;
+		scc_PointIndex* const tmp_heads = from_heads;
+		from_heads = to_heads;
+		to_heads = tmp_heads;
+	}
+
+	for (size_t i = 0; i < len_edges; ++i) {
+		uint64_t key = from_keys[i];
+		key = (key >> 63) ? (key & ~(UINT64_C(1) << 63)) : ~key;
+		out_edges[i].head = from_heads[i];
+		memcpy(&out_edges[i].distance, &key, sizeof(double));
+	}
+}
+
+
 static int iscc_hi_compare_dist_edges(const void* const a,
                                       const void* const b)
 {
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "../include/scclust.h"
+#include "bitset.h"
 #include "clustering_struct.h"
 #include "dist_search.h"
 #include "error.h"
@@ -52,7 +53,7 @@ scc_ErrorCode iscc_run_nng_batches(scc_Clustering* clustering,
                                    uint32_t batch_size,
                                    scc_PointIndex* batch_indices,
                                    scc_PointIndex* out_indices,
-                                   bool* assigned);
+                                   iscc_BitWord* assigned);
 
 
 // =============================================================================
@@ -112,7 +113,7 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 
 	scc_PointIndex* const batch_indices = malloc(sizeof(scc_PointIndex[batch_size]));
 	scc_PointIndex* const out_indices = malloc(sizeof(scc_PointIndex[size_constraint * batch_size]));
-	bool* const assigned = calloc(clustering->num_data_points, sizeof(bool));
+	iscc_BitWord* const assigned = iscc_alloc_bitset(clustering->num_data_points);
 	if ((batch_indices == NULL) || (out_indices == NULL) || (assigned == NULL)) {
 		free(batch_indices);
 		free(out_indices);
@@ -190,7 +191,7 @@ scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
                                    const uint32_t batch_size,
                                    scc_PointIndex* const batch_indices,
                                    scc_PointIndex* const out_indices,
-                                   bool* const assigned)
+                                   iscc_BitWord* const assigned)
 {
 	assert(iscc_check_input_clustering(clustering));
 	assert(clustering->cluster_label != NULL);
@@ -214,7 +215,7 @@ scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
 		size_t in_batch = 0;
 		if (primary_data_points == NULL) {
 			for (; (in_batch < batch_size) && (curr_point < num_data_points); ++curr_point) {
-				if (!assigned[curr_point]) {
+				if (!iscc_bitset_test(assigned, (size_t) curr_point)) {
 					clustering->cluster_label[curr_point] = SCC_CLABEL_NA;
 					batch_indices[in_batch] = curr_point;
 					++in_batch;
@@ -222,7 +223,7 @@ scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
 			}
 		} else {
 			for (; (in_batch < batch_size) && (curr_point < num_data_points); ++curr_point) {
-				if (!assigned[curr_point]) {
+				if (!iscc_bitset_test(assigned, (size_t) curr_point)) {
 					clustering->cluster_label[curr_point] = SCC_CLABEL_NA;
 					if (primary_data_points[curr_point]) {
 						batch_indices[in_batch] = curr_point;
@@ -260,30 +261,30 @@ scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
 		const scc_PointIndex* check_indices = out_indices;
 		for (size_t i = 0; i < num_ok_in_batch; ++i) {
 			const scc_PointIndex* const stop_check_indices = check_indices + size_constraint;
-			if (!assigned[batch_indices[i]]) {
-				for (; (check_indices != stop_check_indices) && !assigned[*check_indices]; ++check_indices) {}
+			if (!iscc_bitset_test(assigned, (size_t) batch_indices[i])) {
+				for (; (check_indices != stop_check_indices) && !iscc_bitset_test(assigned, (size_t) *check_indices); ++check_indices) {}
 				if (check_indices == stop_check_indices) {
 					// `i` has no assigned neighbors and can be seed
 					if (next_cluster_label == SCC_CLABEL_MAX) {
 						return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
 					}
 
-					assert(!assigned[batch_indices[i]]);
+					assert(!iscc_bitset_test(assigned, (size_t) batch_indices[i]));
 					const scc_PointIndex* const stop_assign_indices = stop_check_indices - 1;
 					for (check_indices -= size_constraint; check_indices != stop_assign_indices; ++check_indices) {
-						assert(!assigned[*check_indices]);
-						assigned[*check_indices] = true;
+						assert(!iscc_bitset_test(assigned, (size_t) *check_indices));
+						iscc_bitset_set(assigned, (size_t) *check_indices);
 						clustering->cluster_label[*check_indices] = next_cluster_label;
 					}
-					if (assigned[batch_indices[i]]) {
+					if (iscc_bitset_test(assigned, (size_t) batch_indices[i])) {
 						// Self-loop from `batch_indices[i]` to `batch_indices[i]` existed among NN
-						assert(!assigned[*check_indices]);
-						assigned[*check_indices] = true;
+						assert(!iscc_bitset_test(assigned, (size_t) *check_indices));
+						iscc_bitset_set(assigned, (size_t) *check_indices);
 						clustering->cluster_label[*check_indices] = next_cluster_label;
 					} else {
 						// Self-loop did not exist
-						assert(!assigned[batch_indices[i]]);
-						assigned[batch_indices[i]] = true;
+						assert(!iscc_bitset_test(assigned, (size_t) batch_indices[i]));
+						iscc_bitset_set(assigned, (size_t) batch_indices[i]);
 						clustering->cluster_label[batch_indices[i]] = next_cluster_label;
 					}
 
@@ -294,10 +295,10 @@ scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
 					if (!ignore_unassigned) {
 						// Assign `batch_indices[i]` to a preliminary cluster.
 						// If a future seed wants it as neighbor, it switches cluster.
-						assert(assigned[*check_indices]);
+						assert(iscc_bitset_test(assigned, (size_t) *check_indices));
 						assert(clustering->cluster_label[batch_indices[i]] == SCC_CLABEL_NA);
 						assert(clustering->cluster_label[*check_indices] != SCC_CLABEL_NA);
-						assert(!assigned[batch_indices[i]]);
+						assert(!iscc_bitset_test(assigned, (size_t) batch_indices[i]));
 						clustering->cluster_label[batch_indices[i]] = clustering->cluster_label[*check_indices];
 					}
 				}
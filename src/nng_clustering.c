@@ -38,7 +38,8 @@
 // Internal variables
 // =============================================================================
 
-#define ISCC_M_OPTIONS_STRUCT_VERSION 722678001
+// Must change whenever the layout of scc_ClusterOptions changes
+#define ISCC_M_OPTIONS_STRUCT_VERSION 722725001
 static const int32_t ISCC_OPTIONS_STRUCT_VERSION = ISCC_M_OPTIONS_STRUCT_VERSION;
 
 const scc_ClusterOptions scc_default_cluster_options = {
@@ -60,6 +61,11 @@ const scc_ClusterOptions scc_default_cluster_options = {
 	.secondary_radius = SCC_RM_USE_SEED_RADIUS,
 	.secondary_supplied_radius = 0.0,
 	.batch_size = 0,
+	.approximate_nng = false,
+	.approximate_nng_sample_rate = 1.0,
+	.approximate_nng_delta = 0.001,
+	.dist_backend = NULL,
+	.reorder_nng = false,
 };
 
 
@@ -67,6 +73,16 @@ const scc_ClusterOptions scc_default_cluster_options = {
 // Internal function prototypes
 // =============================================================================
 
+static scc_ErrorCode iscc_make_clustering(void* data_set,
+                                          scc_Clustering* clustering,
+                                          const scc_ClusterOptions* options);
+
+static scc_ErrorCode iscc_make_clusterings(void* data_set,
+                                           size_t num_clusterings,
+                                           scc_Clustering* const clusterings[],
+                                           const uint32_t size_constraints[],
+                                           const scc_ClusterOptions* options);
+
 static scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* options,
                                                 size_t num_data_points);
 
@@ -83,6 +99,60 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* clustering,
 scc_ErrorCode scc_make_clustering(void* const data_set,
                                   scc_Clustering* const clustering,
                                   const scc_ClusterOptions* const options)
+{
+	// The backend must be active before the data set is checked
+	const scc_DistBackend* dist_backend = NULL;
+	if ((options != NULL) && (options->options_version == ISCC_OPTIONS_STRUCT_VERSION)) {
+		dist_backend = options->dist_backend;
+	}
+	if ((dist_backend != NULL) && !iscc_is_dist_backend(dist_backend)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid distance backend.");
+	}
+
+	const scc_DistBackend* const previous_backend = iscc_set_active_dist_backend(dist_backend);
+	const scc_ErrorCode ec = iscc_make_clustering(data_set, clustering, options);
+	iscc_set_active_dist_backend(previous_backend);
+
+	return ec;
+}
+
+
+scc_ErrorCode scc_make_clusterings(void* const data_set,
+                                   const size_t num_clusterings,
+                                   scc_Clustering* const clusterings[const],
+                                   const uint32_t size_constraints[const],
+                                   const scc_ClusterOptions* const options)
+{
+	if ((num_clusterings == 0) || (clusterings == NULL) || (size_constraints == NULL)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clusterings.");
+	}
+	if (options == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid options.");
+	}
+
+	const scc_DistBackend* dist_backend = NULL;
+	if (options->options_version == ISCC_OPTIONS_STRUCT_VERSION) {
+		dist_backend = options->dist_backend;
+	}
+	if ((dist_backend != NULL) && !iscc_is_dist_backend(dist_backend)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid distance backend.");
+	}
+
+	const scc_DistBackend* const previous_backend = iscc_set_active_dist_backend(dist_backend);
+	const scc_ErrorCode ec = iscc_make_clusterings(data_set, num_clusterings, clusterings, size_constraints, options);
+	iscc_set_active_dist_backend(previous_backend);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Internal function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_make_clustering(void* const data_set,
+                                          scc_Clustering* const clustering,
+                                          const scc_ClusterOptions* const options)
 {
 	if (!iscc_check_input_clustering(clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
@@ -111,7 +181,20 @@ scc_ErrorCode scc_make_clustering(void* const data_set,
 	}
 
 	iscc_Digraph nng;
-	if (options->num_types < 2) {
+	if (options->approximate_nng) {
+		if ((ec = iscc_get_approximate_nng_with_size_constraint(data_set,
+		                                                        clustering->num_data_points,
+		                                                        options->size_constraint,
+		                                                        options->len_primary_data_points,
+		                                                        options->primary_data_points,
+		                                                        (options->seed_radius == SCC_RM_USE_SUPPLIED),
+		                                                        options->seed_supplied_radius,
+		                                                        options->approximate_nng_sample_rate,
+		                                                        options->approximate_nng_delta,
+		                                                        &nng)) != SCC_ER_OK) {
+			return ec;
+		}
+	} else if (options->num_types < 2) {
 		if ((ec = iscc_get_nng_with_size_constraint(data_set,
 		                                            clustering->num_data_points,
 		                                            options->size_constraint,
@@ -152,9 +235,86 @@ scc_ErrorCode scc_make_clustering(void* const data_set,
 }
 
 
-// =============================================================================
-// Internal function implementations
-// =============================================================================
+static scc_ErrorCode iscc_make_clusterings(void* const data_set,
+                                           const size_t num_clusterings,
+                                           scc_Clustering* const clusterings[const],
+                                           const uint32_t size_constraints[const],
+                                           const scc_ClusterOptions* const options)
+{
+	assert(num_clusterings > 0);
+	assert(clusterings != NULL);
+	assert(size_constraints != NULL);
+	assert(options != NULL);
+
+	scc_ClusterOptions size_options = *options;
+	uint32_t max_size_constraint = 0;
+	scc_ErrorCode ec;
+	for (size_t i = 0; i < num_clusterings; ++i) {
+		if (!iscc_check_input_clustering(clusterings[i])) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
+		}
+		if (clusterings[i]->num_data_points != clusterings[0]->num_data_points) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Clusterings must have the same number of data points.");
+		}
+		if (clusterings[i]->num_clusters != 0) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
+		}
+		size_options.size_constraint = size_constraints[i];
+		if ((ec = iscc_check_cluster_options(&size_options, clusterings[i]->num_data_points)) != SCC_ER_OK) {
+			return ec;
+		}
+		if (size_constraints[i] > max_size_constraint) max_size_constraint = size_constraints[i];
+	}
+
+	const size_t num_data_points = clusterings[0]->num_data_points;
+	if (!iscc_check_data_set(data_set, num_data_points)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+
+	// The NNG can be shared only when each row holds the nearest neighbors in order of distance
+	const bool share_nng = (options->seed_method != SCC_SM_BATCHES) &&
+	                       !options->approximate_nng &&
+	                       (options->num_types < 2) &&
+	                       (options->seed_radius == SCC_RM_NO_RADIUS) &&
+	                       iscc_nn_search_is_sorted();
+
+	if (!share_nng) {
+		for (size_t i = 0; i < num_clusterings; ++i) {
+			size_options.size_constraint = size_constraints[i];
+			if ((ec = iscc_make_clustering(data_set, clusterings[i], &size_options)) != SCC_ER_OK) {
+				return ec;
+			}
+		}
+		return iscc_no_error();
+	}
+
+	iscc_Digraph sorted_nng;
+	if ((ec = iscc_get_sorted_nng(data_set,
+	                              num_data_points,
+	                              max_size_constraint,
+	                              options->len_primary_data_points,
+	                              options->primary_data_points,
+	                              &sorted_nng)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	for (size_t i = 0; (i < num_clusterings) && (ec == SCC_ER_OK); ++i) {
+		size_options.size_constraint = size_constraints[i];
+		iscc_Digraph nng;
+		if ((ec = iscc_truncate_sorted_nng(&sorted_nng, size_constraints[i], &nng)) == SCC_ER_OK) {
+			ec = iscc_make_clustering_from_nng(clusterings[i],
+			                                   data_set,
+			                                   &nng,
+			                                   &size_options);
+			iscc_free_digraph(&nng);
+		}
+	}
+
+	iscc_free_digraph(&sorted_nng);
+
+	return ec;
+}
+
 
 static scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options,
                                                 const size_t num_data_points)
@@ -203,7 +363,8 @@ static scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const
 			(options->seed_method != SCC_SM_INWARDS_UPDATING) &&
 			(options->seed_method != SCC_SM_INWARDS_ALT_UPDATING) &&
 			(options->seed_method != SCC_SM_EXCLUSION_ORDER) &&
-			(options->seed_method != SCC_SM_EXCLUSION_UPDATING)) {
+			(options->seed_method != SCC_SM_EXCLUSION_UPDATING) &&
+			(options->seed_method != SCC_SM_PARALLEL_MIS)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown seed method.");
 	}
 	if ((options->primary_data_points != NULL) && (options->len_primary_data_points == 0)) {
@@ -271,6 +432,23 @@ static scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const
 			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES must be used with `primary_radius = SCC_RM_USE_SEED_RADIUS`.");
 		}
 	}
+	if (options->reorder_nng && (options->seed_method == SCC_SM_BATCHES)) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES cannot be used with `reorder_nng`.");
+	}
+	if (options->approximate_nng) {
+		if (options->seed_method == SCC_SM_BATCHES) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES cannot be used with `approximate_nng`.");
+		}
+		if (options->num_types >= 2) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Type constraints cannot be used with `approximate_nng`.");
+		}
+		if ((options->approximate_nng_sample_rate <= 0.0) || (options->approximate_nng_sample_rate > 1.0)) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid NN-descent sample rate.");
+		}
+		if (options->approximate_nng_delta < 0.0) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid NN-descent termination threshold.");
+		}
+	}
 
 	return iscc_no_error();
 }
@@ -293,9 +471,12 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	};
 
 	scc_ErrorCode ec;
-	if ((ec = iscc_find_seeds(nng, options->seed_method, &seed_result)) != SCC_ER_OK) {
-		return ec;
+	if (options->reorder_nng) {
+		ec = iscc_find_seeds_reordered(nng, options->seed_method, &seed_result);
+	} else {
+		ec = iscc_find_seeds(nng, options->seed_method, &seed_result);
 	}
+	if (ec != SCC_ER_OK) return ec;
 
 	scc_RadiusMethod primary_radius = options->primary_radius;
 	double primary_supplied_radius = options->primary_supplied_radius;
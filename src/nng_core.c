@@ -21,6 +21,7 @@
 #include "nng_core.h"
 
 #include <assert.h>
+#include <float.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -31,8 +32,14 @@
 #include "digraph_core.h"
 #include "digraph_operations.h"
 #include "dist_search.h"
+#include "dist_search_abandon.h"
+#include "dist_search_balltree.h"
+#include "dist_search_imp.h"
+#include "dist_search_kdtree.h"
 #include "error.h"
 #include "nng_findseeds.h"
+#include "parallel.h"
+#include "random.h"
 #include "scclust_types.h"
 
 
@@ -51,6 +58,50 @@ struct iscc_TypeCount {
 
 static const size_t ISCC_ESTIMATE_AVG_MAX_SAMPLE = 1000;
 
+// Minimum number of queries per block when searching in parallel
+static const size_t ISCC_NNG_MIN_QUERY_BLOCK = 256;
+
+
+typedef struct iscc_NNDCandidates iscc_NNDCandidates;
+struct iscc_NNDCandidates {
+	uint32_t fwd_new;
+	uint32_t num_new;
+	uint32_t seen_new;
+	uint32_t fwd_old;
+	uint32_t num_old;
+	uint32_t seen_old;
+};
+
+
+/* State of the NN-descent algorithm. `dist`, `point` and `is_new` hold one max-heap
+ * of length `k` per data point (ordered by `dist`) so the root is the farthest of
+ * the current neighbors. `new_cand` and `old_cand` hold the candidates for the local
+ * joins; each row starts with the forward candidates followed by at most
+ * `sample_size` reverse candidates drawn by reservoir sampling. */
+typedef struct iscc_NNDescent iscc_NNDescent;
+struct iscc_NNDescent {
+	size_t num_data_points;
+	uint32_t k;
+	uint32_t sample_size;
+	double* dist;
+	scc_PointIndex* point;
+	bool* is_new;
+	iscc_NNDCandidates* cand;
+	scc_PointIndex* new_cand;
+	scc_PointIndex* old_cand;
+	uint32_t* sampled;
+	scc_PointIndex* join_points;
+	double* join_dist;
+	uint64_t rng_state;
+};
+
+
+static const uint32_t ISCC_NND_MIN_K = 10;
+
+static const uint32_t ISCC_NND_MAX_ITERATIONS = 50;
+
+static const uint64_t ISCC_NND_RNG_SEED = 0x2545F4914F6CDD1Du;
+
 
 // =============================================================================
 // Internal function prototypes
@@ -69,6 +120,18 @@ static scc_ErrorCode iscc_make_nng(void* data_set,
                                    scc_PointIndex out_query_indices[],
                                    iscc_Digraph* out_nng);
 
+static scc_ErrorCode iscc_get_fused_nng_with_type_constraint(void* data_set,
+                                                             size_t num_data_points,
+                                                             uint32_t size_constraint,
+                                                             uint_fast16_t num_types,
+                                                             const uint32_t type_constraints[static num_types],
+                                                             const scc_TypeLabel type_labels[static num_data_points],
+                                                             size_t len_primary_data_points,
+                                                             const scc_PointIndex primary_data_points[],
+                                                             bool radius_constraint,
+                                                             double radius,
+                                                             iscc_Digraph* out_nng);
+
 static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* nn_search_object,
                                                       size_t num_data_points,
                                                       size_t len_query_indices,
@@ -80,10 +143,59 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* nn_se
                                                       scc_PointIndex out_query_indices[],
                                                       iscc_Digraph* out_nng);
 
+static bool iscc_nn_search_in_blocks(iscc_NNSearchObject* nn_search_object,
+                                     size_t len_query_indices,
+                                     const scc_PointIndex query_indices[],
+                                     uint32_t k,
+                                     bool radius_search,
+                                     double radius,
+                                     size_t* out_num_ok_queries,
+                                     scc_PointIndex out_query_indices[],
+                                     scc_PointIndex out_nn_indices[]);
+
+static void iscc_fill_nng_tail_ptr(size_t num_data_points,
+                                   size_t num_ok_queries,
+                                   const scc_PointIndex ok_query_indices[],
+                                   uint32_t k,
+                                   iscc_ArcIndex tail_ptr[]);
+
 static inline void iscc_ensure_self_match(iscc_Digraph* nng,
                                           size_t len_search_indices,
                                           const scc_PointIndex search_indices[]);
 
+static scc_ErrorCode iscc_nn_descent(void* data_set,
+                                     size_t num_data_points,
+                                     uint32_t k,
+                                     double sample_rate,
+                                     double delta,
+                                     double out_dist[],
+                                     scc_PointIndex out_point[]);
+
+static bool iscc_nnd_init_graph(void* data_set,
+                                iscc_NNDescent* nnd);
+
+static void iscc_nnd_sample_candidates(iscc_NNDescent* nnd);
+
+static bool iscc_nnd_local_joins(void* data_set,
+                                 iscc_NNDescent* nnd,
+                                 size_t* out_updates);
+
+static inline void iscc_nnd_add_reverse(iscc_NNDescent* nnd,
+                                        scc_PointIndex list[],
+                                        uint32_t fwd,
+                                        uint32_t* num,
+                                        uint32_t* seen,
+                                        scc_PointIndex add_point);
+
+static inline size_t iscc_nnd_push(iscc_NNDescent* nnd,
+                                   scc_PointIndex to_point,
+                                   scc_PointIndex add_point,
+                                   double add_dist);
+
+static inline void iscc_nnd_sort_neighbors(uint32_t k,
+                                           double dist[],
+                                           scc_PointIndex point[]);
+
 static scc_ErrorCode iscc_type_count(size_t num_data_points,
                                      uint32_t size_constraint,
                                      uint_fast16_t num_types,
@@ -175,6 +287,96 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
 }
 
 
+scc_ErrorCode iscc_get_sorted_nng(void* const data_set,
+                                  const size_t num_data_points,
+                                  const uint32_t max_size_constraint,
+                                  const size_t len_primary_data_points,
+                                  const scc_PointIndex primary_data_points[const],
+                                  iscc_Digraph* const out_sorted_nng)
+{
+	assert(iscc_check_data_set(data_set, num_data_points));
+	assert(num_data_points >= 2);
+	assert(max_size_constraint <= num_data_points);
+	assert(max_size_constraint >= 2);
+	assert(iscc_nn_search_is_sorted());
+	assert(out_sorted_nng != NULL);
+
+	const size_t num_queries = (primary_data_points == NULL) ? num_data_points : len_primary_data_points;
+
+	return iscc_make_nng(data_set,
+	                     num_data_points,
+	                     num_data_points,
+	                     NULL,
+	                     num_queries,
+	                     primary_data_points,
+	                     max_size_constraint,
+	                     false,
+	                     0.0,
+	                     NULL,
+	                     NULL,
+	                     out_sorted_nng);
+}
+
+
+scc_ErrorCode iscc_truncate_sorted_nng(const iscc_Digraph* const sorted_nng,
+                                       const uint32_t size_constraint,
+                                       iscc_Digraph* const out_nng)
+{
+	assert(iscc_digraph_is_valid(sorted_nng));
+	assert(!iscc_digraph_is_empty(sorted_nng));
+	assert(size_constraint >= 2);
+	assert(out_nng != NULL);
+
+	const size_t vertices = sorted_nng->vertices;
+	size_t num_arcs = 0;
+	for (size_t v = 0; v < vertices; ++v) {
+		const size_t row_arcs = sorted_nng->tail_ptr[v + 1] - sorted_nng->tail_ptr[v];
+		num_arcs += (row_arcs < size_constraint) ? row_arcs : size_constraint;
+	}
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_init_digraph(vertices, num_arcs, out_nng)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	// The rows are sorted by distance, so their first arcs are the nearest neighbors
+	size_t write = 0;
+	out_nng->tail_ptr[0] = 0;
+	for (size_t v = 0; v < vertices; ++v) {
+		const iscc_ArcIndex row_start = sorted_nng->tail_ptr[v];
+		size_t row_arcs = sorted_nng->tail_ptr[v + 1] - row_start;
+		if (row_arcs > size_constraint) row_arcs = size_constraint;
+		memcpy(out_nng->head + write, sorted_nng->head + row_start, sizeof(scc_PointIndex[row_arcs]));
+		write += row_arcs;
+		out_nng->tail_ptr[v + 1] = (iscc_ArcIndex) write;
+	}
+
+	iscc_ensure_self_match(out_nng, vertices, NULL);
+
+	if ((ec = iscc_delete_loops(out_nng)) != SCC_ER_OK) {
+		iscc_free_digraph(out_nng);
+		return ec;
+	}
+
+	#ifdef SCC_STABLE_NNG
+		iscc_sort_nng(out_nng);
+	#endif // ifdef SCC_STABLE_NNG
+
+	return iscc_no_error();
+}
+
+
+bool iscc_nn_search_is_sorted(void)
+{
+	// The exact built-in searches report neighbors in order of increasing distance
+	const scc_nearest_neighbor_search search = iscc_get_dist_functions()->nearest_neighbor_search;
+	return (search == iscc_imp_nearest_neighbor_search) ||
+	       (search == iscc_kdt_nearest_neighbor_search) ||
+	       (search == iscc_bt_nearest_neighbor_search) ||
+	       (search == iscc_ea_nearest_neighbor_search);
+}
+
+
 scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
                                                 const size_t num_data_points,
                                                 const uint32_t size_constraint,
@@ -198,6 +400,20 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 	assert(!radius_constraint || (radius > 0.0));
 	assert(out_nng != NULL);
 
+	if (iscc_get_dist_functions()->nearest_neighbor_search == iscc_imp_nearest_neighbor_search) {
+		return iscc_get_fused_nng_with_type_constraint(data_set,
+		                                               num_data_points,
+		                                               size_constraint,
+		                                               num_types,
+		                                               type_constraints,
+		                                               type_labels,
+		                                               len_primary_data_points,
+		                                               primary_data_points,
+		                                               radius_constraint,
+		                                               radius,
+		                                               out_nng);
+	}
+
 	size_t num_queries;
 	if (primary_data_points == NULL) {
 		num_queries = num_data_points;
@@ -345,6 +561,113 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 }
 
 
+scc_ErrorCode iscc_get_approximate_nng_with_size_constraint(void* const data_set,
+                                                            const size_t num_data_points,
+                                                            const uint32_t size_constraint,
+                                                            const size_t len_primary_data_points,
+                                                            const scc_PointIndex primary_data_points[const],
+                                                            const bool radius_constraint,
+                                                            const double radius,
+                                                            const double sample_rate,
+                                                            const double delta,
+                                                            iscc_Digraph* const out_nng)
+{
+	assert(iscc_check_data_set(data_set, num_data_points));
+	assert(num_data_points >= 2);
+	assert(size_constraint <= num_data_points);
+	assert(size_constraint >= 2);
+	assert(!radius_constraint || (radius > 0.0));
+	assert((sample_rate > 0.0) && (sample_rate <= 1.0));
+	assert(delta >= 0.0);
+	assert(out_nng != NULL);
+
+	size_t num_queries;
+	if (primary_data_points == NULL) {
+		num_queries = num_data_points;
+	} else {
+		num_queries = len_primary_data_points;
+	}
+
+	// A point is always among its own `size_constraint` nearest neighbors, and
+	// the self-loop is deleted in the exact NNG, so only `k` neighbors are needed.
+	// NN-descent converges poorly for small `k`, so a longer list is maintained.
+	const uint32_t k = size_constraint - 1;
+	uint32_t nnd_k = (k < ISCC_NND_MIN_K) ? ISCC_NND_MIN_K : k;
+	if (nnd_k > num_data_points - 1) nnd_k = (uint32_t) (num_data_points - 1);
+
+	double* const nnd_dist = malloc(sizeof(double[num_data_points * nnd_k]));
+	scc_PointIndex* const nnd_point = malloc(sizeof(scc_PointIndex[num_data_points * nnd_k]));
+	if ((nnd_dist == NULL) || (nnd_point == NULL)) {
+		free(nnd_dist);
+		free(nnd_point);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_nn_descent(data_set,
+	                          num_data_points,
+	                          nnd_k,
+	                          sample_rate,
+	                          delta,
+	                          nnd_dist,
+	                          nnd_point)) != SCC_ER_OK) {
+		free(nnd_dist);
+		free(nnd_point);
+		return ec;
+	}
+
+	if ((ec = iscc_init_digraph(num_data_points,
+	                            num_queries * k,
+	                            out_nng)) != SCC_ER_OK) {
+		free(nnd_dist);
+		free(nnd_point);
+		return ec;
+	}
+
+	size_t num_arcs = 0;
+	size_t q = 0;
+	out_nng->tail_ptr[0] = 0;
+	for (size_t v = 0; v < num_data_points; ++v) {
+		bool is_query = true;
+		if (primary_data_points != NULL) {
+			is_query = (q < num_queries) && ((size_t) primary_data_points[q] == v);
+			if (is_query) ++q;
+		}
+		if (is_query) {
+			double* const v_dist = nnd_dist + v * nnd_k;
+			scc_PointIndex* const v_point = nnd_point + v * nnd_k;
+			iscc_nnd_sort_neighbors(nnd_k, v_dist, v_point);
+			if (!radius_constraint || (v_dist[k - 1] <= radius)) {
+				memcpy(out_nng->head + num_arcs, v_point, sizeof(scc_PointIndex[k]));
+				num_arcs += k;
+			}
+		}
+		out_nng->tail_ptr[v + 1] = (iscc_ArcIndex) num_arcs;
+	}
+
+	free(nnd_dist);
+	free(nnd_point);
+
+	if (num_arcs == 0) {
+		iscc_free_digraph(out_nng);
+		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	if (num_arcs < num_queries * k) {
+		if ((ec = iscc_change_arc_storage(out_nng, num_arcs)) != SCC_ER_OK) {
+			iscc_free_digraph(out_nng);
+			return ec;
+		}
+	}
+
+	#ifdef SCC_STABLE_NNG
+		iscc_sort_nng(out_nng);
+	#endif // ifdef SCC_STABLE_NNG
+
+	return iscc_no_error();
+}
+
+
 scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
                                           const iscc_SeedResult* const seed_result,
                                           const iscc_Digraph* const nng,
@@ -628,6 +951,171 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 // Internal function implementations
 // =============================================================================
 
+static scc_ErrorCode iscc_get_fused_nng_with_type_constraint(void* const data_set,
+                                                             const size_t num_data_points,
+                                                             const uint32_t size_constraint,
+                                                             const uint_fast16_t num_types,
+                                                             const uint32_t type_constraints[const static num_types],
+                                                             const scc_TypeLabel type_labels[const static num_data_points],
+                                                             const size_t len_primary_data_points,
+                                                             const scc_PointIndex primary_data_points[const],
+                                                             const bool radius_constraint,
+                                                             const double radius,
+                                                             iscc_Digraph* const out_nng)
+{
+	assert(num_data_points >= 2);
+	assert(num_types >= 2);
+	assert(type_constraints != NULL);
+	assert(type_labels != NULL);
+	assert(out_nng != NULL);
+
+	/* Gives the same NNG as the search by type in `iscc_get_nng_with_type_constraint`,
+	 * but the lists of all types (and of all points) are found in one pass over the
+	 * data points. The rows of the search output are then compacted in place to the
+	 * union: the type lists without self-loops, followed by the `additional_nn_needed`
+	 * nearest points not already in the type lists. */
+
+	scc_ErrorCode ec;
+	iscc_TypeCount tc;
+	if ((ec = iscc_type_count(num_data_points,
+	                          size_constraint,
+	                          num_types,
+	                          type_constraints,
+	                          type_labels,
+	                          &tc)) != SCC_ER_OK) {
+		return ec;
+	}
+	free(tc.type_group_size);
+	free(tc.point_store);
+	free(tc.type_groups);
+
+	const uint32_t additional_nn_needed = size_constraint - tc.sum_type_constraints;
+	const uint32_t k_all = (additional_nn_needed > 0) ? size_constraint : 0;
+	const size_t row_width = (size_t) tc.sum_type_constraints + k_all;
+
+	const size_t num_queries = (primary_data_points == NULL) ? num_data_points : len_primary_data_points;
+
+	size_t* const type_offset = malloc(sizeof(size_t[num_types]));
+	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[num_data_points]));
+	scc_PointIndex* ok_queries = NULL;
+	if (radius_constraint) {
+		ok_queries = malloc(sizeof(scc_PointIndex[num_queries]));
+	}
+	if ((type_offset == NULL) || (row_markers == NULL) || (radius_constraint && (ok_queries == NULL))) {
+		free(type_offset);
+		free(row_markers);
+		free(ok_queries);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if ((ec = iscc_init_digraph(num_data_points, num_queries * row_width, out_nng)) != SCC_ER_OK) {
+		free(type_offset);
+		free(row_markers);
+		free(ok_queries);
+		return ec;
+	}
+
+	size_t num_ok_queries = 0;
+	if (!iscc_imp_type_nearest_neighbor_search(data_set,
+	                                           num_queries,
+	                                           primary_data_points,
+	                                           type_labels,
+	                                           num_types,
+	                                           type_constraints,
+	                                           k_all,
+	                                           radius_constraint,
+	                                           radius,
+	                                           &num_ok_queries,
+	                                           ok_queries,
+	                                           out_nng->head)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	} else if (num_ok_queries == 0) {
+		ec = iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+	}
+
+	if (ec != SCC_ER_OK) {
+		free(type_offset);
+		free(row_markers);
+		free(ok_queries);
+		iscc_free_digraph(out_nng);
+		return ec;
+	}
+
+	size_t offset = 0;
+	for (uint_fast16_t t = 0; t < num_types; ++t) {
+		type_offset[t] = offset;
+		offset += type_constraints[t];
+	}
+
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) num_data_points; // If `scc_PointIndex` is signed
+	for (scc_PointIndex v = 0; v < vertices; ++v) {
+		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
+	}
+
+	// Rows are never longer after compaction, so writing never overtakes reading
+	const scc_PointIndex* const queries = radius_constraint ? ok_queries : primary_data_points;
+	size_t q = 0;
+	iscc_ArcIndex head_write = 0;
+	out_nng->tail_ptr[0] = 0;
+	for (scc_PointIndex v = 0; v < vertices; ++v) {
+		if ((q < num_ok_queries) && ((queries == NULL) || (queries[q] == v))) {
+			assert((queries != NULL) || ((scc_PointIndex) q == v));
+			scc_PointIndex* const row = out_nng->head + q * row_width;
+
+			// Self-loop in own type group (see `iscc_ensure_self_match`)
+			const uint32_t own_k = type_constraints[type_labels[v]];
+			if (own_k > 0) {
+				scc_PointIndex* const own_list = row + type_offset[type_labels[v]];
+				uint32_t i = 0;
+				for (; (i < own_k) && (own_list[i] != v); ++i);
+				if (i == own_k) own_list[own_k - 1] = v;
+			}
+
+			for (size_t i = 0; i < tc.sum_type_constraints; ++i) {
+				const scc_PointIndex arc = row[i];
+				row_markers[arc] = v;
+				if (arc != v) {
+					out_nng->head[head_write] = arc;
+					++head_write;
+				}
+			}
+
+			uint32_t num_additional = 0;
+			for (size_t i = tc.sum_type_constraints; (i < row_width) && (num_additional < additional_nn_needed); ++i) {
+				const scc_PointIndex arc = row[i];
+				if (row_markers[arc] != v) {
+					++num_additional;
+					if (arc != v) {
+						out_nng->head[head_write] = arc;
+						++head_write;
+					}
+				}
+			}
+
+			++q;
+		}
+		out_nng->tail_ptr[v + 1] = head_write;
+	}
+	assert(q == num_ok_queries);
+
+	free(type_offset);
+	free(row_markers);
+	free(ok_queries);
+
+	if ((ec = iscc_change_arc_storage(out_nng, head_write)) != SCC_ER_OK) {
+		iscc_free_digraph(out_nng);
+		return ec;
+	}
+
+	#ifdef SCC_STABLE_NNG
+		iscc_sort_nng(out_nng);
+	#endif // ifdef SCC_STABLE_NNG
+
+	return iscc_no_error();
+}
+
+
 static scc_ErrorCode iscc_make_nng(void* const data_set,
                                    const size_t num_data_points,
                                    const size_t len_search_indices,
@@ -720,58 +1208,26 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	}
 
 	size_t num_ok_queries = 0;
-	if (!iscc_nearest_neighbor_search(nn_search_object,
-	                                  len_query_indices,
-	                                  query_indices,
-	                                  k,
-	                                  radius_search,
-	                                  radius,
-	                                  &num_ok_queries,
-	                                  dist_out_query_indices,
-	                                  out_nng->head)) {
+	if (!iscc_nn_search_in_blocks(nn_search_object,
+	                              len_query_indices,
+	                              query_indices,
+	                              k,
+	                              radius_search,
+	                              radius,
+	                              &num_ok_queries,
+	                              dist_out_query_indices,
+	                              out_nng->head)) {
 		free(internal_out_query_indices);
 		iscc_free_digraph(out_nng);
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	iscc_ArcIndex* write_tail_ptr = out_nng->tail_ptr;
-	*write_tail_ptr = 0;
-	++write_tail_ptr;
-	const iscc_ArcIndex* const write_tail_ptr_stop = write_tail_ptr + num_data_points;
-
-	if (radius_search || query_indices != NULL) {
-		const scc_PointIndex* ok_q;
-		if (radius_search) {
-			assert(dist_out_query_indices != NULL);
-			ok_q = dist_out_query_indices;
-		} else {
-			assert(len_query_indices == num_ok_queries);
-			assert(query_indices != NULL);
-			ok_q = query_indices;
-		}
-
-		scc_PointIndex i = 0;
-		const scc_PointIndex* const ok_q_stop = ok_q + num_ok_queries;
-		for (; ok_q < ok_q_stop; ++ok_q) {
-			for (; i < *ok_q; ++i) {
-				*write_tail_ptr = *(write_tail_ptr - 1);
-				++write_tail_ptr;
-			}
-			*write_tail_ptr = *(write_tail_ptr - 1) + k;
-			++write_tail_ptr;
-			++i;
-		}
+	if (radius_search) {
+		assert(dist_out_query_indices != NULL);
+		iscc_fill_nng_tail_ptr(num_data_points, num_ok_queries, dist_out_query_indices, k, out_nng->tail_ptr);
 	} else {
-		assert(!radius_search && query_indices == NULL);
 		assert(len_query_indices == num_ok_queries);
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			*write_tail_ptr = *(write_tail_ptr - 1) + k;
-			++write_tail_ptr;
-		}
-	}
-
-	for (; write_tail_ptr < write_tail_ptr_stop; ++write_tail_ptr) {
-		*write_tail_ptr = *(write_tail_ptr - 1);
+		iscc_fill_nng_tail_ptr(num_data_points, num_ok_queries, query_indices, k, out_nng->tail_ptr);
 	}
 
 	if (internal_out_query_indices != NULL) {
@@ -796,6 +1252,155 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 }
 
 
+static bool iscc_nn_search_in_blocks(iscc_NNSearchObject* const nn_search_object,
+                                     const size_t len_query_indices,
+                                     const scc_PointIndex query_indices[const],
+                                     const uint32_t k,
+                                     const bool radius_search,
+                                     const double radius,
+                                     size_t* const out_num_ok_queries,
+                                     scc_PointIndex out_query_indices[const],
+                                     scc_PointIndex out_nn_indices[const])
+{
+	assert(nn_search_object != NULL);
+	assert(len_query_indices > 0);
+	assert(k > 0);
+	assert(out_num_ok_queries != NULL);
+	assert(!radius_search || (out_query_indices != NULL));
+	assert(out_nn_indices != NULL);
+
+	const iscc_dist_functions_struct* const dist_functions = iscc_get_dist_functions();
+
+	size_t num_blocks = 1;
+	if (dist_functions->nn_search_thread_safe) {
+		num_blocks = (size_t) iscc_get_num_threads();
+		if (num_blocks > len_query_indices / ISCC_NNG_MIN_QUERY_BLOCK) {
+			num_blocks = len_query_indices / ISCC_NNG_MIN_QUERY_BLOCK;
+		}
+	}
+
+	if (num_blocks <= 1) {
+		return iscc_nearest_neighbor_search(nn_search_object,
+		                                    len_query_indices,
+		                                    query_indices,
+		                                    k,
+		                                    radius_search,
+		                                    radius,
+		                                    out_num_ok_queries,
+		                                    out_query_indices,
+		                                    out_nn_indices);
+	}
+
+	/* Block b searches queries [q_start, q_stop) into the same rows of the output
+	 * arrays, so the blocks never write to the same memory. Searches over all data
+	 * points (`query_indices == NULL`) need explicit indices to be split. */
+	scc_PointIndex* all_query_indices = NULL;
+	size_t* const block_num_ok = malloc(sizeof(size_t[num_blocks]));
+	if (block_num_ok == NULL) return false;
+	if (query_indices == NULL) {
+		all_query_indices = malloc(sizeof(scc_PointIndex[len_query_indices]));
+		if (all_query_indices == NULL) {
+			free(block_num_ok);
+			return false;
+		}
+		for (size_t q = 0; q < len_query_indices; ++q) {
+			all_query_indices[q] = (scc_PointIndex) q;
+		}
+	}
+	const scc_PointIndex* const block_query_indices = (query_indices == NULL) ? all_query_indices : query_indices;
+	const scc_DistBackend* const dist_backend = iscc_active_dist_backend;
+
+	bool search_ok = true;
+	ISCC_OMP(parallel for num_threads((int) num_blocks) schedule(static, 1) reduction(&&:search_ok))
+	for (size_t block = 0; block < num_blocks; ++block) {
+		const scc_DistBackend* const worker_backend = iscc_set_active_dist_backend(dist_backend);
+		const size_t q_start = (block * len_query_indices) / num_blocks;
+		const size_t q_stop = ((block + 1) * len_query_indices) / num_blocks;
+		block_num_ok[block] = 0;
+		if (!dist_functions->nearest_neighbor_search(nn_search_object,
+		                                             q_stop - q_start,
+		                                             block_query_indices + q_start,
+		                                             k,
+		                                             radius_search,
+		                                             radius,
+		                                             block_num_ok + block,
+		                                             radius_search ? out_query_indices + q_start : NULL,
+		                                             out_nn_indices + q_start * k)) {
+			search_ok = false;
+		}
+		iscc_set_active_dist_backend(worker_backend);
+	}
+
+	free(all_query_indices);
+	if (!search_ok) {
+		free(block_num_ok);
+		return false;
+	}
+
+	// Prefix sum over the blocks gives where each block's results go; moves are in block order
+	size_t num_ok_queries = block_num_ok[0];
+	for (size_t block = 1; block < num_blocks; ++block) {
+		const size_t q_start = (block * len_query_indices) / num_blocks;
+		assert(num_ok_queries <= q_start);
+		if ((num_ok_queries < q_start) && (block_num_ok[block] > 0)) {
+			memmove(out_nn_indices + num_ok_queries * k,
+			        out_nn_indices + q_start * k,
+			        sizeof(scc_PointIndex[block_num_ok[block] * k]));
+			memmove(out_query_indices + num_ok_queries,
+			        out_query_indices + q_start,
+			        sizeof(scc_PointIndex[block_num_ok[block]]));
+		}
+		num_ok_queries += block_num_ok[block];
+	}
+	assert(radius_search || (num_ok_queries == len_query_indices));
+
+	free(block_num_ok);
+	*out_num_ok_queries = num_ok_queries;
+
+	return true;
+}
+
+
+static void iscc_fill_nng_tail_ptr(const size_t num_data_points,
+                                   const size_t num_ok_queries,
+                                   const scc_PointIndex ok_query_indices[const],
+                                   const uint32_t k,
+                                   iscc_ArcIndex tail_ptr[const])
+{
+	assert(num_ok_queries <= num_data_points);
+	assert(tail_ptr != NULL);
+
+	/* The tail pointers are the prefix sum of `k` at each query. As the queries are
+	 * sorted, the sum at query `q` is `k * (q + 1)`, so every segment between two
+	 * queries is filled independently. `ok_query_indices == NULL` means that all
+	 * data points are queries. */
+	tail_ptr[0] = 0;
+
+	if (ok_query_indices == NULL) {
+		assert(num_ok_queries == num_data_points);
+		ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(static))
+		for (size_t v = 0; v < num_data_points; ++v) {
+			tail_ptr[v + 1] = (iscc_ArcIndex) ((v + 1) * k);
+		}
+		return;
+	}
+
+	const size_t first_query = (num_ok_queries > 0) ? (size_t) ok_query_indices[0] : num_data_points;
+	for (size_t v = 0; v < first_query; ++v) {
+		tail_ptr[v + 1] = 0;
+	}
+
+	ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(static))
+	for (size_t q = 0; q < num_ok_queries; ++q) {
+		const size_t seg_stop = (q + 1 < num_ok_queries) ? (size_t) ok_query_indices[q + 1] : num_data_points;
+		const iscc_ArcIndex arcs = (iscc_ArcIndex) ((q + 1) * k);
+		for (size_t v = (size_t) ok_query_indices[q]; v < seg_stop; ++v) {
+			tail_ptr[v + 1] = arcs;
+		}
+	}
+}
+
+
 static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
                                           const size_t len_search_indices,
                                           const scc_PointIndex search_indices[const])
@@ -833,6 +1438,318 @@ static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
 }
 
 
+static scc_ErrorCode iscc_nn_descent(void* const data_set,
+                                     const size_t num_data_points,
+                                     const uint32_t k,
+                                     const double sample_rate,
+                                     const double delta,
+                                     double out_dist[const],
+                                     scc_PointIndex out_point[const])
+{
+	assert(num_data_points > k);
+	assert(k > 0);
+	assert((sample_rate > 0.0) && (sample_rate <= 1.0));
+	assert(delta >= 0.0);
+	assert(out_dist != NULL);
+	assert(out_point != NULL);
+
+	const double sample_size_dbl = sample_rate * (double) k;
+	uint32_t sample_size = (uint32_t) sample_size_dbl;
+	if ((double) sample_size < sample_size_dbl) ++sample_size;
+	if (sample_size == 0) sample_size = 1;
+
+	const size_t new_width = 2 * (size_t) sample_size;
+	const size_t old_width = (size_t) k + sample_size;
+	const size_t max_join = new_width + old_width;
+
+	iscc_NNDescent nnd = {
+		.num_data_points = num_data_points,
+		.k = k,
+		.sample_size = sample_size,
+		.dist = out_dist,
+		.point = out_point,
+		.is_new = malloc(sizeof(bool[num_data_points * k])),
+		.cand = malloc(sizeof(iscc_NNDCandidates[num_data_points])),
+		.new_cand = malloc(sizeof(scc_PointIndex[num_data_points * new_width])),
+		.old_cand = malloc(sizeof(scc_PointIndex[num_data_points * old_width])),
+		.sampled = malloc(sizeof(uint32_t[sample_size])),
+		.join_points = malloc(sizeof(scc_PointIndex[max_join])),
+		.join_dist = malloc(sizeof(double[new_width * max_join])),
+		.rng_state = ISCC_NND_RNG_SEED,
+	};
+
+	scc_ErrorCode ec = SCC_ER_OK;
+	if ((nnd.is_new == NULL) || (nnd.cand == NULL) || (nnd.new_cand == NULL) || (nnd.old_cand == NULL) ||
+			(nnd.sampled == NULL) || (nnd.join_points == NULL) || (nnd.join_dist == NULL)) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	} else if (!iscc_nnd_init_graph(data_set, &nnd)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	} else {
+		// Iterate until fewer than `delta * num_data_points * k` neighbors were improved
+		const double threshold = delta * (double) num_data_points * (double) k;
+		for (uint32_t iter = 0; iter < ISCC_NND_MAX_ITERATIONS; ++iter) {
+			size_t updates;
+			iscc_nnd_sample_candidates(&nnd);
+			if (!iscc_nnd_local_joins(data_set, &nnd, &updates)) {
+				ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+				break;
+			}
+			if ((double) updates <= threshold) break;
+		}
+	}
+
+	free(nnd.is_new);
+	free(nnd.cand);
+	free(nnd.new_cand);
+	free(nnd.old_cand);
+	free(nnd.sampled);
+	free(nnd.join_points);
+	free(nnd.join_dist);
+
+	return ec;
+}
+
+
+static bool iscc_nnd_init_graph(void* const data_set,
+                                iscc_NNDescent* const nnd)
+{
+	assert(nnd != NULL);
+
+	const uint32_t k = nnd->k;
+	const size_t num_others = nnd->num_data_points - 1;
+
+	for (size_t i = 0; i < nnd->num_data_points * k; ++i) {
+		nnd->dist[i] = DBL_MAX;
+		nnd->is_new[i] = true;
+	}
+
+	for (size_t v = 0; v < nnd->num_data_points; ++v) {
+		const scc_PointIndex v_pi = (scc_PointIndex) v;
+		scc_PointIndex* const v_point = nnd->point + v * k;
+		for (uint32_t i = 0; i < k; ++i) {
+			v_point[i] = v_pi; // Placeholder, never a candidate
+		}
+
+		if (2 * (size_t) k < num_others) {
+			for (uint32_t i = 0; i < k; ) {
+				size_t u = (size_t) (iscc_rand(&nnd->rng_state) % num_others);
+				if (u >= v) ++u;
+				uint32_t j = 0;
+				for (; (j < i) && (nnd->join_points[j] != (scc_PointIndex) u); ++j);
+				if (j == i) {
+					nnd->join_points[i] = (scc_PointIndex) u;
+					++i;
+				}
+			}
+		} else {
+			// Dense case, draw a random window of consecutive points instead
+			const size_t offset = (size_t) (iscc_rand(&nnd->rng_state) % num_others);
+			for (uint32_t i = 0; i < k; ++i) {
+				nnd->join_points[i] = (scc_PointIndex) ((v + 1 + (offset + i) % num_others) % nnd->num_data_points);
+			}
+		}
+
+		if (!iscc_get_dist_rows(data_set, 1, &v_pi, k, nnd->join_points, nnd->join_dist)) {
+			return false;
+		}
+		for (uint32_t i = 0; i < k; ++i) {
+			iscc_nnd_push(nnd, v_pi, nnd->join_points[i], nnd->join_dist[i]);
+		}
+	}
+
+	return true;
+}
+
+
+static void iscc_nnd_sample_candidates(iscc_NNDescent* const nnd)
+{
+	assert(nnd != NULL);
+
+	const uint32_t k = nnd->k;
+	const uint32_t sample_size = nnd->sample_size;
+	const size_t new_width = 2 * (size_t) sample_size;
+	const size_t old_width = (size_t) k + sample_size;
+
+	// Forward candidates: all old neighbors and a sample of the new ones, which are marked as old
+	for (size_t v = 0; v < nnd->num_data_points; ++v) {
+		const scc_PointIndex* const v_point = nnd->point + v * k;
+		bool* const v_is_new = nnd->is_new + v * k;
+		scc_PointIndex* const v_new = nnd->new_cand + v * new_width;
+		scc_PointIndex* const v_old = nnd->old_cand + v * old_width;
+
+		uint32_t num_new = 0;
+		uint32_t num_old = 0;
+		uint32_t seen = 0;
+		for (uint32_t i = 0; i < k; ++i) {
+			if (v_is_new[i]) {
+				if (seen < sample_size) {
+					nnd->sampled[num_new] = i;
+					++num_new;
+				} else {
+					const uint32_t j = (uint32_t) (iscc_rand(&nnd->rng_state) % (seen + 1));
+					if (j < sample_size) nnd->sampled[j] = i;
+				}
+				++seen;
+			} else {
+				v_old[num_old] = v_point[i];
+				++num_old;
+			}
+		}
+
+		for (uint32_t s = 0; s < num_new; ++s) {
+			v_new[s] = v_point[nnd->sampled[s]];
+			v_is_new[nnd->sampled[s]] = false;
+		}
+
+		nnd->cand[v] = (iscc_NNDCandidates) {
+			.fwd_new = num_new,
+			.num_new = num_new,
+			.seen_new = 0,
+			.fwd_old = num_old,
+			.num_old = num_old,
+			.seen_old = 0,
+		};
+	}
+
+	// Reverse candidates: `v` is a candidate of `u` if `u` is a forward candidate of `v`
+	for (size_t v = 0; v < nnd->num_data_points; ++v) {
+		const scc_PointIndex v_pi = (scc_PointIndex) v;
+		const scc_PointIndex* const v_new = nnd->new_cand + v * new_width;
+		const scc_PointIndex* const v_old = nnd->old_cand + v * old_width;
+		for (uint32_t s = 0; s < nnd->cand[v].fwd_new; ++s) {
+			const size_t u = (size_t) v_new[s];
+			iscc_nnd_add_reverse(nnd,
+			                     nnd->new_cand + u * new_width,
+			                     nnd->cand[u].fwd_new,
+			                     &nnd->cand[u].num_new,
+			                     &nnd->cand[u].seen_new,
+			                     v_pi);
+		}
+		for (uint32_t s = 0; s < nnd->cand[v].fwd_old; ++s) {
+			const size_t u = (size_t) v_old[s];
+			iscc_nnd_add_reverse(nnd,
+			                     nnd->old_cand + u * old_width,
+			                     nnd->cand[u].fwd_old,
+			                     &nnd->cand[u].num_old,
+			                     &nnd->cand[u].seen_old,
+			                     v_pi);
+		}
+	}
+}
+
+
+static bool iscc_nnd_local_joins(void* const data_set,
+                                 iscc_NNDescent* const nnd,
+                                 size_t* const out_updates)
+{
+	assert(nnd != NULL);
+	assert(out_updates != NULL);
+
+	const size_t new_width = 2 * (size_t) nnd->sample_size;
+	const size_t old_width = (size_t) nnd->k + nnd->sample_size;
+
+	size_t updates = 0;
+	for (size_t v = 0; v < nnd->num_data_points; ++v) {
+		const size_t num_new = nnd->cand[v].num_new;
+		const size_t num_join = num_new + nnd->cand[v].num_old;
+		if (num_new == 0) continue;
+
+		// Compare new candidates with each other and with old candidates
+		scc_PointIndex* const join_points = nnd->join_points;
+		memcpy(join_points, nnd->new_cand + v * new_width, sizeof(scc_PointIndex[num_new]));
+		memcpy(join_points + num_new, nnd->old_cand + v * old_width, sizeof(scc_PointIndex[num_join - num_new]));
+
+		if (!iscc_get_dist_rows(data_set, num_new, join_points, num_join, join_points, nnd->join_dist)) {
+			return false;
+		}
+
+		for (size_t a = 0; a < num_new; ++a) {
+			const double* const row_dist = nnd->join_dist + a * num_join;
+			for (size_t b = a + 1; b < num_join; ++b) {
+				if (join_points[a] == join_points[b]) continue;
+				updates += iscc_nnd_push(nnd, join_points[a], join_points[b], row_dist[b]);
+				updates += iscc_nnd_push(nnd, join_points[b], join_points[a], row_dist[b]);
+			}
+		}
+	}
+
+	*out_updates = updates;
+	return true;
+}
+
+
+static inline void iscc_nnd_add_reverse(iscc_NNDescent* const nnd,
+                                        scc_PointIndex list[const],
+                                        const uint32_t fwd,
+                                        uint32_t* const num,
+                                        uint32_t* const seen,
+                                        const scc_PointIndex add_point)
+{
+	if (*seen < nnd->sample_size) {
+		list[fwd + *seen] = add_point;
+		++(*num);
+	} else {
+		const uint32_t j = (uint32_t) (iscc_rand(&nnd->rng_state) % (*seen + 1));
+		if (j < nnd->sample_size) list[fwd + j] = add_point;
+	}
+	++(*seen);
+}
+
+
+static inline size_t iscc_nnd_push(iscc_NNDescent* const nnd,
+                                   const scc_PointIndex to_point,
+                                   const scc_PointIndex add_point,
+                                   const double add_dist)
+{
+	const uint32_t k = nnd->k;
+	double* const dist = nnd->dist + (size_t) to_point * k;
+	scc_PointIndex* const point = nnd->point + (size_t) to_point * k;
+	bool* const is_new = nnd->is_new + (size_t) to_point * k;
+
+	if (add_dist >= dist[0]) return 0;
+	for (uint32_t i = 0; i < k; ++i) {
+		if (point[i] == add_point) return 0;
+	}
+
+	// Replace the root and sift down
+	size_t i = 0;
+	while (true) {
+		size_t child = 2 * i + 1;
+		if (child >= k) break;
+		if ((child + 1 < k) && (dist[child + 1] > dist[child])) ++child;
+		if (dist[child] <= add_dist) break;
+		dist[i] = dist[child];
+		point[i] = point[child];
+		is_new[i] = is_new[child];
+		i = child;
+	}
+	dist[i] = add_dist;
+	point[i] = add_point;
+	is_new[i] = true;
+
+	return 1;
+}
+
+
+static inline void iscc_nnd_sort_neighbors(const uint32_t k,
+                                           double dist[const],
+                                           scc_PointIndex point[const])
+{
+	// Insertion sort, `k` is small
+	for (uint32_t i = 1; i < k; ++i) {
+		const double tmp_dist = dist[i];
+		const scc_PointIndex tmp_point = point[i];
+		uint32_t j = i;
+		for (; (j > 0) && (dist[j - 1] > tmp_dist); --j) {
+			dist[j] = dist[j - 1];
+			point[j] = point[j - 1];
+		}
+		dist[j] = tmp_dist;
+		point[j] = tmp_point;
+	}
+}
+
+
 static scc_ErrorCode iscc_type_count(const size_t num_data_points,
                                      const uint32_t size_constraint,
                                      const uint_fast16_t num_types,
@@ -42,6 +42,19 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* data_set,
                                                 double radius,
                                                 iscc_Digraph* out_nng);
 
+scc_ErrorCode iscc_get_sorted_nng(void* data_set,
+                                  size_t num_data_points,
+                                  uint32_t max_size_constraint,
+                                  size_t len_primary_data_points,
+                                  const scc_PointIndex primary_data_points[],
+                                  iscc_Digraph* out_sorted_nng);
+
+scc_ErrorCode iscc_truncate_sorted_nng(const iscc_Digraph* sorted_nng,
+                                       uint32_t size_constraint,
+                                       iscc_Digraph* out_nng);
+
+bool iscc_nn_search_is_sorted(void);
+
 scc_ErrorCode iscc_get_nng_with_type_constraint(void* data_set,
                                                 size_t num_data_points,
                                                 uint32_t size_constraint,
@@ -54,6 +67,17 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* data_set,
                                                 double radius,
                                                 iscc_Digraph* out_nng);
 
+scc_ErrorCode iscc_get_approximate_nng_with_size_constraint(void* data_set,
+                                                            size_t num_data_points,
+                                                            uint32_t size_constraint,
+                                                            size_t len_primary_data_points,
+                                                            const scc_PointIndex primary_data_points[],
+                                                            bool radius_constraint,
+                                                            double radius,
+                                                            double sample_rate,
+                                                            double delta,
+                                                            iscc_Digraph* out_nng);
+
 scc_ErrorCode iscc_estimate_avg_seed_dist(void* data_set,
                                           const iscc_SeedResult* seed_result,
                                           const iscc_Digraph* nng,
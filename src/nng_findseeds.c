@@ -23,14 +23,31 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include "../include/scclust.h"
+#include "bitset.h"
 #include "digraph_core.h"
 #include "digraph_operations.h"
 #include "error.h"
+#include "parallel.h"
 #include "scclust_types.h"
 
 
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+// Smallest number of vertices for which the vertices are counted and sorted in parallel
+static const size_t ISCC_FS_MIN_PARALLEL_VERTICES = 65536;
+
+enum {
+	ISCC_MIS_EXCLUDED,
+	ISCC_MIS_CANDIDATE,
+	ISCC_MIS_SELECTED,
+};
+
+
 // =============================================================================
 // Internal structs
 // =============================================================================
@@ -43,6 +60,17 @@ struct iscc_fs_SortResult {
 	scc_PointIndex** bucket_index;
 };
 
+/* The exclusion graph is the union of the NNG and the product of the NNG and
+ * its transpose. It is not stored; its rows are derived when needed. */
+typedef struct iscc_fs_ExclusionGraph iscc_fs_ExclusionGraph;
+struct iscc_fs_ExclusionGraph {
+	const iscc_Digraph* nng;
+	iscc_Digraph nng_transpose;
+	size_t max_row_size;
+	size_t row_stamp;
+	size_t* row_markers;
+};
+
 
 // =============================================================================
 // Internal function prototypes
@@ -62,27 +90,38 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* nng,
                                               bool updating,
                                               iscc_SeedResult* out_seeds);
 
+static scc_ErrorCode iscc_findseeds_parallel_mis(const iscc_Digraph* nng,
+                                                 iscc_SeedResult* out_seeds);
+
 //iscc_findseeds_onearc_updating(const scc_Digraph* nng, ...);
 
 //iscc_findseeds_simulated_annealing();
 
 //iscc_findseeds_approximation();
 
-static scc_ErrorCode iscc_fs_exclusion_graph(const iscc_Digraph* nng,
-                                             size_t len_not_excluded,
-                                             const scc_PointIndex not_excluded[],
-                                             iscc_Digraph* out_dg);
+static scc_ErrorCode iscc_fs_init_exclusion_graph(const iscc_Digraph* nng,
+                                                  iscc_fs_ExclusionGraph* out_eg);
+
+static void iscc_fs_free_exclusion_graph(iscc_fs_ExclusionGraph* eg);
+
+static size_t iscc_fs_exclusion_row(iscc_fs_ExclusionGraph* eg,
+                                    scc_PointIndex v,
+                                    scc_PointIndex out_row[]);
+
+static inline bool iscc_fs_mis_precedes(scc_PointIndex a,
+                                        scc_PointIndex b,
+                                        const scc_PointIndex inwards_count[]);
 
 static inline scc_ErrorCode iscc_fs_add_seed(scc_PointIndex s,
                                              iscc_SeedResult* seed_result);
 
 static inline bool iscc_fs_check_neighbors_marks(scc_PointIndex v,
                                                  const iscc_Digraph*  nng,
-                                                 const bool marks[static nng->vertices]);
+                                                 const iscc_BitWord marks[]);
 
 static inline void iscc_fs_mark_seed_neighbors(scc_PointIndex s,
                                                const iscc_Digraph* nng,
-                                               bool marks[static nng->vertices]);
+                                               iscc_BitWord marks[]);
 
 static void iscc_fs_free_sort_result(iscc_fs_SortResult* sr);
 
@@ -90,6 +129,15 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* nng,
                                              bool make_indices,
                                              iscc_fs_SortResult* out_sort);
 
+static scc_ErrorCode iscc_fs_sort_by_exclusion_inwards(iscc_fs_ExclusionGraph* eg,
+                                                       scc_PointIndex row[],
+                                                       bool make_indices,
+                                                       iscc_fs_SortResult* out_sort);
+
+static scc_ErrorCode iscc_fs_bucket_sort(size_t vertices,
+                                         bool make_indices,
+                                         iscc_fs_SortResult* out_sort);
+
 static inline void iscc_fs_decrease_v_in_sort(scc_PointIndex v_to_decrease,
                                               scc_PointIndex inwards_count[restrict],
                                               scc_PointIndex* vertex_index[restrict],
@@ -156,6 +204,10 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 			ec = iscc_findseeds_exclusion(nng, true, out_seeds);
 			break;
 
+		case SCC_SM_PARALLEL_MIS:
+			ec = iscc_findseeds_parallel_mis(nng, out_seeds);
+			break;
+
 		default:
 			assert(false);
 			ec = iscc_make_error(SCC_ER_UNKNOWN_ERROR);
@@ -177,6 +229,49 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 }
 
 
+/* Seed finding marks the vertices around each seed. When the NNG is larger
+ * than the cache, vertices with nearby IDs should be near each other in the
+ * graph. This relabels the NNG in breadth-first order, finds seeds in the
+ * relabeled NNG and translates them back. */
+scc_ErrorCode iscc_find_seeds_reordered(const iscc_Digraph* const nng,
+                                        const scc_SeedMethod seed_method,
+                                        iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(nng->vertices > 1);
+	assert(out_seeds != NULL);
+
+	scc_PointIndex* const order = malloc(sizeof(scc_PointIndex[nng->vertices]));
+	if (order == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_digraph_bfs_order(nng, order)) != SCC_ER_OK) {
+		free(order);
+		return ec;
+	}
+
+	iscc_Digraph reordered_nng;
+	if ((ec = iscc_permute_digraph(nng, order, &reordered_nng)) != SCC_ER_OK) {
+		free(order);
+		return ec;
+	}
+
+	ec = iscc_find_seeds(&reordered_nng, seed_method, out_seeds);
+	iscc_free_digraph(&reordered_nng);
+
+	if (ec == SCC_ER_OK) {
+		for (size_t i = 0; i < out_seeds->count; ++i) {
+			out_seeds->seeds[i] = order[out_seeds->seeds[i]];
+		}
+	}
+
+	free(order);
+
+	return ec;
+}
+
+
 // =============================================================================
 // Internal function implementations
 // =============================================================================
@@ -192,7 +287,7 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
+	iscc_BitWord* const marks = iscc_alloc_bitset(nng->vertices);
 	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
 		free(marks);
@@ -239,7 +334,7 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 	iscc_fs_SortResult sort;
 	if ((ec = iscc_fs_sort_by_inwards(nng, updating, &sort)) != SCC_ER_OK) return ec;
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
+	iscc_BitWord* const marks = iscc_alloc_bitset(nng->vertices);
 	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
 		iscc_fs_free_sort_result(&sort);
@@ -276,7 +371,7 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 					for (scc_PointIndex* v_arc_arc = nng->head + nng->tail_ptr[*v_arc];
 					        v_arc_arc != v_arc_arc_stop; ++v_arc_arc) {
 						// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
-						if (!marks[*v_arc_arc] && (sorted_v < sort.vertex_index[*v_arc_arc]) && (nng->tail_ptr[*v_arc_arc] != nng->tail_ptr[*v_arc_arc + 1])) {
+						if (!iscc_bitset_test(marks, (size_t) *v_arc_arc) && (sorted_v < sort.vertex_index[*v_arc_arc]) && (nng->tail_ptr[*v_arc_arc] != nng->tail_ptr[*v_arc_arc + 1])) {
 							iscc_fs_decrease_v_in_sort(*v_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
 						}
 					}
@@ -308,7 +403,7 @@ static scc_ErrorCode iscc_findseeds_inwards_alt(const iscc_Digraph* const nng,
 	iscc_fs_SortResult sort;
 	if ((ec = iscc_fs_sort_by_inwards(nng, true, &sort)) != SCC_ER_OK) return ec;
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
+	iscc_BitWord* const marks = iscc_alloc_bitset(nng->vertices);
 	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
 		iscc_fs_free_sort_result(&sort);
@@ -345,18 +440,18 @@ static scc_ErrorCode iscc_findseeds_inwards_alt(const iscc_Digraph* const nng,
 					for (scc_PointIndex* v_arc_arc = nng->head + nng->tail_ptr[*v_arc];
 					        v_arc_arc != v_arc_arc_stop; ++v_arc_arc) {
 						// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
-						if (!marks[*v_arc_arc] && (sorted_v < sort.vertex_index[*v_arc_arc]) && (nng->tail_ptr[*v_arc_arc] != nng->tail_ptr[*v_arc_arc + 1])) {
+						if (!iscc_bitset_test(marks, (size_t) *v_arc_arc) && (sorted_v < sort.vertex_index[*v_arc_arc]) && (nng->tail_ptr[*v_arc_arc] != nng->tail_ptr[*v_arc_arc + 1])) {
 							iscc_fs_decrease_v_in_sort(*v_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
 						}
 					}
 				}
 			}
-		} else if (!marks[*sorted_v]) {
+		} else if (!iscc_bitset_test(marks, (size_t) *sorted_v)) {
 			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[*sorted_v + 1];
 			for (const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[*sorted_v];
 			        v_arc != v_arc_stop; ++v_arc) {
 				// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
-				if (!marks[*v_arc] && (sorted_v < sort.vertex_index[*v_arc]) && (nng->tail_ptr[*v_arc] != nng->tail_ptr[*v_arc + 1])) {
+				if (!iscc_bitset_test(marks, (size_t) *v_arc) && (sorted_v < sort.vertex_index[*v_arc]) && (nng->tail_ptr[*v_arc] != nng->tail_ptr[*v_arc + 1])) {
 					iscc_fs_decrease_v_in_sort(*v_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
 				}
 			}
@@ -382,57 +477,42 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
-	bool* const not_excluded = malloc(sizeof(bool[nng->vertices]));
-	if (not_excluded == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
-
-	// FIX THIS
-	size_t tmp_num_not_excluded = 0;
-	scc_PointIndex* tmp_index_not_excluded = malloc(sizeof(scc_PointIndex[nng->vertices]));
-	if (tmp_index_not_excluded == NULL) {
-		free(not_excluded);
-		iscc_make_error(SCC_ER_NO_MEMORY);
-	}
-	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
-	const scc_PointIndex vertices_pi = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
-	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
-		not_excluded[v] = (nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
-		tmp_index_not_excluded[tmp_num_not_excluded] = v;
-		tmp_num_not_excluded += not_excluded[v];
-	}
-	if (tmp_num_not_excluded == nng->vertices) {
-		tmp_num_not_excluded = 0;
-		free(tmp_index_not_excluded);
-		tmp_index_not_excluded = NULL;
-	}
-	// UNTIL HERE
-
-	//for (size_t v = 0; v < nng->vertices; ++v) {
-	//	not_excluded[v] = (nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
-	//}
-
 	scc_ErrorCode ec;
-	iscc_Digraph exclusion_graph;
-	if ((ec = iscc_fs_exclusion_graph(nng, tmp_num_not_excluded, tmp_index_not_excluded, &exclusion_graph)) != SCC_ER_OK) {
-		free(not_excluded);
+	iscc_fs_ExclusionGraph exclusion_graph;
+	if ((ec = iscc_fs_init_exclusion_graph(nng, &exclusion_graph)) != SCC_ER_OK) {
 		return ec;
 	}
 
-	// FIX THIS
-	free(tmp_index_not_excluded);
-	tmp_index_not_excluded = NULL;
-	// UNTIL HERE
+	iscc_BitWord* const excluded = iscc_alloc_bitset(nng->vertices);
+	scc_PointIndex* const seed_row = malloc(sizeof(scc_PointIndex[exclusion_graph.max_row_size]));
+	scc_PointIndex* const ex_row = malloc(sizeof(scc_PointIndex[exclusion_graph.max_row_size]));
+	if ((excluded == NULL) || (seed_row == NULL) || (ex_row == NULL)) {
+		free(excluded);
+		free(seed_row);
+		free(ex_row);
+		iscc_fs_free_exclusion_graph(&exclusion_graph);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	for (size_t v = 0; v < nng->vertices; ++v) {
+		if (nng->tail_ptr[v] == nng->tail_ptr[v + 1]) iscc_bitset_set(excluded, v);
+	}
 
 	iscc_fs_SortResult sort;
-	if ((ec = iscc_fs_sort_by_inwards(&exclusion_graph, updating, &sort)) != SCC_ER_OK) {
-		free(not_excluded);
-		iscc_free_digraph(&exclusion_graph);
+	if ((ec = iscc_fs_sort_by_exclusion_inwards(&exclusion_graph, ex_row, updating, &sort)) != SCC_ER_OK) {
+		free(excluded);
+		free(seed_row);
+		free(ex_row);
+		iscc_fs_free_exclusion_graph(&exclusion_graph);
 		return ec;
 	}
 
 	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if (out_seeds->seeds == NULL) {
-		free(not_excluded);
-		iscc_free_digraph(&exclusion_graph);
+		free(excluded);
+		free(seed_row);
+		free(ex_row);
+		iscc_fs_free_exclusion_graph(&exclusion_graph);
 		iscc_fs_free_sort_result(&sort);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
@@ -445,24 +525,26 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 			if (updating) iscc_fs_debug_check_sort(sorted_v, sorted_v_stop - 1, sort.inwards_count);
 		#endif
 
-		if (not_excluded[*sorted_v]) {
+		if (!iscc_bitset_test(excluded, (size_t) *sorted_v)) {
 			assert(nng->tail_ptr[*sorted_v] != nng->tail_ptr[*sorted_v + 1]);
 
 			if ((ec = iscc_fs_add_seed(*sorted_v, out_seeds)) != SCC_ER_OK) {
-				free(not_excluded);
-				iscc_free_digraph(&exclusion_graph);
+				free(excluded);
+				free(seed_row);
+				free(ex_row);
+				iscc_fs_free_exclusion_graph(&exclusion_graph);
 				iscc_fs_free_sort_result(&sort);
 				free(out_seeds->seeds);
 				return ec;
 			}
 
-			not_excluded[*sorted_v] = false;
+			iscc_bitset_set(excluded, (size_t) *sorted_v);
+
+			const size_t len_seed_row = iscc_fs_exclusion_row(&exclusion_graph, *sorted_v, seed_row);
 
 			if (!updating) {
-				const scc_PointIndex* const ex_arc_stop = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v + 1];
-				const scc_PointIndex* ex_arc = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v];
-				for (; ex_arc != ex_arc_stop; ++ex_arc) {
-					not_excluded[*ex_arc] = false;
+				for (size_t i = 0; i < len_seed_row; ++i) {
+					iscc_bitset_set(excluded, (size_t) seed_row[i]);
 				}
 
 			} else {
@@ -470,28 +552,20 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 				// Since most of the seed's neighbors' neighbors will be neighbors themselves (and thus excluded) we don't want to
 				// waste computations on decreasing their count since they will fall out of the queue anyways. Therefore, we want
 				// to make two passes over the neighbors: one to exclude all neighbors that is not already excluded (and record them),
-				// and another to decrease the count on non-excluded neighbors' neighbors. As we never will return to the seed's edges,
-				// we use that as a scratch area.
-				scc_PointIndex* const ex_arc_start = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v];
-				const scc_PointIndex* const ex_arc_stop = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v + 1];
-				const scc_PointIndex* ex_arc = ex_arc_start;
-				scc_PointIndex* write_arc = ex_arc_start;
-
-				for (; ex_arc != ex_arc_stop; ++ex_arc) {
-					if (not_excluded[*ex_arc]) {
-						*write_arc = *ex_arc;
-						++write_arc;
+				// and another to decrease the count on non-excluded neighbors' neighbors.
+				size_t len_newly_excluded = 0;
+				for (size_t i = 0; i < len_seed_row; ++i) {
+					if (!iscc_bitset_test_and_set(excluded, (size_t) seed_row[i])) {
+						seed_row[len_newly_excluded] = seed_row[i];
+						++len_newly_excluded;
 					}
-					not_excluded[*ex_arc] = false;
 				}
 
-				ex_arc = ex_arc_start;
-				for (; ex_arc != write_arc; ++ex_arc) {
-					const scc_PointIndex* const ex_arc_arc_stop = exclusion_graph.head + exclusion_graph.tail_ptr[*ex_arc + 1];
-					for (scc_PointIndex* ex_arc_arc = exclusion_graph.head + exclusion_graph.tail_ptr[*ex_arc];
-					        ex_arc_arc != ex_arc_arc_stop; ++ex_arc_arc) {
-						if (not_excluded[*ex_arc_arc]) {
-							iscc_fs_decrease_v_in_sort(*ex_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+				for (size_t i = 0; i < len_newly_excluded; ++i) {
+					const size_t len_ex_row = iscc_fs_exclusion_row(&exclusion_graph, seed_row[i], ex_row);
+					for (size_t j = 0; j < len_ex_row; ++j) {
+						if (!iscc_bitset_test(excluded, (size_t) ex_row[j])) {
+							iscc_fs_decrease_v_in_sort(ex_row[j], sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
 						}
 					}
 				}
@@ -499,14 +573,174 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 		}
 	}
 
-	free(not_excluded);
-	iscc_free_digraph(&exclusion_graph);
+	free(excluded);
+	free(seed_row);
+	free(ex_row);
+	iscc_fs_free_exclusion_graph(&exclusion_graph);
 	iscc_fs_free_sort_result(&sort);
 
 	return iscc_no_error();
 }
 
 
+/* Finds a maximal independent set in the exclusion graph in rounds. In each
+ * round, every candidate claims itself and its neighbors, and the candidates
+ * that win all their claims become seeds. Claims are won by the candidate with
+ * fewest inwards arcs from unassigned vertices, as in SCC_SM_INWARDS_UPDATING.
+ * Conflicting candidates always claim a common vertex, so the seeds of a round
+ * are independent, and the best remaining candidate always wins. The claims
+ * are pulled through the transpose of the NNG, so each round is a few parallel
+ * passes over the vertices without writes to shared data. The result does not
+ * depend on the number of threads.
+ */
+static scc_ErrorCode iscc_findseeds_parallel_mis(const iscc_Digraph* const nng,
+                                                 iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(nng->vertices > 1);
+	assert(out_seeds != NULL);
+	assert(out_seeds->capacity > 0);
+	assert(out_seeds->count == 0);
+	assert(out_seeds->seeds == NULL);
+
+	scc_ErrorCode ec;
+	iscc_Digraph nng_transpose;
+	if ((ec = iscc_digraph_transpose(nng, &nng_transpose)) != SCC_ER_OK) return ec;
+
+	const size_t vertices = nng->vertices;
+	iscc_BitWord* const marks = iscc_alloc_bitset(vertices);
+	unsigned char* const mis_state = malloc(sizeof(unsigned char[vertices]));
+	scc_PointIndex* const inwards_count = malloc(sizeof(scc_PointIndex[vertices]));
+	scc_PointIndex* const claims = malloc(sizeof(scc_PointIndex[vertices]));
+	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	if ((marks == NULL) || (mis_state == NULL) || (inwards_count == NULL) ||
+	        (claims == NULL) || (out_seeds->seeds == NULL)) {
+		iscc_free_digraph(&nng_transpose);
+		free(marks);
+		free(mis_state);
+		free(inwards_count);
+		free(claims);
+		free(out_seeds->seeds);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	const iscc_ArcIndex* const tail_ptr = nng->tail_ptr;
+	const scc_PointIndex* const head = nng->head;
+	const iscc_ArcIndex* const tr_tail_ptr = nng_transpose.tail_ptr;
+	const scc_PointIndex* const tr_head = nng_transpose.head;
+
+	size_t num_candidates = 0;
+	ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(static) reduction(+:num_candidates))
+	for (size_t v = 0; v < vertices; ++v) {
+		const bool has_arcs = (tail_ptr[v] != tail_ptr[v + 1]);
+		mis_state[v] = has_arcs ? ISCC_MIS_CANDIDATE : ISCC_MIS_EXCLUDED;
+		num_candidates += has_arcs;
+	}
+
+	while (num_candidates > 0) {
+		// Inwards arcs from unassigned vertices
+		ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(static))
+		for (size_t v = 0; v < vertices; ++v) {
+			if (mis_state[v] != ISCC_MIS_CANDIDATE) continue;
+			scc_PointIndex count = 0;
+			for (iscc_ArcIndex a = tr_tail_ptr[v]; a < tr_tail_ptr[v + 1]; ++a) {
+				count += !iscc_bitset_test(marks, (size_t) tr_head[a]);
+			}
+			inwards_count[v] = count;
+		}
+
+		// Vertex `u` is claimed by the candidates pointing to it, and by itself
+		ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(dynamic, 1024))
+		for (size_t u = 0; u < vertices; ++u) {
+			if (iscc_bitset_test(marks, u)) continue;
+			scc_PointIndex best = (mis_state[u] == ISCC_MIS_CANDIDATE) ? (scc_PointIndex) u : ISCC_POINTINDEX_MAX_PI;
+			for (iscc_ArcIndex a = tr_tail_ptr[u]; a < tr_tail_ptr[u + 1]; ++a) {
+				const scc_PointIndex t = tr_head[a];
+				if ((mis_state[t] == ISCC_MIS_CANDIDATE) &&
+				        ((best == ISCC_POINTINDEX_MAX_PI) || iscc_fs_mis_precedes(t, best, inwards_count))) {
+					best = t;
+				}
+			}
+			claims[u] = best;
+		}
+
+		ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(dynamic, 1024))
+		for (size_t v = 0; v < vertices; ++v) {
+			if (mis_state[v] != ISCC_MIS_CANDIDATE) continue;
+			if (claims[v] != (scc_PointIndex) v) continue;
+			bool won = true;
+			for (iscc_ArcIndex a = tail_ptr[v]; won && (a < tail_ptr[v + 1]); ++a) {
+				won = (claims[head[a]] == (scc_PointIndex) v);
+			}
+			if (won) mis_state[v] = ISCC_MIS_SELECTED;
+		}
+
+		assert(vertices <= ISCC_POINTINDEX_MAX);
+		const scc_PointIndex vertices_pi = (scc_PointIndex) vertices; // If `scc_PointIndex` is signed
+		for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+			if (mis_state[v] != ISCC_MIS_SELECTED) continue;
+			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) {
+				iscc_free_digraph(&nng_transpose);
+				free(marks);
+				free(mis_state);
+				free(inwards_count);
+				free(claims);
+				free(out_seeds->seeds);
+				return ec;
+			}
+		}
+
+		// The neighborhoods of the seeds are unmarked and disjoint, as every
+		// vertex is claimed by at most one seed. Checked before the parallel
+		// loop since the bitset cannot be read while it is written.
+		#ifndef NDEBUG
+			for (size_t v = 0; v < vertices; ++v) {
+				if (mis_state[v] != ISCC_MIS_SELECTED) continue;
+				assert(!iscc_bitset_test(marks, v));
+				for (iscc_ArcIndex a = tail_ptr[v]; a < tail_ptr[v + 1]; ++a) {
+					assert(!iscc_bitset_test(marks, (size_t) head[a]));
+					assert(claims[head[a]] == (scc_PointIndex) v);
+				}
+			}
+		#endif
+
+		ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(dynamic, 1024))
+		for (size_t v = 0; v < vertices; ++v) {
+			if (mis_state[v] != ISCC_MIS_SELECTED) continue;
+			for (iscc_ArcIndex a = tail_ptr[v]; a < tail_ptr[v + 1]; ++a) {
+				iscc_bitset_atomic_set(marks, (size_t) head[a]);
+			}
+			iscc_bitset_atomic_set(marks, v);
+		}
+
+		num_candidates = 0;
+		ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(dynamic, 1024) reduction(+:num_candidates))
+		for (size_t v = 0; v < vertices; ++v) {
+			if (mis_state[v] == ISCC_MIS_SELECTED) mis_state[v] = ISCC_MIS_EXCLUDED;
+			if (mis_state[v] != ISCC_MIS_CANDIDATE) continue;
+			bool excluded = iscc_bitset_test(marks, v);
+			for (iscc_ArcIndex a = tail_ptr[v]; !excluded && (a < tail_ptr[v + 1]); ++a) {
+				excluded = iscc_bitset_test(marks, (size_t) head[a]);
+			}
+			if (excluded) {
+				mis_state[v] = ISCC_MIS_EXCLUDED;
+			} else {
+				++num_candidates;
+			}
+		}
+	}
+
+	iscc_free_digraph(&nng_transpose);
+	free(marks);
+	free(mis_state);
+	free(inwards_count);
+	free(claims);
+
+	return iscc_no_error();
+}
+
+
 /*
 Exclusion graph does not give one arc optimality
 
@@ -524,43 +758,140 @@ bool iscc_findseeds_onearc_updating(const scc_Digraph* const nng, ...) {
 */
 
 
-static scc_ErrorCode iscc_fs_exclusion_graph(const iscc_Digraph* const nng,
-                                             const size_t len_not_excluded,
-                                             const scc_PointIndex not_excluded[const],
-                                             iscc_Digraph* const out_dg)
+static scc_ErrorCode iscc_fs_init_exclusion_graph(const iscc_Digraph* const nng,
+                                                  iscc_fs_ExclusionGraph* const out_eg)
 {
 	assert(iscc_digraph_is_valid(nng));
 	assert(!iscc_digraph_is_empty(nng));
-	assert(out_dg != NULL);
+	assert(out_eg != NULL);
 
-	scc_ErrorCode ec;
+	const size_t vertices = nng->vertices;
 
-	iscc_Digraph nng_transpose;
-	ec = iscc_digraph_transpose(nng, &nng_transpose);
-	if (ec != SCC_ER_OK) return ec;
-	assert(!iscc_digraph_is_empty(&nng_transpose));
+	*out_eg = (iscc_fs_ExclusionGraph) {
+		.nng = nng,
+		.nng_transpose = ISCC_NULL_DIGRAPH,
+		.max_row_size = 0,
+		.row_stamp = 0,
+		.row_markers = calloc(vertices, sizeof(size_t)),
+	};
+	if (out_eg->row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
-	iscc_Digraph nng_nng_transpose;
-	ec = iscc_adjacency_product(nng, &nng_transpose, true, &nng_nng_transpose);
-	iscc_free_digraph(&nng_transpose);
-	if (ec != SCC_ER_OK) return ec;
-
-	/* In `out_dg`, all vertices with zero outwards arcs in `nng` will have
-	 * arcs pointing to vertices that points to them in `nng`. These vertices are
-	 * excluded from the the beginning (due to zero arcs), thus their outwards arcs
-	 * are not necessary. In fact, to keep these arcs leads to that the sorting on
-	 * inwards arcs by `iscc_fs_sort_by_inwards()` becomes wrong. Remove
-	 * by calling `iscc_digraph_union_and_delete` with `not_excluded`.
-	 */
-	const iscc_Digraph nng_sum[2] = { *nng, nng_nng_transpose };
-	ec = iscc_digraph_union_and_delete(2, nng_sum, len_not_excluded, not_excluded, false, out_dg);
-	iscc_free_digraph(&nng_nng_transpose);
-	if (ec != SCC_ER_OK) return ec;
+	scc_ErrorCode ec;
+	if ((ec = iscc_digraph_transpose(nng, &out_eg->nng_transpose)) != SCC_ER_OK) {
+		iscc_fs_free_exclusion_graph(out_eg);
+		return ec;
+	}
+	const iscc_ArcIndex* const tr_tail_ptr = out_eg->nng_transpose.tail_ptr;
+
+	// Bound the row sizes by the number of arcs that `iscc_fs_exclusion_row` visits
+	for (size_t v = 0; v < vertices; ++v) {
+		size_t row_size = (nng->tail_ptr[v + 1] - nng->tail_ptr[v]) + (tr_tail_ptr[v + 1] - tr_tail_ptr[v]);
+		const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[v + 1];
+		for (const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[v];
+		        v_arc != v_arc_stop; ++v_arc) {
+			row_size += tr_tail_ptr[*v_arc + 1] - tr_tail_ptr[*v_arc];
+		}
+		if (row_size >= vertices) row_size = vertices - 1;
+		if (out_eg->max_row_size < row_size) out_eg->max_row_size = row_size;
+	}
+	if (out_eg->max_row_size == 0) out_eg->max_row_size = 1;
 
 	return iscc_no_error();
 }
 
 
+static void iscc_fs_free_exclusion_graph(iscc_fs_ExclusionGraph* const eg)
+{
+	if (eg != NULL) {
+		iscc_free_digraph(&eg->nng_transpose);
+		free(eg->row_markers);
+		eg->row_markers = NULL;
+	}
+}
+
+
+/* Writes the row of `v` in the exclusion graph to `out_row` and returns its
+ * length. The arcs are those to the NNG neighbors of `v`, followed by the arcs
+ * to the vertices that point to `v` or to one of its neighbors, without
+ * duplicates or self-loops. This is the order of the rows in
+ * `iscc_digraph_union_and_delete(nng, nng * transpose(nng))`.
+ */
+static size_t iscc_fs_exclusion_row(iscc_fs_ExclusionGraph* const eg,
+                                    const scc_PointIndex v,
+                                    scc_PointIndex out_row[const])
+{
+	assert(eg != NULL);
+	assert(out_row != NULL);
+
+	const iscc_Digraph* const nng = eg->nng;
+	const iscc_Digraph* const nng_transpose = &eg->nng_transpose;
+	size_t* const row_markers = eg->row_markers;
+	const size_t stamp = ++(eg->row_stamp);
+
+	size_t len_row = 0;
+	row_markers[v] = stamp;
+
+	const scc_PointIndex* const v_arc_start = nng->head + nng->tail_ptr[v];
+	const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[v + 1];
+	for (const scc_PointIndex* v_arc = v_arc_start; v_arc != v_arc_stop; ++v_arc) {
+		if (row_markers[*v_arc] != stamp) {
+			row_markers[*v_arc] = stamp;
+			out_row[len_row] = *v_arc;
+			++len_row;
+		}
+	}
+
+	const scc_PointIndex* const v_tr_arc_stop = nng_transpose->head + nng_transpose->tail_ptr[v + 1];
+	for (const scc_PointIndex* v_tr_arc = nng_transpose->head + nng_transpose->tail_ptr[v];
+	        v_tr_arc != v_tr_arc_stop; ++v_tr_arc) {
+		if (row_markers[*v_tr_arc] != stamp) {
+			row_markers[*v_tr_arc] = stamp;
+			out_row[len_row] = *v_tr_arc;
+			++len_row;
+		}
+	}
+
+	for (const scc_PointIndex* v_arc = v_arc_start; v_arc != v_arc_stop; ++v_arc) {
+		const scc_PointIndex* const tr_arc_stop = nng_transpose->head + nng_transpose->tail_ptr[*v_arc + 1];
+		for (const scc_PointIndex* tr_arc = nng_transpose->head + nng_transpose->tail_ptr[*v_arc];
+		        tr_arc != tr_arc_stop; ++tr_arc) {
+			if (row_markers[*tr_arc] != stamp) {
+				row_markers[*tr_arc] = stamp;
+				out_row[len_row] = *tr_arc;
+				++len_row;
+			}
+		}
+	}
+
+	assert(len_row <= eg->max_row_size);
+
+	return len_row;
+}
+
+
+/* Orders candidates by inwards count. Ties are broken by a hash of the vertex
+ * ID; breaking them by ID would make chains of vertices take one round per
+ * link. */
+static inline bool iscc_fs_mis_precedes(const scc_PointIndex a,
+                                        const scc_PointIndex b,
+                                        const scc_PointIndex inwards_count[const])
+{
+	if (inwards_count[a] != inwards_count[b]) return inwards_count[a] < inwards_count[b];
+
+	uint64_t hash_a = (uint64_t) a + 0x9E3779B97F4A7C15u;
+	uint64_t hash_b = (uint64_t) b + 0x9E3779B97F4A7C15u;
+	hash_a = (hash_a ^ (hash_a >> 30)) * 0xBF58476D1CE4E5B9u;
+	hash_b = (hash_b ^ (hash_b >> 30)) * 0xBF58476D1CE4E5B9u;
+	hash_a = (hash_a ^ (hash_a >> 27)) * 0x94D049BB133111EBu;
+	hash_b = (hash_b ^ (hash_b >> 27)) * 0x94D049BB133111EBu;
+	hash_a ^= hash_a >> 31;
+	hash_b ^= hash_b >> 31;
+	if (hash_a != hash_b) return hash_a < hash_b;
+
+	return a < b;
+}
+
+
 static inline scc_ErrorCode iscc_fs_add_seed(const scc_PointIndex s,
                                              iscc_SeedResult* const seed_result)
 {
@@ -590,16 +921,16 @@ static inline scc_ErrorCode iscc_fs_add_seed(const scc_PointIndex s,
 
 static inline bool iscc_fs_check_neighbors_marks(const scc_PointIndex v,
                                                  const iscc_Digraph* const nng,
-                                                 const bool marks[const static nng->vertices])
+                                                 const iscc_BitWord marks[const])
 {
-	if (marks[v]) return false;
+	if (iscc_bitset_test(marks, (size_t) v)) return false;
 
 	const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[v];
 	const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[v + 1];
 	if (v_arc == v_arc_stop) return false;
 
 	for (; v_arc != v_arc_stop; ++v_arc) {
-		if (marks[*v_arc]) return false;
+		if (iscc_bitset_test(marks, (size_t) *v_arc)) return false;
 	}
 
 	return true;
@@ -608,18 +939,18 @@ static inline bool iscc_fs_check_neighbors_marks(const scc_PointIndex v,
 
 static inline void iscc_fs_mark_seed_neighbors(const scc_PointIndex s,
                                                const iscc_Digraph* const nng,
-                                               bool marks[const static nng->vertices])
+                                               iscc_BitWord marks[const])
 {
-	assert(!marks[s]);
+	assert(!iscc_bitset_test(marks, (size_t) s));
 
 	const scc_PointIndex* const s_arc_stop = nng->head + nng->tail_ptr[s + 1];
 	for (const scc_PointIndex* s_arc = nng->head + nng->tail_ptr[s];
 	        s_arc != s_arc_stop; ++s_arc) {
-		assert(!marks[*s_arc]);
-		marks[*s_arc] = true;
+		assert(!iscc_bitset_test(marks, (size_t) *s_arc));
+		iscc_bitset_set(marks, (size_t) *s_arc);
 	}
 
-	marks[s] = true; // Mark seed last, if there're self-loops
+	iscc_bitset_set(marks, (size_t) s); // Mark seed last, if there're self-loops
 }
 
 
@@ -657,57 +988,138 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	const scc_PointIndex* const arc_stop = nng->head + nng->tail_ptr[vertices];
-	for (const scc_PointIndex* arc = nng->head; arc != arc_stop; ++arc) {
-		++out_sort->inwards_count[*arc];
+	const size_t num_arcs = nng->tail_ptr[vertices];
+	const scc_PointIndex* const head = nng->head;
+	scc_PointIndex* const inwards_count = out_sort->inwards_count;
+	ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) if(vertices >= ISCC_FS_MIN_PARALLEL_VERTICES) schedule(static))
+	for (size_t a = 0; a < num_arcs; ++a) {
+		ISCC_OMP(atomic)
+		++inwards_count[head[a]];
+	}
+
+	return iscc_fs_bucket_sort(vertices, make_indices, out_sort);
+}
+
+
+/* As `iscc_fs_sort_by_inwards` applied to the exclusion graph. Rows of vertices
+ * without arcs in the NNG are excluded from the beginning and are not counted.
+ * The inwards arcs are counted row by row, using `row` as scratch space.
+ */
+static scc_ErrorCode iscc_fs_sort_by_exclusion_inwards(iscc_fs_ExclusionGraph* const eg,
+                                                       scc_PointIndex row[const],
+                                                       const bool make_indices,
+                                                       iscc_fs_SortResult* const out_sort)
+{
+	assert(eg != NULL);
+	assert(row != NULL);
+	assert(out_sort != NULL);
+
+	const iscc_Digraph* const nng = eg->nng;
+	const size_t vertices = nng->vertices;
+
+	*out_sort = (iscc_fs_SortResult) {
+		.inwards_count = calloc(vertices, sizeof(scc_PointIndex)),
+		.sorted_vertices = malloc(sizeof(scc_PointIndex[vertices])),
+		.vertex_index = NULL,
+		.bucket_index = NULL,
+	};
+
+	if ((out_sort->inwards_count == NULL) || (out_sort->sorted_vertices == NULL)) {
+		iscc_fs_free_sort_result(out_sort);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	assert(vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices_pi = (scc_PointIndex) vertices; // If `scc_PointIndex` is signed
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		if (nng->tail_ptr[v] == nng->tail_ptr[v + 1]) continue;
+		const size_t len_row = iscc_fs_exclusion_row(eg, v, row);
+		for (size_t i = 0; i < len_row; ++i) {
+			++out_sort->inwards_count[row[i]];
+		}
 	}
 
-	// Dynamic alloc is slightly faster but more error-prone
-	// Add if turns out to be bottleneck
+	return iscc_fs_bucket_sort(vertices, make_indices, out_sort);
+}
+
+
+static scc_ErrorCode iscc_fs_bucket_sort(const size_t vertices,
+                                         const bool make_indices,
+                                         iscc_fs_SortResult* const out_sort)
+{
+	assert(vertices > 1);
+	assert(out_sort != NULL);
+	assert(out_sort->inwards_count != NULL);
+	assert(out_sort->sorted_vertices != NULL);
+
+	const scc_PointIndex* const inwards_count = out_sort->inwards_count;
+
 	scc_PointIndex max_inwards_tmp = 0;
+	ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) if(vertices >= ISCC_FS_MIN_PARALLEL_VERTICES) schedule(static) reduction(max:max_inwards_tmp))
 	for (size_t v = 0; v < vertices; ++v) {
-		if (max_inwards_tmp < out_sort->inwards_count[v]) max_inwards_tmp = out_sort->inwards_count[v];
+		if (max_inwards_tmp < inwards_count[v]) max_inwards_tmp = inwards_count[v];
 	}
 	const size_t max_inwards = (size_t) max_inwards_tmp; // If `scc_PointIndex` is signed
+	const size_t num_buckets = max_inwards + 1;
+
+	/* The vertices are split into contiguous chunks, each with its own bucket
+	 * counts. Within a bucket, the vertices of a chunk are placed after those
+	 * of earlier chunks, so every bucket is sorted by vertex ID, as when
+	 * sorting serially. */
+	size_t num_chunks = 1;
+	if (vertices >= ISCC_FS_MIN_PARALLEL_VERTICES) {
+		num_chunks = (size_t) iscc_get_num_threads();
+	}
 
-	size_t* bucket_count = calloc(max_inwards + 1, sizeof(size_t));
-	out_sort->bucket_index = malloc(sizeof(scc_PointIndex*[max_inwards + 1]));
-	if ((bucket_count == NULL) || (out_sort->bucket_index == NULL)) {
+	size_t* const bucket_count = calloc(num_chunks * num_buckets, sizeof(size_t));
+	out_sort->bucket_index = malloc(sizeof(scc_PointIndex*[num_buckets]));
+	if (make_indices) {
+		out_sort->vertex_index = malloc(sizeof(scc_PointIndex*[vertices]));
+	}
+	if ((bucket_count == NULL) || (out_sort->bucket_index == NULL) ||
+	        (make_indices && (out_sort->vertex_index == NULL))) {
 		free(bucket_count);
 		iscc_fs_free_sort_result(out_sort);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	for (size_t v = 0; v < vertices; ++v) {
-		++bucket_count[out_sort->inwards_count[v]];
+	ISCC_OMP(parallel for num_threads((int) num_chunks) if(num_chunks > 1) schedule(static, 1))
+	for (size_t c = 0; c < num_chunks; ++c) {
+		size_t* const chunk_count = bucket_count + c * num_buckets;
+		const size_t v_stop = ((c + 1) * vertices) / num_chunks;
+		for (size_t v = (c * vertices) / num_chunks; v < v_stop; ++v) {
+			++chunk_count[inwards_count[v]];
+		}
 	}
 
-	out_sort->bucket_index[0] = out_sort->sorted_vertices + bucket_count[0];
-	for (size_t b = 1; b <= max_inwards; ++b) {
-		out_sort->bucket_index[b] = out_sort->bucket_index[b - 1] + bucket_count[b];
+	// Turn counts into the position of each chunk in each bucket
+	size_t pos = 0;
+	for (size_t b = 0; b < num_buckets; ++b) {
+		out_sort->bucket_index[b] = out_sort->sorted_vertices + pos;
+		for (size_t c = 0; c < num_chunks; ++c) {
+			const size_t count = bucket_count[c * num_buckets + b];
+			bucket_count[c * num_buckets + b] = pos;
+			pos += count;
+		}
 	}
-	free(bucket_count);
+	assert(pos == vertices);
 
 	assert(vertices <= ISCC_POINTINDEX_MAX);
-	if (make_indices) {
-		out_sort->vertex_index = malloc(sizeof(scc_PointIndex*[vertices]));
-		if (out_sort->vertex_index == NULL) {
-			iscc_fs_free_sort_result(out_sort);
-			return iscc_make_error(SCC_ER_NO_MEMORY);
-		}
-		for (scc_PointIndex v = (scc_PointIndex) vertices; v > 0; ) {
-			--v;
-			--(out_sort->bucket_index[out_sort->inwards_count[v]]);
-			*out_sort->bucket_index[out_sort->inwards_count[v]] = v;
-			out_sort->vertex_index[v] = out_sort->bucket_index[out_sort->inwards_count[v]];
-		}
-	} else {
-		for (scc_PointIndex v = (scc_PointIndex) vertices; v > 0; ) {
-			--v;
-			--(out_sort->bucket_index[out_sort->inwards_count[v]]);
-			*out_sort->bucket_index[out_sort->inwards_count[v]] = v;
+	scc_PointIndex* const sorted_vertices = out_sort->sorted_vertices;
+	scc_PointIndex** const vertex_index = out_sort->vertex_index;
+	ISCC_OMP(parallel for num_threads((int) num_chunks) if(num_chunks > 1) schedule(static, 1))
+	for (size_t c = 0; c < num_chunks; ++c) {
+		size_t* const chunk_pos = bucket_count + c * num_buckets;
+		const size_t v_stop = ((c + 1) * vertices) / num_chunks;
+		for (size_t v = (c * vertices) / num_chunks; v < v_stop; ++v) {
+			const size_t v_pos = chunk_pos[inwards_count[v]]++;
+			sorted_vertices[v_pos] = (scc_PointIndex) v;
+			if (make_indices) vertex_index[v] = sorted_vertices + v_pos;
 		}
+	}
+	free(bucket_count);
 
+	if (!make_indices) {
 		free(out_sort->inwards_count);
 		free(out_sort->bucket_index);
 		out_sort->inwards_count = NULL;
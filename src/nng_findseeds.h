@@ -47,5 +47,9 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* nng,
                               scc_SeedMethod seed_method,
                               iscc_SeedResult* out_seeds);
 
+scc_ErrorCode iscc_find_seeds_reordered(const iscc_Digraph* nng,
+                                        scc_SeedMethod seed_method,
+                                        iscc_SeedResult* out_seeds);
+
 
 #endif // ifndef SCC_NNG_FINDSEEDS_HG
@@ -0,0 +1,77 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "parallel.h"
+
+#include <stdint.h>
+#include "../include/scclust.h"
+#include "error.h"
+
+
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+#ifdef _OPENMP
+	// Zero means OpenMP default
+	static int iscc_num_threads = 0;
+#endif
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode scc_set_num_threads(const uint32_t num_threads)
+{
+	#ifdef _OPENMP
+		if (num_threads > INT32_MAX) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Too many threads.");
+		}
+		iscc_num_threads = (int) num_threads;
+	#else
+		if (num_threads > 1) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "scclust is compiled without OpenMP support.");
+		}
+	#endif
+
+	return iscc_no_error();
+}
+
+
+int iscc_get_num_threads(void)
+{
+	#ifdef _OPENMP
+		if (iscc_num_threads > 0) return iscc_num_threads;
+		return omp_get_max_threads();
+	#else
+		return 1;
+	#endif
+}
+
+
+int iscc_get_thread_num(void)
+{
+	#ifdef _OPENMP
+		return omp_get_thread_num();
+	#else
+		return 0;
+	#endif
+}
@@ -0,0 +1,89 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_PARALLEL_HG
+#define SCC_PARALLEL_HG
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// =============================================================================
+// Macros
+// =============================================================================
+
+/** Macro for OpenMP directives.
+ *
+ *  `ISCC_OMP(parallel for)` expands to `#pragma omp parallel for` when
+ *  compiled with OpenMP, and to nothing otherwise.
+ */
+#ifdef _OPENMP
+	#define ISCC_OMP_STRINGIFY(...) #__VA_ARGS__
+	#define ISCC_OMP(...) _Pragma(ISCC_OMP_STRINGIFY(omp __VA_ARGS__))
+#else
+	#define ISCC_OMP(...)
+#endif
+
+/** Storage class for thread-local variables.
+ *
+ *  C99 has no thread-local storage; compiler extensions are used where
+ *  available. The error state and the active distance backend are
+ *  thread-local, so concurrent library calls are only safe with one of
+ *  them, and compilers without any are rejected.
+ */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+	#define ISCC_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+	#define ISCC_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+	#define ISCC_THREAD_LOCAL __declspec(thread)
+#else
+	#error "scclust requires thread-local storage (C11, GCC, Clang or MSVC)."
+#endif
+
+
+// =============================================================================
+// Function prototypes
+// =============================================================================
+
+/** Number of threads to use in parallel regions.
+ *
+ *  Returns the number set by #scc_set_num_threads, or the OpenMP default if
+ *  no number is set. Always returns 1 without OpenMP.
+ */
+int iscc_get_num_threads(void);
+
+/** Index of the calling thread in the current parallel region.
+ *
+ *  Always returns 0 outside parallel regions and without OpenMP.
+ */
+int iscc_get_thread_num(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ifndef SCC_PARALLEL_HG
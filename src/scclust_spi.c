@@ -20,9 +20,19 @@
 
 #include "../include/scclust_spi.h"
 
+#include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/scclust.h"
 #include "dist_search.h"
+#include "dist_search_abandon.h"
+#include "dist_search_balltree.h"
+#include "dist_search_hnsw.h"
 #include "dist_search_imp.h"
+#include "dist_search_kdtree.h"
+#include "error.h"
 
 
 iscc_dist_functions_struct iscc_dist_functions = {
@@ -37,6 +47,8 @@ iscc_dist_functions_struct iscc_dist_functions = {
 	.close_nn_search_object = iscc_imp_close_nn_search_object,
 };
 
+ISCC_THREAD_LOCAL const scc_DistBackend* iscc_active_dist_backend = NULL;
+
 
 bool scc_reset_dist_functions(void)
 {
@@ -96,6 +108,7 @@ bool scc_set_dist_functions(scc_check_data_set check_data_set,
 		iscc_dist_functions.init_nn_search_object = init_nn_search_object;
 		iscc_dist_functions.nearest_neighbor_search = nearest_neighbor_search;
 		iscc_dist_functions.close_nn_search_object = close_nn_search_object;
+		iscc_dist_functions.nn_search_thread_safe = false;
 	} else if (init_nn_search_object != NULL ||
 			nearest_neighbor_search != NULL ||
 			close_nn_search_object != NULL) {
@@ -104,3 +117,262 @@ bool scc_set_dist_functions(scc_check_data_set check_data_set,
 
 	return true;
 }
+
+
+bool scc_set_nn_search_thread_safe(const bool thread_safe)
+{
+	iscc_dist_functions.nn_search_thread_safe = thread_safe;
+	return true;
+}
+
+
+bool scc_set_kdtree_dist_search(void)
+{
+	return scc_set_dist_functions(NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              iscc_kdt_init_nn_search_object,
+	                              iscc_kdt_nearest_neighbor_search,
+	                              iscc_kdt_close_nn_search_object);
+}
+
+
+bool scc_set_balltree_dist_search(void)
+{
+	return scc_set_dist_functions(NULL,
+	                              NULL,
+	                              NULL,
+	                              iscc_bt_init_max_dist_object,
+	                              iscc_bt_get_max_dist,
+	                              iscc_bt_close_max_dist_object,
+	                              iscc_bt_init_nn_search_object,
+	                              iscc_bt_nearest_neighbor_search,
+	                              iscc_bt_close_nn_search_object);
+}
+
+
+bool scc_set_early_abandon_dist_search(const bool reorder_dimensions)
+{
+	return scc_set_dist_functions(NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              reorder_dimensions ? iscc_ea_init_nn_search_object_reordered : iscc_ea_init_nn_search_object,
+	                              iscc_ea_nearest_neighbor_search,
+	                              iscc_ea_close_nn_search_object);
+}
+
+
+bool scc_set_hnsw_dist_search(const uint32_t m,
+                              const uint32_t ef_construction,
+                              const uint32_t ef_search,
+                              const char* const index_file)
+{
+	if (!iscc_hnsw_set_parameters(m, ef_construction, ef_search, index_file)) {
+		return false;
+	}
+	return scc_set_dist_functions(NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              NULL,
+	                              iscc_hnsw_init_nn_search_object,
+	                              iscc_hnsw_nearest_neighbor_search,
+	                              iscc_hnsw_close_nn_search_object);
+}
+
+
+scc_ErrorCode scc_init_dist_backend(const scc_check_data_set check_data_set,
+                                    const scc_get_dist_matrix get_dist_matrix,
+                                    const scc_get_dist_rows get_dist_rows,
+                                    const scc_init_max_dist_object init_max_dist_object,
+                                    const scc_get_max_dist get_max_dist,
+                                    const scc_close_max_dist_object close_max_dist_object,
+                                    const scc_init_nn_search_object init_nn_search_object,
+                                    const scc_nearest_neighbor_search nearest_neighbor_search,
+                                    const scc_close_nn_search_object close_nn_search_object,
+                                    void* const user_data,
+                                    scc_DistBackend** const out_dist_backend)
+{
+	if (out_dist_backend == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_dist_backend = NULL;
+
+	const bool max_dist_set = (init_max_dist_object != NULL) &&
+	                          (get_max_dist != NULL) &&
+	                          (close_max_dist_object != NULL);
+	if (!max_dist_set && ((init_max_dist_object != NULL) ||
+	                      (get_max_dist != NULL) ||
+	                      (close_max_dist_object != NULL))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Max distance functions must be set together.");
+	}
+	const bool nn_search_set = (init_nn_search_object != NULL) &&
+	                           (nearest_neighbor_search != NULL) &&
+	                           (close_nn_search_object != NULL);
+	if (!nn_search_set && ((init_nn_search_object != NULL) ||
+	                       (nearest_neighbor_search != NULL) ||
+	                       (close_nn_search_object != NULL))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Nearest neighbor search functions must be set together.");
+	}
+
+	scc_DistBackend* const tmp_backend = malloc(sizeof(scc_DistBackend));
+	if (tmp_backend == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	*tmp_backend = (scc_DistBackend) {
+		.dist_backend_version = ISCC_DIST_BACKEND_STRUCT_VERSION,
+		.functions = {
+			.check_data_set = (check_data_set != NULL) ? check_data_set : iscc_imp_check_data_set,
+			.get_dist_matrix = (get_dist_matrix != NULL) ? get_dist_matrix : iscc_imp_get_dist_matrix,
+			.get_dist_rows = (get_dist_rows != NULL) ? get_dist_rows : iscc_imp_get_dist_rows,
+			.init_max_dist_object = max_dist_set ? init_max_dist_object : iscc_imp_init_max_dist_object,
+			.get_max_dist = max_dist_set ? get_max_dist : iscc_imp_get_max_dist,
+			.close_max_dist_object = max_dist_set ? close_max_dist_object : iscc_imp_close_max_dist_object,
+			.init_nn_search_object = nn_search_set ? init_nn_search_object : iscc_imp_init_nn_search_object,
+			.nearest_neighbor_search = nn_search_set ? nearest_neighbor_search : iscc_imp_nearest_neighbor_search,
+			.close_nn_search_object = nn_search_set ? close_nn_search_object : iscc_imp_close_nn_search_object,
+		},
+		.user_data = user_data,
+		.owns_user_data = false,
+	};
+
+	*out_dist_backend = tmp_backend;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_init_kdtree_dist_backend(scc_DistBackend** const out_dist_backend)
+{
+	return scc_init_dist_backend(NULL,
+	                             NULL,
+	                             NULL,
+	                             NULL,
+	                             NULL,
+	                             NULL,
+	                             iscc_kdt_init_nn_search_object,
+	                             iscc_kdt_nearest_neighbor_search,
+	                             iscc_kdt_close_nn_search_object,
+	                             NULL,
+	                             out_dist_backend);
+}
+
+
+scc_ErrorCode scc_init_balltree_dist_backend(scc_DistBackend** const out_dist_backend)
+{
+	return scc_init_dist_backend(NULL,
+	                             NULL,
+	                             NULL,
+	                             iscc_bt_init_max_dist_object,
+	                             iscc_bt_get_max_dist,
+	                             iscc_bt_close_max_dist_object,
+	                             iscc_bt_init_nn_search_object,
+	                             iscc_bt_nearest_neighbor_search,
+	                             iscc_bt_close_nn_search_object,
+	                             NULL,
+	                             out_dist_backend);
+}
+
+
+scc_ErrorCode scc_init_early_abandon_dist_backend(const bool reorder_dimensions,
+                                                  scc_DistBackend** const out_dist_backend)
+{
+	return scc_init_dist_backend(NULL,
+	                             NULL,
+	                             NULL,
+	                             NULL,
+	                             NULL,
+	                             NULL,
+	                             reorder_dimensions ? iscc_ea_init_nn_search_object_reordered : iscc_ea_init_nn_search_object,
+	                             iscc_ea_nearest_neighbor_search,
+	                             iscc_ea_close_nn_search_object,
+	                             NULL,
+	                             out_dist_backend);
+}
+
+
+scc_ErrorCode scc_init_hnsw_dist_backend(const uint32_t m,
+                                         const uint32_t ef_construction,
+                                         const uint32_t ef_search,
+                                         const char* const index_file,
+                                         scc_DistBackend** const out_dist_backend)
+{
+	if (out_dist_backend == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_dist_backend = NULL;
+
+	scc_ErrorCode ec;
+	iscc_hnsw_Settings* settings;
+	if ((ec = iscc_hnsw_make_settings(m, ef_construction, ef_search, index_file, &settings)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	if ((ec = scc_init_dist_backend(NULL,
+	                                NULL,
+	                                NULL,
+	                                NULL,
+	                                NULL,
+	                                NULL,
+	                                iscc_hnsw_init_nn_search_object,
+	                                iscc_hnsw_nearest_neighbor_search,
+	                                iscc_hnsw_close_nn_search_object,
+	                                settings,
+	                                out_dist_backend)) != SCC_ER_OK) {
+		free(settings);
+		return ec;
+	}
+	(*out_dist_backend)->owns_user_data = true;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_set_dist_backend_thread_safe(scc_DistBackend* const dist_backend,
+                                               const bool thread_safe)
+{
+	if (!iscc_is_dist_backend(dist_backend)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid distance backend.");
+	}
+	dist_backend->functions.nn_search_thread_safe = thread_safe;
+	return iscc_no_error();
+}
+
+
+void scc_free_dist_backend(scc_DistBackend** const dist_backend)
+{
+	if ((dist_backend != NULL) && (*dist_backend != NULL)) {
+		if ((*dist_backend)->owns_user_data) free((*dist_backend)->user_data);
+		free(*dist_backend);
+		*dist_backend = NULL;
+	}
+}
+
+
+void* scc_get_dist_backend_user_data(void)
+{
+	if (iscc_active_dist_backend == NULL) return NULL;
+	return iscc_active_dist_backend->user_data;
+}
+
+
+bool iscc_is_dist_backend(const scc_DistBackend* const dist_backend)
+{
+	if (dist_backend == NULL) return false;
+	return (dist_backend->dist_backend_version == ISCC_DIST_BACKEND_STRUCT_VERSION);
+}
+
+
+const scc_DistBackend* iscc_set_active_dist_backend(const scc_DistBackend* const dist_backend)
+{
+	assert((dist_backend == NULL) || iscc_is_dist_backend(dist_backend));
+	const scc_DistBackend* const previous = iscc_active_dist_backend;
+	iscc_active_dist_backend = dist_backend;
+	return previous;
+}
@@ -102,6 +102,9 @@ typedef enum scc_ErrorCode scc_ErrorCode;
  *  Writes a description of the latest error prroduced by the library to the
  *  supplied buffer.
  *
+ *  Errors are recorded per thread. The description is of the latest error
+ *  produced by a call made from the calling thread.
+ *
  *  \param[in] len_error_message_buffer the length of the buffer #error_message_buffer.
  *  \param[out] error_message_buffer the buffer to write to.
  *
@@ -111,6 +114,42 @@ bool scc_get_latest_error(size_t len_error_message_buffer,
                           char error_message_buffer[]);
 
 
+// =============================================================================
+// Thread safety
+// =============================================================================
+
+/* Library calls working on different objects may run concurrently in
+ * different threads. For example, a thread pool can make one clustering per
+ * stratum with #scc_make_clustering. Objects shared between the threads
+ * (e.g., a #scc_DataSet) may be read concurrently, but must not be freed
+ * while in use.
+ *
+ * The settings are global: #scc_set_num_threads and the functions in
+ * `scclust_spi.h` must not be called while other library calls are running.
+ */
+
+
+// =============================================================================
+// Parallel execution
+// =============================================================================
+
+/** Set the number of threads.
+ *
+ *  Sets the number of threads used by the parallel parts of the library.
+ *  The setting is global and applies to all subsequent calls.
+ *
+ *  \param[in] num_threads the number of threads. If zero, the OpenMP default
+ *                         is used (typically the number of cores).
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note The library must be compiled with `--enable-openmp` to run in
+ *        parallel. Otherwise, this function returns #SCC_ER_NOT_IMPLEMENTED
+ *        for all #num_threads larger than one.
+ */
+scc_ErrorCode scc_set_num_threads(uint32_t num_threads);
+
+
 // =============================================================================
 // Library types
 // =============================================================================
@@ -184,6 +223,124 @@ scc_ErrorCode scc_init_data_set(uintmax_t num_data_points,
                                 const double data_matrix[],
                                 scc_DataSet** out_data_set);
 
+/** Construct new single precision data set.
+ *
+ *  As #scc_init_data_set, but with the coordinates stored as \c float. This
+ *  halves the memory traffic of the distance calculations, which are
+ *  accumulated in single precision.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_dimensions the number of dimensions for each data point.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the raw data, ordered as in #scc_init_data_set.
+ *  \param[in] rerank_matrix optional double precision copy of #data_matrix (or \c NULL).
+ *                           If provided, the final nearest neighbors are re-ranked
+ *                           using exact distances.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_init_float_data_set(uintmax_t num_data_points,
+                                      uintmax_t num_dimensions,
+                                      size_t len_data_matrix,
+                                      const float data_matrix[],
+                                      const double rerank_matrix[],
+                                      scc_DataSet** out_data_set);
+
+/** Construct new quantized data set.
+ *
+ *  As #scc_init_data_set, but with the coordinates scalar quantized to 8 bits.
+ *  The coordinate of a point is `scale` times its stored value. Distances between
+ *  quantized points are computed exactly in integer arithmetic.
+ *
+ *  \param[in] num_data_points the number of data points in the data set.
+ *  \param[in] num_dimensions the number of dimensions for each data point.
+ *  \param[in] len_data_matrix the length of #data_matrix.
+ *  \param[in] data_matrix the quantized data, ordered as in #scc_init_data_set.
+ *  \param[in] scale positive scale of the quantization.
+ *  \param[in] rerank_matrix optional double precision copy of the data (or \c NULL).
+ *                           If provided, the final nearest neighbors are re-ranked
+ *                           using exact distances.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note Data sets of signed 8-bit values can be stored by adding 128 to each value.
+ */
+scc_ErrorCode scc_init_quantized_data_set(uintmax_t num_data_points,
+                                          uintmax_t num_dimensions,
+                                          size_t len_data_matrix,
+                                          const uint8_t data_matrix[],
+                                          double scale,
+                                          const double rerank_matrix[],
+                                          scc_DataSet** out_data_set);
+
+/// Enum to specify how the points of a data set mapped from file are accessed.
+enum scc_FileAccessHint {
+
+	/// No particular access pattern.
+	SCC_FA_NORMAL,
+
+	/// Points are mostly accessed in order (e.g., by the default brute-force search).
+	SCC_FA_SEQUENTIAL,
+
+	/// Points are mostly accessed in random order (e.g., by tree or graph searches).
+	SCC_FA_RANDOM,
+
+	/// Read the whole file into memory ahead of use.
+	SCC_FA_WILLNEED,
+
+};
+
+/// Typedef for the scc_FileAccessHint enum
+typedef enum scc_FileAccessHint scc_FileAccessHint;
+
+/** Construct new data set from a file.
+ *
+ *  Memory maps a file with a data matrix and creates a #scc_DataSet based on
+ *  it. The data is read lazily from the file as it is accessed, and several
+ *  processes mapping the same file share the memory. The file must not be
+ *  changed while the data set is in use.
+ *
+ *  The file is either raw or headered. A raw file contains the data matrix of
+ *  doubles, ordered as in #scc_init_data_set, and nothing else. A headered file
+ *  starts with a 64 byte header followed by the data matrix:
+ *
+ *  | Bytes | Content                                                      |
+ *  |-------|--------------------------------------------------------------|
+ *  | 0-7   | The string `"SCCDATA"` (including the terminating null)      |
+ *  | 8-11  | Format version as `uint32_t` (currently 1)                   |
+ *  | 12-15 | Type as `uint32_t`: 0 = double, 1 = float, 2 = quantized uint8 |
+ *  | 16-23 | Number of data points as `uint64_t`                          |
+ *  | 24-31 | Number of dimensions as `uint64_t`                           |
+ *  | 32-39 | Quantization scale as `double` (only used with type 2)       |
+ *  | 40-63 | Unused                                                       |
+ *
+ *  All values are in native byte order. Float and quantized data are handled
+ *  as in #scc_init_float_data_set and #scc_init_quantized_data_set (without
+ *  re-ranking).
+ *
+ *  \param[in] file_path path to the file.
+ *  \param[in] num_data_points the number of data points in the data set. Required for raw
+ *                             files, and must be zero or match the header for headered files.
+ *  \param[in] num_dimensions the number of dimensions for each data point. Required for raw
+ *                            files, and must be zero or match the header for headered files.
+ *  \param[in] access_hint how the data points will be accessed.
+ *  \param[in] huge_pages if \c true, ask the system to back the mapping with huge pages
+ *                        where supported. This is only a hint.
+ *  \param[out] out_data_set double pointer to where to write the data set reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note Returns #SCC_ER_NOT_IMPLEMENTED on platforms without `mmap`.
+ */
+scc_ErrorCode scc_init_data_set_from_file(const char* file_path,
+                                          uintmax_t num_data_points,
+                                          uintmax_t num_dimensions,
+                                          scc_FileAccessHint access_hint,
+                                          bool huge_pages,
+                                          scc_DataSet** out_data_set);
+
 /** Free data set.
  *
  *  Frees a #scc_DataSet previously allocated by #scc_init_data_set.
@@ -311,6 +468,14 @@ enum scc_SeedMethod {
 	 *  seed so that only edges where the tails that still can become seeds are counted.
 	 */
 	SCC_SM_EXCLUSION_UPDATING,
+
+	/** Find seeds as a maximal independent set in the exclusion graph, in parallel rounds.
+	 *
+	 *  In each round, the vertices that precede all their neighbors in the exclusion graph become seeds. Vertices are ordered
+	 *  by inwards pointing arcs from unassigned vertices, as in #SCC_SM_INWARDS_UPDATING, and ties are broken by a hash of the
+	 *  vertex ID. The rounds use the threads set with #scc_set_num_threads, and the seeds do not depend on the number of threads.
+	 */
+	SCC_SM_PARALLEL_MIS,
 };
 
 /// Typedef for the scc_NNGMethod enum
@@ -337,12 +502,16 @@ enum scc_RadiusMethod {
 typedef enum scc_RadiusMethod scc_RadiusMethod;
 
 
+/// Typedef for struct containing distance backends.
+typedef struct scc_DistBackend scc_DistBackend;
+
+
 struct scc_ClusterOptions {
 
 	/** scc_ClusterOptions struct version
 	 *
 	 *  \note
-	 *  This must be set to "722678001".
+	 *  This must be set to "722725001".
 	 */
 	int32_t options_version;
 	uint32_t size_constraint;
@@ -362,6 +531,38 @@ struct scc_ClusterOptions {
 	scc_RadiusMethod secondary_radius;
 	double secondary_supplied_radius;
 	uint32_t batch_size;
+
+	/** Build an approximate NNG using NN-descent instead of exact nearest neighbor searches.
+	 *
+	 *  Useful for very large data sets where the exact NNG is too costly. Cannot be combined with type constraints
+	 *  or #SCC_SM_BATCHES. With a radius constraint, a few points whose true neighbors are within the radius may
+	 *  be treated as unseedable.
+	 */
+	bool approximate_nng;
+
+	/** Fraction of neighbors sampled in each NN-descent iteration (in (0, 1]). Higher values increase recall
+	 *  at the cost of more distance computations.
+	 */
+	double approximate_nng_sample_rate;
+
+	/** NN-descent stops when fewer than `approximate_nng_delta * num_data_points * (size_constraint - 1)`
+	 *  neighbors were improved in an iteration.
+	 */
+	double approximate_nng_delta;
+
+	/** Distance backend used by the clustering (see `scclust_spi.h`).
+	 *
+	 *  If \c NULL, the functions set with `scc_set_dist_functions` are used.
+	 */
+	const scc_DistBackend* dist_backend;
+
+	/** Relabel the NNG in breadth-first order before finding seeds.
+	 *
+	 *  Seed finding visits the neighbors of each vertex, and the relabeling places vertices that are close in the NNG
+	 *  close in memory. This reduces cache misses on large problems. The seeds are those found in the relabeled NNG, so
+	 *  the clustering may differ from the one without relabeling. Cannot be combined with #SCC_SM_BATCHES.
+	 */
+	bool reorder_nng;
 };
 
 typedef struct scc_ClusterOptions scc_ClusterOptions;
@@ -373,11 +574,87 @@ scc_ErrorCode scc_make_clustering(void* data_set,
                                   scc_Clustering* clustering,
                                   const scc_ClusterOptions* options);
 
+/** Make several clusterings that differ only in size constraint.
+ *
+ *  Equivalent to calling #scc_make_clustering once for each clustering in
+ *  #clusterings, with `options->size_constraint` replaced by the
+ *  corresponding element of #size_constraints. When the clusterings do not
+ *  use seed radius constraints, type constraints, approximate NNGs or
+ *  #SCC_SM_BATCHES, and a built-in exact nearest neighbor search is used,
+ *  the nearest neighbor graph is built once for the largest size constraint
+ *  and truncated for the others.
+ *
+ *  \param num_clusterings number of clusterings to make.
+ *  \param[in,out] clusterings empty clusterings with the same number of data points.
+ *  \param[in] size_constraints size constraint of each clustering.
+ *
+ *  \return #scc_ErrorCode describing eventual error. If an error is returned,
+ *          the clusterings may be partially made.
+ */
+scc_ErrorCode scc_make_clusterings(void* data_set,
+                                   size_t num_clusterings,
+                                   scc_Clustering* const clusterings[],
+                                   const uint32_t size_constraints[],
+                                   const scc_ClusterOptions* options);
+
 scc_ErrorCode scc_hierarchical_clustering(void* data_set,
                                           scc_Clustering* clustering,
                                           uint32_t size_constraint,
                                           bool batch_assign);
 
+struct scc_HierarchicalOptions {
+
+	/** scc_HierarchicalOptions struct version
+	 *
+	 *  \note
+	 *  This must be set to "722726001".
+	 */
+	int32_t options_version;
+
+	/** Distance backend used by the clustering (see `scclust_spi.h`).
+	 *
+	 *  If \c NULL, the functions set with `scc_set_dist_functions` are used.
+	 */
+	const scc_DistBackend* dist_backend;
+
+	/** Number of points the search for the centers of each split starts from (at least one).
+	 *
+	 *  A cluster is split around two points that are far apart. The search starts from `center_search_points`
+	 *  points spread over the cluster and finds the farthest point from each. In each following round, the search
+	 *  continues from the farthest points that have not been checked, until no new points are found or
+	 *  `center_search_rounds` rounds have been made. The two points farthest apart are the centers. Each round
+	 *  makes one pass over the cluster per point checked.
+	 *
+	 *  The starting points are evenly spaced in the order the cluster's points are stored, not drawn at random,
+	 *  so the clustering is deterministic and does not depend on the number of threads.
+	 *
+	 *  The default (100 points, no maximum) checks many points on large clusters. A sample with one round
+	 *  (e.g., 10 and 1) bounds the work per split, and a single point with two rounds (1 and 2) is the classic
+	 *  double sweep approximation of the farthest pair.
+	 */
+	uint32_t center_search_points;
+
+	/// Maximum number of center search rounds. If zero, there is no maximum.
+	uint32_t center_search_rounds;
+};
+
+typedef struct scc_HierarchicalOptions scc_HierarchicalOptions;
+
+extern const scc_HierarchicalOptions scc_default_hierarchical_options;
+
+/** Hierarchical clustering with options.
+ *
+ *  #scc_hierarchical_clustering is identical to calling this function with
+ *  #scc_default_hierarchical_options.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_hierarchical_clustering_with_options(void* data_set,
+                                                       scc_Clustering* clustering,
+                                                       uint32_t size_constraint,
+                                                       bool batch_assign,
+                                                       const scc_HierarchicalOptions* options);
+
 
 // =============================================================================
 // Clustering stats function
@@ -0,0 +1,47 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_UT_BITSET_HELPERS_HG
+#define SCC_UT_BITSET_HELPERS_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <src/bitset.h>
+
+
+void scc_ut_bitset_clear(iscc_BitWord* const bitset,
+                         const size_t i)
+{
+	bitset[i / ISCC_BITWORD_BITS] &= ~(((iscc_BitWord) 1) << (i % ISCC_BITWORD_BITS));
+}
+
+
+size_t scc_ut_bitset_count(const iscc_BitWord* const bitset,
+                           const size_t len)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < len; ++i) {
+		if (iscc_bitset_test(bitset, i)) ++count;
+	}
+	return count;
+}
+
+
+#endif // ifndef SCC_UT_BITSET_HELPERS_HG
@@ -0,0 +1,150 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#ifndef SCC_UT_COMPARE_NN_SEARCH_HG
+#define SCC_UT_COMPARE_NN_SEARCH_HG
+
+#include <src/cmocka_headers.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/dist_search_imp.h>
+
+
+void scc_ut_search_nn(const scc_init_nn_search_object init_nn_search_object,
+                      const scc_nearest_neighbor_search nearest_neighbor_search,
+                      const scc_close_nn_search_object close_nn_search_object,
+                      void* const data_set,
+                      const size_t len_search,
+                      const scc_PointIndex search_indices[const],
+                      const size_t len_query,
+                      const scc_PointIndex query_indices[const],
+                      const uint32_t k,
+                      const bool radius_search,
+                      const double radius,
+                      size_t* const out_num_ok,
+                      scc_PointIndex out_query[const],
+                      scc_PointIndex out_nn[const])
+{
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(init_nn_search_object(data_set, len_search, search_indices, &nn_search_object));
+	assert_true(nearest_neighbor_search(nn_search_object, len_query, query_indices, k, radius_search, radius, out_num_ok, out_query, out_nn));
+	assert_true(close_nn_search_object(&nn_search_object));
+	assert_null(nn_search_object);
+}
+
+
+// The search functions must return the same neighbors as the exact search
+void scc_ut_compare_nn_with_imp(const scc_init_nn_search_object init_nn_search_object,
+                                const scc_nearest_neighbor_search nearest_neighbor_search,
+                                const scc_close_nn_search_object close_nn_search_object,
+                                void* const data_set,
+                                const size_t len_search,
+                                const scc_PointIndex search_indices[const],
+                                const size_t len_query,
+                                const scc_PointIndex query_indices[const],
+                                const uint32_t k,
+                                const bool radius_search,
+                                const double radius)
+{
+	scc_PointIndex* const imp_query = malloc(sizeof(scc_PointIndex[len_query]));
+	scc_PointIndex* const test_query = malloc(sizeof(scc_PointIndex[len_query]));
+	scc_PointIndex* const imp_nn = malloc(sizeof(scc_PointIndex[len_query * k]));
+	scc_PointIndex* const test_nn = malloc(sizeof(scc_PointIndex[len_query * k]));
+	size_t imp_num_ok;
+	size_t test_num_ok;
+
+	scc_ut_search_nn(iscc_imp_init_nn_search_object, iscc_imp_nearest_neighbor_search, iscc_imp_close_nn_search_object,
+	                 data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius,
+	                 &imp_num_ok, imp_query, imp_nn);
+	scc_ut_search_nn(init_nn_search_object, nearest_neighbor_search, close_nn_search_object,
+	                 data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius,
+	                 &test_num_ok, test_query, test_nn);
+
+	assert_int_equal(imp_num_ok, test_num_ok);
+	assert_memory_equal(imp_query, test_query, sizeof(scc_PointIndex[imp_num_ok]));
+	assert_memory_equal(imp_nn, test_nn, sizeof(scc_PointIndex[imp_num_ok * k]));
+
+	free(imp_query);
+	free(test_query);
+	free(imp_nn);
+	free(test_nn);
+}
+
+
+// Queries found by approximate search functions must be found by the exact search, with at least `min_recall` of the neighbors
+void scc_ut_compare_nn_recall_with_imp(const scc_init_nn_search_object init_nn_search_object,
+                                       const scc_nearest_neighbor_search nearest_neighbor_search,
+                                       const scc_close_nn_search_object close_nn_search_object,
+                                       void* const data_set,
+                                       const size_t len_search,
+                                       const scc_PointIndex search_indices[const],
+                                       const size_t len_query,
+                                       const scc_PointIndex query_indices[const],
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double radius,
+                                       const double min_recall)
+{
+	scc_PointIndex* const imp_query = malloc(sizeof(scc_PointIndex[len_query]));
+	scc_PointIndex* const test_query = malloc(sizeof(scc_PointIndex[len_query]));
+	scc_PointIndex* const imp_nn = malloc(sizeof(scc_PointIndex[len_query * k]));
+	scc_PointIndex* const test_nn = malloc(sizeof(scc_PointIndex[len_query * k]));
+	size_t imp_num_ok;
+	size_t test_num_ok;
+
+	scc_ut_search_nn(iscc_imp_init_nn_search_object, iscc_imp_nearest_neighbor_search, iscc_imp_close_nn_search_object,
+	                 data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius,
+	                 &imp_num_ok, imp_query, imp_nn);
+	scc_ut_search_nn(init_nn_search_object, nearest_neighbor_search, close_nn_search_object,
+	                 data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius,
+	                 &test_num_ok, test_query, test_nn);
+
+	assert_true(test_num_ok <= imp_num_ok);
+	if (!radius_search) assert_int_equal(test_num_ok, imp_num_ok);
+	assert_true((double) test_num_ok >= min_recall * (double) imp_num_ok);
+
+	size_t found = 0;
+	size_t i = 0;
+	for (size_t t = 0; t < test_num_ok; ++t) {
+		for (; (i < imp_num_ok) && (imp_query[i] != test_query[t]); ++i);
+		assert_true(i < imp_num_ok);
+		for (size_t a = 0; a < k; ++a) {
+			for (size_t b = 0; b < k; ++b) {
+				if (test_nn[t * k + a] == imp_nn[i * k + b]) {
+					++found;
+					break;
+				}
+			}
+		}
+	}
+	assert_true((double) found >= min_recall * (double) (test_num_ok * k));
+
+	free(imp_query);
+	free(test_query);
+	free(imp_nn);
+	free(test_nn);
+}
+
+#endif // SCC_UT_COMPARE_NN_SEARCH_HG
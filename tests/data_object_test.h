@@ -144,14 +144,14 @@ scc_DataSet scc_ut_test_data_large_struct = {
 	.num_data_points = 100,
 	.num_dimensions = 3,
 	.data_matrix = coord1,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722720001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet scc_ut_test_data_small_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 1,
 	.data_matrix = coord2,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722720001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet* const scc_ut_test_data_large = &scc_ut_test_data_large_struct;
@@ -167,14 +167,14 @@ scc_DataSet scc_ut_test_data_invalid1_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 0,
 	.data_matrix = coord2,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722720001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet scc_ut_test_data_invalid2_struct = {
 	.num_data_points = 15,
 	.num_dimensions = 1,
 	.data_matrix = NULL,
-	.data_set_version = 722328001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
+	.data_set_version = 722720001, // ISCC_DATASET_STRUCT_VERSION: gcc error if not set by value
 };
 
 scc_DataSet scc_ut_test_data_invalid3_struct = {
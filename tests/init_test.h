@@ -24,11 +24,27 @@
 
 #include <src/cmocka_headers.h>
 
-#ifdef SCC_UT_ANN
-	#include <ann_wrapper.h>
+#if defined(SCC_UT_ANN) || defined(SCC_UT_KDTREE) || defined(SCC_UT_BALLTREE) || defined(SCC_UT_OPENMP)
+	#include <include/scclust.h>
+	#include <include/scclust_spi.h>
+	#ifdef SCC_UT_ANN
+		#include <ann_wrapper.h>
+	#endif
 
 	static bool scc_ut_init_tests() {
-		return scc_set_ann_dist_search();
+		#ifdef SCC_UT_OPENMP
+			if (scc_set_num_threads(4) != SCC_ER_OK) return false;
+		#endif
+		#ifdef SCC_UT_KDTREE
+			if (!scc_set_kdtree_dist_search()) return false;
+		#endif
+		#ifdef SCC_UT_BALLTREE
+			if (!scc_set_balltree_dist_search()) return false;
+		#endif
+		#ifdef SCC_UT_ANN
+			if (!scc_set_ann_dist_search()) return false;
+		#endif
+		return true;
 	}
 
 #else
@@ -26,6 +26,7 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 
@@ -97,4 +98,37 @@ void scc_rand_double_array(const double min,
 	}
 }
 
+
+// Seed of `scc_rand_coords` used by most tests
+#define SCC_RAND_DEFAULT_SEED 88172645463325252u
+
+
+uint64_t scc_rand_xorshift64(uint64_t* const state)
+{
+	assert(*state != 0);
+
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+
+/* Coordinates in [0, 1000] drawn with a xorshift64 generator, so that the
+ * data are the same on all platforms. The caller frees the array. */
+double* scc_rand_coords(const size_t num_points,
+                        const size_t num_dims,
+                        uint64_t seed)
+{
+	assert(num_points > 0);
+	assert(num_dims > 0);
+
+	double* const coords = malloc(sizeof(double[num_points * num_dims]));
+	assert(coords != NULL);
+	for (size_t i = 0; i < num_points * num_dims; ++i) {
+		coords[i] = (double) (scc_rand_xorshift64(&seed) % 1000003) / 1000.0;
+	}
+	return coords;
+}
+
 #endif
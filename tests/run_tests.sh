@@ -14,6 +14,9 @@ run_test()
 
 STRESS="false"
 ANN="N"
+OPENMP="N"
+KDTREE="N"
+BALLTREE="N"
 KEEP_SCC_BUILD="false"
 
 while [ "$1" != "" ]; do
@@ -22,8 +25,20 @@ while [ "$1" != "" ]; do
 			ANN="Y"
 			printf "${REDCOLOR}Running ANN search tests.${NOCOLOR}\n"
 			;;
+		-b )
+			BALLTREE="Y"
+			printf "${REDCOLOR}Running ball tree search tests.${NOCOLOR}\n"
+			;;
 		-k )
 			KEEP_SCC_BUILD="true" ;;
+		-p )
+			OPENMP="Y"
+			printf "${REDCOLOR}Running OpenMP tests.${NOCOLOR}\n"
+			;;
+		-t )
+			KDTREE="Y"
+			printf "${REDCOLOR}Running kd-tree search tests.${NOCOLOR}\n"
+			;;
 		-s )
 			STRESS="true"
 			printf "${REDCOLOR}Running stress tests.${NOCOLOR}\n"
@@ -40,14 +55,20 @@ make clean
 if [ "$KEEP_SCC_BUILD" = "false" ]; then
 	rm -rf scc_build
 fi
-make all ANN_SEARCH=$ANN
+make all ANN_SEARCH=$ANN OPENMP=$OPENMP KDTREE_SEARCH=$KDTREE BALLTREE_SEARCH=$BALLTREE
 
+run_test test_bitset
 run_test test_data_set
 run_test test_digraph_core
 run_test test_digraph_debug
 run_test test_digraph_operations_internal
 run_test test_digraph_operations
+run_test test_dist_kernels
 run_test test_dist_search
+run_test test_dist_search_abandon
+run_test test_dist_search_balltree
+run_test test_dist_search_hnsw
+run_test test_dist_search_kdtree
 run_test test_error
 run_test test_hierarchical_clustering_internal
 run_test test_hierarchical_clustering
@@ -64,6 +85,7 @@ run_test test_nng_findseeds
 run_test test_scclust
 
 if [ "$STRESS" = "true" ]; then
+	run_test stress_dist_search
 	run_test stress_hierarchical_clustering
 	run_test stress_nng_clustering
 fi
@@ -0,0 +1,240 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <include/scclust.h>
+#include <src/dist_search_abandon.h>
+#include <src/dist_search_imp.h>
+#include <src/dist_search_list.h>
+#include "rand.h"
+
+static const size_t STREAM_LENGTH = 20000;
+static const size_t NUM_ROUNDS = 200;
+static const uint32_t K_VALUES[] = { 2, 4, 8, 16, 24, 32, 64, 128, 256, 512 };
+static const size_t NUM_K_VALUES = sizeof(K_VALUES) / sizeof(K_VALUES[0]);
+static const size_t SEARCH_SAMPLE_SIZE = 5000;
+static const size_t SEARCH_DIMENSION = 8;
+static const size_t ABANDON_DIMENSION = 60;
+
+
+// Selects the `k` smallest distances in `stream` with a sorted list
+static void scc_ut_select_with_list(const size_t len_stream,
+                                    const double stream[const],
+                                    const uint32_t k,
+                                    double out_dists[const],
+                                    scc_PointIndex out_indices[const])
+{
+	double* const dists_end = out_dists + k - 1;
+	scc_PointIndex* const indices_end = out_indices + k - 1;
+	size_t s = 0;
+	for (; s < k; ++s) {
+		iscc_add_dist_to_list(stream[s], (scc_PointIndex) s, out_dists + s, out_indices + s, out_dists);
+	}
+	for (; s < len_stream; ++s) {
+		if (stream[s] >= *dists_end) continue;
+		iscc_add_dist_to_list(stream[s], (scc_PointIndex) s, dists_end, indices_end, out_dists);
+	}
+}
+
+
+// Selects the `k` smallest distances in `stream` with a heap
+static void scc_ut_select_with_heap(const size_t len_stream,
+                                    const double stream[const],
+                                    const uint32_t k,
+                                    double out_dists[const],
+                                    scc_PointIndex out_indices[const])
+{
+	size_t s = 0;
+	for (; s < k; ++s) {
+		iscc_push_dist_heap(stream[s], (scc_PointIndex) s, s, out_dists, out_indices);
+	}
+	for (; s < len_stream; ++s) {
+		if (stream[s] >= out_dists[0]) continue;
+		iscc_replace_dist_heap_top(stream[s], (scc_PointIndex) s, k, out_dists, out_indices);
+	}
+	iscc_sort_dist_heap(k, out_dists, out_indices);
+}
+
+
+/* Compares the sorted list and the heap for `k` from 2 to 512. The timings
+ * are used to set `ISCC_DIST_HEAP_MIN_K`. Distances are rounded to give ties,
+ * which must be ordered the same by both. */
+void scc_ut_stress_dist_heap(void** state)
+{
+	(void) state;
+
+	srand(123456789);
+
+	double* const stream = malloc(sizeof(double[STREAM_LENGTH]));
+	double* const list_dists = malloc(sizeof(double[512]));
+	double* const heap_dists = malloc(sizeof(double[512]));
+	scc_PointIndex* const list_indices = malloc(sizeof(scc_PointIndex[512]));
+	scc_PointIndex* const heap_indices = malloc(sizeof(scc_PointIndex[512]));
+
+	printf("%8s %14s %14s\n", "k", "list (ms)", "heap (ms)");
+	for (size_t i = 0; i < NUM_K_VALUES; ++i) {
+		const uint32_t k = K_VALUES[i];
+		clock_t list_time = 0;
+		clock_t heap_time = 0;
+
+		for (size_t r = 0; r < NUM_ROUNDS; ++r) {
+			for (size_t s = 0; s < STREAM_LENGTH; ++s) {
+				stream[s] = (double) (rand() % 10000);
+			}
+
+			const clock_t list_start = clock();
+			scc_ut_select_with_list(STREAM_LENGTH, stream, k, list_dists, list_indices);
+			list_time += clock() - list_start;
+
+			const clock_t heap_start = clock();
+			scc_ut_select_with_heap(STREAM_LENGTH, stream, k, heap_dists, heap_indices);
+			heap_time += clock() - heap_start;
+
+			assert_memory_equal(list_dists, heap_dists, sizeof(double[k]));
+			assert_memory_equal(list_indices, heap_indices, sizeof(scc_PointIndex[k]));
+		}
+
+		printf("%8u %14.2f %14.2f\n", (unsigned) k,
+		       1000.0 * (double) list_time / CLOCKS_PER_SEC,
+		       1000.0 * (double) heap_time / CLOCKS_PER_SEC);
+	}
+
+	free(stream);
+	free(list_dists);
+	free(heap_dists);
+	free(list_indices);
+	free(heap_indices);
+}
+
+
+// Times the brute force search, which switches to heaps at `ISCC_DIST_HEAP_MIN_K`
+void scc_ut_stress_imp_nn_search(void** state)
+{
+	(void) state;
+
+	srand(987654321);
+
+	double* const data_matrix = malloc(sizeof(double[SEARCH_DIMENSION * SEARCH_SAMPLE_SIZE]));
+	scc_rand_double_array(0, 100, SEARCH_DIMENSION * SEARCH_SAMPLE_SIZE, data_matrix);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SEARCH_SAMPLE_SIZE, SEARCH_DIMENSION, SEARCH_DIMENSION * SEARCH_SAMPLE_SIZE, data_matrix, &data_set), SCC_ER_OK);
+	scc_PointIndex* const nn_indices = malloc(sizeof(scc_PointIndex[512 * SEARCH_SAMPLE_SIZE]));
+
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_imp_init_nn_search_object(data_set, SEARCH_SAMPLE_SIZE, NULL, &nn_search_object));
+
+	printf("%8s %14s\n", "k", "search (ms)");
+	for (size_t i = 0; i < NUM_K_VALUES; ++i) {
+		const uint32_t k = K_VALUES[i];
+		size_t num_ok_queries;
+		const clock_t start = clock();
+		assert_true(iscc_imp_nearest_neighbor_search(nn_search_object, SEARCH_SAMPLE_SIZE, NULL, k,
+		                                             false, 0.0, &num_ok_queries, NULL, nn_indices));
+		const clock_t search_time = clock() - start;
+		assert_int_equal(num_ok_queries, SEARCH_SAMPLE_SIZE);
+		printf("%8u %14.2f\n", (unsigned) k, 1000.0 * (double) search_time / CLOCKS_PER_SEC);
+	}
+
+	assert_true(iscc_imp_close_nn_search_object(&nn_search_object));
+	free(nn_indices);
+	scc_free_data_set(&data_set);
+	free(data_matrix);
+}
+
+
+// Times the early abandoning search against the brute force search on data with unequal dimension scales
+void scc_ut_stress_early_abandon_search(void** state)
+{
+	(void) state;
+
+	srand(192837465);
+
+	const size_t num_values = ABANDON_DIMENSION * SEARCH_SAMPLE_SIZE;
+	double* const data_matrix = malloc(sizeof(double[num_values]));
+	scc_rand_double_array(0, 100, num_values, data_matrix);
+	for (size_t i = 0; i < num_values; ++i) {
+		data_matrix[i] /= (double) (1 + (i * 13) % ABANDON_DIMENSION);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(SEARCH_SAMPLE_SIZE, ABANDON_DIMENSION, num_values, data_matrix, &data_set), SCC_ER_OK);
+	scc_PointIndex* const imp_nn = malloc(sizeof(scc_PointIndex[128 * SEARCH_SAMPLE_SIZE]));
+	scc_PointIndex* const ea_nn = malloc(sizeof(scc_PointIndex[128 * SEARCH_SAMPLE_SIZE]));
+
+	printf("%8s %14s %14s %14s\n", "k", "imp (ms)", "abandon (ms)", "reordered (ms)");
+	const uint32_t k_values[3] = { 4, 16, 128 };
+	for (size_t i = 0; i < 3; ++i) {
+		const uint32_t k = k_values[i];
+		size_t num_ok_queries;
+		clock_t times[3];
+
+		for (size_t method = 0; method < 3; ++method) {
+			iscc_NNSearchObject* nn_search_object;
+			const clock_t start = clock();
+			if (method == 0) {
+				assert_true(iscc_imp_init_nn_search_object(data_set, SEARCH_SAMPLE_SIZE, NULL, &nn_search_object));
+				assert_true(iscc_imp_nearest_neighbor_search(nn_search_object, SEARCH_SAMPLE_SIZE, NULL, k,
+				                                             false, 0.0, &num_ok_queries, NULL, imp_nn));
+				assert_true(iscc_imp_close_nn_search_object(&nn_search_object));
+			} else {
+				if (method == 1) {
+					assert_true(iscc_ea_init_nn_search_object(data_set, SEARCH_SAMPLE_SIZE, NULL, &nn_search_object));
+				} else {
+					assert_true(iscc_ea_init_nn_search_object_reordered(data_set, SEARCH_SAMPLE_SIZE, NULL, &nn_search_object));
+				}
+				assert_true(iscc_ea_nearest_neighbor_search(nn_search_object, SEARCH_SAMPLE_SIZE, NULL, k,
+				                                            false, 0.0, &num_ok_queries, NULL, ea_nn));
+				assert_true(iscc_ea_close_nn_search_object(&nn_search_object));
+				assert_memory_equal(imp_nn, ea_nn, sizeof(scc_PointIndex[k * SEARCH_SAMPLE_SIZE]));
+			}
+			times[method] = clock() - start;
+			assert_int_equal(num_ok_queries, SEARCH_SAMPLE_SIZE);
+		}
+
+		printf("%8u %14.2f %14.2f %14.2f\n", (unsigned) k,
+		       1000.0 * (double) times[0] / CLOCKS_PER_SEC,
+		       1000.0 * (double) times[1] / CLOCKS_PER_SEC,
+		       1000.0 * (double) times[2] / CLOCKS_PER_SEC);
+	}
+
+	free(imp_nn);
+	free(ea_nn);
+	scc_free_data_set(&data_set);
+	free(data_matrix);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_stress_dist_heap),
+		cmocka_unit_test(scc_ut_stress_imp_nn_search),
+		cmocka_unit_test(scc_ut_stress_early_abandon_search),
+	};
+
+	return cmocka_run_group_tests_name("stress dist_search.c", test_cases, NULL, NULL);
+}
@@ -30,7 +30,7 @@ static const size_t SAMPLE_SIZE = 10000;
 static const size_t DATA_DIMENSION = 3;
 static const size_t NUM_ROUNDS = 10;
 
-static const int32_t ISCC_UT_OPTIONS_STRUCT_VERSION = 722678001;
+static const int32_t ISCC_UT_OPTIONS_STRUCT_VERSION = 722725001;
 
 static void iscc_make_batch_options(scc_ClusterOptions* out_options,
                                     uint32_t size_constraint,
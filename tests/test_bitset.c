@@ -0,0 +1,120 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <src/bitset.h>
+#include <src/parallel.h>
+#include "bitset_helpers.h"
+
+
+void scc_ut_bitset_words(void** state)
+{
+	(void) state;
+
+	assert_int_equal(iscc_bitset_words(0), 0);
+	assert_int_equal(iscc_bitset_words(1), 1);
+	assert_int_equal(iscc_bitset_words(64), 1);
+	assert_int_equal(iscc_bitset_words(65), 2);
+	assert_int_equal(iscc_bitset_words(128), 2);
+	assert_int_equal(iscc_bitset_words(129), 3);
+}
+
+
+void scc_ut_bitset_set_clear(void** state)
+{
+	(void) state;
+
+	const size_t len = 200;
+	iscc_BitWord* const bitset = iscc_alloc_bitset(len);
+	assert_non_null(bitset);
+	assert_int_equal(scc_ut_bitset_count(bitset, len), 0);
+
+	for (size_t i = 0; i < len; i += 3) {
+		iscc_bitset_set(bitset, i);
+	}
+	for (size_t i = 0; i < len; ++i) {
+		assert_int_equal(iscc_bitset_test(bitset, i), (i % 3 == 0));
+	}
+	assert_int_equal(scc_ut_bitset_count(bitset, len), 67);
+
+	scc_ut_bitset_clear(bitset, 0);
+	scc_ut_bitset_clear(bitset, 63);
+	scc_ut_bitset_clear(bitset, 64);
+	scc_ut_bitset_clear(bitset, 198);
+	assert_false(iscc_bitset_test(bitset, 0));
+	assert_false(iscc_bitset_test(bitset, 63));
+	assert_false(iscc_bitset_test(bitset, 198));
+	assert_true(iscc_bitset_test(bitset, 66));
+	assert_int_equal(scc_ut_bitset_count(bitset, len), 64);
+
+	assert_false(iscc_bitset_test_and_set(bitset, 63));
+	assert_true(iscc_bitset_test_and_set(bitset, 63));
+	assert_true(iscc_bitset_test_and_set(bitset, 66));
+	assert_false(iscc_bitset_test_and_set(bitset, 199));
+	assert_int_equal(scc_ut_bitset_count(bitset, len), 66);
+
+	free(bitset);
+}
+
+
+void scc_ut_bitset_atomic_set(void** state)
+{
+	(void) state;
+
+	const scc_ErrorCode ec_threads = scc_set_num_threads(4);
+	assert_true((ec_threads == SCC_ER_OK) || (ec_threads == SCC_ER_NOT_IMPLEMENTED));
+
+	// Neighboring bits in the same words are set from different threads
+	const size_t len = 100000;
+	iscc_BitWord* const bitset = iscc_alloc_bitset(len);
+	assert_non_null(bitset);
+
+	ISCC_OMP(parallel for num_threads(iscc_get_num_threads()) schedule(static, 1))
+	for (size_t i = 0; i < len; ++i) {
+		if ((i % 5) != 0) iscc_bitset_atomic_set(bitset, i);
+	}
+
+	assert_int_equal(scc_ut_bitset_count(bitset, len), len - len / 5);
+	for (size_t i = 0; i < len; ++i) {
+		assert_int_equal(iscc_bitset_test(bitset, i), ((i % 5) != 0));
+	}
+
+	free(bitset);
+	scc_set_num_threads(0);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_bitset_words),
+		cmocka_unit_test(scc_ut_bitset_set_clear),
+		cmocka_unit_test(scc_ut_bitset_atomic_set),
+	};
+
+	return cmocka_run_group_tests_name("bitset.h", test_cases, NULL, NULL);
+}
@@ -22,7 +22,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <include/scclust.h>
 #include <src/data_set_struct.h>
 #include <src/scclust_types.h>
@@ -147,6 +149,178 @@ void scc_ut_get_data_set(void** state)
 }
 
 
+void scc_ut_get_low_precision_data_set(void** state)
+{
+	(void) state;
+
+	float coord_f[10] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f };
+	uint8_t coord_q[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	double coord_d[10] = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0 };
+
+	scc_DataSet* dso1;
+	assert_int_equal(scc_init_float_data_set(5, 2, 10, coord_f, NULL, NULL), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_init_float_data_set(0, 2, 10, coord_f, NULL, &dso1), SCC_ER_INVALID_INPUT);
+	assert_null(dso1);
+	assert_int_equal(scc_init_float_data_set(5, 2, 8, coord_f, NULL, &dso1), SCC_ER_INVALID_INPUT);
+	assert_null(dso1);
+	assert_int_equal(scc_init_float_data_set(5, 2, 10, NULL, coord_d, &dso1), SCC_ER_INVALID_INPUT);
+	assert_null(dso1);
+
+	scc_DataSet* dso2;
+	assert_int_equal(scc_init_quantized_data_set(5, 0, 10, coord_q, 0.5, NULL, &dso2), SCC_ER_INVALID_INPUT);
+	assert_null(dso2);
+	assert_int_equal(scc_init_quantized_data_set(5, 2, 10, NULL, 0.5, NULL, &dso2), SCC_ER_INVALID_INPUT);
+	assert_null(dso2);
+	assert_int_equal(scc_init_quantized_data_set(5, 2, 10, coord_q, 0.0, NULL, &dso2), SCC_ER_INVALID_INPUT);
+	assert_null(dso2);
+	assert_int_equal(scc_init_quantized_data_set(5, 2, 10, coord_q, -1.0, NULL, &dso2), SCC_ER_INVALID_INPUT);
+	assert_null(dso2);
+
+	scc_DataSet* dso3;
+	assert_int_equal(scc_init_float_data_set(5, 2, 10, coord_f, NULL, &dso3), SCC_ER_OK);
+	assert_int_equal(dso3->num_data_points, 5);
+	assert_int_equal(dso3->num_dimensions, 2);
+	assert_int_equal(dso3->data_type, ISCC_DT_FLOAT);
+	assert_null(dso3->data_matrix);
+	assert_ptr_equal(dso3->float_matrix, coord_f);
+	assert_null(dso3->rerank_matrix);
+	assert_true(scc_is_initialized_data_set(dso3));
+
+	scc_DataSet* dso4;
+	assert_int_equal(scc_init_quantized_data_set(5, 2, 10, coord_q, 0.5, coord_d, &dso4), SCC_ER_OK);
+	assert_int_equal(dso4->num_data_points, 5);
+	assert_int_equal(dso4->num_dimensions, 2);
+	assert_int_equal(dso4->data_type, ISCC_DT_UINT8);
+	assert_null(dso4->data_matrix);
+	assert_ptr_equal(dso4->uint8_matrix, coord_q);
+	assert_ptr_equal(dso4->rerank_matrix, coord_d);
+	assert_true(scc_is_initialized_data_set(dso4));
+
+	// Data matrix of the wrong type
+	dso4->data_type = ISCC_DT_FLOAT;
+	assert_false(scc_is_initialized_data_set(dso4));
+
+	scc_free_data_set(&dso3);
+	scc_free_data_set(&dso4);
+}
+
+
+static const char* const SCC_UT_DATA_FILE = "test_data_set.dat";
+
+
+static void scc_ut_write_data_file(const void* const header,
+                                   const size_t header_size,
+                                   const void* const data,
+                                   const size_t data_size)
+{
+	FILE* const data_file = fopen(SCC_UT_DATA_FILE, "wb");
+	assert_non_null(data_file);
+	if (header_size > 0) assert_int_equal(fwrite(header, 1, header_size, data_file), header_size);
+	if (data_size > 0) assert_int_equal(fwrite(data, 1, data_size, data_file), data_size);
+	assert_int_equal(fclose(data_file), 0);
+}
+
+
+static void scc_ut_make_data_file_header(unsigned char header[static 64],
+                                         const uint32_t data_type,
+                                         const uint64_t num_data_points,
+                                         const uint64_t num_dimensions,
+                                         const double scale)
+{
+	const uint32_t format_version = 1;
+	memset(header, 0, 64);
+	memcpy(header, "SCCDATA", 8);
+	memcpy(header + 8, &format_version, 4);
+	memcpy(header + 12, &data_type, 4);
+	memcpy(header + 16, &num_data_points, 8);
+	memcpy(header + 24, &num_dimensions, 8);
+	memcpy(header + 32, &scale, 8);
+}
+
+
+void scc_ut_get_data_set_from_file(void** state)
+{
+	(void) state;
+
+	double coord[10] = { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0 };
+	float coord_f[10] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f };
+	uint8_t coord_q[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	unsigned char header[64];
+	scc_DataSet* dso;
+
+	remove(SCC_UT_DATA_FILE);
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 5, 2, SCC_FA_NORMAL, false, NULL), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_init_data_set_from_file(NULL, 5, 2, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 5, 2, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+
+	// Raw file
+	scc_ut_write_data_file(NULL, 0, coord, sizeof(coord));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 0, 2, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 6, 2, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 5, 2, (scc_FileAccessHint) 99, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 5, 2, SCC_FA_SEQUENTIAL, true, &dso), SCC_ER_OK);
+	assert_non_null(dso);
+	assert_int_equal(dso->num_data_points, 5);
+	assert_int_equal(dso->num_dimensions, 2);
+	assert_int_equal(dso->data_type, ISCC_DT_DOUBLE);
+	assert_non_null(dso->file_map);
+	assert_memory_equal(dso->data_matrix, coord, sizeof(coord));
+	assert_true(scc_is_initialized_data_set(dso));
+	scc_free_data_set(&dso);
+	assert_null(dso);
+
+	// Headered files
+	scc_ut_make_data_file_header(header, 0, 5, 2, 0.0);
+	scc_ut_write_data_file(header, 64, coord, sizeof(coord));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 4, 0, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 0, 0, SCC_FA_RANDOM, false, &dso), SCC_ER_OK);
+	assert_int_equal(dso->num_data_points, 5);
+	assert_int_equal(dso->num_dimensions, 2);
+	assert_int_equal(dso->data_type, ISCC_DT_DOUBLE);
+	assert_memory_equal(dso->data_matrix, coord, sizeof(coord));
+	scc_free_data_set(&dso);
+
+	scc_ut_make_data_file_header(header, 1, 5, 2, 0.0);
+	scc_ut_write_data_file(header, 64, coord_f, sizeof(coord_f));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 5, 2, SCC_FA_WILLNEED, false, &dso), SCC_ER_OK);
+	assert_int_equal(dso->data_type, ISCC_DT_FLOAT);
+	assert_null(dso->data_matrix);
+	assert_memory_equal(dso->float_matrix, coord_f, sizeof(coord_f));
+	assert_true(scc_is_initialized_data_set(dso));
+	scc_free_data_set(&dso);
+
+	scc_ut_make_data_file_header(header, 2, 5, 2, 0.5);
+	scc_ut_write_data_file(header, 64, coord_q, sizeof(coord_q));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 0, 0, SCC_FA_NORMAL, false, &dso), SCC_ER_OK);
+	assert_int_equal(dso->data_type, ISCC_DT_UINT8);
+	assert_memory_equal(dso->uint8_matrix, coord_q, sizeof(coord_q));
+	assert_true(dso->uint8_scale > 0.49 && dso->uint8_scale < 0.51);
+	scc_free_data_set(&dso);
+
+	// Truncated data, unknown type and zero scale
+	scc_ut_make_data_file_header(header, 0, 5, 2, 0.0);
+	scc_ut_write_data_file(header, 64, coord, sizeof(double[9]));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 0, 0, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	scc_ut_make_data_file_header(header, 3, 5, 2, 0.0);
+	scc_ut_write_data_file(header, 64, coord, sizeof(coord));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 0, 0, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+	scc_ut_make_data_file_header(header, 2, 5, 2, 0.0);
+	scc_ut_write_data_file(header, 64, coord_q, sizeof(coord_q));
+	assert_int_equal(scc_init_data_set_from_file(SCC_UT_DATA_FILE, 0, 0, SCC_FA_NORMAL, false, &dso), SCC_ER_INVALID_INPUT);
+	assert_null(dso);
+
+	assert_int_equal(remove(SCC_UT_DATA_FILE), 0);
+}
+
+
 void scc_ut_is_initialized_data_set(void** state)
 {
 	(void) state;
@@ -168,6 +342,8 @@ int main(void)
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_free_data_set),
 		cmocka_unit_test(scc_ut_get_data_set),
+		cmocka_unit_test(scc_ut_get_low_precision_data_set),
+		cmocka_unit_test(scc_ut_get_data_set_from_file),
 		cmocka_unit_test(scc_ut_is_initialized_data_set),
 	};
 
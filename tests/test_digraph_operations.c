@@ -22,6 +22,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <src/digraph_core.h>
 #include <src/digraph_debug.h>
 #include <src/digraph_operations.h>
@@ -1262,6 +1263,71 @@ void scc_ut_adjacency_product(void** state)
 }
 
 
+void scc_ut_digraph_bfs_order(void** state)
+{
+	(void) state;
+
+	iscc_Digraph ut_dg;
+	iscc_digraph_from_string("..#.../...#../#...../.....#/..#.../...#../", &ut_dg);
+
+	scc_PointIndex order[6];
+	const scc_PointIndex control_order[6] = { 0, 2, 4, 1, 3, 5 };
+	scc_ErrorCode ec = iscc_digraph_bfs_order(&ut_dg, order);
+	assert_int_equal(ec, SCC_ER_OK);
+	assert_memory_equal(order, control_order, sizeof(scc_PointIndex[6]));
+
+	iscc_Digraph ut_empty;
+	iscc_empty_digraph(4, 0, &ut_empty);
+	const scc_PointIndex control_empty_order[4] = { 0, 1, 2, 3 };
+	ec = iscc_digraph_bfs_order(&ut_empty, order);
+	assert_int_equal(ec, SCC_ER_OK);
+	assert_memory_equal(order, control_empty_order, sizeof(scc_PointIndex[4]));
+
+	iscc_free_digraph(&ut_dg);
+	iscc_free_digraph(&ut_empty);
+}
+
+
+void scc_ut_permute_digraph(void** state)
+{
+	(void) state;
+
+	iscc_Digraph ut_dg;
+	iscc_digraph_from_string("..#.../...#../#...../.....#/..#.../...#../", &ut_dg);
+	iscc_Digraph control;
+	iscc_digraph_from_string(".#..../#...../.#..../....#./.....#/....#./", &control);
+
+	const scc_PointIndex order[6] = { 0, 2, 4, 1, 3, 5 };
+	iscc_Digraph res;
+	scc_ErrorCode ec = iscc_permute_digraph(&ut_dg, order, &res);
+	assert_int_equal(ec, SCC_ER_OK);
+	assert_valid_digraph(&res, 6);
+	assert_equal_digraph(&res, &control);
+
+	// Arcs keep their order within rows
+	iscc_Digraph ut_dg2;
+	iscc_init_digraph(3, 4, &ut_dg2);
+	const iscc_ArcIndex tail_ptr2[4] = { 0, 2, 3, 4 };
+	const scc_PointIndex head2[4] = { 2, 1, 0, 1 };
+	memcpy(ut_dg2.tail_ptr, tail_ptr2, sizeof(iscc_ArcIndex[4]));
+	memcpy(ut_dg2.head, head2, sizeof(scc_PointIndex[4]));
+	const scc_PointIndex order2[3] = { 2, 0, 1 };
+	iscc_Digraph res2;
+	ec = iscc_permute_digraph(&ut_dg2, order2, &res2);
+	assert_int_equal(ec, SCC_ER_OK);
+	const iscc_ArcIndex control_tail_ptr2[4] = { 0, 1, 3, 4 };
+	const scc_PointIndex control_head2[4] = { 2, 0, 2, 1 };
+	assert_memory_equal(res2.tail_ptr, control_tail_ptr2, sizeof(iscc_ArcIndex[4]));
+	assert_memory_equal(res2.head, control_head2, sizeof(scc_PointIndex[4]));
+
+	iscc_free_digraph(&ut_dg);
+	iscc_free_digraph(&control);
+	iscc_free_digraph(&res);
+	iscc_free_digraph(&ut_dg2);
+	iscc_free_digraph(&res2);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
@@ -1277,6 +1343,8 @@ int main(void)
 		cmocka_unit_test(scc_ut_digraph_difference),
 		cmocka_unit_test(scc_ut_digraph_transpose),
 		cmocka_unit_test(scc_ut_adjacency_product),
+		cmocka_unit_test(scc_ut_digraph_bfs_order),
+		cmocka_unit_test(scc_ut_permute_digraph),
 	};
 
 	return cmocka_run_group_tests_name("digraph_operations.c", test_cases, NULL, NULL);
@@ -0,0 +1,131 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <src/dist_kernels.h>
+#include "double_assert.h"
+
+
+static void scc_ut_fill_vectors(const size_t len,
+                                double vec1[const],
+                                double vec2[const])
+{
+	for (size_t i = 0; i < len; ++i) {
+		vec1[i] = (double) ((i * 37 + 11) % 101) - 50.123;
+		vec2[i] = (double) ((i * 53 + 7) % 97) * 0.731;
+	}
+}
+
+
+void scc_ut_get_sq_dist_kernel(void** state)
+{
+	(void) state;
+
+	const iscc_SqDistKernel kernel = iscc_get_sq_dist_kernel();
+	assert_non_null(kernel);
+	assert_true(kernel == iscc_get_sq_dist_kernel_by_type(iscc_get_sq_dist_kernel_type()));
+	assert_true(iscc_get_sq_dist_kernel_by_type(ISCC_SDK_SCALAR) == iscc_sq_dist_scalar);
+}
+
+
+void scc_ut_sq_dist_scalar(void** state)
+{
+	(void) state;
+
+	const double vec1[3] = { 1.0, 2.0, 3.0 };
+	const double vec2[3] = { 4.0, 0.0, 3.5 };
+
+	assert_double_equal(iscc_sq_dist_scalar(vec1, vec2, 0), 0.0);
+	assert_double_equal(iscc_sq_dist_scalar(vec1, vec2, 1), 9.0);
+	assert_double_equal(iscc_sq_dist_scalar(vec1, vec2, 3), 13.25);
+	assert_double_equal(iscc_sq_dist_scalar(vec1, vec1, 3), 0.0);
+}
+
+
+void scc_ut_sq_dist_kernels(void** state)
+{
+	(void) state;
+
+	const iscc_SqDistKernelType kernel_types[3] = { ISCC_SDK_SSE2, ISCC_SDK_AVX2, ISCC_SDK_AVX512 };
+	double vec1[67];
+	double vec2[67];
+
+	for (size_t t = 0; t < 3; ++t) {
+		const iscc_SqDistKernel kernel = iscc_get_sq_dist_kernel_by_type(kernel_types[t]);
+		if (kernel == NULL) continue;
+
+		// Every tail length, and unaligned starting points
+		for (size_t len = 0; len <= 64; ++len) {
+			scc_ut_fill_vectors(len + 3, vec1, vec2);
+			for (size_t offset = 0; offset < 3; ++offset) {
+				const double ref = iscc_sq_dist_scalar(vec1 + offset, vec2 + offset, len);
+				const double res = kernel(vec1 + offset, vec2 + offset, len);
+				assert_true(fabs(ref - res) <= 1e-12 * ref + 1e-12);
+				assert_double_equal(kernel(vec1 + offset, vec1 + offset, len), 0.0);
+			}
+		}
+	}
+}
+
+
+void scc_ut_sq_dist_early_abandon(void** state)
+{
+	(void) state;
+
+	const iscc_SqDistKernel kernel = iscc_get_sq_dist_kernel();
+	double vec1[64];
+	double vec2[64];
+
+	for (size_t len = 0; len <= 64; ++len) {
+		scc_ut_fill_vectors(len, vec1, vec2);
+		const double ref = iscc_sq_dist_scalar(vec1, vec2, len);
+
+		// Not abandoned
+		const double full = iscc_sq_dist_early_abandon(kernel, vec1, vec2, len, HUGE_VAL);
+		assert_true(fabs(ref - full) <= 1e-12 * ref + 1e-12);
+		assert_double_equal(iscc_sq_dist_early_abandon(kernel, vec1, vec2, len, full), full);
+		assert_double_equal(iscc_sq_dist_early_abandon(kernel, vec1, vec1, len, 0.0), 0.0);
+
+		// Abandoned with a partial sum above the bound
+		const double bound = 0.25 * full;
+		const double partial = iscc_sq_dist_early_abandon(kernel, vec1, vec2, len, bound);
+		assert_true(partial > bound || len == 0);
+		assert_true(partial <= full);
+		if (len >= 2 * ISCC_EARLY_ABANDON_BLOCK) assert_true(partial < full);
+	}
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_get_sq_dist_kernel),
+		cmocka_unit_test(scc_ut_sq_dist_scalar),
+		cmocka_unit_test(scc_ut_sq_dist_kernels),
+		cmocka_unit_test(scc_ut_sq_dist_early_abandon),
+	};
+
+	return cmocka_run_group_tests_name("dist_kernels.c", test_cases, NULL, NULL);
+}
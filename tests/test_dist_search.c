@@ -19,9 +19,16 @@
  * ========================================================================== */
 
 #include "init_test.h"
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <src/dist_kernels.h>
 #include <src/dist_search.h>
+#include <src/dist_search_imp.h>
+#include <src/dist_search_kdtree.h>
+#include <src/dist_search_list.h>
 #include <src/scclust_types.h>
 #include "data_object_test.h"
 #include "double_assert.h"
@@ -391,6 +398,64 @@ void scc_ut_get_dist_rows(void** state)
 }
 
 
+void scc_ut_get_dist_tiles(void** state)
+{
+	(void) state;
+
+	// Large enough to span several tiles in both directions
+	const size_t num_points = 300;
+	const size_t num_dims = 5;
+	double* const coords = malloc(sizeof(double[num_points * num_dims]));
+	for (size_t i = 0; i < num_points * num_dims; ++i) {
+		coords[i] = (double) ((i * 7919) % 1009) / 10.0;
+	}
+	// Duplicate point
+	for (size_t k = 0; k < num_dims; ++k) {
+		coords[250 * num_dims + k] = coords[3 * num_dims + k];
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex indices[299];
+	for (size_t i = 0; i < 299; ++i) {
+		indices[i] = (scc_PointIndex) (298 - i);
+	}
+
+	double* const output = malloc(sizeof(double[num_points * num_points]));
+
+	assert_true(iscc_get_dist_rows(data_set, num_points, NULL, num_points, NULL, output));
+	for (size_t q = 0; q < num_points; ++q) {
+		for (size_t c = 0; c < num_points; ++c) {
+			const double ref = sqrt(iscc_sq_dist_scalar(coords + q * num_dims, coords + c * num_dims, num_dims));
+			assert_double_equal(output[q * num_points + c], ref);
+		}
+	}
+	assert_double_equal(output[3 * num_points + 250], 0.0);
+
+	assert_true(iscc_get_dist_rows(data_set, 299, indices, 131, NULL, output));
+	for (size_t q = 0; q < 299; ++q) {
+		for (size_t c = 0; c < 131; ++c) {
+			const double ref = sqrt(iscc_sq_dist_scalar(coords + (size_t) indices[q] * num_dims, coords + c * num_dims, num_dims));
+			assert_double_equal(output[q * 131 + c], ref);
+		}
+	}
+
+	assert_true(iscc_get_dist_matrix(data_set, 299, indices, output));
+	const double* out_pos = output;
+	for (size_t p1 = 0; p1 < 299; ++p1) {
+		for (size_t p2 = p1 + 1; p2 < 299; ++p2) {
+			const double ref = sqrt(iscc_sq_dist_scalar(coords + (size_t) indices[p1] * num_dims, coords + (size_t) indices[p2] * num_dims, num_dims));
+			assert_double_equal(*out_pos, ref);
+			++out_pos;
+		}
+	}
+
+	free(output);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
 void scc_ut_init_close_max_dist_object(void** state)
 {
 	(void) state;
@@ -697,6 +762,76 @@ void scc_ut_get_max_dist(void** state)
 }
 
 
+void scc_ut_get_max_dist_boxed(void** state)
+{
+	(void) state;
+
+	// Integer coordinates give exact distances with many ties
+	const size_t num_points = 2000;
+	const size_t num_dims = 3;
+	double* const coords = malloc(sizeof(double[num_points * num_dims]));
+	for (size_t i = 0; i < num_points; ++i) {
+		coords[3 * i] = (double) ((i * 7) % 23);
+		coords[3 * i + 1] = (double) ((i * 13) % 17);
+		coords[3 * i + 2] = (double) ((i * 31) % 5);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	// Search points in no particular order, large enough to be boxed
+	const size_t len_search = 1200;
+	scc_PointIndex* const search = malloc(sizeof(scc_PointIndex[len_search]));
+	for (size_t s = 0; s < len_search; ++s) {
+		search[s] = (scc_PointIndex) ((s * 37 + 11) % num_points);
+	}
+	// Enough queries to be searched in parallel
+	scc_PointIndex query[300];
+	for (size_t q = 0; q < 300; ++q) {
+		query[q] = (scc_PointIndex) ((q * 97 + 3) % num_points);
+	}
+
+	const scc_ErrorCode ec = scc_set_num_threads(4);
+	assert_true((ec == SCC_ER_OK) || (ec == SCC_ER_NOT_IMPLEMENTED));
+
+	scc_PointIndex out_ids[300];
+	double out_dists[300];
+	for (int with_indices = 0; with_indices <= 1; ++with_indices) {
+		const scc_PointIndex* const search_indices = (with_indices == 1) ? search : NULL;
+		const size_t len_search_indices = (with_indices == 1) ? len_search : num_points;
+		iscc_MaxDistObject* max_dist_object;
+		assert_true(iscc_imp_init_max_dist_object(data_set, len_search_indices, search_indices, &max_dist_object));
+		assert_true(iscc_imp_get_max_dist(max_dist_object, 300, query, out_ids, out_dists));
+		assert_true(iscc_imp_close_max_dist_object(&max_dist_object));
+
+		// The first farthest point in search order
+		for (size_t q = 0; q < 300; ++q) {
+			double ref_dist = -1.0;
+			scc_PointIndex ref_id = 0;
+			for (size_t s = 0; s < len_search_indices; ++s) {
+				const size_t point = (search_indices == NULL) ? s : (size_t) search_indices[s];
+				double dist = 0.0;
+				for (size_t d = 0; d < num_dims; ++d) {
+					const double diff = coords[(size_t) query[q] * num_dims + d] - coords[point * num_dims + d];
+					dist += diff * diff;
+				}
+				if (ref_dist < dist) {
+					ref_dist = dist;
+					ref_id = (scc_PointIndex) point;
+				}
+			}
+			assert_int_equal(out_ids[q], ref_id);
+			assert_double_equal(out_dists[q], sqrt(ref_dist));
+		}
+	}
+
+	assert_int_equal(scc_set_num_threads(0), SCC_ER_OK);
+
+	free(search);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
 void scc_ut_init_close_nn_search_object(void** state)
 {
 	(void) state;
@@ -1254,6 +1389,253 @@ void scc_ut_nearest_neighbor_search_radius(void** state)
 }
 
 
+void scc_ut_nearest_neighbor_search_threads(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 1000;
+	double* const coords = malloc(sizeof(double[num_points * 2]));
+	for (size_t i = 0; i < num_points * 2; ++i) {
+		coords[i] = (double) ((i * i * 7919 + i * 31) % 10007) / 100.0;
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, 2, num_points * 2, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const out_query1 = malloc(sizeof(scc_PointIndex[num_points]));
+	scc_PointIndex* const out_query4 = malloc(sizeof(scc_PointIndex[num_points]));
+	scc_PointIndex* const out_nn1 = malloc(sizeof(scc_PointIndex[num_points * 3]));
+	scc_PointIndex* const out_nn4 = malloc(sizeof(scc_PointIndex[num_points * 3]));
+	size_t num_ok1;
+	size_t num_ok4;
+
+	// Radius search drops some queries in all chunks
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, num_points, NULL, &nn_search_object));
+
+	assert_int_equal(scc_set_num_threads(1), SCC_ER_OK);
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, num_points, NULL, 3, true, 3.0, &num_ok1, out_query1, out_nn1));
+
+	const scc_ErrorCode ec = scc_set_num_threads(4);
+	assert_true((ec == SCC_ER_OK) || (ec == SCC_ER_NOT_IMPLEMENTED));
+	assert_true(iscc_nearest_neighbor_search(nn_search_object, num_points, NULL, 3, true, 3.0, &num_ok4, out_query4, out_nn4));
+
+	assert_true(num_ok1 > 0);
+	assert_true(num_ok1 < num_points);
+	assert_int_equal(num_ok1, num_ok4);
+	assert_memory_equal(out_query1, out_query4, sizeof(scc_PointIndex[num_ok1]));
+	assert_memory_equal(out_nn1, out_nn4, sizeof(scc_PointIndex[num_ok1 * 3]));
+
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+	assert_int_equal(scc_set_num_threads(0), SCC_ER_OK);
+
+	free(out_query1);
+	free(out_query4);
+	free(out_nn1);
+	free(out_nn4);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+void scc_ut_nearest_neighbor_search_heap(void** state)
+{
+	(void) state;
+
+	// Integer coordinates give exact distances with many ties
+	const size_t num_points = 300;
+	const uint32_t k = ISCC_DIST_HEAP_MIN_K + 6;
+	double coords[600];
+	for (size_t i = 0; i < num_points; ++i) {
+		coords[2 * i] = (double) ((i * 7) % 11);
+		coords[2 * i + 1] = (double) ((i * 13) % 5);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, 2, 600, coords, &data_set), SCC_ER_OK);
+
+	// Search points in no particular order
+	scc_PointIndex search[200];
+	for (size_t s = 0; s < 200; ++s) {
+		search[s] = (scc_PointIndex) ((s * 37 + 11) % num_points);
+	}
+
+	scc_PointIndex* const out_query = malloc(sizeof(scc_PointIndex[num_points]));
+	scc_PointIndex* const out_nn = malloc(sizeof(scc_PointIndex[num_points * k]));
+	double ref_dists[ISCC_DIST_HEAP_MIN_K + 6];
+	scc_PointIndex ref_nn[ISCC_DIST_HEAP_MIN_K + 6];
+
+	for (int radius_search = 0; radius_search <= 1; ++radius_search) {
+		const double radius = 3.0;
+		iscc_NNSearchObject* nn_search_object;
+		size_t num_ok;
+		assert_true(iscc_imp_init_nn_search_object(data_set, 200, search, &nn_search_object));
+		assert_true(iscc_imp_nearest_neighbor_search(nn_search_object, num_points, NULL, k, (radius_search == 1), radius,
+		                                             &num_ok, out_query, out_nn));
+		assert_true(iscc_imp_close_nn_search_object(&nn_search_object));
+
+		// Sorted lists give the reference
+		size_t ref_num_ok = 0;
+		for (size_t q = 0; q < num_points; ++q) {
+			for (size_t s = 0; s < 200; ++s) {
+				const double dx = coords[2 * q] - coords[2 * search[s]];
+				const double dy = coords[2 * q + 1] - coords[2 * search[s] + 1];
+				const double dist = dx * dx + dy * dy;
+				if (s < k) {
+					iscc_add_dist_to_list(dist, search[s], ref_dists + s, ref_nn + s, ref_dists);
+				} else if (dist < ref_dists[k - 1]) {
+					iscc_add_dist_to_list(dist, search[s], ref_dists + k - 1, ref_nn + k - 1, ref_dists);
+				}
+			}
+			if ((radius_search == 1) && (ref_dists[k - 1] > radius * radius)) continue;
+			assert_true(ref_num_ok < num_ok);
+			if (radius_search == 1) assert_int_equal(out_query[ref_num_ok], q);
+			assert_memory_equal(out_nn + ref_num_ok * k, ref_nn, sizeof(scc_PointIndex[k]));
+			++ref_num_ok;
+		}
+		assert_int_equal(num_ok, ref_num_ok);
+		if (radius_search == 1) assert_true((num_ok > 0) && (num_ok < num_points));
+	}
+
+	free(out_query);
+	free(out_nn);
+	scc_free_data_set(&data_set);
+}
+
+
+static void scc_ut_imp_nn_search(scc_DataSet* const data_set,
+                                 const size_t num_points,
+                                 const uint32_t k,
+                                 const bool radius_search,
+                                 const double radius,
+                                 size_t* const out_num_ok,
+                                 scc_PointIndex out_query[const],
+                                 scc_PointIndex out_nn[const])
+{
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_imp_init_nn_search_object(data_set, num_points, NULL, &nn_search_object));
+	assert_true(iscc_imp_nearest_neighbor_search(nn_search_object, num_points, NULL, k, radius_search, radius, out_num_ok, out_query, out_nn));
+	assert_true(iscc_imp_close_nn_search_object(&nn_search_object));
+}
+
+
+void scc_ut_low_precision_data_sets(void** state)
+{
+	(void) state;
+
+	// Multiples of 1/4 below 64 are exact in all storage types
+	const size_t num_points = 400;
+	const size_t num_dims = 6;
+	const uint32_t k = 5;
+	double* const coords = malloc(sizeof(double[num_points * num_dims]));
+	float* const coords_f = malloc(sizeof(float[num_points * num_dims]));
+	uint8_t* const coords_q = malloc(sizeof(uint8_t[num_points * num_dims]));
+	for (size_t i = 0; i < num_points * num_dims; ++i) {
+		coords_q[i] = (uint8_t) ((i * i * 7919 + i * 31) % 256);
+		coords[i] = 0.25 * (double) coords_q[i];
+		coords_f[i] = (float) coords[i];
+	}
+
+	scc_DataSet* data_sets[4];
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_sets[0]), SCC_ER_OK);
+	assert_int_equal(scc_init_float_data_set(num_points, num_dims, num_points * num_dims, coords_f, NULL, &data_sets[1]), SCC_ER_OK);
+	assert_int_equal(scc_init_quantized_data_set(num_points, num_dims, num_points * num_dims, coords_q, 0.25, NULL, &data_sets[2]), SCC_ER_OK);
+	assert_int_equal(scc_init_quantized_data_set(num_points, num_dims, num_points * num_dims, coords_q, 0.25, coords, &data_sets[3]), SCC_ER_OK);
+
+	scc_PointIndex indices[150];
+	for (size_t i = 0; i < 150; ++i) {
+		indices[i] = (scc_PointIndex) (2 * i + 7);
+	}
+
+	double* const ref_dists = malloc(sizeof(double[num_points * num_points]));
+	double* const dists = malloc(sizeof(double[num_points * num_points]));
+	scc_PointIndex* const ref_query = malloc(sizeof(scc_PointIndex[num_points]));
+	scc_PointIndex* const out_query = malloc(sizeof(scc_PointIndex[num_points]));
+	scc_PointIndex* const ref_nn = malloc(sizeof(scc_PointIndex[num_points * k]));
+	scc_PointIndex* const out_nn = malloc(sizeof(scc_PointIndex[num_points * k]));
+	scc_PointIndex ref_max_indices[150];
+	scc_PointIndex max_indices[150];
+	double ref_max_dists[150];
+	double max_dists[150];
+	size_t ref_num_ok;
+	size_t num_ok;
+
+	iscc_MaxDistObject* max_dist_object;
+	assert_true(iscc_imp_init_max_dist_object(data_sets[0], num_points, NULL, &max_dist_object));
+	assert_true(iscc_imp_get_max_dist(max_dist_object, 150, indices, ref_max_indices, ref_max_dists));
+	assert_true(iscc_imp_close_max_dist_object(&max_dist_object));
+
+	for (size_t d = 1; d < 4; ++d) {
+		assert_true(iscc_imp_check_data_set(data_sets[d], num_points));
+
+		assert_true(iscc_imp_get_dist_rows(data_sets[0], 150, indices, num_points, NULL, ref_dists));
+		assert_true(iscc_imp_get_dist_rows(data_sets[d], 150, indices, num_points, NULL, dists));
+		for (size_t i = 0; i < 150 * num_points; ++i) {
+			assert_double_equal(dists[i], ref_dists[i]);
+		}
+
+		assert_true(iscc_imp_get_dist_matrix(data_sets[0], 150, indices, ref_dists));
+		assert_true(iscc_imp_get_dist_matrix(data_sets[d], 150, indices, dists));
+		for (size_t i = 0; i < (149 * 150) / 2; ++i) {
+			assert_double_equal(dists[i], ref_dists[i]);
+		}
+
+		assert_true(iscc_imp_init_max_dist_object(data_sets[d], num_points, NULL, &max_dist_object));
+		assert_true(iscc_imp_get_max_dist(max_dist_object, 150, indices, max_indices, max_dists));
+		assert_true(iscc_imp_close_max_dist_object(&max_dist_object));
+		assert_memory_equal(max_indices, ref_max_indices, sizeof(ref_max_indices));
+		for (size_t i = 0; i < 150; ++i) {
+			assert_double_equal(max_dists[i], ref_max_dists[i]);
+		}
+
+		scc_ut_imp_nn_search(data_sets[0], num_points, k, false, 0.0, &ref_num_ok, ref_query, ref_nn);
+		scc_ut_imp_nn_search(data_sets[d], num_points, k, false, 0.0, &num_ok, out_query, out_nn);
+		assert_int_equal(num_ok, ref_num_ok);
+		assert_memory_equal(out_nn, ref_nn, sizeof(scc_PointIndex[num_ok * k]));
+
+		scc_ut_imp_nn_search(data_sets[0], num_points, k, true, 20.0, &ref_num_ok, ref_query, ref_nn);
+		scc_ut_imp_nn_search(data_sets[d], num_points, k, true, 20.0, &num_ok, out_query, out_nn);
+		assert_true(ref_num_ok > 0);
+		assert_true(ref_num_ok < num_points);
+		assert_int_equal(num_ok, ref_num_ok);
+		assert_memory_equal(out_query, ref_query, sizeof(scc_PointIndex[num_ok]));
+		assert_memory_equal(out_nn, ref_nn, sizeof(scc_PointIndex[num_ok * k]));
+	}
+
+	// Coarse quantization is corrected by the re-ranking
+	double* const fine_coords = malloc(sizeof(double[num_points * num_dims]));
+	for (size_t i = 0; i < num_points * num_dims; ++i) {
+		fine_coords[i] = coords[i] + (double) ((i * 104729) % 1000) / 4000.0;
+	}
+	scc_DataSet* fine_data_set;
+	scc_DataSet* rerank_data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, fine_coords, &fine_data_set), SCC_ER_OK);
+	assert_int_equal(scc_init_quantized_data_set(num_points, num_dims, num_points * num_dims, coords_q, 0.25, fine_coords, &rerank_data_set), SCC_ER_OK);
+	scc_ut_imp_nn_search(fine_data_set, num_points, k, false, 0.0, &ref_num_ok, ref_query, ref_nn);
+	scc_ut_imp_nn_search(rerank_data_set, num_points, k, false, 0.0, &num_ok, out_query, out_nn);
+	assert_int_equal(num_ok, ref_num_ok);
+	assert_memory_equal(out_nn, ref_nn, sizeof(scc_PointIndex[num_ok * k]));
+
+	// Tree searches need double precision coordinates
+	iscc_NNSearchObject* nn_search_object;
+	assert_false(iscc_kdt_init_nn_search_object(data_sets[1], num_points, NULL, &nn_search_object));
+
+	for (size_t d = 0; d < 4; ++d) {
+		scc_free_data_set(&data_sets[d]);
+	}
+	scc_free_data_set(&fine_data_set);
+	scc_free_data_set(&rerank_data_set);
+	free(fine_coords);
+	free(ref_dists);
+	free(dists);
+	free(ref_query);
+	free(out_query);
+	free(ref_nn);
+	free(out_nn);
+	free(coords);
+	free(coords_f);
+	free(coords_q);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
@@ -1262,11 +1644,16 @@ int main(void)
 		cmocka_unit_test(scc_ut_check_data_set),
 		cmocka_unit_test(scc_ut_get_dist_matrix),
 		cmocka_unit_test(scc_ut_get_dist_rows),
+		cmocka_unit_test(scc_ut_get_dist_tiles),
 		cmocka_unit_test(scc_ut_init_close_max_dist_object),
 		cmocka_unit_test(scc_ut_get_max_dist),
+		cmocka_unit_test(scc_ut_get_max_dist_boxed),
 		cmocka_unit_test(scc_ut_init_close_nn_search_object),
 		cmocka_unit_test(scc_ut_nearest_neighbor_search),
 		cmocka_unit_test(scc_ut_nearest_neighbor_search_radius),
+		cmocka_unit_test(scc_ut_nearest_neighbor_search_threads),
+		cmocka_unit_test(scc_ut_nearest_neighbor_search_heap),
+		cmocka_unit_test(scc_ut_low_precision_data_sets),
 	};
 
 	return cmocka_run_group_tests_name("dist_search.c", test_cases, NULL, NULL);
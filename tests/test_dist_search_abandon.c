@@ -0,0 +1,179 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/dist_search_abandon.h>
+#include <src/dist_search_imp.h>
+#include <src/scclust_types.h>
+#include "compare_nn_search.h"
+#include "rand.h"
+
+
+// Dimensions have different scales, so that the reordering has an effect
+static double* scc_ut_make_coords(const size_t num_points,
+                                  const size_t num_dims,
+                                  const bool discrete)
+{
+	double* const coords = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	for (size_t i = 0; i < num_points * num_dims; ++i) {
+		if (discrete) {
+			coords[i] = (double) ((uint64_t) coords[i] % 3);
+		} else {
+			coords[i] /= (double) (1 + (i * 7) % num_dims);
+		}
+	}
+	return coords;
+}
+
+
+static void scc_ut_compare_ea_with_imp(scc_DataSet* const data_set,
+                                       const size_t len_search,
+                                       const scc_PointIndex search_indices[const],
+                                       const size_t len_query,
+                                       const scc_PointIndex query_indices[const],
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double radius)
+{
+	scc_ut_compare_nn_with_imp(iscc_ea_init_nn_search_object, iscc_ea_nearest_neighbor_search, iscc_ea_close_nn_search_object,
+	                           data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius);
+	scc_ut_compare_nn_with_imp(iscc_ea_init_nn_search_object_reordered, iscc_ea_nearest_neighbor_search, iscc_ea_close_nn_search_object,
+	                           data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius);
+}
+
+
+void scc_ut_early_abandon_nearest_neighbor_search(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 1500;
+	const size_t num_dims = 60;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, false);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_points / 2]));
+	for (size_t i = 0; i < num_points / 2; ++i) {
+		indices[i] = (scc_PointIndex) (num_points - 1 - 2 * i);
+	}
+
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points, NULL, 1, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points, NULL, 7, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points / 2, indices, 5, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points / 2, indices, num_points, NULL, 5, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, 10, indices, 300, NULL, 10, false, 0.0);
+
+	// Neighbor heaps
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, 200, indices, 100, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points / 2, indices, 200, NULL, 70, true, 300.0);
+
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points, NULL, 4, true, 170.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points / 2, indices, num_points, NULL, 3, true, 190.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points / 2, indices, 2, true, 160.0);
+
+	free(indices);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+void scc_ut_early_abandon_duplicates(void** state)
+{
+	(void) state;
+
+	// Many ties, summed exactly in any order
+	const size_t num_points = 1000;
+	const size_t num_dims = 20;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, true);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points, NULL, 3, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points, NULL, 80, false, 0.0);
+	scc_ut_compare_ea_with_imp(data_set, num_points, NULL, num_points, NULL, 3, true, 3.0);
+
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+void scc_ut_early_abandon_clustering(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 500;
+	const size_t num_dims = 30;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, false);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_ClusterOptions options = scc_default_cluster_options;
+	options.size_constraint = 4;
+
+	scc_Clabel* const imp_labels = malloc(sizeof(scc_Clabel[num_points]));
+	scc_Clabel* const ea_labels = malloc(sizeof(scc_Clabel[num_points]));
+	scc_Clustering* imp_clustering;
+	assert_int_equal(scc_init_empty_clustering(num_points, imp_labels, &imp_clustering), SCC_ER_OK);
+	assert_int_equal(scc_make_clustering(data_set, imp_clustering, &options), SCC_ER_OK);
+
+	for (size_t reorder = 0; reorder < 2; ++reorder) {
+		scc_DistBackend* backend;
+		assert_int_equal(scc_init_early_abandon_dist_backend(reorder == 1, &backend), SCC_ER_OK);
+		options.dist_backend = backend;
+
+		scc_Clustering* ea_clustering;
+		assert_int_equal(scc_init_empty_clustering(num_points, ea_labels, &ea_clustering), SCC_ER_OK);
+		assert_int_equal(scc_make_clustering(data_set, ea_clustering, &options), SCC_ER_OK);
+		assert_memory_equal(imp_labels, ea_labels, sizeof(scc_Clabel[num_points]));
+
+		scc_free_clustering(&ea_clustering);
+		scc_free_dist_backend(&backend);
+		options.dist_backend = NULL;
+	}
+
+	assert_true(scc_set_early_abandon_dist_search(true));
+	assert_true(scc_reset_dist_functions());
+
+	scc_free_clustering(&imp_clustering);
+	free(imp_labels);
+	free(ea_labels);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_early_abandon_nearest_neighbor_search),
+		cmocka_unit_test(scc_ut_early_abandon_duplicates),
+		cmocka_unit_test(scc_ut_early_abandon_clustering),
+	};
+
+	return cmocka_run_group_tests_name("dist_search_abandon.c", test_cases, NULL, NULL);
+}
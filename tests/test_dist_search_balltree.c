@@ -0,0 +1,163 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <src/dist_search_balltree.h>
+#include <src/dist_search_imp.h>
+#include <src/scclust_types.h>
+#include "compare_nn_search.h"
+#include "double_assert.h"
+#include "rand.h"
+
+
+static double* scc_ut_make_coords(const size_t num_points,
+                                  const size_t num_dims,
+                                  const bool discrete)
+{
+	double* const coords = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	for (size_t i = 0; i < num_points * num_dims; ++i) {
+		// Clustered data in the first dimension
+		if (i % num_dims == 0) coords[i] = (double) ((i / num_dims) % 7) * 300.0 + coords[i] / 100.0;
+		if (discrete && (i % num_dims == 1)) coords[i] = (double) ((uint64_t) coords[i] % 2);
+	}
+	return coords;
+}
+
+
+static void scc_ut_compare_bt_with_imp(scc_DataSet* const data_set,
+                                       const size_t len_search,
+                                       const scc_PointIndex search_indices[const],
+                                       const size_t len_query,
+                                       const scc_PointIndex query_indices[const],
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double radius)
+{
+	scc_ut_compare_nn_with_imp(iscc_bt_init_nn_search_object, iscc_bt_nearest_neighbor_search, iscc_bt_close_nn_search_object,
+	                           data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius);
+}
+
+
+static void scc_ut_compare_max_dist_with_imp(scc_DataSet* const data_set,
+                                             const size_t len_search,
+                                             const scc_PointIndex search_indices[const],
+                                             const size_t len_query,
+                                             const scc_PointIndex query_indices[const])
+{
+	scc_PointIndex* const imp_max_indices = malloc(sizeof(scc_PointIndex[len_query]));
+	scc_PointIndex* const bt_max_indices = malloc(sizeof(scc_PointIndex[len_query]));
+	double* const imp_max_dists = malloc(sizeof(double[len_query]));
+	double* const bt_max_dists = malloc(sizeof(double[len_query]));
+
+	iscc_MaxDistObject* imp_object;
+	assert_true(iscc_imp_init_max_dist_object(data_set, len_search, search_indices, &imp_object));
+	assert_true(iscc_imp_get_max_dist(imp_object, len_query, query_indices, imp_max_indices, imp_max_dists));
+	assert_true(iscc_imp_close_max_dist_object(&imp_object));
+
+	iscc_MaxDistObject* bt_object;
+	assert_true(iscc_bt_init_max_dist_object(data_set, len_search, search_indices, &bt_object));
+	assert_true(iscc_bt_get_max_dist(bt_object, len_query, query_indices, bt_max_indices, bt_max_dists));
+	assert_true(iscc_bt_close_max_dist_object(&bt_object));
+	assert_null(bt_object);
+
+	for (size_t q = 0; q < len_query; ++q) {
+		assert_int_equal(imp_max_indices[q], bt_max_indices[q]);
+		assert_double_equal(imp_max_dists[q], bt_max_dists[q]);
+	}
+
+	free(imp_max_indices);
+	free(bt_max_indices);
+	free(imp_max_dists);
+	free(bt_max_dists);
+}
+
+
+void scc_ut_balltree_nearest_neighbor_search(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 1500;
+	const size_t num_dims = 30;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, true);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_points / 2]));
+	for (size_t i = 0; i < num_points / 2; ++i) {
+		indices[i] = (scc_PointIndex) (num_points - 1 - 2 * i);
+	}
+
+	scc_ut_compare_bt_with_imp(data_set, num_points, NULL, num_points, NULL, 1, false, 0.0);
+	scc_ut_compare_bt_with_imp(data_set, num_points, NULL, num_points, NULL, 6, false, 0.0);
+	scc_ut_compare_bt_with_imp(data_set, num_points, NULL, num_points / 2, indices, 4, false, 0.0);
+	scc_ut_compare_bt_with_imp(data_set, num_points / 2, indices, num_points, NULL, 4, false, 0.0);
+	scc_ut_compare_bt_with_imp(data_set, 20, indices, 100, NULL, 20, false, 0.0);
+
+	scc_ut_compare_bt_with_imp(data_set, num_points, NULL, num_points, NULL, 3, true, 1500.0);
+	scc_ut_compare_bt_with_imp(data_set, num_points / 2, indices, num_points, NULL, 2, true, 1550.0);
+
+	free(indices);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+void scc_ut_balltree_max_dist(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 1500;
+	const size_t num_dims = 30;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, false);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_points / 3]));
+	for (size_t i = 0; i < num_points / 3; ++i) {
+		indices[i] = (scc_PointIndex) (3 * i + 1);
+	}
+
+	scc_ut_compare_max_dist_with_imp(data_set, num_points, NULL, num_points, NULL);
+	scc_ut_compare_max_dist_with_imp(data_set, num_points / 3, indices, num_points, NULL);
+	scc_ut_compare_max_dist_with_imp(data_set, num_points, NULL, num_points / 3, indices);
+	scc_ut_compare_max_dist_with_imp(data_set, 1, indices, 10, NULL);
+
+	free(indices);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_balltree_nearest_neighbor_search),
+		cmocka_unit_test(scc_ut_balltree_max_dist),
+	};
+
+	return cmocka_run_group_tests_name("dist_search_balltree.c", test_cases, NULL, NULL);
+}
@@ -0,0 +1,291 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <include/scclust_spi.h>
+#include <src/dist_search_hnsw.h>
+#include <src/dist_search_imp.h>
+#include <src/scclust_types.h>
+#include "compare_nn_search.h"
+#include "rand.h"
+
+
+static const char* const SCC_UT_HNSW_INDEX_FILE = "test_dist_search_hnsw.idx";
+static const char* const SCC_UT_HNSW_BACKEND_FILES[2] = { "test_dist_search_hnsw_backend0.idx",
+                                                          "test_dist_search_hnsw_backend1.idx" };
+
+
+static void scc_ut_hnsw_search(scc_DataSet* const data_set,
+                               const size_t len_search,
+                               const scc_PointIndex search_indices[const],
+                               const size_t len_query,
+                               const scc_PointIndex query_indices[const],
+                               const uint32_t k,
+                               const bool radius_search,
+                               const double radius,
+                               size_t* const out_num_ok,
+                               scc_PointIndex out_query[const],
+                               scc_PointIndex out_nn[const])
+{
+	scc_ut_search_nn(iscc_hnsw_init_nn_search_object, iscc_hnsw_nearest_neighbor_search, iscc_hnsw_close_nn_search_object,
+	                 data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius,
+	                 out_num_ok, out_query, out_nn);
+}
+
+
+static void scc_ut_compare_hnsw_with_imp(scc_DataSet* const data_set,
+                                         const size_t len_search,
+                                         const scc_PointIndex search_indices[const],
+                                         const size_t len_query,
+                                         const scc_PointIndex query_indices[const],
+                                         const uint32_t k,
+                                         const bool radius_search,
+                                         const double radius,
+                                         const double min_recall)
+{
+	scc_ut_compare_nn_recall_with_imp(iscc_hnsw_init_nn_search_object, iscc_hnsw_nearest_neighbor_search, iscc_hnsw_close_nn_search_object,
+	                                  data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius,
+	                                  min_recall);
+}
+
+
+void scc_ut_hnsw_nearest_neighbor_search(void** state)
+{
+	(void) state;
+
+	assert_true(iscc_hnsw_set_parameters(0, 0, 0, NULL));
+
+	const size_t num_points = 3000;
+	const size_t num_dims = 8;
+	double* const coords = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_points / 2]));
+	for (size_t i = 0; i < num_points / 2; ++i) {
+		indices[i] = (scc_PointIndex) (num_points - 1 - 2 * i);
+	}
+
+	scc_ut_compare_hnsw_with_imp(data_set, num_points, NULL, num_points, NULL, 1, false, 0.0, 0.95);
+	scc_ut_compare_hnsw_with_imp(data_set, num_points, NULL, num_points, NULL, 6, false, 0.0, 0.95);
+	scc_ut_compare_hnsw_with_imp(data_set, num_points, NULL, num_points / 2, indices, 4, false, 0.0, 0.95);
+	scc_ut_compare_hnsw_with_imp(data_set, num_points / 2, indices, num_points, NULL, 4, false, 0.0, 0.95);
+	scc_ut_compare_hnsw_with_imp(data_set, num_points, NULL, num_points, NULL, 3, true, 250.0, 0.95);
+
+	// Small search sets are searched exactly
+	scc_ut_compare_hnsw_with_imp(data_set, 20, indices, 100, NULL, 20, false, 0.0, 1.0);
+	scc_ut_compare_hnsw_with_imp(data_set, 300, indices, num_points, NULL, 5, true, 400.0, 1.0);
+
+	// A large `k` widens the beam
+	scc_ut_compare_hnsw_with_imp(data_set, num_points, NULL, 50, indices, 200, false, 0.0, 0.95);
+
+	// Few links
+	assert_true(iscc_hnsw_set_parameters(2, 30, 30, NULL));
+	scc_ut_compare_hnsw_with_imp(data_set, num_points, NULL, num_points, NULL, 2, false, 0.0, 0.5);
+
+	assert_true(iscc_hnsw_set_parameters(0, 0, 0, NULL));
+
+	free(indices);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+void scc_ut_hnsw_index_file(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 2000;
+	const size_t num_dims = 5;
+	const uint32_t k = 4;
+	double* const coords1 = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	double* const coords2 = scc_rand_coords(num_points, num_dims, 2463534242u);
+	scc_DataSet* data_set1;
+	scc_DataSet* data_set2;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords1, &data_set1), SCC_ER_OK);
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords2, &data_set2), SCC_ER_OK);
+
+	scc_PointIndex* const nn1 = malloc(sizeof(scc_PointIndex[num_points * k]));
+	scc_PointIndex* const nn2 = malloc(sizeof(scc_PointIndex[num_points * k]));
+	size_t num_ok1;
+	size_t num_ok2;
+
+	remove(SCC_UT_HNSW_INDEX_FILE);
+	assert_false(iscc_hnsw_set_parameters(1, 0, 0, NULL));
+	assert_true(iscc_hnsw_set_parameters(8, 100, 40, SCC_UT_HNSW_INDEX_FILE));
+
+	// Built and written
+	scc_ut_hnsw_search(data_set1, num_points, NULL, num_points, NULL, k, false, 0.0, &num_ok1, NULL, nn1);
+	FILE* index_file = fopen(SCC_UT_HNSW_INDEX_FILE, "rb");
+	assert_non_null(index_file);
+	fclose(index_file);
+
+	// Read, gives the same graph
+	scc_ut_hnsw_search(data_set1, num_points, NULL, num_points, NULL, k, false, 0.0, &num_ok2, NULL, nn2);
+	assert_int_equal(num_ok1, num_points);
+	assert_int_equal(num_ok2, num_points);
+	assert_memory_equal(nn1, nn2, sizeof(scc_PointIndex[num_points * k]));
+
+	// Corrupt link tables are rejected and the index is rebuilt. The first
+	// count in `links0` follows the 56 byte header and `levels`.
+	const long links0_offset = 56 + (long) sizeof(uint32_t[num_points]);
+	const uint32_t bad_links[2][2] = { { 2 * 8 + 1, 0 }, { 1, (uint32_t) num_points } };
+	for (size_t b = 0; b < 2; ++b) {
+		index_file = fopen(SCC_UT_HNSW_INDEX_FILE, "r+b");
+		assert_non_null(index_file);
+		assert_int_equal(fseek(index_file, links0_offset, SEEK_SET), 0);
+		assert_int_equal(fwrite(bad_links[b], sizeof(uint32_t), 2, index_file), 2);
+		fclose(index_file);
+
+		scc_ut_compare_hnsw_with_imp(data_set1, num_points, NULL, num_points, NULL, k, false, 0.0, 0.95);
+
+		uint32_t stored_links[2];
+		index_file = fopen(SCC_UT_HNSW_INDEX_FILE, "rb");
+		assert_non_null(index_file);
+		assert_int_equal(fseek(index_file, links0_offset, SEEK_SET), 0);
+		assert_int_equal(fread(stored_links, sizeof(uint32_t), 2, index_file), 2);
+		fclose(index_file);
+		assert_true(stored_links[0] <= 2 * 8);
+		assert_true(stored_links[1] < num_points);
+	}
+
+	// Other data or parameters do not match the stored graph
+	scc_ut_compare_hnsw_with_imp(data_set2, num_points, NULL, num_points, NULL, k, false, 0.0, 0.95);
+	assert_true(iscc_hnsw_set_parameters(12, 100, 40, SCC_UT_HNSW_INDEX_FILE));
+	scc_ut_compare_hnsw_with_imp(data_set1, num_points, NULL, num_points, NULL, k, false, 0.0, 0.95);
+
+	// Subsets are not stored
+	scc_PointIndex indices[1000];
+	for (size_t i = 0; i < 1000; ++i) {
+		indices[i] = (scc_PointIndex) (2 * i);
+	}
+	assert_int_equal(remove(SCC_UT_HNSW_INDEX_FILE), 0);
+	scc_ut_compare_hnsw_with_imp(data_set1, 1000, indices, num_points, NULL, k, false, 0.0, 0.95);
+	index_file = fopen(SCC_UT_HNSW_INDEX_FILE, "rb");
+	assert_null(index_file);
+
+	// SPI
+	assert_false(scc_set_hnsw_dist_search(1, 0, 0, NULL));
+	assert_true(scc_set_hnsw_dist_search(0, 0, 0, NULL));
+	assert_true(scc_reset_dist_functions());
+
+	free(nn1);
+	free(nn2);
+	scc_free_data_set(&data_set1);
+	scc_free_data_set(&data_set2);
+	free(coords1);
+	free(coords2);
+}
+
+
+void scc_ut_hnsw_dist_backend(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 2000;
+	const size_t num_dims = 5;
+	double* const coords = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_DistBackend* backend;
+	assert_int_equal(scc_init_hnsw_dist_backend(1, 0, 0, NULL, &backend), SCC_ER_INVALID_INPUT);
+	assert_null(backend);
+	assert_int_equal(scc_init_hnsw_dist_backend(0, 0, 0, NULL, NULL), SCC_ER_INVALID_INPUT);
+
+	// Global settings that the backends must not use
+	remove(SCC_UT_HNSW_INDEX_FILE);
+	assert_true(scc_set_hnsw_dist_search(2, 30, 30, SCC_UT_HNSW_INDEX_FILE));
+
+	scc_DistBackend* backends[2];
+	scc_Clabel* labels[2];
+	scc_ErrorCode ec[2];
+	for (size_t b = 0; b < 2; ++b) {
+		remove(SCC_UT_HNSW_BACKEND_FILES[b]);
+		assert_int_equal(scc_init_hnsw_dist_backend((uint32_t) (8 + 4 * b), 100, 40, SCC_UT_HNSW_BACKEND_FILES[b], &backends[b]), SCC_ER_OK);
+		labels[b] = malloc(sizeof(scc_Clabel[num_points]));
+	}
+
+	// Clusterings with different backends run concurrently; cmocka is not thread-safe, so results are checked after
+	#ifdef _OPENMP
+		#pragma omp parallel for num_threads(2)
+	#endif
+	for (int b = 0; b < 2; ++b) {
+		scc_ClusterOptions options = scc_default_cluster_options;
+		options.size_constraint = 3;
+		options.dist_backend = backends[b];
+		scc_Clustering* clustering;
+		ec[b] = scc_init_empty_clustering(num_points, labels[b], &clustering);
+		if (ec[b] == SCC_ER_OK) ec[b] = scc_make_clustering(data_set, clustering, &options);
+		scc_free_clustering(&clustering);
+	}
+
+	for (size_t b = 0; b < 2; ++b) {
+		assert_int_equal(ec[b], SCC_ER_OK);
+		FILE* const index_file = fopen(SCC_UT_HNSW_BACKEND_FILES[b], "rb");
+		assert_non_null(index_file);
+		fclose(index_file);
+		assert_int_equal(remove(SCC_UT_HNSW_BACKEND_FILES[b]), 0);
+	}
+	assert_null(fopen(SCC_UT_HNSW_INDEX_FILE, "rb"));
+
+	// The global functions use the global settings, which match the first backend
+	assert_true(scc_set_hnsw_dist_search(8, 100, 40, NULL));
+	scc_Clabel* const global_labels = malloc(sizeof(scc_Clabel[num_points]));
+	scc_Clustering* clustering;
+	assert_int_equal(scc_init_empty_clustering(num_points, global_labels, &clustering), SCC_ER_OK);
+	scc_ClusterOptions options = scc_default_cluster_options;
+	options.size_constraint = 3;
+	assert_int_equal(scc_make_clustering(data_set, clustering, &options), SCC_ER_OK);
+	assert_memory_equal(global_labels, labels[0], sizeof(scc_Clabel[num_points]));
+	scc_free_clustering(&clustering);
+
+	assert_true(scc_reset_dist_functions());
+	assert_true(iscc_hnsw_set_parameters(0, 0, 0, NULL));
+
+	for (size_t b = 0; b < 2; ++b) {
+		scc_free_dist_backend(&backends[b]);
+		assert_null(backends[b]);
+		free(labels[b]);
+	}
+	free(global_labels);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_hnsw_nearest_neighbor_search),
+		cmocka_unit_test(scc_ut_hnsw_index_file),
+		cmocka_unit_test(scc_ut_hnsw_dist_backend),
+	};
+
+	return cmocka_run_group_tests_name("dist_search_hnsw.c", test_cases, NULL, NULL);
+}
@@ -0,0 +1,122 @@
+/* =============================================================================
+ * scclust -- A C library for size constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2016  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "init_test.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust.h>
+#include <src/dist_search_imp.h>
+#include <src/dist_search_kdtree.h>
+#include <src/scclust_types.h>
+#include "compare_nn_search.h"
+#include "rand.h"
+
+
+static double* scc_ut_make_coords(const size_t num_points,
+                                  const size_t num_dims,
+                                  const bool discrete)
+{
+	double* const coords = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	if (discrete) {
+		for (size_t i = 0; i < num_points * num_dims; i += num_dims) {
+			coords[i] = (double) ((uint64_t) coords[i] % 3);
+		}
+	}
+	return coords;
+}
+
+
+static void scc_ut_compare_kdt_with_imp(scc_DataSet* const data_set,
+                                        const size_t len_search,
+                                        const scc_PointIndex search_indices[const],
+                                        const size_t len_query,
+                                        const scc_PointIndex query_indices[const],
+                                        const uint32_t k,
+                                        const bool radius_search,
+                                        const double radius)
+{
+	scc_ut_compare_nn_with_imp(iscc_kdt_init_nn_search_object, iscc_kdt_nearest_neighbor_search, iscc_kdt_close_nn_search_object,
+	                           data_set, len_search, search_indices, len_query, query_indices, k, radius_search, radius);
+}
+
+
+void scc_ut_kdtree_nearest_neighbor_search(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 2000;
+	const size_t num_dims = 3;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, false);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const indices = malloc(sizeof(scc_PointIndex[num_points / 2]));
+	for (size_t i = 0; i < num_points / 2; ++i) {
+		indices[i] = (scc_PointIndex) (num_points - 1 - 2 * i);
+	}
+
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points, NULL, 1, false, 0.0);
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points, NULL, 7, false, 0.0);
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points / 2, indices, 5, false, 0.0);
+	scc_ut_compare_kdt_with_imp(data_set, num_points / 2, indices, num_points, NULL, 5, false, 0.0);
+	scc_ut_compare_kdt_with_imp(data_set, 10, indices, 300, NULL, 10, false, 0.0);
+
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points, NULL, 4, true, 70.0);
+	scc_ut_compare_kdt_with_imp(data_set, num_points / 2, indices, num_points, NULL, 3, true, 90.0);
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points / 2, indices, 2, true, 1000.0);
+
+	free(indices);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+void scc_ut_kdtree_duplicates(void** state)
+{
+	(void) state;
+
+	// Many identical values along the first dimension
+	const size_t num_points = 1500;
+	const size_t num_dims = 5;
+	double* const coords = scc_ut_make_coords(num_points, num_dims, true);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points, NULL, 3, false, 0.0);
+	scc_ut_compare_kdt_with_imp(data_set, num_points, NULL, num_points, NULL, 3, true, 150.0);
+
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+int main(void)
+{
+	if(!scc_ut_init_tests()) return 1;
+
+	const struct CMUnitTest test_cases[] = {
+		cmocka_unit_test(scc_ut_kdtree_nearest_neighbor_search),
+		cmocka_unit_test(scc_ut_kdtree_duplicates),
+	};
+
+	return cmocka_run_group_tests_name("dist_search_kdtree.c", test_cases, NULL, NULL);
+}
@@ -22,9 +22,15 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <include/scclust.h>
 #include <src/error.h>
 
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
 
 void scc_ut_get_error_message(void** state)
 {
@@ -49,13 +55,13 @@ void scc_ut_get_error_message(void** state)
 	bool err_res4 = scc_get_latest_error(buffer_size, text_buffer);
 	assert_true(err_res4);
 	assert_int_equal(ec4, SCC_ER_INVALID_INPUT);
-	assert_string_equal(text_buffer, "(scclust:test_error.c:48) Function parameters are invalid.");
+	assert_string_equal(text_buffer, "(scclust:test_error.c:54) Function parameters are invalid.");
 
 	scc_ErrorCode ec4b = iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Test message 12345.");
 	bool err_res4b = scc_get_latest_error(buffer_size, text_buffer);
 	assert_true(err_res4b);
 	assert_int_equal(ec4b, SCC_ER_INVALID_INPUT);
-	assert_string_equal(text_buffer, "(scclust:test_error.c:54) Test message 12345.");
+	assert_string_equal(text_buffer, "(scclust:test_error.c:60) Test message 12345.");
 
 	iscc_reset_error();
 	bool err_res5 = scc_get_latest_error(buffer_size, text_buffer);
@@ -112,12 +118,91 @@ void scc_ut_get_error_message(void** state)
 }
 
 
+void scc_ut_error_per_thread(void** state)
+{
+	(void) state;
+
+	const char* const files[4] = { "thread0.c", "thread1.c", "thread2.c", "thread3.c" };
+	int num_wrong = 0;
+
+	iscc_reset_error();
+
+	// cmocka is not thread-safe, so results are checked after the region
+	#ifdef _OPENMP
+		#pragma omp parallel num_threads(4) reduction(+:num_wrong)
+	#endif
+	{
+		int thread = 0;
+		#ifdef _OPENMP
+			thread = omp_get_thread_num();
+		#endif
+
+		iscc_make_error__(SCC_ER_INVALID_INPUT, NULL, files[thread], thread + 1);
+
+		#ifdef _OPENMP
+			#pragma omp barrier
+		#endif
+
+		char text_buffer[256];
+		char expected[256];
+		snprintf(expected, 256, "(scclust:%s:%d) Function parameters are invalid.", files[thread], thread + 1);
+		if (!scc_get_latest_error(256, text_buffer) || (strcmp(text_buffer, expected) != 0)) {
+			++num_wrong;
+		}
+		iscc_reset_error();
+	}
+
+	assert_int_equal(num_wrong, 0);
+}
+
+
+void scc_ut_error_state_between_threads(void** state)
+{
+	(void) state;
+
+	iscc_reset_error();
+	iscc_ErrorState worker_error = { .error_code = SCC_ER_OK };
+
+	#ifdef _OPENMP
+		#pragma omp parallel num_threads(4)
+	#endif
+	{
+		// The error is made in the last thread, which is not the calling thread when there are several
+		int thread = 0;
+		int last_thread = 0;
+		#ifdef _OPENMP
+			thread = omp_get_thread_num();
+			last_thread = omp_get_num_threads() - 1;
+		#endif
+
+		if (thread == last_thread) {
+			iscc_make_error__(SCC_ER_TOO_LARGE_PROBLEM, "Worker message.", "worker.c", 42);
+			worker_error = iscc_get_error_state();
+			iscc_reset_error();
+		}
+	}
+
+	const size_t buffer_size = 256;
+	char text_buffer[buffer_size];
+	assert_true(scc_get_latest_error(buffer_size, text_buffer));
+	assert_string_equal(text_buffer, "(scclust) No error.");
+
+	assert_int_equal(iscc_set_error_state(&worker_error), SCC_ER_TOO_LARGE_PROBLEM);
+	assert_true(scc_get_latest_error(buffer_size, text_buffer));
+	assert_string_equal(text_buffer, "(scclust:worker.c:42) Worker message.");
+
+	iscc_reset_error();
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
 
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_get_error_message),
+		cmocka_unit_test(scc_ut_error_per_thread),
+		cmocka_unit_test(scc_ut_error_state_between_threads),
 	};
 
 	return cmocka_run_group_tests_name("error.c", test_cases, NULL, NULL);
@@ -21,11 +21,15 @@
 #include "init_test.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <include/scclust.h>
+#include <include/scclust_spi.h>
 #include <src/clustering_struct.h>
 #include <src/scclust_types.h>
 #include "data_object_test.h"
+#include "rand.h"
+
 
 /*
 R code:
@@ -105,23 +109,25 @@ hierarchical_clustering <- function(in_clustering, k, dist, batch) {
 }
 */
 
+// Labels of `scc_ut_test_data_large` clustered with size constraint 20 and batch assignment
+static const scc_Clabel scc_ut_ref_label_large[100] = { 2, 3, 3, 2, 2, 3, 0, 0, 4, 3, 2, 1, 1, 0, 4, 3, 0, 2, 0, 4, 3, 1, 3,
+                                                        0, 0, 0, 4, 0, 4, 0, 3, 4, 3, 1, 0, 0, 3, 4, 1, 0, 3, 2, 1, 2, 2, 2,
+                                                        0, 2, 1, 4, 3, 4, 4, 4, 1, 0, 3, 1, 3, 1, 1, 1, 4, 4, 3, 4, 4, 1, 2,
+                                                        3, 1, 4, 2, 3, 4, 0, 0, 4, 1, 1, 3, 2, 1, 0, 2, 1, 0, 2, 2, 2, 4, 2,
+                                                        1, 2, 2, 1, 3, 4, 3, 0 };
+
+
 void scc_ut_hierarchical_clustering(void** state)
 {
 	(void) state;
 
-	scc_Clabel ref_label1[100] = { 2, 3, 3, 2, 2, 3, 0, 0, 4, 3, 2, 1, 1, 0, 4, 3, 0, 2, 0, 4, 3, 1, 3,
-	                               0, 0, 0, 4, 0, 4, 0, 3, 4, 3, 1, 0, 0, 3, 4, 1, 0, 3, 2, 1, 2, 2, 2,
-	                               0, 2, 1, 4, 3, 4, 4, 4, 1, 0, 3, 1, 3, 1, 1, 1, 4, 4, 3, 4, 4, 1, 2,
-	                               3, 1, 4, 2, 3, 4, 0, 0, 4, 1, 1, 3, 2, 1, 0, 2, 1, 0, 2, 2, 2, 4, 2,
-	                               1, 2, 2, 1, 3, 4, 3, 0 };
-
 	scc_Clustering* cl1_a;
 	scc_init_empty_clustering(100, NULL, &cl1_a);
 	scc_ErrorCode ec1_a = scc_hierarchical_clustering(scc_ut_test_data_large, cl1_a, 20, true);
 	assert_int_equal(ec1_a, SCC_ER_OK);
 	assert_int_equal(cl1_a->num_data_points, 100);
 	assert_int_equal(cl1_a->num_clusters, 5);
-	assert_memory_equal(cl1_a->cluster_label, ref_label1, 100 * sizeof(scc_Clabel));
+	assert_memory_equal(cl1_a->cluster_label, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
 	scc_free_clustering(&cl1_a);
 
 	scc_Clabel* ext_cluster_label1 = malloc(sizeof(scc_Clabel[100]));
@@ -131,8 +137,8 @@ void scc_ut_hierarchical_clustering(void** state)
 	assert_int_equal(ec1_b, SCC_ER_OK);
 	assert_int_equal(cl1_b->num_data_points, 100);
 	assert_int_equal(cl1_b->num_clusters, 5);
-	assert_memory_equal(cl1_b->cluster_label, ref_label1, 100 * sizeof(scc_Clabel));
-	assert_memory_equal(ext_cluster_label1, ref_label1, 100 * sizeof(scc_Clabel));
+	assert_memory_equal(cl1_b->cluster_label, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
+	assert_memory_equal(ext_cluster_label1, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
 	scc_free_clustering(&cl1_b);
 	free(ext_cluster_label1);
 
@@ -208,12 +214,159 @@ void scc_ut_hierarchical_clustering(void** state)
 }
 
 
+void scc_ut_hierarchical_clustering_with_backend(void** state)
+{
+	(void) state;
+
+	scc_DistBackend* backend;
+	assert_int_equal(scc_init_balltree_dist_backend(&backend), SCC_ER_OK);
+
+	scc_HierarchicalOptions options = scc_default_hierarchical_options;
+	options.dist_backend = backend;
+
+	scc_Clustering* cl;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, 5);
+	assert_memory_equal(cl->cluster_label, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
+	scc_free_clustering(&cl);
+
+	scc_init_empty_clustering(100, NULL, &cl);
+	options.dist_backend = NULL;
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_OK);
+	assert_memory_equal(cl->cluster_label, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
+	options.dist_backend = (const scc_DistBackend*) scc_ut_test_data_large;
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	scc_free_dist_backend(&backend);
+	assert_null(backend);
+}
+
+
+void scc_ut_hierarchical_center_search(void** state)
+{
+	(void) state;
+
+	scc_DistBackend* backend;
+	assert_int_equal(scc_init_balltree_dist_backend(&backend), SCC_ER_OK);
+
+	// The work area is not sized by starting points beyond the number of data points
+	const uint32_t settings[5][2] = { { 1, 2 }, { 10, 1 }, { 1, 0 }, { 500, 0 }, { UINT32_MAX, 0 } };
+	for (size_t i = 0; i < 5; ++i) {
+		scc_HierarchicalOptions options = scc_default_hierarchical_options;
+		options.dist_backend = (i % 2 == 0) ? NULL : backend;
+		options.center_search_points = settings[i][0];
+		options.center_search_rounds = settings[i][1];
+		scc_Clustering* cl;
+		scc_init_empty_clustering(100, NULL, &cl);
+		assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 10, false, &options), SCC_ER_OK);
+		bool cl_is_OK;
+		assert_int_equal(scc_check_clustering(cl, 10, 0, NULL, 0, NULL, &cl_is_OK), SCC_ER_OK);
+		assert_true(cl_is_OK);
+		scc_free_clustering(&cl);
+	}
+
+	// The default
+	scc_HierarchicalOptions options = scc_default_hierarchical_options;
+	scc_Clustering* cl;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_OK);
+	assert_memory_equal(cl->cluster_label, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
+	scc_free_clustering(&cl);
+
+	// The settings of one call do not carry over to the next
+	options.center_search_points = 1;
+	options.center_search_rounds = 2;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_OK);
+	scc_free_clustering(&cl);
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_hierarchical_clustering(scc_ut_test_data_large, cl, 20, true), SCC_ER_OK);
+	assert_memory_equal(cl->cluster_label, scc_ut_ref_label_large, 100 * sizeof(scc_Clabel));
+
+	// Invalid options
+	options.center_search_points = 0;
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_INVALID_INPUT);
+	options = scc_default_hierarchical_options;
+	options.options_version = 1;
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, &options), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_hierarchical_clustering_with_options(scc_ut_test_data_large, cl, 20, true, NULL), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	scc_free_dist_backend(&backend);
+}
+
+
+// Clusters the data with `num_threads` threads, starting from three clusters if `from_clustering`
+static scc_Clabel* scc_ut_hierarchical_with_threads(scc_DataSet* const data_set,
+                                                    const size_t num_points,
+                                                    const uint32_t num_threads,
+                                                    const bool from_clustering,
+                                                    const bool batch_assign,
+                                                    size_t* const out_num_clusters)
+{
+	const scc_ErrorCode ec = scc_set_num_threads(num_threads);
+	assert_true((ec == SCC_ER_OK) || (ec == SCC_ER_NOT_IMPLEMENTED));
+
+	scc_Clabel* const cluster_label = malloc(sizeof(scc_Clabel[num_points]));
+	scc_Clustering* cl;
+	if (from_clustering) {
+		for (size_t i = 0; i < num_points; ++i) {
+			cluster_label[i] = (scc_Clabel) ((7 * i) % 3);
+		}
+		assert_int_equal(scc_init_existing_clustering(num_points, 3, cluster_label, false, &cl), SCC_ER_OK);
+	} else {
+		assert_int_equal(scc_init_empty_clustering(num_points, cluster_label, &cl), SCC_ER_OK);
+	}
+	assert_int_equal(scc_hierarchical_clustering(data_set, cl, 5, batch_assign), SCC_ER_OK);
+	*out_num_clusters = cl->num_clusters;
+	scc_free_clustering(&cl);
+
+	return cluster_label;
+}
+
+
+void scc_ut_hierarchical_clustering_parallel(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 6000;
+	double* const coords = scc_rand_coords(num_points, 3, SCC_RAND_DEFAULT_SEED);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, 3, num_points * 3, coords, &data_set), SCC_ER_OK);
+
+	// The clusters split in parallel are labeled as in the serial clustering
+	for (int from_clustering = 0; from_clustering < 2; ++from_clustering) {
+		for (int batch_assign = 0; batch_assign < 2; ++batch_assign) {
+			size_t num_clusters1;
+			size_t num_clusters4;
+			scc_Clabel* const label1 = scc_ut_hierarchical_with_threads(data_set, num_points, 1, from_clustering, batch_assign, &num_clusters1);
+			scc_Clabel* const label4 = scc_ut_hierarchical_with_threads(data_set, num_points, 4, from_clustering, batch_assign, &num_clusters4);
+			assert_true(num_clusters1 > 500);
+			assert_int_equal(num_clusters1, num_clusters4);
+			assert_memory_equal(label1, label4, sizeof(scc_Clabel[num_points]));
+			free(label1);
+			free(label4);
+		}
+	}
+
+	assert_int_equal(scc_set_num_threads(0), SCC_ER_OK);
+
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
 
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_hierarchical_clustering),
+		cmocka_unit_test(scc_ut_hierarchical_clustering_with_backend),
+		cmocka_unit_test(scc_ut_hierarchical_center_search),
+		cmocka_unit_test(scc_ut_hierarchical_clustering_parallel),
 	};
 
 	return cmocka_run_group_tests_name("hierarchical_clustering.c", test_cases, NULL, NULL);
@@ -186,6 +186,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 		.vertex_markers = calloc(100, sizeof(uint_fast16_t)),
 		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[100])),
 		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[100])),
+		.num_to_check = 100,
 	};
 
 	scc_Clustering cl1 = {
@@ -197,7 +198,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	};
 	iscc_hi_ClusterStack cl_stack1;
 	iscc_hi_empty_cl_stack(100, &cl_stack1);
-	scc_ErrorCode ec1 = iscc_hi_run_hierarchical_clustering(&cl_stack1, &cl1, scc_ut_test_data_large, &wa, 20, true);
+	scc_ErrorCode ec1 = iscc_hi_run_hierarchical_clustering(&cl_stack1, cl1.cluster_label, scc_ut_test_data_large, &wa, 20, true, &cl1.num_clusters);
 	assert_int_equal(ec1, SCC_ER_OK);
 	scc_Clabel ref_label1[100] = { 2, 3, 3, 2, 2, 3, 0, 0, 4, 3, 2, 1, 1, 0, 4, 3, 0, 2, 0, 4, 3, 1, 3,
 	                               0, 0, 0, 4, 0, 4, 0, 3, 4, 3, 1, 0, 0, 3, 4, 1, 0, 3, 2, 1, 2, 2, 2,
@@ -225,7 +226,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	};
 	iscc_hi_ClusterStack cl_stack2;
 	iscc_hi_empty_cl_stack(100, &cl_stack2);
-	scc_ErrorCode ec2 = iscc_hi_run_hierarchical_clustering(&cl_stack2, &cl2, scc_ut_test_data_large, &wa, 20, false);
+	scc_ErrorCode ec2 = iscc_hi_run_hierarchical_clustering(&cl_stack2, cl2.cluster_label, scc_ut_test_data_large, &wa, 20, false, &cl2.num_clusters);
 	assert_int_equal(ec2, SCC_ER_OK);
 	scc_Clabel ref_label2[100] = { 3, 0, 2, 3, 3, 2, 1, 1, 3, 2, 3, 0, 1, 0, 2, 2, 1, 3, 0, 2, 2, 0, 1, 1, 0, 1, 2, 1, 2, 0,
 	                               2, 2, 2, 0, 1, 1, 2, 2, 0, 0, 3, 3, 0, 3, 3, 0, 1, 3, 0, 2, 0, 2, 2, 2, 0, 0, 2, 0, 2, 1,
@@ -261,7 +262,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	iscc_hi_ClusterStack cl_stack3;
 	iscc_hi_init_cl_stack(&cl3, &cl_stack3, &size_largest_cluster3);
 	assert_int_equal(size_largest_cluster3, 50);
-	scc_ErrorCode ec3 = iscc_hi_run_hierarchical_clustering(&cl_stack3, &cl3, scc_ut_test_data_large, &wa, 20, true);
+	scc_ErrorCode ec3 = iscc_hi_run_hierarchical_clustering(&cl_stack3, cl3.cluster_label, scc_ut_test_data_large, &wa, 20, true, &cl3.num_clusters);
 	assert_int_equal(ec3, SCC_ER_OK);
 	scc_Clabel ref_label3[100] = { 1, 1, 3, 3, 3, 0, 0, 2, 0, 0, 3, 1, 2, 2, 3, 1, 0, 3, 1, 0, 0, 2, 1, 1, 1,
 	                               0, 1, 2, 0, 2, 3, 0, 0, 1, 2, 0, 3, 2, 1, 1, 1, 3, 2, 3, 1, 2, 2, 2, 1, 0,
@@ -296,7 +297,7 @@ void scc_ut_hi_run_hierarchical_clustering(void** state)
 	iscc_hi_ClusterStack cl_stack4;
 	iscc_hi_init_cl_stack(&cl4, &cl_stack4, &size_largest_cluster4);
 	assert_int_equal(size_largest_cluster4, 50);
-	scc_ErrorCode ec4 = iscc_hi_run_hierarchical_clustering(&cl_stack4, &cl4, scc_ut_test_data_large, &wa, 20, false);
+	scc_ErrorCode ec4 = iscc_hi_run_hierarchical_clustering(&cl_stack4, cl4.cluster_label, scc_ut_test_data_large, &wa, 20, false, &cl4.num_clusters);
 	assert_int_equal(ec4, SCC_ER_OK);
 	scc_Clabel ref_label4[100] = { 1, 0, 3, 3, 3, 0, 0, 2, 0, 0, 3, 0, 2, 2, 3, 1, 0, 3, 1, 0, 0, 2, 1, 1, 1,
 	                               0, 0, 2, 0, 2, 3, 0, 0, 1, 2, 0, 3, 3, 0, 0, 1, 3, 2, 3, 1, 2, 2, 2, 0, 0,
@@ -391,6 +392,7 @@ void scc_ut_hi_break_cluster_into_two(void** state)
 		.vertex_markers = calloc(100, sizeof(uint_fast16_t)),
 		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[40])),
 		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[40])),
+		.num_to_check = 100,
 	};
 
 	scc_PointIndex members1[10] = { 2, 4, 6, 8, 10, 12, 14, 16, 18, 20 };
@@ -626,6 +628,7 @@ void scc_ut_hi_get_next_k_nn(void** state)
 		.vertex_markers = calloc(100, sizeof(uint_fast16_t)),
 		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[10])),
 		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[10])),
+		.num_to_check = 100,
 	};
 
 	assert_int_equal(iscc_hi_populate_edge_lists(&cl, scc_ut_test_data_large, 6, 16, &wa), SCC_ER_OK);
@@ -730,6 +733,7 @@ void scc_ut_hi_get_next_dist(void** state)
 		.vertex_markers = calloc(100, sizeof(uint_fast16_t)),
 		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[5])),
 		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[5])),
+		.num_to_check = 100,
 	};
 
 	assert_int_equal(iscc_hi_populate_edge_lists(&cl, scc_ut_test_data_large, 6, 4, &wa), SCC_ER_OK);
@@ -1197,6 +1201,7 @@ void scc_ut_hi_find_centers(void** state)
 		.vertex_markers = calloc(100, sizeof(uint_fast16_t)),
 		.edge_store1 = NULL,
 		.edge_store2 = NULL,
+		.num_to_check = 100,
 	};
 
 	scc_PointIndex ref_members1[10] = { 2, 4, 6, 8, 10, 12, 14, 16, 18, 20 };
@@ -1282,6 +1287,7 @@ void scc_ut_hi_find_centers_second(void** state)
 		.vertex_markers = calloc(100, sizeof(uint_fast16_t)),
 		.edge_store1 = NULL,
 		.edge_store2 = NULL,
+		.num_to_check = 100,
 	};
 
 	scc_PointIndex members1[40] = { 34, 42, 78, 27, 99, 67, 29, 18, 92, 25,
@@ -1325,6 +1331,7 @@ void scc_ut_hi_populate_edge_lists(void** state)
 		.vertex_markers = NULL,
 		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[4])),
 		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[4])),
+		.num_to_check = 100,
 	};
 
 	scc_ErrorCode ec = iscc_hi_populate_edge_lists(&cl, scc_ut_test_data_large, 10, 5, &wa);
@@ -1374,7 +1381,7 @@ void scc_ut_hi_sort_edge_list(void** state)
 
 	iscc_hi_DistanceEdge* const edge_store = malloc(sizeof(iscc_hi_DistanceEdge[10]));
 
-	iscc_hi_sort_edge_list(&ci, 9, output_dists, edge_store);
+	iscc_hi_sort_edge_list(&ci, 9, output_dists, NULL, NULL, edge_store);
 
 	assert_int_equal(edge_store[1].head, 4);
 	assert_double_equal(edge_store[1].distance, 1.2);
@@ -1404,6 +1411,60 @@ void scc_ut_hi_sort_edge_list(void** state)
 }
 
 
+void scc_ut_hi_sort_edge_list_radix(void** state)
+{
+	(void) state;
+
+	const size_t size = 600;
+	scc_PointIndex* const mem = malloc(sizeof(scc_PointIndex[size]));
+	double* const output_dists = malloc(sizeof(double[size]));
+	for (size_t i = 0; i < size; ++i) {
+		mem[i] = (scc_PointIndex) (3 * i);
+		output_dists[i] = (i % 7 == 0) ? 1.0e10 * (double) (i % 3) : (double) ((37 * i) % 50) / 8.0;
+	}
+
+	iscc_hi_ClusterItem ci = {
+		.size = size,
+		.marker = 0,
+		.members = mem,
+	};
+
+	uint64_t* const sort_keys = malloc(sizeof(uint64_t[2 * size]));
+	scc_PointIndex* const sort_heads = malloc(sizeof(scc_PointIndex[2 * size]));
+	iscc_hi_DistanceEdge* const edge_store = malloc(sizeof(iscc_hi_DistanceEdge[size]));
+
+	iscc_hi_sort_edge_list(&ci, 30, output_dists, sort_keys, sort_heads, edge_store);
+
+	// Sorted by distance, equal distances in member order
+	for (size_t i = 1; i < size - 1; ++i) {
+		assert_true(edge_store[i].distance <= edge_store[i + 1].distance);
+		if (!(edge_store[i].distance < edge_store[i + 1].distance)) {
+			assert_true(edge_store[i].head < edge_store[i + 1].head);
+		}
+	}
+	size_t num_found = 0;
+	for (size_t i = 1; i < size; ++i) {
+		assert_int_not_equal(edge_store[i].head, 30);
+		assert_int_equal(edge_store[i].head % 3, 0);
+		const size_t member = (size_t) edge_store[i].head / 3;
+		assert_double_equal(edge_store[i].distance, output_dists[member]);
+		num_found += member;
+	}
+	assert_int_equal(num_found, (size * (size - 1)) / 2 - 10);
+
+	for (size_t i = 0; i < size - 1; ++i) {
+		assert_ptr_equal(edge_store[i].next_dist, &edge_store[i + 1]);
+	}
+	assert_null(edge_store[size - 1].next_dist);
+
+	free(mem);
+	free(output_dists);
+	free(sort_keys);
+	free(sort_heads);
+	free(edge_store);
+}
+
+
 void scc_ut_hi_compare_dist_edges(void** state)
 {
 	(void) state;
@@ -1441,6 +1502,7 @@ int main(void)
 		cmocka_unit_test(scc_ut_hi_get_next_marker),
 		cmocka_unit_test(scc_ut_hi_compare_dist_edges),
 		cmocka_unit_test(scc_ut_hi_sort_edge_list),
+		cmocka_unit_test(scc_ut_hi_sort_edge_list_radix),
 		cmocka_unit_test(scc_ut_hi_populate_edge_lists),
 		cmocka_unit_test(scc_ut_hi_get_next_dist),
 		cmocka_unit_test(scc_ut_hi_get_next_k_nn),
@@ -20,12 +20,14 @@
 
 #include "init_test.h"
 #include <include/scclust.h>
+#include <include/scclust_spi.h>
 #include <src/clustering_struct.h>
+#include <src/dist_search_imp.h>
 #include <src/scclust_types.h>
 #include "data_object_test.h"
 
 
-static const int32_t ISCC_UT_OPTIONS_STRUCT_VERSION = 722678001;
+static const int32_t ISCC_UT_OPTIONS_STRUCT_VERSION = 722725001;
 
 
 void iscc_run_nonval_tests(scc_SeedMethod seed_method,
@@ -6671,6 +6673,322 @@ void scc_ut_nng_clustering_with_types_nonval(void** state)
 }
 
 
+void scc_ut_nng_clustering_approximate(void** state)
+{
+	(void) state;
+
+	bool cl_is_OK;
+	scc_Clustering* cl;
+	scc_ClusterOptions options;
+	scc_ErrorCode ec;
+	const uint32_t type_constraints[3] = { 1, 0, 1 };
+	const scc_TypeLabel type_labels[100] = { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1,
+	                                         2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0,
+	                                         1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2,
+	                                         0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1,
+	                                         2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 };
+
+	scc_init_empty_clustering(100, NULL, &cl);
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_INWARDS_UPDATING, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	options.approximate_nng = true;
+	options.approximate_nng_sample_rate = 0.5;
+	options.approximate_nng_delta = 0.001;
+	ec = scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options);
+	assert_int_equal(ec, SCC_ER_OK);
+	ec = scc_check_clustering(cl, 3, 0, NULL, 0, NULL, &cl_is_OK);
+	assert_int_equal(ec, SCC_ER_OK);
+	assert_true(cl_is_OK);
+	scc_free_clustering(&cl);
+
+	scc_init_empty_clustering(100, NULL, &cl);
+	options.approximate_nng_sample_rate = 0.0;
+	ec = scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options);
+	assert_int_equal(ec, SCC_ER_INVALID_INPUT);
+	options.approximate_nng_sample_rate = 1.5;
+	ec = scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options);
+	assert_int_equal(ec, SCC_ER_INVALID_INPUT);
+	options.approximate_nng_sample_rate = 1.0;
+	options.approximate_nng_delta = -1.0;
+	ec = scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options);
+	assert_int_equal(ec, SCC_ER_INVALID_INPUT);
+
+	options = iscc_translate_options(3,
+	                                 3, type_constraints, 100, type_labels,
+	                                 SCC_SM_LEXICAL, SCC_UM_IGNORE, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	options.approximate_nng = true;
+	options.approximate_nng_sample_rate = 1.0;
+	ec = scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options);
+	assert_int_equal(ec, SCC_ER_NOT_IMPLEMENTED);
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_BATCHES, SCC_UM_IGNORE, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	options.approximate_nng = true;
+	options.approximate_nng_sample_rate = 1.0;
+	ec = scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options);
+	assert_int_equal(ec, SCC_ER_NOT_IMPLEMENTED);
+	scc_free_clustering(&cl);
+}
+
+
+// Counts the nearest neighbor searches in the backend's user data
+static bool scc_ut_counting_nn_search(iscc_NNSearchObject* const nn_search_object,
+                                      const size_t len_query_indices,
+                                      const scc_PointIndex query_indices[const],
+                                      const uint32_t k,
+                                      const bool radius_search,
+                                      const double radius,
+                                      size_t* const out_num_ok_queries,
+                                      scc_PointIndex out_query_indices[const],
+                                      scc_PointIndex out_nn_indices[const])
+{
+	size_t* const num_searches = scc_get_dist_backend_user_data();
+	if (num_searches == NULL) return false;
+	++(*num_searches);
+	return iscc_imp_nearest_neighbor_search(nn_search_object, len_query_indices, query_indices, k,
+	                                        radius_search, radius, out_num_ok_queries, out_query_indices, out_nn_indices);
+}
+
+
+void scc_ut_nng_clustering_dist_backend(void** state)
+{
+	(void) state;
+
+	scc_Clustering* cl_ref;
+	scc_Clustering* cl;
+	scc_ClusterOptions options;
+	scc_DistBackend* backend;
+	size_t num_searches = 0;
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_INWARDS_UPDATING, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	scc_init_empty_clustering(100, NULL, &cl_ref);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl_ref, &options), SCC_ER_OK);
+
+	assert_int_equal(scc_init_dist_backend(NULL, NULL, NULL, NULL, NULL, NULL,
+	                                       iscc_imp_init_nn_search_object, NULL, iscc_imp_close_nn_search_object,
+	                                       &num_searches, &backend), SCC_ER_INVALID_INPUT);
+	assert_null(backend);
+	assert_int_equal(scc_init_dist_backend(NULL, NULL, NULL, NULL, NULL, NULL,
+	                                       iscc_imp_init_nn_search_object, scc_ut_counting_nn_search, iscc_imp_close_nn_search_object,
+	                                       &num_searches, NULL), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_init_dist_backend(NULL, NULL, NULL, NULL, NULL, NULL,
+	                                       iscc_imp_init_nn_search_object, scc_ut_counting_nn_search, iscc_imp_close_nn_search_object,
+	                                       &num_searches, &backend), SCC_ER_OK);
+
+	// Same clustering, searched with the backend
+	options.dist_backend = backend;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_OK);
+	assert_true(num_searches > 0);
+	assert_int_equal(cl->num_clusters, cl_ref->num_clusters);
+	assert_memory_equal(cl->cluster_label, cl_ref->cluster_label, sizeof(scc_Clabel[100]));
+	assert_null(scc_get_dist_backend_user_data());
+	scc_free_clustering(&cl);
+
+	// The backend is not used by other calls
+	const size_t searches_with_backend = num_searches;
+	options.dist_backend = NULL;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_OK);
+	assert_int_equal(num_searches, searches_with_backend);
+	scc_free_clustering(&cl);
+	scc_free_dist_backend(&backend);
+	assert_null(backend);
+
+	assert_int_equal(scc_init_kdtree_dist_backend(&backend), SCC_ER_OK);
+	options.dist_backend = backend;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_OK);
+	assert_memory_equal(cl->cluster_label, cl_ref->cluster_label, sizeof(scc_Clabel[100]));
+	scc_free_clustering(&cl);
+	scc_free_dist_backend(&backend);
+
+	// Not a backend
+	options.dist_backend = (const scc_DistBackend*) &scc_ut_test_data_large_struct;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cl);
+
+	scc_free_clustering(&cl_ref);
+}
+
+
+void scc_ut_nng_clustering_parallel_mis(void** state)
+{
+	(void) state;
+
+	bool cl_is_OK;
+	scc_Clustering* cl;
+	scc_Clustering* cl_threads;
+	scc_ClusterOptions options;
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_PARALLEL_MIS, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_OK);
+	assert_int_equal(scc_check_clustering(cl, 3, 0, NULL, 0, NULL, &cl_is_OK), SCC_ER_OK);
+	assert_true(cl_is_OK);
+
+	const scc_ErrorCode ec_threads = scc_set_num_threads(4);
+	assert_true((ec_threads == SCC_ER_OK) || (ec_threads == SCC_ER_NOT_IMPLEMENTED));
+	scc_init_empty_clustering(100, NULL, &cl_threads);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl_threads, &options), SCC_ER_OK);
+	assert_int_equal(scc_set_num_threads(0), SCC_ER_OK);
+	assert_int_equal(cl->num_clusters, cl_threads->num_clusters);
+	assert_memory_equal(cl->cluster_label, cl_threads->cluster_label, sizeof(scc_Clabel[100]));
+
+	scc_free_clustering(&cl);
+	scc_free_clustering(&cl_threads);
+}
+
+
+void scc_ut_nng_clustering_reorder_nng(void** state)
+{
+	(void) state;
+
+	bool cl_is_OK;
+	scc_Clustering* cl;
+	scc_ClusterOptions options;
+	const scc_SeedMethod seed_methods[4] = { SCC_SM_LEXICAL, SCC_SM_INWARDS_UPDATING, SCC_SM_EXCLUSION_UPDATING, SCC_SM_PARALLEL_MIS };
+
+	for (size_t i = 0; i < 4; ++i) {
+		options = iscc_translate_options(3,
+		                                 0, NULL, 0, NULL,
+		                                 seed_methods[i], SCC_UM_CLOSEST_SEED, false, 0.0,
+		                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+		options.reorder_nng = true;
+		scc_init_empty_clustering(100, NULL, &cl);
+		assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_OK);
+		assert_int_equal(scc_check_clustering(cl, 3, 0, NULL, 0, NULL, &cl_is_OK), SCC_ER_OK);
+		assert_true(cl_is_OK);
+		scc_free_clustering(&cl);
+	}
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_BATCHES, SCC_UM_IGNORE, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	options.reorder_nng = true;
+	scc_init_empty_clustering(100, NULL, &cl);
+	assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_NOT_IMPLEMENTED);
+	scc_free_clustering(&cl);
+}
+
+
+// Options with the version of an earlier layout must be rejected
+void scc_ut_nng_clustering_old_options_version(void** state)
+{
+	(void) state;
+
+	scc_Clustering* cl;
+	scc_Clustering* cls[1];
+	const uint32_t size_constraints[1] = { 3 };
+	const int32_t old_versions[3] = { 722678001, 722706001, 722722001 };
+
+	for (size_t i = 0; i < 3; ++i) {
+		scc_ClusterOptions options = iscc_translate_options(3,
+		                                                    0, NULL, 0, NULL,
+		                                                    SCC_SM_LEXICAL, SCC_UM_CLOSEST_SEED, false, 0.0,
+		                                                    0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+		options.options_version = old_versions[i];
+		scc_init_empty_clustering(100, NULL, &cl);
+		assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl, &options), SCC_ER_INVALID_INPUT);
+		cls[0] = cl;
+		assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 1, cls, size_constraints, &options), SCC_ER_INVALID_INPUT);
+		scc_free_clustering(&cl);
+	}
+}
+
+
+// Clusterings made together must equal those made one at a time
+static void scc_ut_compare_multiple_sizes(const scc_ClusterOptions* const options)
+{
+	const uint32_t size_constraints[3] = { 5, 2, 3 };
+	scc_Clustering* cls[3];
+	for (size_t i = 0; i < 3; ++i) {
+		scc_init_empty_clustering(100, NULL, &cls[i]);
+	}
+	assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 3, cls, size_constraints, options), SCC_ER_OK);
+
+	scc_ClusterOptions size_options = *options;
+	for (size_t i = 0; i < 3; ++i) {
+		scc_Clustering* cl_ref;
+		scc_init_empty_clustering(100, NULL, &cl_ref);
+		size_options.size_constraint = size_constraints[i];
+		assert_int_equal(scc_make_clustering(&scc_ut_test_data_large_struct, cl_ref, &size_options), SCC_ER_OK);
+		assert_int_equal(cls[i]->num_clusters, cl_ref->num_clusters);
+		assert_memory_equal(cls[i]->cluster_label, cl_ref->cluster_label, sizeof(scc_Clabel[100]));
+		scc_free_clustering(&cl_ref);
+		scc_free_clustering(&cls[i]);
+	}
+}
+
+
+void scc_ut_nng_clustering_multiple_sizes(void** state)
+{
+	(void) state;
+
+	scc_ClusterOptions options;
+	const scc_PointIndex primary_data_points[10] = { 2, 3, 11, 20, 35, 46, 58, 71, 86, 97 };
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_INWARDS_UPDATING, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	scc_ut_compare_multiple_sizes(&options);
+
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_EXCLUSION_ORDER, SCC_UM_ANY_NEIGHBOR, false, 0.0,
+	                                 10, primary_data_points, SCC_UM_CLOSEST_SEED, false, 0.0, 0);
+	scc_ut_compare_multiple_sizes(&options);
+
+	// Not shared
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_LEXICAL, SCC_UM_CLOSEST_SEED, true, 40.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	scc_ut_compare_multiple_sizes(&options);
+
+	scc_DistBackend* backend;
+	assert_int_equal(scc_init_kdtree_dist_backend(&backend), SCC_ER_OK);
+	options = iscc_translate_options(3,
+	                                 0, NULL, 0, NULL,
+	                                 SCC_SM_LEXICAL, SCC_UM_CLOSEST_SEED, false, 0.0,
+	                                 0, NULL, SCC_UM_IGNORE, false, 0.0, 0);
+	options.dist_backend = backend;
+	scc_ut_compare_multiple_sizes(&options);
+	scc_free_dist_backend(&backend);
+
+	// Invalid input
+	const uint32_t size_constraints[2] = { 3, 101 };
+	scc_Clustering* cls[2];
+	scc_init_empty_clustering(100, NULL, &cls[0]);
+	scc_init_empty_clustering(50, NULL, &cls[1]);
+	options.dist_backend = NULL;
+	assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 0, cls, size_constraints, &options), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 2, cls, NULL, &options), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 2, cls, size_constraints, NULL), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 2, cls, size_constraints, &options), SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&cls[1]);
+	scc_init_empty_clustering(100, NULL, &cls[1]);
+	assert_int_equal(scc_make_clusterings(&scc_ut_test_data_large_struct, 2, cls, size_constraints, &options), SCC_ER_NO_SOLUTION);
+	assert_int_equal(cls[0]->num_clusters, 0);
+	scc_free_clustering(&cls[0]);
+	scc_free_clustering(&cls[1]);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
@@ -6680,6 +6998,12 @@ int main(void)
 		cmocka_unit_test(scc_ut_nng_clustering_nonval),
 		cmocka_unit_test(scc_ut_nng_clustering_with_types),
 		cmocka_unit_test(scc_ut_nng_clustering_with_types_nonval),
+		cmocka_unit_test(scc_ut_nng_clustering_approximate),
+		cmocka_unit_test(scc_ut_nng_clustering_dist_backend),
+		cmocka_unit_test(scc_ut_nng_clustering_multiple_sizes),
+		cmocka_unit_test(scc_ut_nng_clustering_parallel_mis),
+		cmocka_unit_test(scc_ut_nng_clustering_reorder_nng),
+		cmocka_unit_test(scc_ut_nng_clustering_old_options_version),
 	};
 
 	return cmocka_run_group_tests_name("nng_clustering.c", test_cases, NULL, NULL);
@@ -25,7 +25,7 @@
 #include <src/scclust_types.h>
 #include "data_object_test.h"
 
-static const int32_t ISCC_UT_OPTIONS_STRUCT_VERSION = 722678001;
+static const int32_t ISCC_UT_OPTIONS_STRUCT_VERSION = 722725001;
 
 void iscc_run_nonval_tests_batches(scc_UnassignedMethod unassigned_method,
                                    bool radius_constraint,
@@ -24,7 +24,7 @@
 #include "data_object_test.h"
 
 
-#define ISCC_UT_OPTIONS_STRUCT_VERSION 722678001
+#define ISCC_UT_OPTIONS_STRUCT_VERSION 722725001
 
 static scc_ClusterOptions iscc_translate_options(const uint32_t size_constraint,
                                                  const scc_SeedMethod seed_method,
@@ -21,6 +21,7 @@
 #include "init_test.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <src/clustering_struct.h>
 #include <src/digraph_debug.h>
@@ -28,6 +29,7 @@
 #include "assert_digraph.h"
 #include "data_object_test.h"
 #include "double_assert.h"
+#include "rand.h"
 
 
 void scc_ut_get_nng_with_size_constraint(void** state)
@@ -2805,6 +2807,109 @@ void scc_ut_make_nng_clusters_from_seeds(void** state)
 }
 
 
+static double scc_ut_nng_recall(const iscc_Digraph* const approx,
+                                const iscc_Digraph* const exact)
+{
+	size_t found = 0;
+	size_t total = 0;
+	for (size_t v = 0; v < approx->vertices; ++v) {
+		for (iscc_ArcIndex a = approx->tail_ptr[v]; a < approx->tail_ptr[v + 1]; ++a) {
+			for (iscc_ArcIndex e = exact->tail_ptr[v]; e < exact->tail_ptr[v + 1]; ++e) {
+				if (approx->head[a] == exact->head[e]) {
+					++found;
+					break;
+				}
+			}
+			++total;
+		}
+	}
+	return (double) found / (double) total;
+}
+
+
+void scc_ut_get_approximate_nng_with_size_constraint(void** state)
+{
+	(void) state;
+
+	iscc_Digraph exact1;
+	iscc_Digraph approx1;
+	assert_int_equal(iscc_get_nng_with_size_constraint(scc_ut_test_data_large, 100, 4, 0, NULL, false, 0.0, &exact1), SCC_ER_OK);
+	assert_int_equal(iscc_get_approximate_nng_with_size_constraint(scc_ut_test_data_large, 100, 4, 0, NULL, false, 0.0, 1.0, 0.0, &approx1), SCC_ER_OK);
+	assert_true(iscc_digraph_is_valid(&approx1));
+	for (size_t v = 0; v < 100; ++v) {
+		assert_int_equal(approx1.tail_ptr[v + 1] - approx1.tail_ptr[v], 3);
+		for (iscc_ArcIndex a = approx1.tail_ptr[v]; a < approx1.tail_ptr[v + 1]; ++a) {
+			assert_int_not_equal(approx1.head[a], v);
+		}
+	}
+	assert_true(scc_ut_nng_recall(&approx1, &exact1) >= 0.95);
+	iscc_free_digraph(&exact1);
+	iscc_free_digraph(&approx1);
+
+	// The whole graph is the candidate set when `size_constraint` is close to the number of points
+	iscc_Digraph exact2;
+	iscc_Digraph approx2;
+	assert_int_equal(iscc_get_nng_with_size_constraint(scc_ut_test_data_small, 15, 10, 0, NULL, false, 0.0, &exact2), SCC_ER_OK);
+	assert_int_equal(iscc_get_approximate_nng_with_size_constraint(scc_ut_test_data_small, 15, 10, 0, NULL, false, 0.0, 0.5, 0.0, &approx2), SCC_ER_OK);
+	assert_true(scc_ut_nng_recall(&approx2, &exact2) >= 0.99);
+	iscc_free_digraph(&exact2);
+	iscc_free_digraph(&approx2);
+
+	const size_t num_points = 3000;
+	double* const coords = scc_rand_coords(num_points, 4, SCC_RAND_DEFAULT_SEED);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, 4, num_points * 4, coords, &data_set), SCC_ER_OK);
+
+	iscc_Digraph exact3;
+	iscc_Digraph approx3;
+	assert_int_equal(iscc_get_nng_with_size_constraint(data_set, num_points, 6, 0, NULL, false, 0.0, &exact3), SCC_ER_OK);
+	assert_int_equal(iscc_get_approximate_nng_with_size_constraint(data_set, num_points, 6, 0, NULL, false, 0.0, 1.0, 0.001, &approx3), SCC_ER_OK);
+	assert_true(scc_ut_nng_recall(&approx3, &exact3) >= 0.95);
+	iscc_free_digraph(&exact3);
+	iscc_free_digraph(&approx3);
+
+	// Primary data points and radius constraint
+	const scc_PointIndex primary_data_points[5] = { 3, 10, 100, 1000, 2999 };
+	iscc_Digraph approx4;
+	assert_int_equal(iscc_get_approximate_nng_with_size_constraint(data_set, num_points, 6, 5, primary_data_points, false, 0.0, 1.0, 0.001, &approx4), SCC_ER_OK);
+	size_t p = 0;
+	for (size_t v = 0; v < num_points; ++v) {
+		if ((p < 5) && (primary_data_points[p] == (scc_PointIndex) v)) {
+			assert_int_equal(approx4.tail_ptr[v + 1] - approx4.tail_ptr[v], 5);
+			++p;
+		} else {
+			assert_int_equal(approx4.tail_ptr[v + 1] - approx4.tail_ptr[v], 0);
+		}
+	}
+	iscc_free_digraph(&approx4);
+
+	iscc_Digraph exact5;
+	iscc_Digraph approx5;
+	assert_int_equal(iscc_get_nng_with_size_constraint(data_set, num_points, 6, 0, NULL, true, 200.0, &exact5), SCC_ER_OK);
+	assert_int_equal(iscc_get_approximate_nng_with_size_constraint(data_set, num_points, 6, 0, NULL, true, 200.0, 1.0, 0.001, &approx5), SCC_ER_OK);
+	size_t num_exact_rows = 0;
+	size_t num_approx_rows = 0;
+	for (size_t v = 0; v < num_points; ++v) {
+		if (exact5.tail_ptr[v + 1] > exact5.tail_ptr[v]) ++num_exact_rows;
+		if (approx5.tail_ptr[v + 1] > approx5.tail_ptr[v]) {
+			assert_true(exact5.tail_ptr[v + 1] > exact5.tail_ptr[v]);
+			++num_approx_rows;
+		}
+	}
+	assert_true(num_approx_rows > 0);
+	assert_true(num_approx_rows < num_points);
+	assert_true((double) num_approx_rows >= 0.9 * (double) num_exact_rows);
+	iscc_free_digraph(&exact5);
+	iscc_free_digraph(&approx5);
+
+	iscc_Digraph approx6;
+	assert_int_equal(iscc_get_approximate_nng_with_size_constraint(data_set, num_points, 6, 0, NULL, true, 0.001, 1.0, 0.001, &approx6), SCC_ER_NO_SOLUTION);
+
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
 int main(void)
 {
 	if(!scc_ut_init_tests()) return 1;
@@ -2812,6 +2917,7 @@ int main(void)
 	const struct CMUnitTest test_cases[] = {
 		cmocka_unit_test(scc_ut_get_nng_with_size_constraint),
 		cmocka_unit_test(scc_ut_get_nng_with_type_constraint),
+		cmocka_unit_test(scc_ut_get_approximate_nng_with_size_constraint),
 		cmocka_unit_test(scc_ut_estimate_avg_seed_dist),
 		cmocka_unit_test(scc_ut_make_nng_clusters_from_seeds),
 	};
@@ -20,10 +20,15 @@
 
 #include "init_test.h"
 #include <src/nng_core.c>
+#include <stdint.h>
+#include <stdlib.h>
+#include <include/scclust_spi.h>
 #include <src/digraph_debug.h>
+#include <src/dist_search_imp.h>
 #include <src/scclust_types.h>
 #include "assert_digraph.h"
 #include "data_object_test.h"
+#include "rand.h"
 
 
 void scc_ut_make_nng(void** state)
@@ -880,6 +885,202 @@ void scc_ut_make_nng_from_search_object_radius(void** state)
 }
 
 
+// Fails unless the backend's user data is visible in the calling thread
+static bool scc_ut_user_data_nn_search(iscc_NNSearchObject* const nn_search_object,
+                                       const size_t len_query_indices,
+                                       const scc_PointIndex query_indices[const],
+                                       const uint32_t k,
+                                       const bool radius_search,
+                                       const double radius,
+                                       size_t* const out_num_ok_queries,
+                                       scc_PointIndex out_query_indices[const],
+                                       scc_PointIndex out_nn_indices[const])
+{
+	if (scc_get_dist_backend_user_data() == NULL) return false;
+	return iscc_imp_nearest_neighbor_search(nn_search_object, len_query_indices, query_indices, k,
+	                                        radius_search, radius, out_num_ok_queries, out_query_indices, out_nn_indices);
+}
+
+
+void scc_ut_make_nng_from_search_object_blocks(void** state)
+{
+	(void) state;
+
+	const size_t num_points = 3000;
+	const size_t num_dims = 4;
+	double* const coords = scc_rand_coords(num_points, num_dims, SCC_RAND_DEFAULT_SEED);
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, num_dims, num_points * num_dims, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex* const query = malloc(sizeof(scc_PointIndex[num_points]));
+	const size_t len_query = num_points / 3;
+	for (size_t i = 0; i < len_query; ++i) {
+		query[i] = (scc_PointIndex) (3 * i + 1);
+	}
+
+	iscc_NNSearchObject* nn_search_object;
+	assert_true(iscc_init_nn_search_object(data_set, num_points, NULL, &nn_search_object));
+
+	iscc_Digraph ref_nng[4];
+	iscc_Digraph out_nng[4];
+	size_t ref_num_ok[4];
+	size_t out_num_ok[4];
+	scc_PointIndex* const ref_ok = malloc(sizeof(scc_PointIndex[4 * num_points]));
+	scc_PointIndex* const out_ok = malloc(sizeof(scc_PointIndex[4 * num_points]));
+
+	for (int thread_safe = 0; thread_safe <= 1; ++thread_safe) {
+		assert_true(scc_set_nn_search_thread_safe(thread_safe == 1));
+		iscc_Digraph* const nng = (thread_safe == 1) ? out_nng : ref_nng;
+		size_t* const num_ok = (thread_safe == 1) ? out_num_ok : ref_num_ok;
+		scc_PointIndex* const ok = (thread_safe == 1) ? out_ok : ref_ok;
+		assert_int_equal(iscc_make_nng_from_search_object(nn_search_object, num_points, num_points, NULL,
+		                                                  5, false, 0.0, &num_ok[0], NULL, &nng[0]), SCC_ER_OK);
+		assert_int_equal(iscc_make_nng_from_search_object(nn_search_object, num_points, len_query, query,
+		                                                  3, false, 0.0, &num_ok[1], NULL, &nng[1]), SCC_ER_OK);
+		assert_int_equal(iscc_make_nng_from_search_object(nn_search_object, num_points, num_points, NULL,
+		                                                  4, true, 120.0, &num_ok[2], ok + 2 * num_points, &nng[2]), SCC_ER_OK);
+		assert_int_equal(iscc_make_nng_from_search_object(nn_search_object, num_points, len_query, query,
+		                                                  2, true, 90.0, &num_ok[3], NULL, &nng[3]), SCC_ER_OK);
+	}
+	assert_true(scc_set_nn_search_thread_safe(false));
+
+	assert_true(ref_num_ok[2] > 0);
+	assert_true(ref_num_ok[2] < num_points);
+	assert_true(ref_num_ok[3] > 0);
+	assert_true(ref_num_ok[3] < len_query);
+	for (size_t i = 0; i < 4; ++i) {
+		assert_int_equal(out_num_ok[i], ref_num_ok[i]);
+		assert_valid_digraph(&out_nng[i], num_points);
+		assert_identical_digraph(&out_nng[i], &ref_nng[i]);
+		iscc_free_digraph(&ref_nng[i]);
+		iscc_free_digraph(&out_nng[i]);
+	}
+	assert_memory_equal(out_ok + 2 * num_points, ref_ok + 2 * num_points, sizeof(scc_PointIndex[ref_num_ok[2]]));
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+
+	// Workers see the backend
+	int user_data = 1;
+	scc_DistBackend* backend;
+	assert_int_equal(scc_set_dist_backend_thread_safe(NULL, true), SCC_ER_INVALID_INPUT);
+	assert_int_equal(scc_init_dist_backend(NULL, NULL, NULL, NULL, NULL, NULL,
+	                                       iscc_imp_init_nn_search_object, scc_ut_user_data_nn_search, iscc_imp_close_nn_search_object,
+	                                       &user_data, &backend), SCC_ER_OK);
+	assert_int_equal(scc_set_dist_backend_thread_safe(backend, true), SCC_ER_OK);
+	const scc_DistBackend* const previous_backend = iscc_set_active_dist_backend(backend);
+	assert_true(iscc_init_nn_search_object(data_set, num_points, NULL, &nn_search_object));
+	assert_int_equal(iscc_make_nng_from_search_object(nn_search_object, num_points, num_points, NULL,
+	                                                  5, false, 0.0, NULL, NULL, &out_nng[0]), SCC_ER_OK);
+	assert_true(iscc_close_nn_search_object(&nn_search_object));
+	iscc_set_active_dist_backend(previous_backend);
+	assert_valid_digraph(&out_nng[0], num_points);
+	assert_int_equal(out_nng[0].tail_ptr[num_points], 5 * num_points);
+	iscc_free_digraph(&out_nng[0]);
+	scc_free_dist_backend(&backend);
+
+	free(ref_ok);
+	free(out_ok);
+	free(query);
+	scc_free_data_set(&data_set);
+	free(coords);
+}
+
+
+// Same search as the default, but not recognized as the built-in brute force search
+static bool scc_ut_wrapped_nn_search(iscc_NNSearchObject* const nn_search_object,
+                                     const size_t len_query_indices,
+                                     const scc_PointIndex query_indices[const],
+                                     const uint32_t k,
+                                     const bool radius_search,
+                                     const double radius,
+                                     size_t* const out_num_ok_queries,
+                                     scc_PointIndex out_query_indices[const],
+                                     scc_PointIndex out_nn_indices[const])
+{
+	return iscc_imp_nearest_neighbor_search(nn_search_object, len_query_indices, query_indices, k,
+	                                        radius_search, radius, out_num_ok_queries, out_query_indices, out_nn_indices);
+}
+
+
+void scc_ut_get_nng_with_type_constraint_fused(void** state)
+{
+	(void) state;
+
+	// Few distinct coordinates, so many ties and duplicates
+	const size_t num_points = 400;
+	double coords[800];
+	scc_TypeLabel type_labels[400];
+	uint64_t rng = 2463534242u;
+	for (size_t i = 0; i < num_points; ++i) {
+		rng ^= rng << 13;
+		rng ^= rng >> 7;
+		rng ^= rng << 17;
+		coords[2 * i] = (double) (rng % 10);
+		coords[2 * i + 1] = (double) ((rng >> 8) % 10);
+		type_labels[i] = (scc_TypeLabel) ((rng >> 16) % 3);
+	}
+	scc_DataSet* data_set;
+	assert_int_equal(scc_init_data_set(num_points, 2, 800, coords, &data_set), SCC_ER_OK);
+
+	scc_PointIndex primary[100];
+	for (size_t i = 0; i < 100; ++i) {
+		primary[i] = (scc_PointIndex) (4 * i + 3);
+	}
+
+	scc_DistBackend* fused_backend;
+	scc_DistBackend* ref_backend;
+	assert_int_equal(scc_init_dist_backend(NULL, NULL, NULL, NULL, NULL, NULL,
+	                                       NULL, NULL, NULL, NULL, &fused_backend), SCC_ER_OK);
+	assert_int_equal(scc_init_dist_backend(NULL, NULL, NULL, NULL, NULL, NULL,
+	                                       iscc_imp_init_nn_search_object, scc_ut_wrapped_nn_search, iscc_imp_close_nn_search_object,
+	                                       NULL, &ref_backend), SCC_ER_OK);
+	const scc_DistBackend* const previous_backend = iscc_set_active_dist_backend(fused_backend);
+
+	// The last setting uses neighbor heaps
+	const uint32_t type_constraints[5][3] = { { 1, 2, 0 }, { 1, 2, 0 }, { 0, 3, 1 }, { 2, 2, 2 }, { 70, 0, 1 } };
+	const uint32_t size_constraints[5] = { 3, 7, 5, 6, 140 };
+	const bool radius_constraints[5] = { false, false, true, true, false };
+	const double radii[5] = { 0.0, 0.0, 1.5, 2.0, 0.0 };
+
+	for (size_t c = 0; c < 5; ++c) {
+		for (size_t use_primary = 0; use_primary <= 1; ++use_primary) {
+			iscc_Digraph fused_nng;
+			iscc_Digraph ref_nng;
+			const scc_PointIndex* const primary_points = (use_primary == 1) ? primary : NULL;
+
+			iscc_set_active_dist_backend(fused_backend);
+			assert_int_equal(iscc_get_nng_with_type_constraint(data_set, num_points, size_constraints[c],
+			                                                   3, type_constraints[c], type_labels, 100, primary_points,
+			                                                   radius_constraints[c], radii[c], &fused_nng), SCC_ER_OK);
+
+			iscc_set_active_dist_backend(ref_backend);
+			assert_int_equal(iscc_get_nng_with_type_constraint(data_set, num_points, size_constraints[c],
+			                                                   3, type_constraints[c], type_labels, 100, primary_points,
+			                                                   radius_constraints[c], radii[c], &ref_nng), SCC_ER_OK);
+
+			assert_valid_digraph(&fused_nng, num_points);
+			assert_identical_digraph(&fused_nng, &ref_nng);
+			iscc_free_digraph(&fused_nng);
+			iscc_free_digraph(&ref_nng);
+		}
+	}
+
+	// Errors as in the search by type
+	iscc_set_active_dist_backend(fused_backend);
+	const uint32_t too_large[3] = { 1, 300, 0 };
+	iscc_Digraph out_nng;
+	assert_int_equal(iscc_get_nng_with_type_constraint(data_set, num_points, 301, 3, too_large, type_labels, 0, NULL,
+	                                                   false, 0.0, &out_nng), SCC_ER_NO_SOLUTION);
+	assert_int_equal(iscc_get_nng_with_type_constraint(data_set, num_points, 3, 3, type_constraints[3], type_labels, 0, NULL,
+	                                                   false, 0.0, &out_nng), SCC_ER_INVALID_INPUT);
+
+	iscc_set_active_dist_backend(previous_backend);
+
+	scc_free_dist_backend(&fused_backend);
+	scc_free_dist_backend(&ref_backend);
+	scc_free_data_set(&data_set);
+}
+
+
 void scc_ut_ensure_self_match(void** state)
 {
 	(void) state;
@@ -1330,6 +1531,8 @@ int main(void)
 		cmocka_unit_test(scc_ut_make_nng_radius),
 		cmocka_unit_test(scc_ut_make_nng_from_search_object),
 		cmocka_unit_test(scc_ut_make_nng_from_search_object_radius),
+		cmocka_unit_test(scc_ut_make_nng_from_search_object_blocks),
+		cmocka_unit_test(scc_ut_get_nng_with_type_constraint_fused),
 		cmocka_unit_test(scc_ut_ensure_self_match),
 		cmocka_unit_test(scc_ut_type_count),
 		cmocka_unit_test(scc_ut_assign_seeds_and_neighbors),
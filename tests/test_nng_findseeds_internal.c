@@ -19,6 +19,7 @@
  * ========================================================================== */
 
 #include "init_test.h"
+#include <string.h>
 #include <include/scclust.h>
 #include <src/digraph_core.h>
 #include <src/digraph_operations.h>
@@ -26,6 +27,7 @@
 #include <src/nng_findseeds.c>
 #include <src/scclust_types.h>
 #include "assert_digraph.h"
+#include "bitset_helpers.h"
 
 #ifdef SCC_STABLE_FINDSEED
     #error Please run this test without the SCC_STABLE_FINDSEED flag
@@ -227,6 +229,106 @@ void scc_ut_findseeds_exclusion(void** state)
 }
 
 
+// Seeds must have arcs, disjoint neighborhoods, and exclude all other vertices with arcs
+static void scc_ut_check_seeds_maximal(const iscc_Digraph* const nng,
+                                       const iscc_SeedResult* const sr)
+{
+	scc_PointIndex* const owner = malloc(sizeof(scc_PointIndex[nng->vertices]));
+	for (size_t v = 0; v < nng->vertices; ++v) owner[v] = ISCC_POINTINDEX_MAX_PI;
+	for (size_t i = 0; i < sr->count; ++i) {
+		const scc_PointIndex s = sr->seeds[i];
+		assert_true(nng->tail_ptr[s] != nng->tail_ptr[s + 1]);
+		assert_true(owner[s] == ISCC_POINTINDEX_MAX_PI);
+		owner[s] = s;
+		for (iscc_ArcIndex a = nng->tail_ptr[s]; a < nng->tail_ptr[s + 1]; ++a) {
+			assert_true((owner[nng->head[a]] == ISCC_POINTINDEX_MAX_PI) || (owner[nng->head[a]] == s));
+			owner[nng->head[a]] = s;
+		}
+	}
+	for (size_t v = 0; v < nng->vertices; ++v) {
+		if (nng->tail_ptr[v] == nng->tail_ptr[v + 1]) continue;
+		bool excluded = (owner[v] != ISCC_POINTINDEX_MAX_PI);
+		for (iscc_ArcIndex a = nng->tail_ptr[v]; a < nng->tail_ptr[v + 1]; ++a) {
+			excluded = excluded || (owner[nng->head[a]] != ISCC_POINTINDEX_MAX_PI);
+		}
+		assert_true(excluded);
+	}
+	free(owner);
+}
+
+
+void scc_ut_findseeds_parallel_mis(void** state)
+{
+	(void) state;
+
+	iscc_Digraph nng1;
+	iscc_digraph_from_string("...#....../"
+	                         "...#....../"
+	                         ".#......../"
+	                         ".#......../"
+	                         ".....#..../"
+	                         ".#......../"
+	                         "....#...../"
+	                         "......#.../"
+	                         "......#.../"
+	                         "......#.../",
+	                         &nng1);
+	iscc_SeedResult sr1 = {
+		.capacity = 10,
+		.count = 0,
+		.seeds = NULL,
+	};
+
+	scc_ErrorCode ec1 = iscc_findseeds_parallel_mis(&nng1, &sr1);
+	assert_int_equal(ec1, SCC_ER_OK);
+	assert_int_equal(sr1.capacity, 10);
+	assert_non_null(sr1.seeds);
+	scc_ut_check_seeds_maximal(&nng1, &sr1);
+	free(sr1.seeds);
+	iscc_free_digraph(&nng1);
+
+	// A long chain, and random arcs
+	const size_t vertices = 5000;
+	const size_t k = 3;
+	iscc_Digraph nng2;
+	assert_int_equal(iscc_init_digraph(vertices, vertices * k, &nng2), SCC_ER_OK);
+	uint64_t rng = 88172645463325252u;
+	size_t num_arcs = 0;
+	nng2.tail_ptr[0] = 0;
+	for (size_t v = 0; v < vertices; ++v) {
+		// Some vertices have no arcs
+		if (v % 17 != 3) {
+			nng2.head[num_arcs] = (scc_PointIndex) ((v + 1) % vertices);
+			for (size_t a = 1; a < k; ++a) {
+				rng ^= rng << 13;
+				rng ^= rng >> 7;
+				rng ^= rng << 17;
+				// Distinct heads: random arcs go to vertices v + 2 to v + 201
+				nng2.head[num_arcs + a] = (scc_PointIndex) ((v + 2 + (a - 1) * 100 + (rng % 100)) % vertices);
+			}
+			num_arcs += k;
+		}
+		nng2.tail_ptr[v + 1] = (iscc_ArcIndex) num_arcs;
+	}
+
+	iscc_SeedResult sr2 = { .capacity = 100, .count = 0, .seeds = NULL, };
+	iscc_SeedResult sr3 = { .capacity = 100, .count = 0, .seeds = NULL, };
+	assert_int_equal(iscc_findseeds_parallel_mis(&nng2, &sr2), SCC_ER_OK);
+	scc_ut_check_seeds_maximal(&nng2, &sr2);
+
+	const scc_ErrorCode ec_threads = scc_set_num_threads(4);
+	assert_true((ec_threads == SCC_ER_OK) || (ec_threads == SCC_ER_NOT_IMPLEMENTED));
+	assert_int_equal(iscc_findseeds_parallel_mis(&nng2, &sr3), SCC_ER_OK);
+	assert_int_equal(scc_set_num_threads(0), SCC_ER_OK);
+	assert_int_equal(sr2.count, sr3.count);
+	assert_memory_equal(sr2.seeds, sr3.seeds, sizeof(scc_PointIndex[sr2.count]));
+
+	free(sr2.seeds);
+	free(sr3.seeds);
+	iscc_free_digraph(&nng2);
+}
+
+
 void scc_ut_findseeds_lexical_withdiag(void** state)
 {
 	(void) state;
@@ -1007,6 +1109,40 @@ void scc_ut_findseeds_exclusion_caliper_selfpointing_withdiag(void** state)
 }
 
 
+// Stores the rows of `tails_to_keep` (all if NULL) of the exclusion graph in a digraph
+static scc_ErrorCode scc_ut_store_exclusion_graph(const iscc_Digraph* const nng,
+                                                  const size_t len_tails_to_keep,
+                                                  const scc_PointIndex tails_to_keep[const],
+                                                  iscc_Digraph* const out_dg)
+{
+	iscc_fs_ExclusionGraph eg;
+	scc_ErrorCode ec = iscc_fs_init_exclusion_graph(nng, &eg);
+	if (ec != SCC_ER_OK) return ec;
+
+	const size_t vertices = nng->vertices;
+	scc_PointIndex* const row = malloc(sizeof(scc_PointIndex[eg.max_row_size]));
+	ec = iscc_init_digraph(vertices, vertices * eg.max_row_size, out_dg);
+	assert_int_equal(ec, SCC_ER_OK);
+
+	size_t next_keep = 0;
+	out_dg->tail_ptr[0] = 0;
+	for (scc_PointIndex v = 0; v < (scc_PointIndex) vertices; ++v) {
+		size_t len_row = 0;
+		if ((tails_to_keep == NULL) || ((next_keep < len_tails_to_keep) && (tails_to_keep[next_keep] == v))) {
+			++next_keep;
+			len_row = iscc_fs_exclusion_row(&eg, v, row);
+			memcpy(out_dg->head + out_dg->tail_ptr[v], row, sizeof(scc_PointIndex[len_row]));
+		}
+		out_dg->tail_ptr[v + 1] = out_dg->tail_ptr[v] + (iscc_ArcIndex) len_row;
+	}
+
+	free(row);
+	iscc_fs_free_exclusion_graph(&eg);
+
+	return iscc_no_error();
+}
+
+
 void scc_ut_fs_exclusion_graph(void** state)
 {
 	(void) state;
@@ -1052,7 +1188,7 @@ void scc_ut_fs_exclusion_graph(void** state)
 	                         ".........#..###.#./",
 	                         &exg);
 	iscc_Digraph exclusion_graph;
-	scc_ErrorCode ec1 = iscc_fs_exclusion_graph(&nng, 0, NULL, &exclusion_graph);
+	scc_ErrorCode ec1 = scc_ut_store_exclusion_graph(&nng, 0, NULL, &exclusion_graph);
 	assert_int_equal(ec1, SCC_ER_OK);
 	assert_equal_digraph(&exg, &exclusion_graph);
 	iscc_free_digraph(&nng);
@@ -1085,7 +1221,7 @@ void scc_ut_fs_exclusion_graph(void** state)
 	                         "..#.. ..##./",
 	                         &exg2);
 	iscc_Digraph exclusion_graph2;
-	scc_ErrorCode ec2 = iscc_fs_exclusion_graph(&nng2, 0, NULL, &exclusion_graph2);
+	scc_ErrorCode ec2 = scc_ut_store_exclusion_graph(&nng2, 0, NULL, &exclusion_graph2);
 	assert_int_equal(ec2, SCC_ER_OK);
 	assert_equal_digraph(&exg2, &exclusion_graph2);
 	iscc_free_digraph(&nng2);
@@ -1133,7 +1269,7 @@ void scc_ut_fs_exclusion_graph(void** state)
 	                         ".........#..###.#./",
 	                         &exg3);
 	iscc_Digraph exclusion_graph3;
-	scc_ErrorCode ec3 = iscc_fs_exclusion_graph(&nng3, 0, NULL, &exclusion_graph3);
+	scc_ErrorCode ec3 = scc_ut_store_exclusion_graph(&nng3, 0, NULL, &exclusion_graph3);
 	assert_int_equal(ec3, SCC_ER_OK);
 	assert_equal_digraph(&exg3, &exclusion_graph3);
 	iscc_free_digraph(&nng3);
@@ -1166,7 +1302,7 @@ void scc_ut_fs_exclusion_graph(void** state)
 	                         "..#.. ..##./",
 	                         &exg4);
 	iscc_Digraph exclusion_graph4;
-	scc_ErrorCode ec4 = iscc_fs_exclusion_graph(&nng4, 0, NULL, &exclusion_graph4);
+	scc_ErrorCode ec4 = scc_ut_store_exclusion_graph(&nng4, 0, NULL, &exclusion_graph4);
 	assert_int_equal(ec4, SCC_ER_OK);
 	assert_equal_digraph(&exg4, &exclusion_graph4);
 	iscc_free_digraph(&nng4);
@@ -1216,7 +1352,7 @@ void scc_ut_fs_exclusion_graph(void** state)
 	                         "................../",
 	                         &exg5);
 	iscc_Digraph exclusion_graph5;
-	scc_ErrorCode ec5 = iscc_fs_exclusion_graph(&nng5, 9, keep_vertex5, &exclusion_graph5);
+	scc_ErrorCode ec5 = scc_ut_store_exclusion_graph(&nng5, 9, keep_vertex5, &exclusion_graph5);
 	assert_int_equal(ec5, SCC_ER_OK);
 	assert_equal_digraph(&exg5, &exclusion_graph5);
 	iscc_free_digraph(&nng5);
@@ -1250,7 +1386,7 @@ void scc_ut_fs_exclusion_graph(void** state)
 	                         "..... ...../",
 	                         &exg6);
 	iscc_Digraph exclusion_graph6;
-	scc_ErrorCode ec6 = iscc_fs_exclusion_graph(&nng6, 6, keep_vertex6, &exclusion_graph6);
+	scc_ErrorCode ec6 = scc_ut_store_exclusion_graph(&nng6, 6, keep_vertex6, &exclusion_graph6);
 	assert_int_equal(ec6, SCC_ER_OK);
 	assert_equal_digraph(&exg6, &exclusion_graph6);
 	iscc_free_digraph(&nng6);
@@ -1382,6 +1518,30 @@ void scc_ut_fs_add_seed(void** state)
 }
 
 
+// Bitset with the bits in `bools` set
+static void scc_ut_bitset_from_bools(const size_t len,
+                                     const bool bools[const],
+                                     iscc_BitWord out_bitset[const])
+{
+	for (size_t i = 0; i < iscc_bitset_words(len); ++i) {
+		out_bitset[i] = 0;
+	}
+	for (size_t i = 0; i < len; ++i) {
+		if (bools[i]) iscc_bitset_set(out_bitset, i);
+	}
+}
+
+
+static void scc_ut_assert_bitset_equal(const size_t len,
+                                       const iscc_BitWord bitset[const],
+                                       const bool ref[const])
+{
+	for (size_t i = 0; i < len; ++i) {
+		assert_int_equal(iscc_bitset_test(bitset, i), ref[i]);
+	}
+}
+
+
 void scc_ut_fs_check_neighbors_marks(void** state)
 {
 	(void) state;
@@ -1396,7 +1556,9 @@ void scc_ut_fs_check_neighbors_marks(void** state)
 	                         "......./",
 	                         &nng);
 
-	bool marks[7] = {true, false, false, false, true, false, false};
+	const bool bool_marks[7] = {true, false, false, false, true, false, false};
+	iscc_BitWord marks[1];
+	scc_ut_bitset_from_bools(7, bool_marks, marks);
 
 	assert_false(iscc_fs_check_neighbors_marks(0, &nng, marks));
 	assert_false(iscc_fs_check_neighbors_marks(1, &nng, marks));
@@ -1424,7 +1586,9 @@ void scc_ut_fs_check_neighbors_marks_withdiag(void** state)
 	                         "......./",
 	                         &nng);
 
-	bool marks[7] = {true, false, false, false, true, false, false};
+	const bool bool_marks[7] = {true, false, false, false, true, false, false};
+	iscc_BitWord marks[1];
+	scc_ut_bitset_from_bools(7, bool_marks, marks);
 
 	assert_false(iscc_fs_check_neighbors_marks(0, &nng, marks));
 	assert_false(iscc_fs_check_neighbors_marks(1, &nng, marks));
@@ -1452,41 +1616,51 @@ void scc_ut_fs_mark_seed_neighbors(void** state)
 	                         "......./",
 	                         &nng);
 
-	bool stc_marks[7] = {false, false, false, false, false, false, false};
+	iscc_BitWord stc_marks[1] = { 0 };
 
 	iscc_fs_mark_seed_neighbors(0, &nng, stc_marks);
 	bool ref_marks0[7] = {true, false, true, true, false, false, true};
-	assert_memory_equal(stc_marks, ref_marks0, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks0);
 
-	stc_marks[0] = stc_marks[2] = stc_marks[3] = stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 0);
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 3);
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(1, &nng, stc_marks);
 	bool ref_marks1[7] = {false, true, true, false, true, false, true};
-	assert_memory_equal(stc_marks, ref_marks1, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks1);
 
-	stc_marks[2] = stc_marks[4] = stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 4);
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(2, &nng, stc_marks);
 	bool ref_marks2[7] = {true, true, true, false, true, false, true};
-	assert_memory_equal(stc_marks, ref_marks2, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks2);
 
-	stc_marks[0] = stc_marks[1] = stc_marks[2] = stc_marks[4] = stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 0);
+	scc_ut_bitset_clear(stc_marks, 1);
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 4);
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(5, &nng, stc_marks);
 	bool ref_marks5[7] = {false, false, true, false, false, true, false};
-	assert_memory_equal(stc_marks, ref_marks5, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks5);
 
-	stc_marks[2] = stc_marks[5] = false;
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 5);
 
 	iscc_fs_mark_seed_neighbors(3, &nng, stc_marks);
 	bool ref_marks3[7] = {false, false, true, true, false, true, true};
-	assert_memory_equal(stc_marks, ref_marks3, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks3);
 
-	stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(6, &nng, stc_marks);
 	bool ref_marks6[7] = {false, false, true, true, false, true, true};
-	assert_memory_equal(stc_marks, ref_marks6, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks6);
 
 	iscc_free_digraph(&nng);
 }
@@ -1506,41 +1680,51 @@ void scc_ut_fs_mark_seed_neighbors_withdiag(void** state)
 	                         "......#/",
 	                         &nng);
 
-	bool stc_marks[7] = {false, false, false, false, false, false, false};
+	iscc_BitWord stc_marks[1] = { 0 };
 
 	iscc_fs_mark_seed_neighbors(0, &nng, stc_marks);
 	bool ref_marks0[7] = {true, false, true, true, false, false, true};
-	assert_memory_equal(stc_marks, ref_marks0, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks0);
 
-	stc_marks[0] = stc_marks[2] = stc_marks[3] = stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 0);
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 3);
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(1, &nng, stc_marks);
 	bool ref_marks1[7] = {false, true, true, false, true, false, true};
-	assert_memory_equal(stc_marks, ref_marks1, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks1);
 
-	stc_marks[2] = stc_marks[4] = stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 4);
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(2, &nng, stc_marks);
 	bool ref_marks2[7] = {true, true, true, false, true, false, true};
-	assert_memory_equal(stc_marks, ref_marks2, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks2);
 
-	stc_marks[0] = stc_marks[1] = stc_marks[2] = stc_marks[4] = stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 0);
+	scc_ut_bitset_clear(stc_marks, 1);
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 4);
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(5, &nng, stc_marks);
 	bool ref_marks5[7] = {false, false, true, false, false, true, false};
-	assert_memory_equal(stc_marks, ref_marks5, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks5);
 
-	stc_marks[2] = stc_marks[5] = false;
+	scc_ut_bitset_clear(stc_marks, 2);
+	scc_ut_bitset_clear(stc_marks, 5);
 
 	iscc_fs_mark_seed_neighbors(3, &nng, stc_marks);
 	bool ref_marks3[7] = {false, false, true, true, false, true, true};
-	assert_memory_equal(stc_marks, ref_marks3, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks3);
 
-	stc_marks[6] = false;
+	scc_ut_bitset_clear(stc_marks, 6);
 
 	iscc_fs_mark_seed_neighbors(6, &nng, stc_marks);
 	bool ref_marks6[7] = {false, false, true, true, false, true, true};
-	assert_memory_equal(stc_marks, ref_marks6, 7 * sizeof(bool));
+	scc_ut_assert_bitset_equal(7, stc_marks, ref_marks6);
 
 	iscc_free_digraph(&nng);
 }
@@ -1700,6 +1884,60 @@ void scc_ut_fs_sort_by_inwards(void** state)
 }
 
 
+void scc_ut_fs_sort_by_inwards_parallel(void** state)
+{
+	(void) state;
+
+	// Large enough to be sorted in parallel
+	const size_t vertices = 100000;
+	const size_t k = 3;
+	iscc_Digraph nng;
+	assert_int_equal(iscc_init_digraph(vertices, vertices * k, &nng), SCC_ER_OK);
+	uint64_t rng = 88172645463325252u;
+	nng.tail_ptr[0] = 0;
+	for (size_t v = 0; v < vertices; ++v) {
+		for (size_t a = 0; a < k; ++a) {
+			rng ^= rng << 13;
+			rng ^= rng >> 7;
+			rng ^= rng << 17;
+			// Skewed heads give many buckets
+			nng.head[v * k + a] = (scc_PointIndex) ((rng % vertices) * (rng % 7 + 1) / 8);
+		}
+		nng.tail_ptr[v + 1] = (iscc_ArcIndex) ((v + 1) * k);
+	}
+
+	iscc_fs_SortResult sort_serial;
+	iscc_fs_SortResult sort_parallel;
+	assert_int_equal(iscc_fs_sort_by_inwards(&nng, true, &sort_serial), SCC_ER_OK);
+	const scc_ErrorCode ec_threads = scc_set_num_threads(4);
+	assert_true((ec_threads == SCC_ER_OK) || (ec_threads == SCC_ER_NOT_IMPLEMENTED));
+	assert_int_equal(iscc_fs_sort_by_inwards(&nng, true, &sort_parallel), SCC_ER_OK);
+	assert_int_equal(scc_set_num_threads(0), SCC_ER_OK);
+
+	// Sorted by count, then by vertex ID
+	for (size_t i = 1; i < vertices; ++i) {
+		const scc_PointIndex prev = sort_serial.sorted_vertices[i - 1];
+		const scc_PointIndex cur = sort_serial.sorted_vertices[i];
+		assert_true((sort_serial.inwards_count[prev] < sort_serial.inwards_count[cur]) ||
+		            ((sort_serial.inwards_count[prev] == sort_serial.inwards_count[cur]) && (prev < cur)));
+	}
+
+	assert_memory_equal(sort_serial.sorted_vertices, sort_parallel.sorted_vertices, sizeof(scc_PointIndex[vertices]));
+	assert_memory_equal(sort_serial.inwards_count, sort_parallel.inwards_count, sizeof(scc_PointIndex[vertices]));
+	for (size_t v = 0; v < vertices; ++v) {
+		assert_int_equal(*sort_serial.vertex_index[v], v);
+		assert_true(sort_serial.vertex_index[v] - sort_serial.sorted_vertices == sort_parallel.vertex_index[v] - sort_parallel.sorted_vertices);
+	}
+	for (scc_PointIndex b = 0; b <= sort_serial.inwards_count[sort_serial.sorted_vertices[vertices - 1]]; ++b) {
+		assert_true(sort_serial.bucket_index[b] - sort_serial.sorted_vertices == sort_parallel.bucket_index[b] - sort_parallel.sorted_vertices);
+	}
+
+	iscc_fs_free_sort_result(&sort_serial);
+	iscc_fs_free_sort_result(&sort_parallel);
+	iscc_free_digraph(&nng);
+}
+
+
 void scc_ut_fs_decrease_v_in_sort(void** state)
 {
 	(void) state;
@@ -1835,6 +2073,7 @@ int main(void)
 		cmocka_unit_test(scc_ut_findseeds_inwards),
 		cmocka_unit_test(scc_ut_findseeds_inwards_alt),
 		cmocka_unit_test(scc_ut_findseeds_exclusion),
+		cmocka_unit_test(scc_ut_findseeds_parallel_mis),
 		cmocka_unit_test(scc_ut_findseeds_lexical_withdiag),
 		cmocka_unit_test(scc_ut_findseeds_inwards_withdiag),
 		cmocka_unit_test(scc_ut_findseeds_inwards_alt_withdiag),
@@ -1859,6 +2098,7 @@ int main(void)
 		cmocka_unit_test(scc_ut_fs_mark_seed_neighbors_withdiag),
 		cmocka_unit_test(scc_ut_fs_free_sort_result),
 		cmocka_unit_test(scc_ut_fs_sort_by_inwards),
+		cmocka_unit_test(scc_ut_fs_sort_by_inwards_parallel),
 		cmocka_unit_test(scc_ut_fs_decrease_v_in_sort),
 	};
 